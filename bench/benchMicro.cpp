@@ -0,0 +1,214 @@
+/*
+ ***********************************************************************************************************************
+ * File: benchMicro.cpp
+ * Description: This file contains the microbenchmarks of the helpers on the hot path of a scan,
+ *              CommandTemplate::Render, Logger::Log, GetCurrentTime, GetReturnMessage, Host::AddPortToHost and the
+ *              XML extraction done by Port::NMAPScriptScan, across realistic input sizes. Next to the time per
+ *              operation each benchmark reports the heap allocations and bytes allocated per operation, counted by
+ *              replacing the global allocation functions of this binary.
+ * Functions:
+ *           void *operator new ()
+ *           void *operator new [] ()
+ *           void operator delete ()
+ *           void operator delete [] ()
+ *           void CountAllocations ()
+ *           void BM_RenderCommand ()
+ *           void BM_LoggerLogFile ()
+ *           void BM_LoggerLogConsole ()
+ *           void BM_GetCurrentTime ()
+ *           void BM_GetReturnMessage ()
+ *           void BM_AddPortToHost ()
+ *           void BM_ExtractScriptResults ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <benchmark/benchmark.h>
+#include "fakeXml.hpp"
+#include "logger.hpp"
+#include "scanner.hpp"
+#include "utilities.hpp"
+
+const std::string MICRO_LOG = DIR_LOGS + "PH_BenchMicro.log";
+
+/* Allocation counters, shared by every thread of the binary */
+static std::atomic <size_t> allocCount {0};
+static std::atomic <size_t> allocBytes {0};
+
+
+/*
+ * These functions replace the global allocation functions so that every heap allocation of the binary is counted.
+ * Every single & array form, unsized & sized, is replaced as a matching pair, so no block allocated by one is freed
+ * by another; the nothrow forms of the standard library forward to these. The unsized new & delete are kept out of
+ * line, so the compiler pairs each new with a delete rather than a malloc () or free () inlined from one of them.
+ */
+[[gnu::noinline]] void *operator new (size_t size) {
+
+    allocCount.fetch_add (1, std::memory_order_relaxed);
+    allocBytes.fetch_add (size, std::memory_order_relaxed);
+    if (void *block = std::malloc (size ? size : 1)) { return block; }
+    throw std::bad_alloc ();
+
+} /* End of operator new () */
+
+void *operator new [] (size_t size) { return operator new (size); }
+[[gnu::noinline]] void operator delete (void *block) noexcept { std::free (block); }
+void operator delete (void *block, size_t) noexcept { operator delete (block); }
+void operator delete [] (void *block) noexcept { operator delete (block); }
+void operator delete [] (void *block, size_t) noexcept { operator delete (block); }
+
+
+/*
+ * This function runs the benchmark loop and attaches the allocations per operation to the report.
+ * :arg: state, benchmark state of the running benchmark.
+ * :arg: body, callable run once per iteration.
+ */
+template <typename Body>
+static void CountAllocations (benchmark::State &state, Body &&body) {
+
+    size_t count = allocCount.load (std::memory_order_relaxed);
+    size_t bytes = allocBytes.load (std::memory_order_relaxed);
+    for (auto _ : state) { body (); }
+    state.counters ["allocs/op"] = benchmark::Counter (allocCount.load (std::memory_order_relaxed) - count,
+                                                        benchmark::Counter::kAvgIterations);
+    state.counters ["bytes/op"] = benchmark::Counter (allocBytes.load (std::memory_order_relaxed) - bytes,
+                                                       benchmark::Counter::kAvgIterations);
+
+} /* End of CountAllocations () */
+
+
+/*
+ * Rendering of the compiled deep scan template, repeated range(0) times to model longer user supplied command
+ * templates.
+ */
+static void BM_RenderCommand (benchmark::State &state) {
+
+    std::string command;
+    std::string error;
+    for (int index = 0; index < state.range (0); index++) { command += BASE_NMAP_DEEP + " "; }
+    CommandTemplate compiled;
+    compiled.Compile (command, 1U << SLOT_ID | 1U << SLOT_XML_FILE | 1U << SLOT_TARGET, error);
+    CommandValues values;
+    values [SLOT_ID] = {"8443"};
+    values [SLOT_XML_FILE] = {DIR_PORTS + "8443.xml"};
+    values [SLOT_TARGET] = {"192.168.100.254"};
+    CountAllocations (state, [&]() { benchmark::DoNotOptimize (compiled.Render (values)); });
+    state.SetBytesProcessed (state.iterations () * command.size ());
+
+} /* End of BM_RenderCommand () */
+BENCHMARK (BM_RenderCommand)->Arg (1)->Arg (8)->Arg (64);
+
+
+/*
+ * A log line written to the log file only, with an optional message of range(0) bytes.
+ */
+static void BM_LoggerLogFile (benchmark::State &state) {
+
+    Logger benchLog (MICRO_LOG);
+    std::stringstream optional;
+    optional << std::string (state.range (0), 'x');
+    CountAllocations (state, [&]() { benchLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, false, optional); });
+
+} /* End of BM_LoggerLogFile () */
+BENCHMARK (BM_LoggerLogFile)->Arg (0)->Arg (128)->Arg (1024);
+
+
+/*
+ * A log line written to both the log file and the console, with the console discarded.
+ */
+static void BM_LoggerLogConsole (benchmark::State &state) {
+
+    Logger benchLog (MICRO_LOG);
+    std::stringstream optional;
+    optional << std::string (state.range (0), 'x');
+    std::ofstream discard ("/dev/null");
+    std::streambuf *console = std::cout.rdbuf (discard.rdbuf ());
+    CountAllocations (state, [&]() { benchLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, true, optional); });
+    std::cout.rdbuf (console);
+
+} /* End of BM_LoggerLogConsole () */
+BENCHMARK (BM_LoggerLogConsole)->Arg (0)->Arg (128)->Arg (1024);
+
+
+/*
+ * Timestamp formatting done for every log line.
+ */
+static void BM_GetCurrentTime (benchmark::State &state) {
+
+    CountAllocations (state, [&]() { benchmark::DoNotOptimize (GetCurrentTime ()); });
+
+} /* End of BM_GetCurrentTime () */
+BENCHMARK (BM_GetCurrentTime);
+
+
+/*
+ * Message lookup done for every log line.
+ */
+static void BM_GetReturnMessage (benchmark::State &state) {
+
+    CountAllocations (state, [&]() { benchmark::DoNotOptimize (GetReturnMessage (NMAP_SCRIPT_PASS)); });
+
+} /* End of BM_GetReturnMessage () */
+BENCHMARK (BM_GetReturnMessage);
+
+
+/*
+ * Filling a host with range(0) ports, as done after an open ports scan. Reported per port.
+ */
+static void BM_AddPortToHost (benchmark::State &state) {
+
+    std::vector <Port> ports;
+    for (int index = 0; index < state.range (0); index++) {
+        ports.emplace_back (std::to_string (index + 1), index % 8 ? "open" : "filtered", "svc");
+    }
+    CountAllocations (state, [&]() {
+        Host host ("192.168.100.254");
+        for (const auto &port : ports) { host.AddPortToHost (port); }
+        benchmark::ClobberMemory ();
+    });
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+
+} /* End of BM_AddPortToHost () */
+BENCHMARK (BM_AddPortToHost)->Arg (10)->Arg (1000)->Arg (65535)->Unit (benchmark::kMicrosecond);
+
+
+/*
+ * Parsing a deep scan XML document with scripts of range(0) bytes and extracting its results into the port.
+ */
+static void BM_ExtractScriptResults (benchmark::State &state) {
+
+    std::string xml = FakeDeepXML ("192.168.100.254", "22", state.range (0));
+    SignatureEngine signatures;
+    Logger portLog (MICRO_LOG);
+    CountAllocations (state, [&]() {
+        Port port ("22", "open", "ssh");
+        pugi::xml_document document;
+        document.load_buffer (xml.data (), xml.size ());
+        port.ExtractScriptResults (document.child ("nmaprun").child ("host"), portLog, signatures);
+        benchmark::DoNotOptimize (port.findings.data ());
+    });
+    state.SetBytesProcessed (state.iterations () * xml.size ());
+
+} /* End of BM_ExtractScriptResults () */
+BENCHMARK (BM_ExtractScriptResults)->Arg (512)->Arg (4096)->Arg (65536)->Unit (benchmark::kMicrosecond);
+
+
+int main (int argCount, char **values) {
+
+    std::string error;
+    if (InitializeDirectories ({DIR_BASE, DIR_LOGS, DIR_PORTS}, error) != WORK_DIRS_PASS) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+    benchmark::Initialize (&argCount, values);
+    if (benchmark::ReportUnrecognizedArguments (argCount, values)) { return 1; }
+    benchmark::RunSpecifiedBenchmarks ();
+    benchmark::Shutdown ();
+    return 0;
+
+} /* End of main () */
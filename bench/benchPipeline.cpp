@@ -0,0 +1,144 @@
+/*
+ ***********************************************************************************************************************
+ * File: benchPipeline.cpp
+ * Description: This file contains the end-to-end benchmark of the scan pipeline, GetOpenPorts, PrintOpenScanSummary,
+ *              MultitreadedNMAPScript and PrintDeepScanSummary, run against the fakeNmap stand-in so it needs no
+ *              network. Console output of the pipeline is discarded while timing. Results are printed as CSV, one row
+ *              per phase, and optionally appended to a file so runs can be compared.
+ * Functions:
+ *           void Usage ()
+ *           double Percentile ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <unistd.h>
+#include "logger.hpp"
+#include "scanner.hpp"
+#include "utilities.hpp"
+
+#ifndef FAKE_NMAP_PATH
+#define FAKE_NMAP_PATH "fakeNmap"
+#endif
+
+const std::string BENCH_TARGET = "127.0.0.1";
+const std::string BENCH_BIN = DIR_BASE + "Bench/";
+const std::string CSV_HEADER = "benchmark,ports,filtered,script_bytes,latency_ms,deep_latency_ms,threads,phase,"
+                               "iterations,min_ms,median_ms,mean_ms,max_ms";
+
+
+/*
+ * This function prints usage instructions of the benchmark and exits.
+ */
+static void Usage () {
+
+    std::cerr << "Usage: benchPipeline [--ports N] [--filtered N] [--script-bytes N] [--latency-ms N]\n"
+              << "                     [--deep-latency-ms N] [--threads N] [--iterations N] [--output <csv file>]\n"
+              << "                     [--fake-nmap <path>]" << std::endl;
+    exit (-1);
+
+} /* End of Usage () */
+
+
+/*
+ * This function returns the given percentile of the samples.
+ * :arg: samples, vector of doubles, sorted in place.
+ * :arg: percentile, double between 0 and 1.
+ * :return: double holding the sample at the percentile.
+ */
+static double Percentile (std::vector <double> &samples, double percentile) {
+
+    std::sort (samples.begin (), samples.end ());
+    return samples [static_cast <size_t> (percentile * (samples.size () - 1) + 0.5)];
+
+} /* End of Percentile () */
+
+
+int main (int argCount, char **values) {
+
+    std::map <std::string, int> settings = {
+        {"--ports", 10}, {"--filtered", 2}, {"--script-bytes", 512}, {"--latency-ms", 0}, {"--deep-latency-ms", 0},
+        {"--threads", MAX_THREADS}, {"--iterations", 5},
+    };
+    std::string outputFile;
+    std::string fakeNmap = FAKE_NMAP_PATH;
+    for (int index = 1; index < argCount; index++) {
+        std::string flag = values [index];
+        if (index + 1 >= argCount) { Usage (); }
+        if (flag == "--output") { outputFile = values [++index]; }
+        else if (flag == "--fake-nmap") { fakeNmap = values [++index]; }
+        else if (settings.count (flag)) { settings [flag] = std::max (0, atoi (values [++index])); }
+        else { Usage (); }
+    }
+    settings ["--iterations"] = std::max (1, settings ["--iterations"]);
+
+    /* Put the stand-in first on PATH under the name the command templates use */
+    std::string error;
+    if (InitializeDirectories ({DIR_BASE, DIR_LOGS, DIR_PORTS, BENCH_BIN}, error) != WORK_DIRS_PASS) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+    std::string link = BENCH_BIN + "nmap";
+    unlink (link.c_str ());
+    if (symlink (std::filesystem::absolute (fakeNmap).c_str (), link.c_str ()) != 0) {
+        std::cerr << "Linking " << fakeNmap << " as " << link << " has failed." << std::endl;
+        return -1;
+    }
+    setenv ("PATH", (BENCH_BIN + ":" + getenv ("PATH")).c_str (), 1);
+    setenv ("PH_FAKE_PORTS", std::to_string (settings ["--ports"]).c_str (), 1);
+    setenv ("PH_FAKE_FILTERED", std::to_string (settings ["--filtered"]).c_str (), 1);
+    setenv ("PH_FAKE_SCRIPT_BYTES", std::to_string (settings ["--script-bytes"]).c_str (), 1);
+    setenv ("PH_FAKE_LATENCY_MS", std::to_string (settings ["--latency-ms"]).c_str (), 1);
+    setenv ("PH_FAKE_DEEP_LATENCY_MS", std::to_string (settings ["--deep-latency-ms"]).c_str (), 1);
+
+    const std::vector <std::string> phases = {"GetOpenPorts", "PrintOpenScanSummary", "MultitreadedNMAPScript",
+                                              "PrintDeepScanSummary", "Total"};
+    std::map <std::string, std::vector <double>> samples;
+    std::ofstream discard ("/dev/null");
+    Logger benchLog (DIR_LOGS + "PH_Bench.log");
+    for (int iteration = 0; iteration < settings ["--iterations"]; iteration++) {
+        Host host (BENCH_TARGET);
+        std::streambuf *console = std::cout.rdbuf (discard.rdbuf ());
+        auto timed = [&](const std::string &phase, const std::function <void ()> &body) {
+            auto start = std::chrono::steady_clock::now ();
+            body ();
+            std::chrono::duration <double, std::milli> elapsed = std::chrono::steady_clock::now () - start;
+            samples [phase].push_back (elapsed.count ());
+        };
+        timed ("Total", [&]() {
+            timed ("GetOpenPorts", [&]() { host.GetOpenPorts (benchLog, interruptToken); });
+            timed ("PrintOpenScanSummary", [&]() { host.PrintOpenScanSummary (benchLog); });
+            timed ("MultitreadedNMAPScript", [&]() {
+                host.MultitreadedNMAPScript (benchLog, interruptToken, std::max (1, settings ["--threads"]));
+            });
+            timed ("PrintDeepScanSummary", [&]() { host.PrintDeepScanSummary (benchLog); });
+        });
+        std::cout.rdbuf (console);
+    }
+
+    std::stringstream rows;
+    for (const auto &phase : phases) {
+        std::vector <double> &phaseSamples = samples [phase];
+        double mean = std::accumulate (phaseSamples.begin (), phaseSamples.end (), 0.0) / phaseSamples.size ();
+        rows << "pipeline," << settings ["--ports"] << "," << settings ["--filtered"] << ","
+             << settings ["--script-bytes"] << "," << settings ["--latency-ms"] << "," << settings ["--deep-latency-ms"]
+             << "," << settings ["--threads"] << "," << phase << "," << phaseSamples.size () << "," << std::fixed
+             << std::setprecision (3) << Percentile (phaseSamples, 0.0) << "," << Percentile (phaseSamples, 0.5) << ","
+             << mean << "," << Percentile (phaseSamples, 1.0) << "\n";
+    }
+    std::cout << CSV_HEADER << "\n" << rows.str ();
+    if (!outputFile.empty ()) {
+        bool fresh = !std::filesystem::exists (outputFile);
+        std::ofstream csv (outputFile, std::ios::app);
+        if (fresh) { csv << CSV_HEADER << "\n"; }
+        csv << rows.str ();
+    }
+    return 0;
+
+} /* End of main () */
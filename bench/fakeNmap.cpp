@@ -0,0 +1,147 @@
+/*
+ ***********************************************************************************************************************
+ * File: fakeNmap.cpp
+ * Description: This file contains a stand-in for the nmap executable, used to benchmark the scan pipeline on a machine
+ *              without network access. It accepts the command lines PortHawk builds, sleeps for the configured latency
+ *              and writes synthetic "nmaprun" XML to the file given by -oX. It is configured through the environment:
+ *                  PH_FAKE_HOSTS            number of <host> nodes written by a discovery scan (default 1)
+ *                  PH_FAKE_PORTS            number of open ports per host (default 10)
+ *                  PH_FAKE_FILTERED         number of filtered ports per host (default 2)
+ *                  PH_FAKE_SCRIPT_BYTES     size of each script's output in a deep scan (default 512)
+ *                  PH_FAKE_LATENCY_MS       latency of a discovery scan (default 0)
+ *                  PH_FAKE_DEEP_LATENCY_MS  latency of a deep scan (default 0)
+ * Functions:
+ *           int EnvInt ()
+ *           bool InPortSpec ()
+ *           void WriteDiscovery ()
+ *           void WriteDeep ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fakeXml.hpp"
+
+const int FAKE_BASE_PORT = 20;
+const int FAKE_PORT_STRIDE = 37;
+
+
+/*
+ * This function reads an integer from the environment.
+ * :arg: name, const char pointer holding the name of the variable.
+ * :arg: fallback, integer returned when the variable is not set.
+ * :return: integer value of the variable.
+ */
+static int EnvInt (const char *name, int fallback) {
+
+    const char *value = std::getenv (name);
+    return value ? std::atoi (value) : fallback;
+
+} /* End of EnvInt () */
+
+
+/*
+ * This function checks whether a port falls within an nmap port specification, e.g. "-", "22,80" or "1-1024,8080".
+ * :arg: spec, const string holding the port specification.
+ * :arg: port, integer holding the port.
+ * :return: bool value indicating whether the port is covered by the specification.
+ */
+static bool InPortSpec (const std::string &spec, int port) {
+
+    if (spec.empty () || spec == "-") { return true; }
+    std::stringstream ranges (spec);
+    std::string range;
+    while (std::getline (ranges, range, ',')) {
+        size_t dash = range.find ('-');
+        int low = (dash == 0) ? 1 : std::atoi (range.c_str ());
+        int high = (dash == std::string::npos) ? low : (dash + 1 == range.size ()) ? 65535
+                                                                                    : std::atoi (range.c_str () + dash + 1);
+        if (port >= low && port <= high) { return true; }
+    }
+    return false;
+
+} /* End of InPortSpec () */
+
+
+/*
+ * This function writes the XML of an open ports discovery scan.
+ * :arg: output, ofstream to which the XML is written.
+ * :arg: target, const string holding the scanned target.
+ * :arg: spec, const string holding the port specification.
+ * :arg: excluded, const string holding the specification of the ports excluded, empty if none.
+ */
+static void WriteDiscovery (std::ofstream &output, const std::string &target, const std::string &spec,
+                            const std::string &excluded) {
+
+    int hosts = EnvInt ("PH_FAKE_HOSTS", 1);
+    int open = EnvInt ("PH_FAKE_PORTS", 10);
+    int filtered = EnvInt ("PH_FAKE_FILTERED", 2);
+    output << "<?xml version=\"1.0\"?>\n<nmaprun scanner=\"nmap\" args=\"fake\">\n";
+    for (int host = 0; host < hosts; host++) {
+        output << "<host><status state=\"up\"/><address addr=\"" << (host ? "10.0.0." + std::to_string (host) : target)
+               << "\" addrtype=\"ipv4\"/>\n<ports>\n";
+        for (int index = 0; index < open + filtered; index++) {
+            int port = FAKE_BASE_PORT + index * FAKE_PORT_STRIDE;
+            if (port > 65535 || !InPortSpec (spec, port) || (!excluded.empty () && InPortSpec (excluded, port))) {
+                continue;
+            }
+            output << "<port protocol=\"tcp\" portid=\"" << port << "\"><state state=\""
+                   << (index < open ? "open" : "filtered") << "\" reason=\"syn-ack\"/><service name=\"svc" << port
+                   << "\" method=\"table\" conf=\"3\"/></port>\n";
+        }
+        output << "</ports>\n</host>\n";
+    }
+    output << "<runstats><finished exit=\"success\"/></runstats>\n</nmaprun>\n";
+
+} /* End of WriteDiscovery () */
+
+
+/*
+ * This function writes the XML of a deep script scan of a single port.
+ * :arg: output, ofstream to which the XML is written.
+ * :arg: target, const string holding the scanned target.
+ * :arg: spec, const string holding the port.
+ */
+static void WriteDeep (std::ofstream &output, const std::string &target, const std::string &spec) {
+
+    output << FakeDeepXML (target, spec, EnvInt ("PH_FAKE_SCRIPT_BYTES", 512));
+
+} /* End of WriteDeep () */
+
+
+int main (int argCount, char **values) {
+
+    std::string xmlFile;
+    std::string spec;
+    std::string excluded;
+    bool deep = false;
+    std::vector <std::string> args (values + 1, values + argCount);
+    for (size_t index = 0; index < args.size (); index++) {
+        if (args [index] == "-oX" && index + 1 < args.size ()) { xmlFile = args [++index]; }
+        else if (args [index] == "-p" && index + 1 < args.size ()) { spec = args [++index]; }
+        else if (args [index] == "--exclude-ports" && index + 1 < args.size ()) { excluded = args [++index]; }
+        else if (args [index] == "-sV" || args [index].rfind ("--script", 0) == 0) { deep = true; }
+    }
+    if (xmlFile.empty () || args.empty ()) {
+        std::cerr << "fakeNmap: -oX <file> and a target are required" << std::endl;
+        return 1;
+    }
+
+    int latency = deep ? EnvInt ("PH_FAKE_DEEP_LATENCY_MS", 0) : EnvInt ("PH_FAKE_LATENCY_MS", 0);
+    std::this_thread::sleep_for (std::chrono::milliseconds (latency));
+    std::ofstream output (xmlFile, std::ios::trunc);
+    if (deep) { WriteDeep (output, args.back (), spec); }
+    else { WriteDiscovery (output, args.back (), spec, excluded); }
+    std::cout << "Nmap done: 1 IP address (1 host up) scanned" << std::endl;
+    return output ? 0 : 1;
+
+} /* End of main () */
@@ -0,0 +1,54 @@
+/*
+ ***********************************************************************************************************************
+ * File: fakeXml.hpp
+ * Description: This file contains the generator of synthetic NMAP deep scan XML, shared by the fakeNmap stand-in and
+ *              the microbenchmarks so both exercise the same document shape.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_FAKEXML_HPP
+#define PORTHAWK_FAKEXML_HPP
+
+#include <sstream>
+#include <string>
+
+
+/*
+ * This function generates the XML of a deep script scan of a single port, with a vulnerable service, two CPEs, two
+ * scripts carrying both text output and NSE tables, and a host script.
+ * :arg: target, const string holding the scanned target.
+ * :arg: port, const string holding the port.
+ * :arg: scriptBytes, integer denoting the approximate size of each script's text output.
+ * :return: string holding the XML document.
+ */
+inline std::string FakeDeepXML (const std::string &target, const std::string &port, int scriptBytes) {
+
+    std::string filler = "  Synthetic script output line for benchmarking the parser.&#xa;";
+    std::string text;
+    std::stringstream output;
+    text.reserve (scriptBytes + 128);
+    while (static_cast <int> (text.size ()) < scriptBytes) { text += filler; }
+    text += "  VULNERABLE:&#xa;  State: VULNERABLE&#xa;  IDs: CVE:CVE-2023-38408";
+
+    output << "<?xml version=\"1.0\"?>\n<nmaprun scanner=\"nmap\" args=\"fake\">\n<host><status state=\"up\"/>"
+           << "<address addr=\"" << target << "\" addrtype=\"ipv4\"/>\n<ports>\n<port protocol=\"tcp\" portid=\"" << port
+           << "\"><state state=\"open\" reason=\"syn-ack\"/><service name=\"ssh\" product=\"OpenSSH\" "
+           << "version=\"8.9p1 Ubuntu 3ubuntu0.1\" extrainfo=\"Ubuntu Linux; protocol 2.0\" ostype=\"Linux\" "
+           << "method=\"probed\" conf=\"10\"><cpe>cpe:/a:openbsd:openssh:8.9p1</cpe><cpe>cpe:/o:linux:linux_kernel</cpe>"
+           << "</service>\n<script id=\"fake-vuln\" output=\"" << text << "\"><table key=\"CVE-2023-38408\">"
+           << "<elem key=\"title\">Synthetic vulnerability</elem><elem key=\"state\">VULNERABLE</elem>"
+           << "<table key=\"ids\"><elem>CVE:CVE-2023-38408</elem></table><table key=\"refs\">"
+           << "<elem>https://example.invalid/CVE-2023-38408</elem></table></table></script>\n"
+           << "<script id=\"vulners\" output=\"" << text << "\"><table key=\"cpe:/a:openbsd:openssh:8.9p1\">"
+           << "<table><elem key=\"id\">CVE-2023-38408</elem><elem key=\"cvss\">9.8</elem></table>"
+           << "<table><elem key=\"id\">CVE-2023-28531</elem><elem key=\"cvss\">9.8</elem></table></table></script>\n"
+           << "</port>\n</ports>\n<hostscript><script id=\"fake-host\" output=\"host\"><table key=\"CVE-2017-0143\">"
+           << "<elem key=\"title\">Synthetic host vulnerability</elem><elem key=\"state\">LIKELY VULNERABLE</elem>"
+           << "</table></script></hostscript>\n</host>\n<runstats><finished exit=\"success\"/></runstats>\n</nmaprun>\n";
+    return output.str ();
+
+} /* End of FakeDeepXML () */
+
+#endif
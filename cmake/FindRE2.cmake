@@ -0,0 +1,25 @@
+# Finds RE2 and provides it as the imported target RE2::re2, so neither the build nor the exported package of a
+# static libporthawk records the path RE2 has on the machine it was built on. RE2's own package configuration is used
+# when installed, the headers & library are looked up otherwise (Debian's libre2-dev ships no CMake files).
+find_package (re2 CONFIG QUIET)
+if (re2_FOUND AND TARGET re2::re2)
+    set (RE2_LIBRARY re2::re2)
+    get_target_property (RE2_INCLUDE_DIR re2::re2 INTERFACE_INCLUDE_DIRECTORIES)
+else ()
+    find_path (RE2_INCLUDE_DIR re2/set.h)
+    find_library (RE2_LIBRARY re2)
+endif ()
+
+include (FindPackageHandleStandardArgs)
+find_package_handle_standard_args (RE2 REQUIRED_VARS RE2_LIBRARY RE2_INCLUDE_DIR)
+mark_as_advanced (RE2_INCLUDE_DIR RE2_LIBRARY)
+
+if (RE2_FOUND AND NOT TARGET RE2::re2)
+    add_library (RE2::re2 INTERFACE IMPORTED)
+    if (TARGET re2::re2)
+        set_target_properties (RE2::re2 PROPERTIES INTERFACE_LINK_LIBRARIES re2::re2)
+    else ()
+        set_target_properties (RE2::re2 PROPERTIES INTERFACE_INCLUDE_DIRECTORIES "${RE2_INCLUDE_DIR}"
+                               INTERFACE_LINK_LIBRARIES "${RE2_LIBRARY}")
+    endif ()
+endif ()
@@ -0,0 +1,43 @@
+/*
+ ***********************************************************************************************************************
+ * File: banner.hpp
+ * Description: This file contains declarations of constants, data structures & functions associated with banner
+ *              grabbing, which identifies the services that announce themselves (SSH, FTP, SMTP, POP3, IMAP, VNC,
+ *              MySQL, ...) from the first bytes they send, without an NMAP child.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_BANNER_HPP
+#define PORTHAWK_BANNER_HPP
+
+#include <regex>
+#include "eventloop.hpp"
+
+class Port;
+
+const int BANNER_TIMEOUT_MS = 2000;
+/* Once the first bytes are in, the rest of a banner is given this long to follow */
+const int BANNER_LINGER_MS = 100;
+const size_t BANNER_MAX_BYTES = 1024;
+const size_t BANNER_KEEP_BYTES = 160;
+const int BANNER_CONCURRENCY = 256;
+
+/* Identifies a service from its banner. Groups of the pattern, when non-zero, hold the product, version & extra info */
+struct BannerRule {
+    std::string service;
+    std::string product;
+    std::regex pattern;
+    int productGroup;
+    int versionGroup;
+    int extraGroup;
+};
+
+/* Function Declarations */
+Task <int> ConnectTCP (EventLoop &loop, const std::string &address, const std::string &portid, int timeoutMs);
+Task <std::string> GrabBanner (EventLoop &loop, const std::string &address, const std::string &portid, int timeoutMs);
+bool MatchBanner (const std::string &banner, Port &port);
+std::string PrintableBanner (const std::string &banner);
+
+#endif
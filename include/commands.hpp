@@ -0,0 +1,86 @@
+/*
+ ***********************************************************************************************************************
+ * File: commands.hpp
+ * Description: This file contains declarations of constants, data structures, classes & member functions associated
+ *              with the command templates the NMAP children are spawned from. A template is compiled once into the
+ *              words of an argument vector, each a run of literal text and slots, and is validated against the slots
+ *              its command is given, so a template naming an unknown or a missing slot is rejected when loaded rather
+ *              than run. Rendering only copies literals & slot values into the argument vector handed to the process
+ *              runner, with no shell in between. Templates of PH/commands.conf override the built-in ones.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_COMMANDS_HPP
+#define PORTHAWK_COMMANDS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "logger.hpp"
+
+const std::string BASE_NMAP_OPEN = "nmap -Pn -T4 -sT --min-rate=2000 $ports -oX $xmlFile $target";
+const std::string BASE_NMAP_DEEP = "nmap -sT -sV -sC --script=vuln -p $id -oX $xmlFile $target";
+/* Script scan of a port whose version has already been detected natively */
+const std::string BASE_NMAP_SCRIPT = "nmap -sT -sC --script=vuln -p $id -oX $xmlFile $target";
+const std::string BASE_NMAP_DEEP_UDP = "nmap -sU -sV -sC --script=vuln -p $id -oX $xmlFile $target";
+
+/* User-defined templates, one "<name> = <template>" per line, lines starting with '#' are comments */
+const std::string COMMANDS_FILE = DIR_BASE + "commands.conf";
+
+/* Slots a value is rendered into, named "$name" or "${name}" in a template */
+enum CommandSlot : uint8_t {
+    SLOT_TARGET,
+    SLOT_XML_FILE,
+    SLOT_PORTS,
+    SLOT_ID,
+    SLOT_COUNT,
+};
+
+/* Commands spawned by the scan, each rendered from a template of its own */
+enum CommandKind : uint8_t {
+    COMMAND_NMAP_OPEN,
+    COMMAND_NMAP_DEEP,
+    COMMAND_NMAP_SCRIPT,
+    COMMAND_NMAP_DEEP_UDP,
+    COMMAND_COUNT,
+};
+
+/* Values of the slots, a slot making up a whole word is rendered as an argument per value, e.g. "-p" "1-1024", while
+ * one within a word is rendered as its values joined by commas */
+using CommandValues = std::array <std::vector <std::string>, SLOT_COUNT>;
+
+/* A run of literal text, followed by the slot rendered after it, if any */
+struct CommandSegment {
+    std::string literal;
+    int slot = -1;
+};
+
+/* CommandTemplate class */
+class CommandTemplate {
+    private:
+        std::string text;
+        std::vector <std::vector <CommandSegment>> words;
+    public:
+        bool Compile (const std::string &source, uint32_t slots, std::string &error);
+        std::vector <std::string> Render (const CommandValues &values) const;
+        const std::string &Text () const;
+
+}; /* End of class CommandTemplate */
+
+/* CommandTemplates class */
+/* Read-only once loaded, so the templates may be rendered by any thread. Each engine loads a set of its own. */
+class CommandTemplates {
+    private:
+        std::array <CommandTemplate, COMMAND_COUNT> templates;
+    public:
+        CommandTemplates ();
+        ReturnCodes Load (const std::string &fileName, Logger objLog);
+        std::vector <std::string> Render (CommandKind kind, const CommandValues &values) const;
+        const CommandTemplate &Get (CommandKind kind) const;
+
+}; /* End of class CommandTemplates */
+
+#endif
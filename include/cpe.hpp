@@ -0,0 +1,67 @@
+/*
+ ***********************************************************************************************************************
+ * File: cpe.hpp
+ * Description: This file contains declarations of data structures, support functions, classes & member functions
+ *              associated with parsing, normalising, interning and indexing CPE names reported by NMAP.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_CPE_HPP
+#define PORTHAWK_CPE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const uint32_t CPE_ANY = 0;
+const int CPE_COMPONENTS = 4;
+
+/* Normalised CPE name, every component is an interned string id with CPE_ANY for an unspecified component */
+struct CPE {
+    char part = 0;
+    uint32_t vendor = CPE_ANY;
+    uint32_t product = CPE_ANY;
+    uint32_t version = CPE_ANY;
+    uint32_t update = CPE_ANY;
+    std::string ToString () const;
+    bool operator== (const CPE &other) const;
+};
+
+/* Reference to a port of a scanned host */
+struct PortRef {
+    std::string address;
+    std::string portid;
+};
+
+/* Function Declarations */
+uint32_t InternString (const std::string &value);
+bool FindInterned (const std::string &value, uint32_t &id);
+const std::string InternedString (uint32_t id);
+bool ParseCPE (const std::string &name, CPE &cpe, int &depth, bool intern = true);
+
+/* CPEIndex class */
+/* Maps every prefix of every CPE seen on a port (part, vendor, product, version, update) to the ports carrying it. */
+class CPEIndex {
+    private:
+        struct Key {
+            uint8_t depth;
+            char part;
+            uint32_t ids [CPE_COMPONENTS];
+            bool operator== (const Key &other) const;
+        };
+        struct KeyHash {
+            size_t operator() (const Key &key) const;
+        };
+        std::unordered_map <Key, std::vector <PortRef>, KeyHash> prefixes;
+        mutable std::mutex mtx;
+    public:
+        void Add (const std::string &address, const std::string &portid, const CPE &cpe);
+        std::vector <PortRef> Find (const std::string &prefix) const;
+
+}; /* End of class CPEIndex */
+
+#endif
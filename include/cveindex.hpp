@@ -0,0 +1,103 @@
+/*
+ ***********************************************************************************************************************
+ * File: cveindex.hpp
+ * Description: This file contains declarations of constants, on-disk data structures, class & member functions
+ *              associated with the offline CVE index, which maps product & version to known vulnerabilities.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_CVEINDEX_HPP
+#define PORTHAWK_CVEINDEX_HPP
+
+#include <cstdint>
+#include "logger.hpp"
+#include "scanner.hpp"
+
+const std::string CVE_INDEX_FILE = DIR_BASE + "CVE.idx";
+const char CVE_INDEX_MAGIC [8] = {'P', 'H', 'C', 'V', 'E', 'I', 'X', '1'};
+const int VERSION_PARTS = 8;
+
+/* Range flags */
+const uint16_t RANGE_START_EXCL = 0x1;
+const uint16_t RANGE_END_EXCL   = 0x2;
+
+/*
+ * On-disk layout, all records are fixed size and naturally aligned so the file is used in place once mapped:
+ *     CVEIndexHeader | TrieNode [nodeCount] | TrieEdge [edgeCount] | CVEEntry [entryCount] | char strings []
+ * The trie is keyed on the CPE product name, each node owns a run of entries sorted by the end of their version range.
+ */
+struct VersionKey {
+    uint32_t parts [VERSION_PARTS];
+};
+
+struct CVEIndexHeader {
+    char magic [8];
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t entryCount;
+    uint32_t stringBytes;
+};
+
+struct TrieNode {
+    uint32_t firstEdge;
+    uint32_t edgeCount;
+    uint32_t firstEntry;
+    uint32_t entryCount;
+};
+
+struct TrieEdge {
+    uint32_t label;
+    uint32_t child;
+};
+
+struct CVEEntry {
+    VersionKey start;
+    VersionKey end;
+    uint32_t vendor;
+    uint32_t cveNumber;
+    uint16_t cveYear;
+    uint16_t flags;
+    uint16_t score;
+    uint16_t reserved;
+};
+
+/* A single known vulnerability matched against a product & version */
+struct CVEMatch {
+    std::string cve;
+    float score;
+};
+
+/* Function Declarations */
+VersionKey ParseVersion (const std::string &version);
+int CompareVersions (const VersionKey &left, const VersionKey &right);
+std::string NormaliseProduct (const std::string &product);
+ReturnCodes BuildCVEIndex (const std::string &feedFile, const std::string &indexFile, Logger objLog);
+
+/* CVEIndex class */
+/* Read-only view of a mapped index file, safe to share across threads. */
+class CVEIndex {
+    private:
+        void *mapping;
+        size_t mappingSize;
+        const CVEIndexHeader *header;
+        const TrieNode *nodes;
+        const TrieEdge *edges;
+        const CVEEntry *entries;
+        const char *strings;
+        const TrieNode *FindProduct (const std::string &product) const;
+    public:
+        CVEIndex ();
+        ~CVEIndex ();
+        CVEIndex (const CVEIndex &) = delete;
+        CVEIndex &operator= (const CVEIndex &) = delete;
+        ReturnCodes Open (const std::string &indexFile, Logger objLog);
+        bool IsOpen () const;
+        std::vector <CVEMatch> Lookup (const std::string &product, const std::string &version,
+                                       const std::string &vendor = "") const;
+        size_t MatchPorts (const std::vector <Port *> &ports) const;
+
+}; /* End of class CVEIndex */
+
+#endif
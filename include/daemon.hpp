@@ -0,0 +1,107 @@
+/*
+ ***********************************************************************************************************************
+ * File: daemon.hpp
+ * Description: This file contains declarations of constants, data structures, classes & member functions associated
+ *              with the long running scan daemon, which takes scan jobs over a local Unix socket.
+ *
+ *              Requests are single lines of space separated words, responses are tab separated lines:
+ *                  SUBMIT <target> [profile]   OK <job id> [cached]
+ *                  STATUS <job id>             OK <job id> <target> <profile> <state> <ports scanned>/<ports>
+ *                  LIST                        a STATUS line per job, then END
+ *                  RESULTS <job id>            a PORT line per result as soon as it is known, then END <state>
+ *                  CANCEL <job id>             OK <job id>
+ *                  SHUTDOWN                    OK
+ *              Errors are answered with ERR <message>. PORT lines hold the port id, state, service, product,
+ *              version, severity, CVEs reported by NMAP & known CVEs from the offline index.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_DAEMON_HPP
+#define PORTHAWK_DAEMON_HPP
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include "engine.hpp"
+
+const std::string DAEMON_SOCKET = DIR_BASE + "portHawk.sock";
+const std::string LOG_DAEMON = DIR_LOGS + "PH_Daemon.log";
+const int RESULT_TTL_SECONDS = 600;
+const int RESOLVED_TTL_SECONDS = 300;
+const size_t REQUEST_MAX = 4096;
+
+enum JobState : uint8_t {
+    JOB_QUEUED,
+    JOB_DISCOVERY,
+    JOB_DEEP_SCAN,
+    JOB_DONE,
+    JOB_FAILED,
+    JOB_CANCELLED,
+};
+
+/* A scan job and the results it has produced so far */
+struct Job {
+    uint32_t id = 0;
+    std::string target;
+    std::string address;
+    std::string profile;
+    JobState state = JOB_QUEUED;
+    size_t portsTotal = 0;
+    size_t portsDone = 0;
+    std::vector <std::string> results;
+    CancelToken token;
+    time_t finished = 0;
+};
+
+/* An address a target has been resolved to, and when */
+struct ResolvedAddress {
+    std::string address;
+    time_t resolved = 0;
+};
+
+/* A request line split into its words, the job id given as a number */
+struct DaemonRequest {
+    std::string verb;
+    std::string target;
+    std::string profile;
+    uint32_t id = 0;
+};
+
+/* Function Declarations */
+bool ParseRequest (const std::string &line, DaemonRequest &request, std::string &error);
+
+/* ScanDaemon class */
+/* Jobs are run by an engine of the daemon's own, the daemon being one of its sinks */
+class ScanDaemon : public ResultSink {
+    private:
+        std::string socketPath;
+        Logger daemonLog;
+        std::unique_ptr <ScanEngine> engine;
+        std::mutex mtx;
+        std::condition_variable changed;
+        std::map <uint32_t, std::shared_ptr <Job>> jobs;
+        std::deque <uint32_t> queue;
+        std::unordered_map <std::string, ResolvedAddress> resolved;
+        std::vector <int> clients;
+        Job *current;
+        uint32_t nextId;
+        bool stopping;
+        void RunJobs ();
+        void RunJob (Job &job);
+        void PruneExpired ();
+        void ServeClient (int fd);
+        bool HandleRequest (int fd, const std::string &request);
+        std::string FormatStatus (const Job &job) const;
+    public:
+        ScanDaemon (const std::string &path);
+        ReturnCodes Run (const CancelToken &token);
+        void PortsDiscovered (const Host &host) override;
+        void PortScanned (const std::string &address, const Port &port) override;
+
+}; /* End of class ScanDaemon */
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ ***********************************************************************************************************************
+ * File: discovery.hpp
+ * Description: This file contains declarations of constants, data structures, classes & functions associated with the
+ *              native discovery sweep, an in-process TCP connect scan run on the event loop. Its sending is governed by
+ *              a congestion controller per target network: the window of probes in flight grows additively with each
+ *              response and is halved on loss, i.e. a probe left unanswered, while probes are paced at window / RTT so
+ *              they leave evenly instead of in bursts. Ports may be swept in the order of a port frequency table, so
+ *              the ports most likely to be open are found first, and an NMAP sweep may be split into shards of the
+ *              port space run as concurrent NMAP children, as a single NMAP process is bound to a single core.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_DISCOVERY_HPP
+#define PORTHAWK_DISCOVERY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "eventloop.hpp"
+#include "utilities.hpp"
+
+const size_t DISC_WINDOW_INIT = 16;
+const size_t DISC_WINDOW_MAX = 4096;
+const int DISC_RTO_INIT_MS = 1000;
+const int DISC_RTO_MIN_MS = 100;
+const int DISC_RTO_MAX_MS = 3000;
+const int DISC_RETRIES = 2;
+/* Like NMAP, filtered ports are only listed when they are the exception */
+const size_t DISC_FILTER_LIST_MAX = 25;
+/* Descriptors kept free for everything but the probes */
+const size_t DISC_FD_RESERVE = 128;
+/* Ports swept ahead of the rest when the sweep is ordered by frequency, the rest are swept in the background */
+const size_t DISC_HEAD_PORTS = 1000;
+/* Port frequency table, a copy under PH/ overrides NMAP's */
+const std::string PORT_FREQUENCY_FILE = DIR_BASE + "nmap-services";
+const std::string PORT_FREQUENCY_SYSTEM = "/usr/share/nmap/nmap-services";
+/* NMAP children a sweep is split across at most, each of them sends at the minimum rate of BASE_NMAP_OPEN */
+const size_t DISC_MAX_SHARDS = 16;
+/* Ports below which a shard is not worth an NMAP child of its own */
+const size_t DISC_SHARD_MIN_PORTS = 256;
+/* Shard count tuned to the available cores */
+const std::string SHARDS_AUTO = "auto";
+
+/* Discovery backends */
+enum DiscoveryBackend : uint8_t {
+    DISCOVERY_NMAP,
+    DISCOVERY_NATIVE,
+};
+
+/* CongestionController class */
+/* AIMD window & RTT estimator (RFC 6298) of a target network, shared by every sweep of that network */
+class CongestionController {
+    private:
+        double window;
+        double ssthresh;
+        size_t cap;
+        double srtt;
+        double rttvar;
+        bool sampled;
+        std::chrono::steady_clock::time_point recovery;
+    public:
+        CongestionController ();
+        void Limit (size_t maxWindow);
+        void OnResponse (uint64_t rttMicros);
+        bool OnTimeout ();
+        size_t Window () const;
+        int TimeoutMs () const;
+        double Rate () const;
+
+}; /* End of class CongestionController */
+
+/* Outcome of a sweep */
+struct SweepResult {
+    std::vector <uint16_t> open;
+    std::vector <uint16_t> filtered;
+    /* UDP ports left unanswered, either open or filtered */
+    std::vector <uint16_t> openFiltered;
+    size_t closed = 0;
+    size_t responses = 0;
+    size_t timeouts = 0;
+};
+
+/* Function Declarations */
+CongestionController &NetworkController (const std::string &address);
+Task <ReturnCodes> NativeSweep (EventLoop &loop, const std::string &address, const std::vector <uint16_t> &ports,
+                                const CancelToken &token, CongestionController &controller, SweepResult &result);
+std::string ServiceName (uint16_t port, const char *protocol = "tcp");
+std::vector <uint16_t> RankedPorts (const std::string &servicesFile);
+std::vector <uint16_t> PortSchedule (const std::vector <uint16_t> &ranked);
+bool ParseShardCount (const std::string &value, size_t &shards);
+size_t ShardCount (size_t requested, size_t ports);
+std::vector <std::vector <std::string>> ShardPortSpecs (const std::vector <uint16_t> &ports, size_t shards);
+
+#endif
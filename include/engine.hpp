@@ -0,0 +1,122 @@
+/*
+ ***********************************************************************************************************************
+ * File: engine.hpp
+ * Description: This file contains declarations of constants, data structures, classes & member functions of the
+ *              embeddable scan engine, the public entry point of libporthawk. A scan is described by a ScanRequest,
+ *              run synchronously or on a thread of its own, and its progress is reported to any number of attached
+ *              ResultSinks. Log messages reach the LogSink attached to the Logger given to the engine.
+ *
+ *                  Logger log (LOG_RAW);
+ *                  log.AttachSink (&mySink);
+ *                  ScanEngine engine (log);
+ *                  engine.AddResultSink (&myResults);
+ *                  auto pending = engine.ScanAsync ({"scanme.example"}, token);
+ *                  ScanResult result = pending.get ();
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_ENGINE_HPP
+#define PORTHAWK_ENGINE_HPP
+
+#include <functional>
+#include <future>
+#include <memory>
+#include "cpe.hpp"
+#include "cveindex.hpp"
+#include "liveness.hpp"
+#include "scanner.hpp"
+
+/* Scan profiles */
+const std::string PROFILE_DEFAULT = "default";
+const std::string PROFILE_DISCOVERY = "discovery";
+
+/* What to scan and how */
+struct ScanRequest {
+    std::string target;
+    std::string profile = PROFILE_DEFAULT;
+    bool resume = false;
+    DiscoveryBackend discovery = DISCOVERY_NMAP;
+    bool udp = false;
+    bool frequentFirst = false;
+    /* NMAP children the discovery sweep is split across, 0 to tune it to the available cores */
+    size_t shards = 1;
+    bool ping = false;
+    UnknownPolicy unknownHosts = UNKNOWN_SCAN;
+    bool banners = false;
+    bool versionProbes = false;
+    bool tls = false;
+    bool http = false;
+    std::vector <std::string> httpPaths = HTTP_PATHS;
+    int maxThreads = MAX_THREADS;
+};
+
+/* Outcome of a scan. status holds the result of port discovery, the host holds every result gathered, partial ones
+ * included when the scan has been cancelled. host is empty when the target could not be resolved, status then being
+ * TARGET_ADDR_FAIL, or when the working directories could not be created, status then being WORK_DIRS_FAIL. */
+struct ScanResult {
+    ReturnCodes status = TARGET_ADDR_FAIL;
+    bool cancelled = false;
+    std::shared_ptr <Host> host;
+};
+
+/* ResultSink class */
+/* Notified as a scan progresses. Every function is called on the thread running Scan (), one call at a time, so a sink
+ * attached to a single scan needs no locking, while one shared with other threads, e.g. the daemon's, guards its own
+ * state. PortScanned is called from the port coroutines while other ports of the host are suspended mid scan, so it
+ * must not read the ports of the host, and is given the port already matched against the offline CVE index. Every
+ * function does nothing unless overridden. */
+class ResultSink {
+    public:
+        virtual ~ResultSink () = default;
+        virtual void HostsSwept (const std::vector <HostLiveness> &, UnknownPolicy) {}
+        virtual void PortsDiscovered (const Host &) {}
+        virtual void PortScanned (const std::string &, const Port &) {}
+        virtual void ScanFinished (const ScanResult &) {}
+
+}; /* End of class ResultSink */
+
+/* ConsoleSink class */
+/* Prints the summaries of a scan, and the CPE queries asked for, as soon as they are known */
+class ConsoleSink : public ResultSink {
+    private:
+        Logger consoleLog;
+        std::vector <std::string> cpeQueries;
+        /* Set once targets have been swept for liveness, the summaries are then headed by the target they are of */
+        bool labelHosts;
+    public:
+        ConsoleSink (Logger objLog, const std::vector <std::string> &queries = {});
+        void HostsSwept (const std::vector <HostLiveness> &hosts, UnknownPolicy policy) override;
+        void PortsDiscovered (const Host &host) override;
+        void ScanFinished (const ScanResult &result) override;
+
+}; /* End of class ConsoleSink */
+
+/* ScanEngine class */
+/* Scans share the NMAP output files & the journal, so an engine runs one scan at a time and further requests wait
+ * for their turn. The engine must outlive every scan started on it. */
+class ScanEngine {
+    private:
+        Logger engineLog;
+        ReturnCodes workDirs;
+        SignatureEngine signatures;
+        CommandTemplates commands;
+        CVEIndex cveIndex;
+        ServiceProbes serviceProbes;
+        std::mutex scanMtx;
+        std::mutex sinkMtx;
+        std::vector <ResultSink *> sinks;
+        ReturnCodes PrepareDirectories ();
+    public:
+        ScanEngine (Logger objLog);
+        void AddResultSink (ResultSink *sink);
+        ScanResult Scan (const ScanRequest &request, const CancelToken &token);
+        std::vector <ScanResult> ScanTargets (const ScanRequest &request, const std::vector <std::string> &addresses,
+                                              const CancelToken &token);
+        std::future <ScanResult> ScanAsync (const ScanRequest &request, const CancelToken &token,
+                                            std::function <void (const ScanResult &)> onComplete = nullptr);
+
+}; /* End of class ScanEngine */
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ ***********************************************************************************************************************
+ * File: eventloop.hpp
+ * Description: This file contains declarations of the coroutine task type, the epoll event loop which drives it & the
+ *              awaitables it offers: descriptor readiness with an optional deadline, timers, yielding & a concurrency
+ *              limiter. A loop is driven by a single thread, so any number of tasks share that thread and nothing they
+ *              touch needs locking against each other.
+ *
+ *                  Task <int> Probe (EventLoop &loop, int fd) {
+ *                      if (!co_await loop.Readable (fd, 500)) { co_return -1; }
+ *                      ...
+ *                  }
+ *
+ *              Tasks are lazy: they start once awaited or handed to EventLoop::Spawn, which runs them detached until
+ *              EventLoop::Run returns. A descriptor may be awaited by a single task at a time.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_EVENTLOOP_HPP
+#define PORTHAWK_EVENTLOOP_HPP
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+template <typename T = void> class Task;
+
+/* Resumes the coroutine awaiting a task once the task has finished */
+struct TaskFinal {
+    bool await_ready () const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle <> await_suspend (std::coroutine_handle <Promise> handle) noexcept {
+        std::coroutine_handle <> continuation = handle.promise ().continuation;
+        return continuation ? continuation : std::noop_coroutine ();
+    }
+    void await_resume () const noexcept {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle <> continuation;
+    std::exception_ptr error;
+    std::suspend_always initial_suspend () noexcept { return {}; }
+    TaskFinal final_suspend () noexcept { return {}; }
+    void unhandled_exception () { error = std::current_exception (); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional <T> value;
+    Task <T> get_return_object ();
+    void return_value (T result) { value = std::move (result); }
+};
+
+template <>
+struct TaskPromise <void> : TaskPromiseBase {
+    Task <void> get_return_object ();
+    void return_void () {}
+};
+
+/* Task class */
+/* A lazily started coroutine producing a T, owned by whoever holds it */
+template <typename T>
+class Task {
+    public:
+        using promise_type = TaskPromise <T>;
+        explicit Task (std::coroutine_handle <promise_type> coroutine) : handle (coroutine) {}
+        Task (Task &&other) noexcept : handle (std::exchange (other.handle, {})) {}
+        Task &operator= (Task &&other) noexcept {
+            if (this != &other) {
+                if (handle) { handle.destroy (); }
+                handle = std::exchange (other.handle, {});
+            }
+            return *this;
+        }
+        Task (const Task &) = delete;
+        Task &operator= (const Task &) = delete;
+        ~Task () { if (handle) { handle.destroy (); } }
+        bool await_ready () const noexcept { return !handle || handle.done (); }
+        std::coroutine_handle <> await_suspend (std::coroutine_handle <> awaiting) noexcept {
+            handle.promise ().continuation = awaiting;
+            return handle;
+        }
+        T await_resume () {
+            if (handle.promise ().error) { std::rethrow_exception (handle.promise ().error); }
+            if constexpr (!std::is_void_v <T>) { return std::move (*handle.promise ().value); }
+        }
+    private:
+        std::coroutine_handle <promise_type> handle;
+
+}; /* End of class Task */
+
+template <typename T>
+Task <T> TaskPromise <T>::get_return_object () {
+    return Task <T> (std::coroutine_handle <TaskPromise <T>>::from_promise (*this));
+}
+
+inline Task <void> TaskPromise <void>::get_return_object () {
+    return Task <void> (std::coroutine_handle <TaskPromise <void>>::from_promise (*this));
+}
+
+/* Awaits a task and keeps its result, so the task can be spawned */
+template <typename T>
+Task <> StoreResult (Task <T> task, T &result) {
+    result = co_await task;
+}
+
+/* A coroutine suspended on the loop until its descriptor is ready or its deadline has passed */
+struct LoopWaiter {
+    std::coroutine_handle <> handle;
+    int fd = -1;
+    bool timedOut = false;
+    bool hasTimer = false;
+    std::multimap <std::chrono::steady_clock::time_point, LoopWaiter *>::iterator timer;
+};
+
+class EventLoop;
+
+/* Awaitable of EventLoop::Readable, Writable & Sleep, resumes with false once the deadline has passed */
+class LoopAwaiter {
+    private:
+        EventLoop &loop;
+        uint32_t events;
+        int timeoutMs;
+        LoopWaiter waiter;
+    public:
+        LoopAwaiter (EventLoop &eventLoop, int fd, uint32_t waitEvents, int waitMs);
+        bool await_ready () const noexcept { return false; }
+        void await_suspend (std::coroutine_handle <> handle);
+        bool await_resume () const noexcept { return !waiter.timedOut; }
+
+}; /* End of class LoopAwaiter */
+
+/* Awaitable of EventLoop::Yield */
+struct YieldAwaiter {
+    EventLoop &loop;
+    bool await_ready () const noexcept { return false; }
+    void await_suspend (std::coroutine_handle <> handle);
+    void await_resume () const noexcept {}
+};
+
+/* Fire and forget coroutine, used to run spawned tasks */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object () noexcept { return {}; }
+        std::suspend_never initial_suspend () noexcept { return {}; }
+        std::suspend_never final_suspend () noexcept { return {}; }
+        void return_void () noexcept {}
+        void unhandled_exception () noexcept { std::terminate (); }
+    };
+};
+
+/* EventLoop class */
+class EventLoop {
+    private:
+        int epollFd;
+        size_t live;
+        std::deque <std::coroutine_handle <>> ready;
+        std::multimap <std::chrono::steady_clock::time_point, LoopWaiter *> timers;
+        static DetachedTask RunDetached (EventLoop &loop, Task <> task);
+        void Wake (LoopWaiter &waiter, bool timedOut);
+    public:
+        EventLoop ();
+        ~EventLoop ();
+        EventLoop (const EventLoop &) = delete;
+        EventLoop &operator= (const EventLoop &) = delete;
+        void Spawn (Task <> task);
+        void Schedule (std::coroutine_handle <> handle);
+        void Suspend (LoopWaiter &waiter, uint32_t events, int timeoutMs);
+        void Run ();
+        LoopAwaiter Readable (int fd, int timeoutMs = -1);
+        LoopAwaiter Writable (int fd, int timeoutMs = -1);
+        LoopAwaiter Sleep (int ms);
+        YieldAwaiter Yield ();
+
+}; /* End of class EventLoop */
+
+/* Limiter class */
+/* Caps the number of tasks of a loop inside a section, waiting tasks enter in the order they arrived */
+class Limiter {
+    private:
+        EventLoop &loop;
+        size_t available;
+        std::deque <std::coroutine_handle <>> waiting;
+    public:
+        struct Awaiter {
+            Limiter &limiter;
+            bool await_ready () noexcept;
+            void await_suspend (std::coroutine_handle <> handle);
+            void await_resume () const noexcept {}
+        };
+        Limiter (EventLoop &eventLoop, size_t limit);
+        Awaiter Acquire ();
+        void Release ();
+
+}; /* End of class Limiter */
+
+#endif
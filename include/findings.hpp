@@ -0,0 +1,63 @@
+/*
+ ***********************************************************************************************************************
+ * File: findings.hpp
+ * Description: This file contains declarations of constants, the fixed-layout finding record & support functions
+ *              associated with extracting structured findings from the tables emitted by NSE scripts.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_FINDINGS_HPP
+#define PORTHAWK_FINDINGS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pugixml.hpp"
+
+const int MAX_FINDING_CVES = 8;
+const int MAX_FINDING_REFS = 4;
+const uint32_t CVE_YEAR_BASE = 1990;
+
+/* Finding states, ordered so that the most severe one ranks first */
+enum FindingState : uint8_t {
+    FINDING_UNKNOWN = 0,
+    FINDING_NOT_VULNERABLE = 1,
+    FINDING_LIKELY = 2,
+    FINDING_VULNERABLE = 3,
+    FINDING_EXPLOITABLE = 4,
+};
+
+/* Scope of a finding, whether it came from a port's <script> or the host's <hostscript> */
+enum FindingScope : uint8_t {
+    SCOPE_PORT = 0,
+    SCOPE_HOST = 1,
+};
+
+/*
+ * Fixed-layout finding record. Strings are interned ids (see cpe.hpp) and CVE ids are packed into 32 bits, so ranking
+ * and de-duplication compare integers only.
+ */
+struct Finding {
+    uint32_t script;
+    uint32_t title;
+    uint32_t cves [MAX_FINDING_CVES];
+    uint32_t refs [MAX_FINDING_REFS];
+    uint16_t score;
+    uint8_t cveCount;
+    uint8_t refCount;
+    FindingState state;
+    FindingScope scope;
+};
+
+/* Function Declarations */
+uint32_t PackCVE (const std::string &cve);
+std::string UnpackCVE (uint32_t packed);
+const std::string FindingStateName (FindingState state);
+FindingState ParseFindingState (const std::string &state);
+void ExtractFindings (const pugi::xml_node &script, FindingScope scope, std::vector <Finding> &findings);
+void RankFindings (std::vector <Finding> &findings);
+std::string FormatFinding (const Finding &finding);
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ ***********************************************************************************************************************
+ * File: http.hpp
+ * Description: This file contains declarations of constants, data structures & functions associated with the native
+ *              fingerprinting of web services: a set of paths fetched with pipelined HTTP/1.1 requests over a
+ *              keep-alive connection per port, TLS wrapped when the port speaks it, and each response reduced to its
+ *              status, notable headers, title & hashes.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_HTTP_HPP
+#define PORTHAWK_HTTP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "eventloop.hpp"
+
+const int HTTP_TIMEOUT_MS = 5000;
+const int HTTP_CONCURRENCY = 128;
+/* Bytes read per connection, a larger response is fingerprinted from its beginning */
+const size_t HTTP_MAX_BYTES = 1 << 20;
+const size_t HTTP_TITLE_CHARS = 128;
+const std::vector <std::string> HTTP_PATHS = {"/", "/favicon.ico", "/robots.txt"};
+
+class CancelToken;
+
+/* Compact fingerprint of the response to a path */
+struct HTTPResponse {
+    std::string path;
+    int status = 0;
+    std::string server;
+    std::string contentType;
+    std::string location;
+    std::string poweredBy;
+    std::string authenticate;
+    std::string title;
+    size_t bodyBytes = 0;
+    int32_t bodyHash = 0;
+};
+
+/* Outcome of the HTTP fingerprinting of a port. The favicon hash is the one Shodan indexes as http.favicon.hash. */
+struct HTTPFingerprint {
+    bool fetched = false;
+    bool tls = false;
+    int connections = 0;
+    int requests = 0;
+    std::vector <HTTPResponse> responses;
+    bool hasFavicon = false;
+    int32_t faviconHash = 0;
+};
+
+/* Function Declarations */
+bool IsHTTPService (const std::string &service, const std::string &portid);
+int32_t MurmurHash3 (const std::string &data, uint32_t seed = 0);
+int32_t FaviconHash (const std::string &icon);
+Task <HTTPFingerprint> FetchHTTP (EventLoop &loop, const std::string &address, const std::string &portid,
+                                  const std::vector <std::string> &paths, bool encrypted, const CancelToken &token);
+
+#endif
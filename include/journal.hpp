@@ -0,0 +1,59 @@
+/*
+ ***********************************************************************************************************************
+ * File: journal.hpp
+ * Description: This file contains declarations of constants, data structures, class & member functions associated
+ *              with the write-ahead scan journal used to checkpoint and resume long running scans.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_JOURNAL_HPP
+#define PORTHAWK_JOURNAL_HPP
+
+#include <map>
+#include <mutex>
+#include "logger.hpp"
+#include "scanner.hpp"
+
+const std::string LOG_JOURNAL = DIR_BASE + "PH_Journal.wal";
+
+/* Record types */
+/* Every record is a single line of the form "<fnv1a-32 hex> <type>\t<field>\t<field>...\n". */
+const char REC_DISC_START = 'S';
+const char REC_DISC_PORT  = 'D';
+const char REC_DISC_END   = 'E';
+const char REC_FINDING    = 'F';
+const char REC_PORT_DONE  = 'P';
+
+/* Work restored from the journal for a single host */
+struct JournalHost {
+    bool discovered = false;
+    std::vector <Port> ports;
+    /* Keyed by Port::Key (), so a UDP port does not shadow the TCP port of the same number */
+    std::map <std::string, Port> completed;
+    std::map <std::string, std::vector <Finding>> findings;
+};
+
+/* Journal class */
+class Journal {
+    private:
+        int fd;
+        std::string fileName;
+        std::mutex mtx;
+        std::map <std::string, JournalHost> hosts;
+        void Replay (const std::string &line);
+        bool Append (char type, const std::vector <std::string> &fields);
+    public:
+        Journal (const std::string &nameFile);
+        ~Journal ();
+        ReturnCodes Open (bool resume, Logger objLog);
+        const JournalHost *Find (const std::string &address) const;
+        void RecordDiscoveryStart (const std::string &address);
+        void RecordDiscoveredPort (const std::string &address, const Port &port);
+        void RecordDiscoveryEnd (const std::string &address);
+        void RecordDeepScan (const std::string &address, const Port &port);
+
+}; /* End of class Journal */
+
+#endif
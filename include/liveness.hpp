@@ -0,0 +1,65 @@
+/*
+ ***********************************************************************************************************************
+ * File: liveness.hpp
+ * Description: This file contains declarations of constants, data structures & functions associated with the native
+ *              host liveness sweep, run over the whole target set ahead of port discovery so dead addresses are not
+ *              given a full port sweep. Every target is sent ICMP echo requests over a single socket, while connect
+ *              pings to common ports run at once on the event loop, a reset proving a host up as well as an accept.
+ *              Targets on a local segment are judged by the kernel's ARP cache, which the probes have filled in.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_LIVENESS_HPP
+#define PORTHAWK_LIVENESS_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "eventloop.hpp"
+#include "logger.hpp"
+
+const int LIVE_TIMEOUT_MS = 1000;
+const int LIVE_RETRIES = 1;
+/* Echo requests & connect pings each leave at this rate */
+const double LIVE_RATE_PPS = 5000;
+/* Connect pings in flight at once, across every target, as far as the descriptors allow */
+const size_t LIVE_CONCURRENCY = 4096;
+/* Ports pinged in turn, until one of them answers */
+const std::vector <uint16_t> LIVE_TCP_PORTS = {80, 443, 22, 445, 3389};
+const std::string LIVE_ARP_CACHE = "/proc/net/arp";
+
+class CancelToken;
+
+/* Liveness of a target, as the sweep learns it */
+enum Liveness : uint8_t {
+    LIVENESS_UNKNOWN,
+    LIVENESS_UP,
+    LIVENESS_DOWN,
+};
+
+/* What becomes of a target whose liveness could not be told, e.g. one dropping every probe */
+enum UnknownPolicy : uint8_t {
+    UNKNOWN_SCAN,
+    UNKNOWN_SKIP,
+};
+
+/* Outcome of the liveness sweep of a target, reason names the probe which decided it and elapsedMicros how long
+ * after the start of the sweep it did */
+struct HostLiveness {
+    std::string address;
+    Liveness state = LIVENESS_UNKNOWN;
+    std::string reason;
+    uint64_t elapsedMicros = 0;
+};
+
+/* Function Declarations */
+Task <ReturnCodes> LivenessSweep (EventLoop &loop, std::vector <HostLiveness> &hosts, const CancelToken &token);
+bool AdmitHost (const HostLiveness &host, UnknownPolicy policy);
+bool ParseUnknownPolicy (const std::string &name, UnknownPolicy &policy);
+void PrintLivenessSummary (const std::vector <HostLiveness> &hosts, UnknownPolicy policy, Logger objLog,
+                           std::ostream &out = std::cout);
+
+#endif
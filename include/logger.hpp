@@ -38,7 +38,7 @@ const std::string FOOTER = "Exiting the tool";
 const std::string LINE = "=============================================================================================="
                          "==========================";
 
-const std::string DIR_CWD = std::filesystem::absolute ("");
+const std::string DIR_CWD = std::filesystem::current_path ().string () + "/";
 const std::string DIR_BASE = DIR_CWD + "PH/";
 const std::string DIR_LOGS = DIR_BASE + "Logs/";
 const std::string DIR_PORTS = DIR_BASE + "Ports/";
@@ -47,15 +47,28 @@ const std::string LOG_RAW = DIR_LOGS + "PH_Master.log";
 /* Function Declarations */
 const std::string GetReturnMessage (ReturnCodes code);
 const std::string GetCurrentTime ();
-void InitializeDirectories (const std::vector <std::string>& dirs);
+ReturnCodes InitializeDirectories (const std::vector <std::string>& dirs, std::string &error);
+
+/* LogSink class */
+/* Receives every log message of the Loggers it is attached to, in place of STDOUT. user is set for the messages which
+ * would have been printed to STDOUT. */
+class LogSink {
+    public:
+        virtual ~LogSink () = default;
+        virtual void Write (int severity, const std::string &module, ReturnCodes code, const std::string &message,
+                            bool user) = 0;
+
+}; /* End of class LogSink */
 
 /* Logger class */
 class Logger {
     private:
         std::string fileName;
         bool verbose;
+        LogSink *sink;
     public:
         Logger (std::string nameFile, bool verbose = false);
+        void AttachSink (LogSink *logSink);
         void Header (const std::string identifier = GetCurrentTime (), bool skip = true);
         void Footer (bool skip = true);
         void Log (const int severity, const std::string module, const ReturnCodes code, bool uFlag = false, 
@@ -0,0 +1,181 @@
+/*
+ ***********************************************************************************************************************
+ * File: metrics.hpp
+ * Description: This file contains declarations of constants, classes & member functions associated with the run
+ *              metrics registry of counters, gauges & latency histograms, and with reporting where the wall time of a
+ *              run has been spent.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_METRICS_HPP
+#define PORTHAWK_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "logger.hpp"
+#include "utilities.hpp"
+
+const std::string METRICS_FILE = DIR_LOGS + "PH_Metrics.json";
+/* Histograms keep 2^HIST_SUB_BITS linear buckets per power of two, bounding the relative error to ~3% */
+const int HIST_SUB_BITS = 5;
+const int HIST_SUB_COUNT = 1 << HIST_SUB_BITS;
+const int HIST_BUCKETS = (64 - HIST_SUB_BITS + 1) << HIST_SUB_BITS;
+const size_t METRICS_SLOWEST = 10;
+
+/* Metric names, durations are recorded in microseconds */
+const std::string MET_RUN = "run.total";
+const std::string MET_PHASE_LIVENESS = "phase.liveness";
+const std::string MET_PHASE_DISC = "phase.discovery";
+const std::string MET_PHASE_BANNER = "phase.banner";
+const std::string MET_PHASE_VERSION = "phase.version";
+const std::string MET_PHASE_DEEP = "phase.deep_scan";
+const std::string MET_PHASE_HTTP = "phase.http";
+const std::string MET_PHASE_TLS = "phase.tls";
+const std::string MET_LIVE_ECHOES = "liveness.echo_requests";
+const std::string MET_LIVE_PINGS = "liveness.tcp_pings";
+const std::string MET_LIVE_UP = "liveness.hosts_up";
+const std::string MET_LIVE_DOWN = "liveness.hosts_down";
+const std::string MET_LIVE_UNKNOWN = "liveness.hosts_unknown";
+const std::string MET_DISC_NMAP = "discovery.nmap";
+const std::string MET_DISC_XML = "discovery.xml";
+const std::string MET_DISC_OPEN = "discovery.ports_open";
+const std::string MET_DISC_FILTER = "discovery.ports_filtered";
+const std::string MET_DISC_HEAD = "discovery.head";
+const std::string MET_DISC_TAIL = "discovery.tail";
+const std::string MET_NATIVE_RTT = "discovery.native.rtt";
+const std::string MET_NATIVE_PROBES = "discovery.native.probes";
+const std::string MET_NATIVE_RETRIES = "discovery.native.retries";
+const std::string MET_NATIVE_TIMEOUTS = "discovery.native.timeouts";
+const std::string MET_NATIVE_BACKOFFS = "discovery.native.backoffs";
+const std::string MET_NATIVE_WINDOW = "discovery.native.window";
+const std::string MET_NATIVE_RATE = "discovery.native.rate_pps";
+const std::string MET_NATIVE_RTO = "discovery.native.rto_ms";
+const std::string MET_UDP_PROBES = "discovery.udp.probes";
+const std::string MET_UDP_RETRIES = "discovery.udp.retries";
+const std::string MET_UDP_REPLIES = "discovery.udp.replies";
+const std::string MET_UDP_UNREACHABLE = "discovery.udp.unreachable";
+const std::string MET_BANNER_PORT = "banner.port";
+const std::string MET_BANNER_HIT = "banner.identified";
+const std::string MET_BANNER_MISS = "banner.unidentified";
+const std::string MET_VERSION_PORT = "version.port";
+const std::string MET_VERSION_PROBES = "version.probes_sent";
+const std::string MET_VERSION_HIT = "version.identified";
+const std::string MET_VERSION_SOFT = "version.softmatched";
+const std::string MET_VERSION_MISS = "version.unidentified";
+const std::string MET_HTTP_PORT = "http.port";
+const std::string MET_HTTP_REQUESTS = "http.requests";
+const std::string MET_HTTP_CONNECTIONS = "http.connections";
+const std::string MET_TLS_PORT = "tls.port";
+const std::string MET_TLS_HANDSHAKES = "tls.handshakes";
+const std::string MET_DEEP_SKIPPED = "deep.skipped";
+const std::string MET_OPEN_SUM = "summary.open_ports";
+const std::string MET_DEEP_PORT = "deep.port";
+const std::string MET_DEEP_NMAP = "deep.nmap";
+const std::string MET_DEEP_XML = "deep.xml";
+const std::string MET_DEEP_PASS = "deep.completed";
+const std::string MET_DEEP_FAIL = "deep.failed";
+const std::string MET_DEEP_CANCEL = "deep.cancelled";
+const std::string MET_DEEP_RESTORED = "deep.restored";
+const std::string MET_DEEP_ACTIVE = "deep.active";
+const std::string MET_DEEP_WORKERS = "deep.workers";
+const std::string MET_CVE_MATCH = "cve.match";
+const std::string MET_DEEP_SUM = "summary.deep_scan";
+
+/* Monotonically increasing count */
+class Counter {
+    private:
+        std::atomic <uint64_t> value {0};
+    public:
+        void Add (uint64_t amount = 1) { value.fetch_add (amount, std::memory_order_relaxed); }
+        uint64_t Value () const { return value.load (std::memory_order_relaxed); }
+
+}; /* End of class Counter */
+
+/* Current level of a quantity, along with the highest level it has reached */
+class Gauge {
+    private:
+        std::atomic <int64_t> value {0};
+        std::atomic <int64_t> peak {0};
+    public:
+        void Set (int64_t level);
+        void Add (int64_t amount);
+        int64_t Value () const { return value.load (std::memory_order_relaxed); }
+        int64_t Peak () const { return peak.load (std::memory_order_relaxed); }
+
+}; /* End of class Gauge */
+
+/* Log-linear (HDR style) histogram of non-negative values, recorded without locks */
+class Histogram {
+    private:
+        std::atomic <uint64_t> buckets [HIST_BUCKETS] {};
+        std::atomic <uint64_t> count {0};
+        std::atomic <uint64_t> sum {0};
+        std::atomic <uint64_t> min {UINT64_MAX};
+        std::atomic <uint64_t> max {0};
+    public:
+        static int BucketIndex (uint64_t value);
+        static uint64_t BucketValue (int index);
+        void Record (uint64_t value);
+        uint64_t Count () const { return count.load (std::memory_order_relaxed); }
+        uint64_t Sum () const { return sum.load (std::memory_order_relaxed); }
+        uint64_t Min () const;
+        uint64_t Max () const { return max.load (std::memory_order_relaxed); }
+        uint64_t Percentile (double percentile) const;
+        std::vector <std::pair <uint64_t, uint64_t>> Buckets () const;
+
+}; /* End of class Histogram */
+
+/* Wall time spent by a phase on a single item, e.g. a host or a port */
+struct Span {
+    std::string metric;
+    std::string key;
+    uint64_t micros;
+};
+
+/* MetricsRegistry class */
+class MetricsRegistry {
+    private:
+        std::mutex mtx;
+        std::map <std::string, std::unique_ptr <Counter>> counters;
+        std::map <std::string, std::unique_ptr <Gauge>> gauges;
+        std::map <std::string, std::unique_ptr <Histogram>> histograms;
+        std::vector <Span> spans;
+    public:
+        Counter &GetCounter (const std::string &name);
+        Gauge &GetGauge (const std::string &name);
+        Histogram &GetHistogram (const std::string &name);
+        void RecordSpan (const std::string &metric, const std::string &key, uint64_t micros);
+        void RecordChild (const std::string &metric, const ChildUsage &usage);
+        void PrintReport (Logger objLog);
+        ReturnCodes Dump (const std::string &fileName, Logger objLog);
+
+}; /* End of class MetricsRegistry */
+
+extern MetricsRegistry runMetrics;
+
+/* Records the time between its construction and destruction into a histogram, and as a span when given a key. A
+ * timer running across a co_await overlaps the timers of the other tasks on its thread, so it is traced as an async
+ * span of its item rather than a span of the thread. */
+class ScopedTimer {
+    private:
+        std::string metric;
+        std::string key;
+        std::chrono::steady_clock::time_point start;
+        bool stopped;
+        bool suspends;
+    public:
+        ScopedTimer (const std::string &name, const std::string &item = "", bool acrossAwait = false);
+        ~ScopedTimer ();
+        void Stop ();
+        ScopedTimer (const ScopedTimer &) = delete;
+        ScopedTimer &operator= (const ScopedTimer &) = delete;
+
+}; /* End of class ScopedTimer */
+
+#endif
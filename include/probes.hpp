@@ -0,0 +1,47 @@
+/*
+ ***********************************************************************************************************************
+ * File: probes.hpp
+ * Description: This file contains the USDT static tracepoints of the scanner hot paths. When <sys/sdt.h> is available
+ *              every probe compiles to a single nop plus an ELF note, so a live scan can be traced with bpftrace or
+ *              perf at no cost while nothing is attached, e.g.
+ *                  bpftrace -e 'usdt:./portHawk:porthawk:deep__done { printf("%s %d\n", str(arg1), arg2); }'
+ *              Without it, or with PORTHAWK_NO_PROBES defined, the probes compile to nothing.
+ *
+ *              Provider "porthawk", probes & arguments:
+ *                  discovery__start  (const char *address)
+ *                  discovery__done   (const char *address, int returnCode, int numOpen, int numFilter)
+ *                  deep__start       (const char *address, const char *portid)
+ *                  deep__done        (const char *address, const char *portid, int returnCode)
+ *                  exec__start       (const char *command)
+ *                  exec__spawn       (const char *command, int pid)
+ *                  exec__done        (int pid, int returnCode, size_t outputBytes, int waitStatus)
+ *                  log__write        (int severity, const char *module, int returnCode, size_t bytes)
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_PROBES_HPP
+#define PORTHAWK_PROBES_HPP
+
+#if !defined (PORTHAWK_NO_PROBES) && defined (__has_include)
+#if __has_include (<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PORTHAWK_HAS_PROBES 1
+#endif
+#endif
+
+#ifdef PORTHAWK_HAS_PROBES
+#define PH_PROBE1(name, a1) DTRACE_PROBE1 (porthawk, name, a1)
+#define PH_PROBE2(name, a1, a2) DTRACE_PROBE2 (porthawk, name, a1, a2)
+#define PH_PROBE3(name, a1, a2, a3) DTRACE_PROBE3 (porthawk, name, a1, a2, a3)
+#define PH_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4 (porthawk, name, a1, a2, a3, a4)
+#else
+/* Arguments are not evaluated, so disabled probes cost nothing */
+#define PH_PROBE1(name, a1) do {} while (0)
+#define PH_PROBE2(name, a1, a2) do {} while (0)
+#define PH_PROBE3(name, a1, a2, a3) do {} while (0)
+#define PH_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+#endif
+
+#endif
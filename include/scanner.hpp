@@ -11,39 +11,98 @@
 #ifndef PORTHAWK_SCANNER_HPP
 #define PORTHAWK_SCANNER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <mutex>
+#include <span>
 #include <thread>
+#include "banner.hpp"
+#include "commands.hpp"
+#include "cpe.hpp"
+#include "discovery.hpp"
+#include "findings.hpp"
+#include "http.hpp"
 #include "logger.hpp"
 #include "pugixml.hpp"
+#include "serviceprobes.hpp"
+#include "signatures.hpp"
+#include "tls.hpp"
+#include "udp.hpp"
 #include "utilities.hpp"
 
 const int MAX_THREADS = 20;
 const std::string STATE_OPEN = "open";
 const std::string STATE_FLTR = "filtered";
 const std::string STATE_CLSD = "closed";
+/* A UDP port left unanswered */
+const std::string STATE_OPEN_FLTR = "open|filtered";
+const std::string PROTO_TCP = "tcp";
+const std::string PROTO_UDP = "udp";
+const std::string SCAN_NMAP_VULN = "NMAP vuln";
+const std::string SCAN_BANNER = "banner";
+const std::string SCAN_VERSION = "version";
+const std::string SCAN_TLS = "tls";
+const std::string SCAN_HTTP = "http";
 
-const std::string BASE_NMAP_OPEN = "nmap -Pn -T4 -sT --min-rate=2000 -p- -oX $xmlFile $target";
-const std::string BASE_NMAP_DEEP = "nmap -sT -sV -sC --script=vuln -p $id -oX $xmlFile $target";
+class CVEIndex;
+class Journal;
 
 /* Port class */
 class Port {
     public:
         std::string portid;
+        std::string protocol;
         std::string state;
         std::string service;
         std::string product;
         std::string version;
         std::string osName;
+        std::string extraInfo;
+        std::string osType;
+        std::string banner;
+        TLSReport tls;
+        HTTPFingerprint http;
+        std::vector <CPE> cpes;
+        std::vector <Finding> findings;
+        std::vector <Finding> hostFindings;
         std::vector <std::string> vulnerabilities;
+        std::vector <std::string> cves;
+        std::vector <std::string> knownCVEs;
+        Severity severity;
+        float knownScore;
         std::vector <std::string> scansCompleted;
         std::vector <std::string> scansFailed;
+        ChildUsage usage;
 
         /* Member functions */
-        Port (const std::string &id, const std::string &status, const std::string &name = "N/A");
-        int NMAPScriptScan (const std::string &address, Logger masterLog);
+        Port (const std::string &id, const std::string &status, const std::string &name = "N/A",
+              const std::string &proto = PROTO_TCP);
+        std::string Key () const;
+        void RestoreDeepScan (const Port &journalled);
+        Task <int> NMAPScriptScanAsync (EventLoop &loop, const std::string &address, Logger masterLog,
+                                        const CancelToken &token, const SignatureEngine &signatures,
+                                        const CommandTemplates &templates);
+        int NMAPScriptScan (const std::string &address, Logger masterLog, const CancelToken &token,
+                            const SignatureEngine &signatures, const CommandTemplates &templates);
+        void ExtractScriptResults (const pugi::xml_node &nodeHost, Logger portLog, const SignatureEngine &signatures);
 
 }; /* End of class Port */
 
+/* ScanObserver class */
+/* Notified as the scan of a host progresses. PortsDiscovered is called once per batch of ports discovered, with that
+ * batch, i.e. twice when the sweep is ordered by frequency. PortScanned is called once per open port, from the port
+ * coroutines of the event loop. Both run on the thread scanning the host, one call at a time, so an observer of a
+ * single scan needs no locking; one whose state is also read by other threads must guard it itself. */
+class ScanObserver {
+    public:
+        virtual ~ScanObserver () = default;
+        virtual void PortsDiscovered (const std::string &address, const std::vector <Port> &open,
+                                      const std::vector <Port> &filtered) = 0;
+        virtual void PortScanned (const std::string &address, const Port &port) = 0;
+
+}; /* End of class ScanObserver */
+
 /* Host class */
 class Host {
     private:
@@ -52,15 +111,65 @@ class Host {
         int numFilter;
         std::vector <Port> openPorts;
         std::vector <Port> filterPorts;
+        std::vector <Finding> hostFindings;
+        ChildUsage discoveryUsage;
+        /* Ports before this index have been through the scan stages, only the ones after it are staged */
+        size_t staged;
+        /* Background sweep of the ports left after the most frequent ones, its ports are added once it is joined */
+        std::future <ReturnCodes> tailSweep;
+        std::vector <Port> tailPorts;
+        ChildUsage tailUsage;
         std::mutex mtx;
+        Journal *journal;
+        const SignatureEngine *signatures;
+        const CommandTemplates *commandTemplates;
+        ScanObserver *observer;
+        ReturnCodes SweepNMAP (Logger objLog, const CancelToken &token,
+                               const std::vector <std::vector <std::string>> &portSpecs, const std::string &xmlStem,
+                               std::vector <Port> &found, ChildUsage &usage);
+        ReturnCodes SweepNative (Logger objLog, const CancelToken &token, const std::vector <uint16_t> &ports,
+                                 std::vector <Port> &found);
+        ReturnCodes SweepUDP (Logger objLog, const CancelToken &token);
+        ReturnCodes JoinTail ();
+        std::span <Port> Unstaged ();
+        Task <> ScanPortTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objFile, const CancelToken &token,
+                              const SignatureEngine &engine, const CommandTemplates &templates);
+        Task <> BannerTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token);
+        Task <> VersionTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token,
+                             const ServiceProbes &probes);
+        Task <> HTTPTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token,
+                          const std::vector <std::string> &paths);
+        Task <> TLSTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token);
     public:
         Host (const std::string &addr);
+        void AttachJournal (Journal *scanJournal);
+        void AttachSignatures (const SignatureEngine *engine);
+        void AttachCommands (const CommandTemplates *templates);
+        void AttachObserver (ScanObserver *scanObserver);
+        const std::string &Address () const;
+        const std::vector <Port> &OpenPorts () const;
+        const std::vector <Port> &FilteredPorts () const;
+        const std::vector <Finding> &HostFindings () const;
+        const ChildUsage &DiscoveryUsage () const;
         void AddPortToHost (const Port &port);
-        ReturnCodes GetOpenPorts (Logger objLog);
-        void PrintOpenScanSummary (Logger objLog);
-        int MultitreadedNMAPScript (Logger objLog, int maxThreads = MAX_THREADS);
-        void PrintDeepScanSummary (Logger objLog);
+        ReturnCodes GetOpenPorts (Logger objLog, const CancelToken &token, DiscoveryBackend backend = DISCOVERY_NMAP,
+                                  bool udp = false, bool ordered = false, size_t shards = 1);
+        int CollectTail (Logger objLog);
+        void PrintOpenScanSummary (Logger objLog, std::ostream &out = std::cout) const;
+        int GrabBanners (Logger objLog, const CancelToken &token, int concurrency = BANNER_CONCURRENCY);
+        int DetectVersions (const ServiceProbes &probes, Logger objLog, const CancelToken &token,
+                            int concurrency = SP_CONCURRENCY);
+        int FingerprintHTTP (const std::vector <std::string> &paths, Logger objLog, const CancelToken &token,
+                             int concurrency = HTTP_CONCURRENCY);
+        int MultitreadedNMAPScript (Logger objLog, const CancelToken &token, int maxThreads = MAX_THREADS);
+        int InspectTLSPorts (Logger objLog, const CancelToken &token, int concurrency = TLS_CONCURRENCY);
+        void MatchKnownCVEs (const CVEIndex &index, Logger objLog);
+        void IndexCPEs (CPEIndex &index) const;
+        void PrintDeepScanSummary (Logger objLog, std::ostream &out = std::cout) const;
 
 }; /* End of class Host */
 
+/* Function Declarations */
+void PrintCPEQuery (const CPEIndex &index, const std::string &prefix, Logger objLog);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*
+ ***********************************************************************************************************************
+ * File: serviceprobes.hpp
+ * Description: This file contains declarations of constants, data structures, class & member functions of the native
+ *              service-probe engine, which loads NMAP's nmap-service-probes database and runs its probe/match protocol
+ *              in-process, so version detection needs no NMAP child. The match patterns of each probe are compiled
+ *              once into RE2 sets; without RE2 the engine does not load and version detection stays with NMAP -sV.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_SERVICEPROBES_HPP
+#define PORTHAWK_SERVICEPROBES_HPP
+
+#include <memory>
+#include "eventloop.hpp"
+#include "logger.hpp"
+
+const std::string SERVICE_PROBES_FILE = DIR_BASE + "nmap-service-probes";
+const std::string SERVICE_PROBES_SYSTEM = "/usr/share/nmap/nmap-service-probes";
+const std::string SP_NULL_PROBE = "NULL";
+/* Probes rarer than the intensity are only sent to the ports they list, as NMAP's --version-intensity 7 does */
+const int SP_INTENSITY = 7;
+const int SP_RARITY_DEFAULT = 5;
+const int SP_WAIT_DEFAULT_MS = 5000;
+const int SP_CONNECT_MS = 3000;
+const size_t SP_MAX_RESPONSE = 16384;
+const int SP_CONCURRENCY = 256;
+/* Patterns per RE2 set, bounding the memory of each set's DFA */
+const size_t SP_SET_CHUNK = 1024;
+
+class CancelToken;
+
+/* A match or softmatch line. versionInfo holds the p/v/i/h/o/d/cpe fields, filled from the groups of the pattern */
+struct ServiceMatch {
+    std::string service;
+    std::string pattern;
+    bool soft = false;
+    std::string versionInfo;
+};
+
+/* A TCP probe: the payload sent, the ports it is meant for & the matches tried against the responses */
+struct ServiceProbe {
+    std::string name;
+    std::string payload;
+    std::vector <std::pair <uint16_t, uint16_t>> ports;
+    int rarity = SP_RARITY_DEFAULT;
+    int waitMs = SP_WAIT_DEFAULT_MS;
+    std::vector <std::string> fallbackNames;
+    std::vector <size_t> fallbacks;
+    std::vector <ServiceMatch> matches;
+};
+
+/* Outcome of the version detection of a port */
+struct ServiceVerdict {
+    bool matched = false;
+    bool soft = false;
+    std::string probe;
+    std::string service;
+    std::string product;
+    std::string version;
+    std::string info;
+    std::string hostname;
+    std::string osType;
+    std::string deviceType;
+    std::vector <std::string> cpes;
+    int probesSent = 0;
+};
+
+/* ServiceProbes class */
+/* Once loaded, the engine is read-only and shared across scans & threads. */
+class ServiceProbes {
+    private:
+        struct Compiled;
+        std::vector <ServiceProbe> probes;
+        std::vector <std::pair <uint16_t, uint16_t>> excluded;
+        std::shared_ptr <const Compiled> compiled;
+        size_t numMatches;
+        size_t numRejected;
+        bool MatchProbe (size_t index, const std::string &response, ServiceVerdict &verdict) const;
+    public:
+        ServiceProbes ();
+        ReturnCodes Load (const std::string &fileName, Logger objLog);
+        size_t LoadFromString (const std::string &database);
+        bool IsLoaded () const;
+        size_t NumProbes () const;
+        size_t NumMatches () const;
+        size_t NumRejected () const;
+        bool IsExcluded (uint16_t port) const;
+        bool Match (size_t index, const std::string &response, ServiceVerdict &verdict) const;
+        Task <ServiceVerdict> Detect (EventLoop &loop, const std::string &address, const std::string &portid,
+                                      const CancelToken &token, int intensity = SP_INTENSITY) const;
+
+}; /* End of class ServiceProbes */
+
+/* Function Declarations */
+std::string FillVersionField (const std::string &field, const std::vector <std::string> &groups);
+
+#endif
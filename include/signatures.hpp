@@ -0,0 +1,76 @@
+/*
+ ***********************************************************************************************************************
+ * File: signatures.hpp
+ * Description: This file contains declarations of constants, data structures, class & member functions associated
+ *              with the multi-pattern vulnerability signature engine used to classify NMAP script output.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_SIGNATURES_HPP
+#define PORTHAWK_SIGNATURES_HPP
+
+#include <cstdint>
+#include "logger.hpp"
+
+const std::string SIG_FILE = DIR_BASE + "Signatures.txt";
+const std::string SIG_CVE_MARKER = "cve-";
+
+/*
+ * Default signatures, used when SIG_FILE is absent. One signature per line, as "<severity><TAB><pattern>". Patterns
+ * are matched case-insensitively, lines starting with '#' are comments. A pattern of severity "none" excludes the
+ * patterns it ends with, so "NOT VULNERABLE:" is not taken for "VULNERABLE:".
+ */
+const std::string DEFAULT_SIGNATURES =
+    "critical\tState: VULNERABLE (Exploitable)\n"
+    "high\tState: VULNERABLE\n"
+    "high\tVULNERABLE:\n"
+    "none\tNOT VULNERABLE:\n"
+    "medium\tState: LIKELY VULNERABLE\n"
+    "low\tLikely vulnerable\n"
+    "info\tState: UNKNOWN\n";
+
+/* Severity levels, ordered so that the highest one matched wins */
+enum Severity : uint8_t {
+    SEV_NONE = 0,
+    SEV_INFO = 1,
+    SEV_LOW = 2,
+    SEV_MEDIUM = 3,
+    SEV_HIGH = 4,
+    SEV_CRITICAL = 5,
+};
+
+/* Severity assigned to script output which carries CVE ids but matches no signature */
+const Severity SEV_CVE_ONLY = SEV_LOW;
+
+/* Verdict of a single pass over a script's output */
+struct ScriptVerdict {
+    Severity severity = SEV_NONE;
+    std::vector <std::string> cves;
+};
+
+/* Function Declarations */
+const std::string SeverityName (Severity severity);
+Severity ParseSeverity (const std::string &name);
+
+/* SignatureEngine class */
+/* Patterns are compiled into an Aho-Corasick automaton over byte classes, with all transitions precomputed, so each
+ * script's output is classified in a single pass. Once loaded, the engine is read-only and shared across threads. */
+class SignatureEngine {
+    private:
+        uint8_t byteClass [256];
+        int numClasses;
+        std::vector <int32_t> transitions;
+        std::vector <Severity> nodeSeverity;
+        std::vector <bool> nodeCVE;
+        void Compile (const std::vector <std::pair <std::string, Severity>> &patterns);
+    public:
+        SignatureEngine ();
+        ReturnCodes Load (const std::string &fileName, Logger objLog);
+        size_t LoadFromString (const std::string &signatures);
+        ScriptVerdict Classify (const std::string &text) const;
+
+}; /* End of class SignatureEngine */
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ ***********************************************************************************************************************
+ * File: tls.hpp
+ * Description: This file contains declarations of constants, data structures & functions associated with the native
+ *              TLS inspection of a port: the protocol versions & cipher suites it accepts and the fields of the
+ *              certificate chain it presents, gathered with non-blocking OpenSSL handshakes on an event loop. Without
+ *              OpenSSL the inspection does nothing.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_TLS_HPP
+#define PORTHAWK_TLS_HPP
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "eventloop.hpp"
+
+const int TLS_TIMEOUT_MS = 3000;
+const int TLS_CONCURRENCY = 64;
+/* Cipher suites enumerated per protocol version, each costs a handshake */
+const size_t TLS_MAX_CIPHERS = 64;
+/* Name of an algorithm OpenSSL cannot name */
+const std::string TLS_UNKNOWN_NAME = "unknown";
+
+class CancelToken;
+struct ssl_st;
+
+/* Fields of a certificate of the chain presented by the server */
+struct TLSCertificate {
+    std::string subject;
+    std::string issuer;
+    std::string serial;
+    std::string notBefore;
+    std::string notAfter;
+    bool expired = false;
+    std::string signature;
+    std::string keyType;
+    int keyBits = 0;
+    std::vector <std::string> altNames;
+    std::string sha256;
+};
+
+/* A protocol version accepted by the server, with its cipher suites in the order the server prefers them */
+struct TLSProtocol {
+    std::string name;
+    std::vector <std::string> ciphers;
+};
+
+/* Outcome of the TLS inspection of a port */
+struct TLSReport {
+    bool handshake = false;
+    int handshakes = 0;
+    std::vector <TLSProtocol> protocols;
+    std::vector <TLSCertificate> chain;
+};
+
+/* NetStream class */
+/* A TCP connection, wrapped in TLS or not, read & written as tasks of an event loop */
+class NetStream {
+    private:
+        int fd;
+        struct ssl_st *ssl;
+    public:
+        NetStream ();
+        ~NetStream ();
+        NetStream (const NetStream &) = delete;
+        NetStream &operator= (const NetStream &) = delete;
+        Task <bool> Open (EventLoop &loop, const std::string &address, const std::string &portid, bool encrypted,
+                          int timeoutMs);
+        Task <bool> Send (EventLoop &loop, const std::string &data, int timeoutMs);
+        Task <ssize_t> Receive (EventLoop &loop, char *buffer, size_t length, int timeoutMs);
+        void Close ();
+
+}; /* End of class NetStream */
+
+/* Function Declarations */
+bool TLSAvailable ();
+bool IsTLSService (const std::string &service, const std::string &portid);
+Task <TLSReport> InspectTLS (EventLoop &loop, const std::string &address, const std::string &portid,
+                             const CancelToken &token);
+
+#endif
@@ -30,10 +30,65 @@ const std::string MOD_SUM_PORTS = "Ports Summary";
 const std::string MOD_MULTI_SCAN = "Multi-threaded NMAP Script Scan";
 const std::string MOD_DEEP_SCAN = "NMAP Script Scan";
 const std::string MOD_DEEP_SUM = "NMAP Script Scan Summary";
+const std::string MOD_JOURNAL = "Scan Journal";
+const std::string MOD_SIGNATURES = "Vulnerability Signatures";
+const std::string MOD_CVE_INDEX = "CVE Index";
+const std::string MOD_CPE_INDEX = "CPE Index";
+const std::string MOD_METRICS = "Run Metrics";
+const std::string MOD_TRACE = "Trace Recorder";
+const std::string MOD_CGROUP = "Cgroup Accounting";
+const std::string MOD_DAEMON = "Scan Daemon";
+const std::string MOD_NATIVE_DISC = "Native Discovery";
+const std::string MOD_BANNER = "Banner Grabbing";
+const std::string MOD_SERVICE_PROBES = "Service Probes";
+const std::string MOD_TLS = "TLS Inspection";
+const std::string MOD_HTTP = "HTTP Fingerprinting";
+const std::string MOD_UDP_DISC = "UDP Discovery";
+const std::string MOD_PORT_ORDER = "Frequency-ordered Discovery";
+const std::string MOD_LIVENESS = "Host Discovery";
+const std::string MOD_COMMANDS = "Command Templates";
 
 /* Return Codes */
 /* Use postive integers for PASS and INFO messages and negative integers for FAIL messages. */
 enum ReturnCodes {
+    WORK_DIRS_FAIL = -55,
+    ANTI_INFO_COMMANDS_DEFAULT = -54,
+    COMMAND_TEMPLATE_FAIL = -53,
+    ANTI_INFO_DISC_SHARD = -52,
+    ANTI_INFO_HOST_SKIPPED = -51,
+    LIVENESS_SWEEP_FAIL = -50,
+    ANTI_INFO_DISC_TAIL = -49,
+    ANTI_INFO_DISC_HEAD = -48,
+    UDP_SWEEP_FAIL = -47,
+    ANTI_INFO_HTTP_PORT = -46,
+    ANTI_INFO_HTTP_FINGERPRINT = -45,
+    ANTI_INFO_TLS_PORT = -44,
+    TLS_INSPECT_FAIL = -43,
+    ANTI_INFO_SERVICE_VERSION = -42,
+    SERVICE_PROBES_FAIL = -41,
+    ANTI_INFO_BANNER_GRAB = -40,
+    ANTI_INFO_NATIVE_DISC = -39,
+    NATIVE_DISC_FAIL = -38,
+    ANTI_INFO_DAEMON_STOP = -37,
+    ANTI_INFO_DAEMON_JOB = -36,
+    DAEMON_START_FAIL = -35,
+    ANTI_INFO_CGROUP_STAT = -34,
+    CGROUP_SETUP_FAIL = -33,
+    TRACE_WRITE_FAIL = -32,
+    ANTI_INFO_METRICS_REPORT = -31,
+    METRICS_DUMP_FAIL = -30,
+    ANTI_INFO_CPE_QUERY = -29,
+    ANTI_INFO_CVE_MATCH = -28,
+    CVE_INDEX_BUILD_FAIL = -27,
+    CVE_INDEX_OPEN_FAIL = -26,
+    ANTI_INFO_SIG_DEFAULT = -25,
+    SIG_LOAD_FAIL = -24,
+    CMD_EXEC_CANCEL = -23,
+    ANTI_INFO_SCAN_CANCEL = -22,
+    ANTI_INFO_JOURNAL_PORT = -21,
+    ANTI_INFO_JOURNAL_DISC = -20,
+    JOURNAL_LOAD_FAIL = -19,
+    JOURNAL_OPEN_FAIL = -18,
     VULNS_NOT_FOUND = -17,
     ANTI_INFO_NMAP_SCRIPT_SUM = -16,
     NMAP_SCRIPT_FAIL = -15,
@@ -68,11 +123,65 @@ enum ReturnCodes {
     NMAP_SCRIPT_PASS = 15,
     NMAP_SCRIPT_SUM_INFO = 16,
     VULNS_FOUND = 17,
+    JOURNAL_OPEN_PASS = 18,
+    JOURNAL_LOAD_PASS = 19,
+    JOURNAL_DISC_INFO = 20,
+    JOURNAL_PORT_INFO = 21,
+    SCAN_CANCEL_INFO = 22,
+    SIG_LOAD_PASS = 24,
+    SIG_DEFAULT_INFO = 25,
+    CVE_INDEX_OPEN_PASS = 26,
+    CVE_INDEX_BUILD_PASS = 27,
+    CVE_MATCH_INFO = 28,
+    CPE_QUERY_INFO = 29,
+    METRICS_DUMP_PASS = 30,
+    METRICS_REPORT_INFO = 31,
+    TRACE_WRITE_PASS = 32,
+    CGROUP_SETUP_PASS = 33,
+    CGROUP_STAT_INFO = 34,
+    DAEMON_START_PASS = 35,
+    DAEMON_JOB_INFO = 36,
+    DAEMON_STOP_INFO = 37,
+    NATIVE_DISC_PASS = 38,
+    NATIVE_DISC_INFO = 39,
+    BANNER_GRAB_INFO = 40,
+    SERVICE_PROBES_PASS = 41,
+    SERVICE_VERSION_INFO = 42,
+    TLS_INSPECT_PASS = 43,
+    TLS_PORT_INFO = 44,
+    HTTP_FINGERPRINT_INFO = 45,
+    HTTP_PORT_INFO = 46,
+    UDP_SWEEP_PASS = 47,
+    DISC_HEAD_INFO = 48,
+    DISC_TAIL_INFO = 49,
+    LIVENESS_SWEEP_PASS = 50,
+    HOST_SKIPPED_INFO = 51,
+    DISC_SHARD_INFO = 52,
+    COMMANDS_LOAD_PASS = 53,
+    COMMANDS_DEFAULT_INFO = 54,
+    WORK_DIRS_PASS = 55,
 };
 
 /* Return Messages */
 /* Make sure to leave a space after the message, to make adding optional messages presentable. */
 static std::map <ReturnCodes, std::string> ReturnMessages = {
+    {WORK_DIRS_FAIL, "Creating the working directories has failed, ensure the current path is writable. "},
+    {COMMAND_TEMPLATE_FAIL, "Command template is invalid, the built-in template is kept. "},
+    {LIVENESS_SWEEP_FAIL, "Host liveness sweep has failed, a target is not an IPv4 address. "},
+    {UDP_SWEEP_FAIL, "UDP discovery sweep has failed, the target is not an IPv4 address or no socket is available. "},
+    {TLS_INSPECT_FAIL, "TLS inspection has failed, PortHawk has been built without OpenSSL. "},
+    {SERVICE_PROBES_FAIL, "Loading the service probes has failed, NMAP -sV will detect versions. "},
+    {NATIVE_DISC_FAIL, "Native discovery sweep has failed, the target is not an IPv4 address. "},
+    {DAEMON_START_FAIL, "Starting the scan daemon has failed, the socket could not be bound. "},
+    {CGROUP_SETUP_FAIL, "Setting up cgroup accounting has failed, scan stages will not be accounted. "},
+    {TRACE_WRITE_FAIL, "Writing the scan trace has failed. "},
+    {METRICS_DUMP_FAIL, "Dumping the run metrics has failed. "},
+    {CVE_INDEX_BUILD_FAIL, "Building the offline CVE index from the feed has failed. "},
+    {CVE_INDEX_OPEN_FAIL, "Opening the offline CVE index has failed, skipping known CVE lookup. "},
+    {SIG_LOAD_FAIL, "Signature file holds no valid signature, using the built-in signatures. "},
+    {CMD_EXEC_CANCEL, "Executing the command has been cancelled, its process group has been reaped. "},
+    {JOURNAL_LOAD_FAIL, "Reloading the scan journal has failed, scanning from the start. "},
+    {JOURNAL_OPEN_FAIL, "Opening the scan journal has failed, progress will not be checkpointed. "},
     {VULNS_NOT_FOUND, "No known vulnerabilities found, as per NMAP vulnerability scan. "},
     {NMAP_SCRIPT_FAIL, "Probing port for deeper information has failed. "},
     {NMAP_SCRIPT_XML_FAIL, "Parsing the XML file to identify deep information has failed. " },
@@ -103,6 +212,43 @@ static std::map <ReturnCodes, std::string> ReturnMessages = {
     {NMAP_SCRIPT_PASS, "NMAP script scan has been completed successfully. "},
     {NMAP_SCRIPT_SUM_INFO, "NMAP Script Scan Summary. "},
     {VULNS_FOUND, "Possible known vulnerability found on the port. "},
+    {JOURNAL_OPEN_PASS, "Scan journal has been opened. "},
+    {JOURNAL_LOAD_PASS, "Scan journal has been reloaded, resuming outstanding work. "},
+    {JOURNAL_DISC_INFO, "Open ports discovery restored from the scan journal. "},
+    {JOURNAL_PORT_INFO, "NMAP script scan results restored from the scan journal. "},
+    {SCAN_CANCEL_INFO, "Cancellation requested, no new scans will be scheduled. "},
+    {SIG_LOAD_PASS, "Vulnerability signatures have been loaded. "},
+    {SIG_DEFAULT_INFO, "Signature file not found, using the built-in signatures. "},
+    {CVE_INDEX_OPEN_PASS, "Offline CVE index has been opened. "},
+    {CVE_INDEX_BUILD_PASS, "Offline CVE index has been built. "},
+    {CVE_MATCH_INFO, "Matched open ports' product & version against the offline CVE index. "},
+    {CPE_QUERY_INFO, "Looked up CPE prefix across all scanned hosts. "},
+    {METRICS_DUMP_PASS, "Run metrics have been dumped. "},
+    {METRICS_REPORT_INFO, "Run Timing Report. "},
+    {TRACE_WRITE_PASS, "Scan trace has been written. "},
+    {CGROUP_SETUP_PASS, "Cgroup accounting has been set up for every scan stage. "},
+    {CGROUP_STAT_INFO, "Resources used by scan stage. "},
+    {DAEMON_START_PASS, "Scan daemon is listening for jobs. "},
+    {DAEMON_JOB_INFO, "Scan daemon has started a job. "},
+    {DAEMON_STOP_INFO, "Scan daemon has stopped, outstanding jobs have been cancelled. "},
+    {NATIVE_DISC_PASS, "Native discovery sweep has been completed. "},
+    {NATIVE_DISC_INFO, "Native discovery congestion control. "},
+    {BANNER_GRAB_INFO, "Banner grabbing has identified services without NMAP. "},
+    {SERVICE_PROBES_PASS, "Service probes have been loaded. "},
+    {SERVICE_VERSION_INFO, "Native version detection. "},
+    {TLS_INSPECT_PASS, "TLS inspection has been completed. "},
+    {TLS_PORT_INFO, "TLS service inspected. "},
+    {HTTP_FINGERPRINT_INFO, "HTTP fingerprinting has been completed. "},
+    {HTTP_PORT_INFO, "Web service fingerprinted. "},
+    {UDP_SWEEP_PASS, "UDP discovery sweep has been completed. "},
+    {DISC_HEAD_INFO, "Most frequently open ports have been swept, the rest are swept in the background. "},
+    {DISC_TAIL_INFO, "Background sweep of the remaining ports has been completed. "},
+    {LIVENESS_SWEEP_PASS, "Host liveness sweep has been completed. "},
+    {HOST_SKIPPED_INFO, "Target left out of port discovery by the liveness sweep. "},
+    {DISC_SHARD_INFO, "Open ports sweep has been split across concurrent NMAP processes. "},
+    {COMMANDS_LOAD_PASS, "Command templates have been loaded. "},
+    {COMMANDS_DEFAULT_INFO, "Command template file not found, using the built-in templates. "},
+    {WORK_DIRS_PASS, "Working directories have been created. "},
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+ ***********************************************************************************************************************
+ * File: trace.hpp
+ * Description: This file contains declarations of data structures, classes & member functions associated with the
+ *              optional trace recorder, which writes a timeline of the scan as Chrome/Perfetto trace-event JSON.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_TRACE_HPP
+#define PORTHAWK_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "logger.hpp"
+
+/* Trace categories */
+const std::string TRACE_LOG = "log";
+const std::string TRACE_JOURNAL = "journal";
+
+/* A completed span, timestamps are in microseconds since the recorder was enabled. An async span is one of many
+ * running at once on a thread, e.g. a port task suspended on its NMAP child, and is drawn on a track of its item. */
+struct TraceEvent {
+    std::string name;
+    std::string category;
+    std::string item;
+    uint64_t start;
+    uint64_t duration;
+    bool async;
+};
+
+/* Events recorded by a single thread. Only the owning thread appends, so its lock is never contended while scanning. */
+struct TraceBuffer {
+    uint32_t tid;
+    std::string threadName;
+    std::mutex mtx;
+    std::vector <TraceEvent> events;
+};
+
+/* TraceRecorder class */
+class TraceRecorder {
+    private:
+        std::atomic <bool> enabled;
+        std::chrono::steady_clock::time_point epoch;
+        std::mutex mtx;
+        std::deque <TraceBuffer> buffers;
+        TraceBuffer &LocalBuffer ();
+    public:
+        TraceRecorder ();
+        void Enable ();
+        bool IsEnabled () const { return enabled.load (std::memory_order_relaxed); }
+        uint64_t Offset (std::chrono::steady_clock::time_point point) const;
+        void NameThread (const std::string &name);
+        void Record (const std::string &name, const std::string &category, const std::string &item, uint64_t start,
+                     uint64_t duration, bool async = false);
+        ReturnCodes Write (const std::string &fileName, Logger objLog);
+
+}; /* End of class TraceRecorder */
+
+extern TraceRecorder traceRecorder;
+
+/* Records the time between its construction and destruction as a span, when tracing is enabled */
+class TraceScope {
+    private:
+        bool active;
+        std::string name;
+        std::string category;
+        std::string item;
+        std::chrono::steady_clock::time_point start;
+    public:
+        TraceScope (const std::string &spanName, const std::string &spanCategory, const std::string &spanItem = "");
+        ~TraceScope ();
+        TraceScope (const TraceScope &) = delete;
+        TraceScope &operator= (const TraceScope &) = delete;
+
+}; /* End of class TraceScope */
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ ***********************************************************************************************************************
+ * File: udp.hpp
+ * Description: This file contains declarations of constants, data structures & functions associated with the native
+ *              UDP discovery sweep. A silent UDP port cannot be told from a filtered one, so every port is sent the
+ *              payload its conventional service answers to, in batches over a single socket, while replies & the ICMP
+ *              port-unreachables of closed ports are collected in batches as well. Probes leave at a fixed rate, as
+ *              targets limit the rate of their ICMP errors, and unanswered ones are retransmitted.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_UDP_HPP
+#define PORTHAWK_UDP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "discovery.hpp"
+
+/* Datagrams sent or received per system call */
+const size_t UDP_BATCH = 64;
+const double UDP_RATE_PPS = 500;
+const int UDP_TIMEOUT_MS = 1000;
+const int UDP_RETRIES = 2;
+const size_t UDP_MAX_REPLY = 2048;
+
+/* A protocol-correct payload, sent to the port its service conventionally listens on */
+struct UDPPayload {
+    uint16_t port;
+    std::string service;
+    std::string payload;
+};
+
+/* Function Declarations */
+const std::vector <UDPPayload> &UDPPayloads ();
+Task <ReturnCodes> UDPSweep (EventLoop &loop, const std::string &address, const std::vector <uint16_t> &ports,
+                             const CancelToken &token, SweepResult &result);
+
+#endif
@@ -12,21 +12,122 @@
 #ifndef PORTHAWK_UTILITIES_HPP
 #define PORTHAWK_UTILITIES_HPP
 #include <arpa/inet.h>
+#include <atomic>
 #include <csignal>
+#include <cstdint>
 #include <netdb.h>
+#include <unordered_map>
+#include "eventloop.hpp"
 #include "logger.hpp"
 
-const std::string ID        = "id";
-const std::string XML_FILE  = "xmlFile";
-const std::string TARGET    = "target";
+const int CHILD_GRACE_MS  = 3000;
+const int CANCEL_POLL_MS  = 100;
+/* Exit status of a child whose program could not be run, as shells report it */
+const int EXIT_NOT_RUN    = 127;
+/* Addresses a run may target, i.e. a /16 */
+const size_t MAX_TARGETS  = 65536;
+
+/* Command line flags */
+const std::string FLAG_RESUME = "--resume";
+const std::string FLAG_BUILD_CVE = "--build-cve-index";
+const std::string FLAG_CPE = "--cpe";
+const std::string FLAG_TRACE = "--trace";
+const std::string FLAG_CGROUP = "--cgroup";
+const std::string FLAG_DAEMON = "--daemon";
+const std::string FLAG_SOCKET = "--socket";
+const std::string FLAG_NATIVE = "--native";
+const std::string FLAG_UDP = "--udp";
+const std::string FLAG_FREQUENT_FIRST = "--frequent-first";
+const std::string FLAG_SHARDS = "--shards";
+const std::string FLAG_PING = "--ping";
+const std::string FLAG_UNKNOWN_HOSTS = "--unknown-hosts";
+const std::string FLAG_BANNERS = "--banners";
+const std::string FLAG_VERSION_PROBES = "--version-probes";
+const std::string FLAG_TLS = "--tls";
+const std::string FLAG_HTTP = "--http";
+const std::string FLAG_HTTP_PATH = "--http-path";
+
+/* Scan stages, each given its own cgroup when cgroup accounting is enabled */
+const std::string STAGE_DISCOVERY = "discovery";
+const std::string STAGE_DEEP = "deep";
+
+/* User supplied options */
+struct Options {
+    std::string address;
+    std::vector <std::string> addresses;
+    bool ping = false;
+    std::string unknownHosts = "scan";
+    bool resume = false;
+    bool native = false;
+    bool udp = false;
+    bool frequentFirst = false;
+    std::string shards = "1";
+    bool banners = false;
+    bool versionProbes = false;
+    bool tls = false;
+    bool http = false;
+    std::vector <std::string> httpPaths;
+    std::string cveFeed;
+    std::vector <std::string> cpeQueries;
+    std::string traceFile;
+    std::string cgroupRoot;
+    bool daemon = false;
+    std::string socketPath;
+};
+
+/* Resources used by a spawned child and the descendants it has reaped, as reported by wait4 () */
+struct ChildUsage {
+    bool valid = false;
+    int exitStatus = -1;
+    int termSignal = 0;
+    uint64_t wallMicros = 0;
+    uint64_t userMicros = 0;
+    uint64_t sysMicros = 0;
+    long maxRSSKiB = 0;
+};
+
+/* CancelToken class */
+/* Cancelling only sets a lock-free flag, so it is safe to do from a signal handler. */
+class CancelToken {
+    private:
+        std::atomic <bool> cancelled;
+    public:
+        CancelToken ();
+        void Cancel ();
+        bool IsCancelled () const;
+
+}; /* End of class CancelToken */
+
+extern CancelToken interruptToken;
+
+/* CgroupStages class */
+/* Optional cgroup v2 accounting, a sub-group per scan stage under a delegated, writable cgroup directory */
+class CgroupStages {
+    private:
+        std::string root;
+    public:
+        ReturnCodes Setup (const std::string &rootDir, Logger objLog);
+        std::string StageDir (const std::string &stage) const;
+        void Report (Logger objLog) const;
+
+}; /* End of class CgroupStages */
+
+extern CgroupStages scanCgroups;
 
 /* Function Declarations */
 void UsageExit (ReturnCodes code);
 void KeyboardInterrupt (int signal);
-ReturnCodes ExecuteSystemCommand (const std::string &command, std::stringstream &output);
-ReturnCodes ValidateArguments (int argCount, char **values, std::string &address);
+Task <ReturnCodes> ExecuteCommandAsync (EventLoop &loop, const std::vector <std::string> &command,
+                                        std::stringstream &output, const CancelToken &token,
+                                        ChildUsage *usage = nullptr, const std::string &cgroup = "");
+ReturnCodes ExecuteSystemCommand (const std::vector <std::string> &command, std::stringstream &output,
+                                  const CancelToken &token, ChildUsage *usage = nullptr,
+                                  const std::string &cgroup = "");
+ReturnCodes ValidateArguments (int argCount, char **values, Options &options);
 ReturnCodes ConvertToIPAddress (const std::string &target, std::string &address);
-std::string ReplacePlaceHolders (const std::string &command, 
-                                 const std::unordered_map <std::string, std::string> &placeHolders);
+ReturnCodes ExpandTarget (const std::string &target, std::vector <std::string> &addresses);
+std::string EscapeJSON (const std::string &value);
+std::string FormatChildUsage (const ChildUsage &usage);
+void MergeChildUsage (ChildUsage &total, const ChildUsage &usage);
 
 #endif
\ No newline at end of file
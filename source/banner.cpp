@@ -0,0 +1,194 @@
+/*
+ ***********************************************************************************************************************
+ * File: banner.cpp
+ * Description: This file contains definitions of support functions associated with banner grabbing & the rules used
+ *              to identify services from their banners.
+ * Functions:
+ *           vector <BannerRule> &BannerRules ()
+ *           bool MatchMySQL ()
+ *           Task <int> ConnectTCP ()
+ *           Task <string> GrabBanner ()
+ *           bool MatchBanner ()
+ *           string PrintableBanner ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <arpa/inet.h>
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "scanner.hpp"
+
+
+/*
+ * This function returns the banner rules, compiled on first use. Specific rules come before the generic rule of
+ * their protocol, the first matching rule wins.
+ * :return: reference to the vector of BannerRule objects.
+ */
+static const std::vector <BannerRule> &BannerRules () {
+
+    auto rule = [](const std::string &service, const std::string &product, const std::string &pattern, int productGroup,
+                   int versionGroup, int extraGroup) {
+        return BannerRule {service, product, std::regex (pattern, std::regex::ECMAScript | std::regex::optimize),
+                           productGroup, versionGroup, extraGroup};
+    };
+    static const std::vector <BannerRule> rules = {
+        rule ("ssh", "OpenSSH", R"(^SSH-[\d.]+-OpenSSH_([^\s]+)(?:[ \t]+([^\r\n]+))?)", 0, 1, 2),
+        rule ("ssh", "Dropbear sshd", R"(^SSH-[\d.]+-dropbear_([^\s]+))", 0, 1, 0),
+        rule ("ssh", "", R"(^SSH-[\d.]+-([^\s_]+)(?:_([^\s]+))?)", 1, 2, 0),
+        rule ("ftp", "vsftpd", R"(^220[ -]\(vsFTPd ([\d.]+)\))", 0, 1, 0),
+        rule ("ftp", "ProFTPD", R"(^220[ -]ProFTPD ([\w.]+))", 0, 1, 0),
+        rule ("ftp", "Pure-FTPd", R"(^220[ -].*Pure-FTPd)", 0, 0, 0),
+        rule ("ftp", "FileZilla ftpd", R"(^220[ -].*FileZilla Server(?: version)? ?([\w.]+)?)", 0, 1, 0),
+        rule ("ftp", "Microsoft ftpd", R"(^220[ -]Microsoft FTP Service)", 0, 0, 0),
+        rule ("smtp", "Postfix smtpd", R"(^220[ -][^\s]+ ESMTP Postfix)", 0, 0, 0),
+        rule ("smtp", "Exim smtpd", R"(^220[ -][^\s]+ ESMTP Exim ([\d.]+))", 0, 1, 0),
+        rule ("smtp", "Sendmail", R"(^220[ -][^\s]+ ESMTP Sendmail ([\w.]+))", 0, 1, 0),
+        rule ("smtp", "Microsoft ESMTP", R"(^220[ -][^\s]+ Microsoft ESMTP MAIL Service(?:, Version: ([\d.]+))?)", 0, 1,
+              0),
+        rule ("pop3", "Dovecot pop3d", R"(^\+OK .*Dovecot)", 0, 0, 0),
+        rule ("imap", "Dovecot imapd", R"(^\* OK .*Dovecot)", 0, 0, 0),
+        rule ("imap", "Courier Imapd", R"(^\* OK .*Courier-IMAP)", 0, 0, 0),
+        rule ("vnc", "VNC", R"(^RFB (\d{3}\.\d{3}))", 0, 1, 0),
+        rule ("mongodb", "MongoDB", R"(^It looks like you are trying to access MongoDB)", 0, 0, 0),
+        /* Generic rules, the protocol is known but not the product */
+        rule ("ftp", "", R"(^220[ -][^\r\n]*FTP)", 0, 0, 0),
+        rule ("smtp", "", R"(^220[ -][^\r\n]*E?SMTP)", 0, 0, 0),
+        rule ("pop3", "", R"(^\+OK)", 0, 0, 0),
+        rule ("imap", "", R"(^\* OK)", 0, 0, 0),
+    };
+    return rules;
+
+} /* End of BannerRules () */
+
+
+/*
+ * This function identifies the greeting of a MySQL or MariaDB server: a packet holding protocol version 10 followed
+ * by the NUL terminated server version.
+ * :arg: banner, const string holding the bytes received.
+ * :arg: port, Port object to which the service information is copied.
+ * :return: bool value indicating whether the banner is such a greeting.
+ */
+static bool MatchMySQL (const std::string &banner, Port &port) {
+
+    if (banner.size () < 6 || banner [3] != 0 || banner [4] != 10) { return false; }
+    size_t end = banner.find ('\0', 5);
+    if (end == std::string::npos || end == 5) { return false; }
+    std::string version = banner.substr (5, end - 5);
+    port.service = "mysql";
+    port.product = version.find ("MariaDB") != std::string::npos ? "MariaDB" : "MySQL";
+    port.version = version.substr (0, version.find ('-'));
+    return true;
+
+} /* End of MatchMySQL () */
+
+
+/*
+ * This function opens a non-blocking TCP connection to a port, as a task of the given loop.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target.
+ * :arg: portid, const string holding the port.
+ * :arg: timeoutMs, integer denoting the milliseconds given to connect.
+ * :return: integer holding the connected socket, or the negated errno of the failure (ETIMEDOUT on timeout).
+ */
+Task <int> ConnectTCP (EventLoop &loop, const std::string &address, const std::string &portid, int timeoutMs) {
+
+    struct sockaddr_in target {};
+    target.sin_family = AF_INET;
+    target.sin_port = htons (static_cast <uint16_t> (std::stoi (portid)));
+    if (inet_pton (AF_INET, address.c_str (), &target.sin_addr) != 1) { co_return -EINVAL; }
+    int fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { co_return -errno; }
+    int error = 0;
+    if (connect (fd, reinterpret_cast <struct sockaddr *> (&target), sizeof (target)) != 0) {
+        error = errno;
+        if (error == EINPROGRESS) {
+            error = ETIMEDOUT;
+            if (co_await loop.Writable (fd, timeoutMs)) {
+                socklen_t length = sizeof (error);
+                getsockopt (fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            }
+        }
+    }
+    if (error != 0) {
+        close (fd);
+        co_return -error;
+    }
+    co_return fd;
+
+} /* End of ConnectTCP () */
+
+
+/*
+ * This function connects to a port and reads what the service sends on its own, as a task of the given loop. Reading
+ * stops at the deadline, once the first bytes have been followed by BANNER_LINGER_MS of silence, or after
+ * BANNER_MAX_BYTES.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target, which must outlive the task.
+ * :arg: portid, const string holding the port, which must outlive the task.
+ * :arg: timeoutMs, integer denoting the milliseconds given to connect and to receive the first bytes.
+ * :return: string holding the bytes received, empty when the service stays silent or the connect fails.
+ */
+Task <std::string> GrabBanner (EventLoop &loop, const std::string &address, const std::string &portid, int timeoutMs) {
+
+    std::string banner;
+    int fd = co_await ConnectTCP (loop, address, portid, timeoutMs);
+    if (fd < 0) { co_return banner; }
+    char buffer [BANNER_MAX_BYTES];
+    for (int wait = timeoutMs; banner.size () < BANNER_MAX_BYTES; wait = BANNER_LINGER_MS) {
+        if (!co_await loop.Readable (fd, wait)) { break; }
+        ssize_t bytes = recv (fd, buffer, BANNER_MAX_BYTES - banner.size (), 0);
+        if (bytes < 0 && (errno == EINTR || errno == EAGAIN)) { continue; }
+        if (bytes <= 0) { break; }
+        banner.append (buffer, bytes);
+    }
+    close (fd);
+    co_return banner;
+
+} /* End of GrabBanner () */
+
+
+/*
+ * This function identifies the service of a port from its banner, filling its service, product, version & extra
+ * information. Generic rules only fill the service, and some products do not announce their version, so the product
+ * & version may be left empty even when the service has been identified.
+ * :arg: banner, const string holding the bytes received from the port.
+ * :arg: port, Port object to which the service information is copied.
+ * :return: bool value indicating whether the service has been identified.
+ */
+bool MatchBanner (const std::string &banner, Port &port) {
+
+    if (banner.empty ()) { return false; }
+    if (MatchMySQL (banner, port)) { return true; }
+    std::smatch match;
+    for (const BannerRule &rule : BannerRules ()) {
+        if (!std::regex_search (banner, match, rule.pattern)) { continue; }
+        port.service = rule.service;
+        port.product = rule.productGroup ? match [rule.productGroup].str () : rule.product;
+        if (rule.versionGroup) { port.version = match [rule.versionGroup].str (); }
+        if (rule.extraGroup) { port.extraInfo = match [rule.extraGroup].str (); }
+        return true;
+    }
+    return false;
+
+} /* End of MatchBanner () */
+
+
+/*
+ * This function makes a banner fit for logs & summaries: the first BANNER_KEEP_BYTES bytes, with line breaks and
+ * other unprintable bytes shown as '.'.
+ * :arg: banner, const string holding the bytes received from the port.
+ * :return: string holding the printable banner.
+ */
+std::string PrintableBanner (const std::string &banner) {
+
+    std::string printable = banner.substr (0, BANNER_KEEP_BYTES);
+    while (!printable.empty () && (printable.back () == '\n' || printable.back () == '\r')) { printable.pop_back (); }
+    for (char &character : printable) {
+        if (character < 0x20 || character > 0x7e) { character = '.'; }
+    }
+    return printable;
+
+} /* End of PrintableBanner () */
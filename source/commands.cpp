@@ -0,0 +1,276 @@
+/*
+ ***********************************************************************************************************************
+ * File: commands.cpp
+ * Description: This file contains definitions of member functions associated with the compiled command templates.
+ * Functions:
+ *           class CommandTemplate
+ *              bool Compile ()
+ *              vector <string> Render ()
+ *              string Text ()
+ *           class CommandTemplates
+ *              CommandTemplates ()
+ *              ReturnCodes Load ()
+ *              vector <string> Render ()
+ *              CommandTemplate Get ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include "commands.hpp"
+
+/* Indexed by CommandSlot */
+static const std::array <std::string, SLOT_COUNT> SLOT_NAMES = {"target", "xmlFile", "ports", "id"};
+/* Indexed by CommandKind, the names templates are given in COMMANDS_FILE */
+static const std::array <std::string, COMMAND_COUNT> COMMAND_NAMES = {
+    "nmap-open", "nmap-deep", "nmap-script", "nmap-deep-udp",
+};
+/* Indexed by CommandKind, the slots each command is given, every one of them must appear in its template */
+static const std::array <uint32_t, COMMAND_COUNT> COMMAND_SLOTS = {
+    1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_PORTS,
+    1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_ID,
+    1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_ID,
+    1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_ID,
+};
+
+
+/*
+ * This function compiles the given template into the words of an argument vector, split on whitespace. Quotes group
+ * whitespace into a word and are dropped, slots are expanded within double quotes but not within single ones, and
+ * "$$" stands for a literal '$'. A slot name is the longest run of letters, digits & underscores after the '$', or
+ * the name between "${" and "}", so "$t" is never mistaken for the start of "$target". The current template is kept
+ * if the given one is invalid.
+ * :arg: source, const string holding the template, e.g. "nmap -p $id -oX $xmlFile $target".
+ * :arg: slots, uint32_t holding a bit per CommandSlot given to the command, every one of them must appear.
+ * :arg: error, string to which the reason is written, if the template is invalid.
+ * :return: bool value indicating whether the template is a valid one.
+ */
+bool CommandTemplate::Compile (const std::string &source, uint32_t slots, std::string &error) {
+
+    std::vector <std::vector <CommandSegment>> compiled;
+    std::vector <CommandSegment> word;
+    CommandSegment segment;
+    bool inWord = false;
+    char quote = 0;
+    uint32_t used = 0;
+    for (size_t index = 0; index < source.size ();) {
+        char character = source [index];
+        if (!quote && std::isspace (static_cast <unsigned char> (character))) {
+            if (inWord) {
+                if (!segment.literal.empty () || word.empty ()) { word.push_back (segment); }
+                compiled.push_back (word);
+                word.clear ();
+                segment = CommandSegment {};
+                inWord = false;
+            }
+            index++;
+            continue;
+        }
+        inWord = true;
+        if ((!quote && (character == '\'' || character == '"')) || character == quote) {
+            quote = quote ? 0 : character;
+            index++;
+            continue;
+        }
+        if (character != '$' || quote == '\'') {
+            segment.literal += character;
+            index++;
+            continue;
+        }
+        if (index + 1 < source.size () && source [index + 1] == '$') {
+            segment.literal += '$';
+            index += 2;
+            continue;
+        }
+        bool braced = index + 1 < source.size () && source [index + 1] == '{';
+        size_t start = index + 1 + braced;
+        size_t end = start;
+        while (end < source.size () && (std::isalnum (static_cast <unsigned char> (source [end])) ||
+                                        source [end] == '_')) {
+            end++;
+        }
+        std::string name = source.substr (start, end - start);
+        if (braced && (end >= source.size () || source [end] != '}')) {
+            error = "unterminated \"${\" at column " + std::to_string (index + 1);
+            return false;
+        }
+        auto known = std::find (SLOT_NAMES.begin (), SLOT_NAMES.end (), name);
+        if (name.empty () || known == SLOT_NAMES.end ()) {
+            error = "unknown slot \"$" + name + "\" at column " + std::to_string (index + 1);
+            return false;
+        }
+        segment.slot = static_cast <int> (known - SLOT_NAMES.begin ());
+        if (!(slots & 1U << segment.slot)) {
+            error = "slot \"$" + name + "\" is not given to this command";
+            return false;
+        }
+        used |= 1U << segment.slot;
+        word.push_back (segment);
+        segment = CommandSegment {};
+        index = end + braced;
+    }
+    if (quote) {
+        error = std::string ("unterminated ") + quote + " quote";
+        return false;
+    }
+    if (inWord) {
+        if (!segment.literal.empty () || word.empty ()) { word.push_back (segment); }
+        compiled.push_back (word);
+    }
+    if (compiled.empty () || compiled [0].size () != 1 || compiled [0][0].slot >= 0) {
+        error = "the program must be named literally";
+        return false;
+    }
+    for (size_t slot = 0; slot < SLOT_COUNT; slot++) {
+        if ((slots & ~used) & 1U << slot) {
+            error = "slot \"$" + SLOT_NAMES [slot] + "\" is missing";
+            return false;
+        }
+    }
+    text = source;
+    words = compiled;
+    return true;
+
+} /* End of Compile () */
+
+
+/*
+ * This function renders the template into an argument vector, copying its literals & the values of its slots. A slot
+ * making up a whole word is rendered as an argument per value, none if it has no value, while a slot within a word is
+ * rendered as its values joined by commas.
+ * :arg: values, const CommandValues object holding the values of the slots.
+ * :return: vector of the arguments, the program first.
+ */
+std::vector <std::string> CommandTemplate::Render (const CommandValues &values) const {
+
+    std::vector <std::string> arguments;
+    arguments.reserve (words.size () + values [SLOT_PORTS].size ());
+    for (const auto &word : words) {
+        if (word.size () == 1 && word [0].slot >= 0 && word [0].literal.empty ()) {
+            const auto &slotValues = values [word [0].slot];
+            arguments.insert (arguments.end (), slotValues.begin (), slotValues.end ());
+            continue;
+        }
+        std::string argument;
+        for (const auto &segment : word) {
+            argument += segment.literal;
+            if (segment.slot < 0) { continue; }
+            const auto &slotValues = values [segment.slot];
+            for (size_t index = 0; index < slotValues.size (); index++) {
+                if (index) { argument += ','; }
+                argument += slotValues [index];
+            }
+        }
+        arguments.push_back (std::move (argument));
+    }
+    return arguments;
+
+} /* End of Render () */
+
+
+/*
+ * This function returns the source of the template, as it was given.
+ * :return: const reference to the source of the template.
+ */
+const std::string &CommandTemplate::Text () const {
+
+    return text;
+
+} /* End of Text () */
+
+
+/*
+ * Instantiates a new object of CommandTemplates class, compiling the built-in templates.
+ */
+CommandTemplates::CommandTemplates () {
+
+    std::string error;
+    const std::array <std::string, COMMAND_COUNT> builtIn = {
+        BASE_NMAP_OPEN, BASE_NMAP_DEEP, BASE_NMAP_SCRIPT, BASE_NMAP_DEEP_UDP,
+    };
+    for (size_t kind = 0; kind < COMMAND_COUNT; kind++) {
+        templates [kind].Compile (builtIn [kind], COMMAND_SLOTS [kind], error);
+    }
+
+} /* End of CommandTemplates () */
+
+
+/*
+ * This function loads the user-defined templates of the given file, each overriding the built-in template of the
+ * command it names. Templates are validated as they are loaded, an invalid one is logged along with its line and the
+ * built-in template is kept in its stead.
+ * :arg: fileName, const string holding the path of the template file.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success or failure of the operation.
+ */
+ReturnCodes CommandTemplates::Load (const std::string &fileName, Logger objLog) {
+
+    /* module = MOD_COMMANDS */
+    std::ifstream input (fileName);
+    std::stringstream optional;
+    *this = CommandTemplates ();
+    if (!input) {
+        objLog.Log (INFO, MOD_COMMANDS, COMMANDS_DEFAULT_INFO, false);
+        return COMMANDS_DEFAULT_INFO;
+    }
+    std::string line;
+    size_t number = 0;
+    size_t loaded = 0;
+    ReturnCodes result = COMMANDS_LOAD_PASS;
+    while (std::getline (input, line)) {
+        number++;
+        size_t first = line.find_first_not_of (" \t\r");
+        if (first == std::string::npos || line [first] == '#') { continue; }
+        size_t equals = line.find ('=');
+        std::string name = line.substr (first, equals == std::string::npos ? std::string::npos : equals - first);
+        name.erase (name.find_last_not_of (" \t") + 1);
+        auto known = std::find (COMMAND_NAMES.begin (), COMMAND_NAMES.end (), name);
+        std::string error = equals == std::string::npos ? "expected \"<name> = <template>\"" :
+                            known == COMMAND_NAMES.end () ? "unknown command \"" + name + "\"" : "";
+        CommandTemplate candidate;
+        size_t kind = known - COMMAND_NAMES.begin ();
+        if (error.empty () && candidate.Compile (line.substr (equals + 1), COMMAND_SLOTS [kind], error)) {
+            templates [kind] = candidate;
+            loaded++;
+            continue;
+        }
+        optional.str ("");
+        optional << "Line " << number << ": " << error << ".";
+        objLog.Log (FAIL, MOD_COMMANDS, COMMAND_TEMPLATE_FAIL, true, optional);
+        result = COMMAND_TEMPLATE_FAIL;
+    }
+    optional.str ("");
+    optional << "Loaded " << loaded << " template(s).";
+    objLog.Log (PASS, MOD_COMMANDS, COMMANDS_LOAD_PASS, false, optional);
+    return result;
+
+} /* End of Load () */
+
+
+/*
+ * This function renders the template of the given command into an argument vector.
+ * :arg: kind, CommandKind naming the command.
+ * :arg: values, const CommandValues object holding the values of the slots.
+ * :return: vector of the arguments, the program first.
+ */
+std::vector <std::string> CommandTemplates::Render (CommandKind kind, const CommandValues &values) const {
+
+    return templates [kind].Render (values);
+
+} /* End of Render () */
+
+
+/*
+ * This function returns the template of the given command.
+ * :arg: kind, CommandKind naming the command.
+ * :return: const reference to the template.
+ */
+const CommandTemplate &CommandTemplates::Get (CommandKind kind) const {
+
+    return templates [kind];
+
+} /* End of Get () */
@@ -0,0 +1,231 @@
+/*
+ ***********************************************************************************************************************
+ * File: cpe.cpp
+ * Description: This file contains definitions of support functions & member functions associated with parsing,
+ *              normalising, interning and indexing CPE names reported by NMAP.
+ * Functions:
+ *           uint32_t InternString ()
+ *           bool FindInterned ()
+ *           string InternedString ()
+ *           bool ParseCPE ()
+ *           struct CPE
+ *              string ToString ()
+ *              bool operator== ()
+ *           class CPEIndex
+ *              void Add ()
+ *              vector Find ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include "cpe.hpp"
+
+/* Process wide string pool, id 0 (CPE_ANY) is the empty string */
+static std::mutex internMutex;
+static std::deque <std::string> internPool (1);
+static std::unordered_map <std::string, uint32_t> internIds = {{"", CPE_ANY}};
+
+
+/*
+ * This function interns the given string, so equal strings share a single copy and compare as integers.
+ * :arg: value, const string to be interned.
+ * :return: id of the interned string.
+ */
+uint32_t InternString (const std::string &value) {
+
+    std::lock_guard <std::mutex> lock (internMutex);
+    auto find = internIds.find (value);
+    if (find != internIds.end ()) { return find->second; }
+    uint32_t id = static_cast <uint32_t> (internPool.size ());
+    internPool.push_back (value);
+    internIds.emplace (value, id);
+    return id;
+
+} /* End of InternString () */
+
+
+/*
+ * This function looks up the id of an already interned string, without interning it.
+ * :arg: value, const string to be looked up.
+ * :arg: id, uint32_t to which the id is copied to.
+ * :return: bool value indicating whether the string has been interned.
+ */
+bool FindInterned (const std::string &value, uint32_t &id) {
+
+    std::lock_guard <std::mutex> lock (internMutex);
+    auto find = internIds.find (value);
+    if (find == internIds.end ()) { return false; }
+    id = find->second;
+    return true;
+
+} /* End of FindInterned () */
+
+
+/*
+ * This function returns the string interned under the given id.
+ * :arg: id, uint32_t of the interned string.
+ * :return: string holding the interned value, empty if the id is unknown.
+ */
+const std::string InternedString (uint32_t id) {
+
+    std::lock_guard <std::mutex> lock (internMutex);
+    return (id < internPool.size ()) ? internPool [id] : "";
+
+} /* End of InternedString () */
+
+
+/*
+ * This function parses a CPE name in either its 2.2 URI or 2.3 formatted string binding and normalises it. Components
+ * are lower cased and unescaped, and "*" & "-" are treated as unspecified, so both bindings of a name compare equal.
+ * :arg: name, const string holding the CPE name, or a prefix of one.
+ * :arg: cpe, CPE object to which the normalised name is copied to.
+ * :arg: depth, integer to which the number of leading components given (part counting as one) is copied to.
+ * :arg: intern, bool value indicating whether unseen components are interned, or fail the parse.
+ * :return: bool value indicating whether the name has been parsed.
+ */
+bool ParseCPE (const std::string &name, CPE &cpe, int &depth, bool intern) {
+
+    std::vector <std::string> fields (1);
+    bool formatted = name.compare (0, 8, "cpe:2.3:") == 0;
+    if (!formatted && name.compare (0, 5, "cpe:/") != 0) { return false; }
+    for (size_t index = formatted ? 8 : 5; index < name.size (); index++) {
+        char character = name [index];
+        if (character == '\\' && index + 1 < name.size ()) {
+            fields.back () += std::tolower (name [++index]);
+        } else if (!formatted && character == '%' && index + 2 < name.size () &&
+                   std::isxdigit (static_cast <unsigned char> (name [index + 1])) &&
+                   std::isxdigit (static_cast <unsigned char> (name [index + 2]))) {
+            fields.back () += static_cast <char> (std::tolower (std::stoi (name.substr (index + 1, 2), nullptr, 16)));
+            index += 2;
+        } else if (character == ':') {
+            fields.emplace_back ();
+        } else {
+            fields.back () += std::tolower (static_cast <unsigned char> (character));
+        }
+    }
+    if (fields [0].size () != 1 || std::string ("aoh").find (fields [0][0]) == std::string::npos) { return false; }
+
+    cpe = CPE ();
+    cpe.part = fields [0][0];
+    depth = 1;
+    uint32_t *ids [CPE_COMPONENTS] = {&cpe.vendor, &cpe.product, &cpe.version, &cpe.update};
+    for (int component = 0; component < CPE_COMPONENTS && component + 1 < static_cast <int> (fields.size ());
+         component++) {
+        std::string &value = fields [component + 1];
+        if (value == "*" || value == "-") { value.clear (); }
+        if (value.empty ()) { continue; }
+        if (intern) { *ids [component] = InternString (value); }
+        else if (!FindInterned (value, *ids [component])) { return false; }
+        depth = component + 2;
+    }
+    return true;
+
+} /* End of ParseCPE () */
+
+
+/*
+ * This function formats the CPE in its 2.2 URI binding, dropping trailing unspecified components.
+ * :return: string holding the CPE name.
+ */
+std::string CPE::ToString () const {
+
+    std::string result = std::string ("cpe:/") + part;
+    std::string pending;
+    for (uint32_t id : {vendor, product, version, update}) {
+        pending += ':';
+        if (id == CPE_ANY) { continue; }
+        result += pending + InternedString (id);
+        pending.clear ();
+    }
+    return result;
+
+} /* End of ToString () */
+
+
+/*
+ * This function compares two normalised CPEs.
+ * :arg: other, const CPE object to be compared.
+ * :return: bool value indicating whether both CPEs are the same.
+ */
+bool CPE::operator== (const CPE &other) const {
+
+    return part == other.part && vendor == other.vendor && product == other.product && version == other.version &&
+           update == other.update;
+
+} /* End of operator== () */
+
+
+/*
+ * This function compares two index keys.
+ * :arg: other, const Key object to be compared.
+ * :return: bool value indicating whether both keys are the same.
+ */
+bool CPEIndex::Key::operator== (const Key &other) const {
+
+    return depth == other.depth && part == other.part && std::equal (ids, ids + CPE_COMPONENTS, other.ids);
+
+} /* End of operator== () */
+
+
+/*
+ * This function hashes an index key.
+ * :arg: key, const Key object to be hashed.
+ * :return: hash of the key.
+ */
+size_t CPEIndex::KeyHash::operator() (const Key &key) const {
+
+    size_t hash = (static_cast <size_t> (key.depth) << 8) | static_cast <unsigned char> (key.part);
+    for (uint32_t id : key.ids) { hash = hash * 1000003u ^ id; }
+    return hash;
+
+} /* End of operator() () */
+
+
+/*
+ * This function adds the given port under every prefix of the given CPE.
+ * :arg: address, const string holding the address of the host.
+ * :arg: portid, const string holding the port id.
+ * :arg: cpe, const CPE object reported for the port.
+ */
+void CPEIndex::Add (const std::string &address, const std::string &portid, const CPE &cpe) {
+
+    Key key {1, cpe.part, {CPE_ANY, CPE_ANY, CPE_ANY, CPE_ANY}};
+    uint32_t ids [CPE_COMPONENTS] = {cpe.vendor, cpe.product, cpe.version, cpe.update};
+    std::lock_guard <std::mutex> lock (mtx);
+    for (int depth = 1; depth <= CPE_COMPONENTS + 1; depth++) {
+        if (depth > 1) {
+            /* Stop at the first unspecified component, a prefix never skips one */
+            if (ids [depth - 2] == CPE_ANY) { break; }
+            key.ids [depth - 2] = ids [depth - 2];
+        }
+        key.depth = depth;
+        std::vector <PortRef> &refs = prefixes [key];
+        if (std::none_of (refs.begin (), refs.end (), [&](const PortRef &ref) {
+                return ref.address == address && ref.portid == portid; })) {
+            refs.push_back ({address, portid});
+        }
+    }
+
+} /* End of Add () */
+
+
+/*
+ * This function returns every indexed port carrying a CPE which starts with the given prefix.
+ * :arg: prefix, const string holding the CPE prefix, e.g. "cpe:/a:apache:http_server:2.4.49".
+ * :return: vector of PortRef holding the matching ports, empty if none match or the prefix is malformed.
+ */
+std::vector <PortRef> CPEIndex::Find (const std::string &prefix) const {
+
+    CPE cpe;
+    int depth = 0;
+    if (!ParseCPE (prefix, cpe, depth, false)) { return {}; }
+    Key key {static_cast <uint8_t> (depth), cpe.part, {cpe.vendor, cpe.product, cpe.version, cpe.update}};
+    std::lock_guard <std::mutex> lock (mtx);
+    auto find = prefixes.find (key);
+    return (find != prefixes.end ()) ? find->second : std::vector <PortRef> ();
+
+} /* End of Find () */
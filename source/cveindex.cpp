@@ -0,0 +1,511 @@
+/*
+ ***********************************************************************************************************************
+ * File: cveindex.cpp
+ * Description: This file contains definitions of support functions & member functions associated with the offline CVE
+ *              index. The index is built once from a flattened NVD CPE-match feed and then memory mapped, so ports are
+ *              matched with a trie walk and a binary search, without any network access.
+ * Functions:
+ *           VersionKey ParseVersion ()
+ *           int CompareVersions ()
+ *           string NormaliseProduct ()
+ *           vector SplitCPE ()
+ *           ReturnCodes BuildCVEIndex ()
+ *           bool ValidateLayout ()
+ *           class CVEIndex
+ *              CVEIndex ()
+ *              ~CVEIndex ()
+ *              ReturnCodes Open ()
+ *              bool IsOpen ()
+ *              TrieNode *FindProduct ()
+ *              vector Lookup ()
+ *              size_t MatchPorts ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <queue>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cveindex.hpp"
+
+const uint32_t VERSION_ALPHA = 0x80000000u;
+const uint32_t VERSION_MAX   = 0xFFFFFFFFu;
+
+
+/*
+ * This function converts a version string into a fixed size key which orders the way versions do. Numeric parts are
+ * compared by value and alphabetic parts (e.g. the "p" of "8.9p1") sort after any number. Only the first whitespace
+ * separated word is used, so "8.9p1 Ubuntu 3ubuntu0.1" keys as "8.9p1".
+ * :arg: version, const string holding the version.
+ * :return: VersionKey of the version.
+ */
+VersionKey ParseVersion (const std::string &version) {
+
+    VersionKey key {};
+    int part = 0;
+    size_t index = 0;
+    while (index < version.size () && version [index] != ' ' && part < VERSION_PARTS) {
+        unsigned char character = version [index];
+        if (std::isdigit (character)) {
+            uint64_t value = 0;
+            while (index < version.size () && std::isdigit (static_cast <unsigned char> (version [index]))) {
+                value = std::min <uint64_t> (value * 10 + (version [index++] - '0'), VERSION_ALPHA - 1);
+            }
+            key.parts [part++] = static_cast <uint32_t> (value);
+        } else if (std::isalpha (character)) {
+            uint32_t packed = 0;
+            int length = 0;
+            while (index < version.size () && std::isalpha (static_cast <unsigned char> (version [index]))) {
+                if (length++ < 3) { packed = (packed << 8) | std::tolower (version [index]); }
+                index++;
+            }
+            key.parts [part++] = VERSION_ALPHA | (packed << (8 * (3 - std::min (length, 3))));
+        } else {
+            index++;
+        }
+    }
+    return key;
+
+} /* End of ParseVersion () */
+
+
+/*
+ * This function compares two version keys.
+ * :arg: left, const VersionKey to be compared.
+ * :arg: right, const VersionKey to be compared.
+ * :return: negative, zero or positive integer as left is lower than, equal to or higher than right.
+ */
+int CompareVersions (const VersionKey &left, const VersionKey &right) {
+
+    for (int part = 0; part < VERSION_PARTS; part++) {
+        if (left.parts [part] != right.parts [part]) { return left.parts [part] < right.parts [part] ? -1 : 1; }
+    }
+    return 0;
+
+} /* End of CompareVersions () */
+
+
+/*
+ * This function normalises a product name the way CPE names are written, lower case with underscores for spaces.
+ * :arg: product, const string holding the product name.
+ * :return: string holding the normalised product name.
+ */
+std::string NormaliseProduct (const std::string &product) {
+
+    std::string result;
+    result.reserve (product.size ());
+    for (unsigned char character : product) {
+        result += (character == ' ') ? '_' : static_cast <char> (std::tolower (character));
+    }
+    return result;
+
+} /* End of NormaliseProduct () */
+
+
+/*
+ * This function splits a CPE name, in either its 2.2 URI ("cpe:/a:vendor:product:version") or 2.3 formatted string
+ * ("cpe:2.3:a:vendor:product:version:...") binding, into part, vendor, product & version. Escaped colons are kept.
+ * :arg: cpe, const string holding the CPE name.
+ * :return: vector of four strings holding part, vendor, product & version, empty if the name is malformed.
+ */
+static std::vector <std::string> SplitCPE (const std::string &cpe) {
+
+    std::vector <std::string> fields (1);
+    for (size_t index = 0; index < cpe.size (); index++) {
+        if (cpe [index] == '\\' && index + 1 < cpe.size ()) { fields.back () += cpe [++index]; }
+        else if (cpe [index] == ':') { fields.emplace_back (); }
+        else { fields.back () += cpe [index]; }
+    }
+    if (fields.size () >= 6 && fields [0] == "cpe" && fields [1] == "2.3") {
+        return {fields [2], fields [3], fields [4], fields [5]};
+    }
+    if (fields.size () >= 4 && fields [0] == "cpe" && fields [1].size () == 2 && fields [1][0] == '/') {
+        return {fields [1].substr (1), fields [2], fields [3], fields.size () > 4 ? fields [4] : ""};
+    }
+    return {};
+
+} /* End of SplitCPE () */
+
+
+/*
+ * This function builds the CVE index from a flattened NVD CPE-match feed. Each line of the feed describes one
+ * vulnerable CPE match, tab separated as:
+ *     <CVE id> <CPE name> [<start incl> <start excl> <end incl> <end excl> [<CVSS score>]]
+ * Empty range columns fall back to the version in the CPE name, where "*" and "-" match every version. The index is
+ * written to a temporary file and renamed into place, so readers never see a partial index.
+ * :arg: feedFile, const string holding the path of the feed.
+ * :arg: indexFile, const string holding the path of the index to be written.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success or failure of the operation.
+ */
+ReturnCodes BuildCVEIndex (const std::string &feedFile, const std::string &indexFile, Logger objLog) {
+
+    struct BuildEntry {
+        CVEEntry entry;
+        std::string vendor;
+    };
+    std::ifstream feed (feedFile);
+    std::map <std::string, std::vector <BuildEntry>> products;
+    std::string line;
+    if (!feed) {
+        objLog.Log (FAIL, MOD_CVE_INDEX, CVE_INDEX_BUILD_FAIL, true);
+        return CVE_INDEX_BUILD_FAIL;
+    }
+
+    while (std::getline (feed, line)) {
+        std::vector <std::string> columns (1);
+        for (char character : line) {
+            if (character == '\t') { columns.emplace_back (); }
+            else if (character != '\r') { columns.back () += character; }
+        }
+        if (line.empty () || line [0] == '#' || columns.size () < 2) { continue; }
+        columns.resize (7);
+        std::vector <std::string> cpe = SplitCPE (columns [1]);
+        unsigned year = 0;
+        unsigned number = 0;
+        if (cpe.empty () || cpe [2].empty () || sscanf (columns [0].c_str (), "CVE-%u-%u", &year, &number) != 2) {
+            continue;
+        }
+
+        BuildEntry build {};
+        build.vendor = NormaliseProduct (cpe [1]);
+        build.entry.cveYear = static_cast <uint16_t> (year);
+        build.entry.cveNumber = number;
+        build.entry.score = static_cast <uint16_t> (std::max (0.0, atof (columns [6].c_str ()) * 10));
+        std::fill (std::begin (build.entry.end.parts), std::end (build.entry.end.parts), VERSION_MAX);
+        bool ranged = !(columns [2].empty () && columns [3].empty () && columns [4].empty () && columns [5].empty ());
+        if (ranged) {
+            if (!columns [2].empty ()) { build.entry.start = ParseVersion (columns [2]); }
+            if (!columns [3].empty ()) {
+                build.entry.start = ParseVersion (columns [3]);
+                build.entry.flags |= RANGE_START_EXCL;
+            }
+            if (!columns [4].empty ()) { build.entry.end = ParseVersion (columns [4]); }
+            if (!columns [5].empty ()) {
+                build.entry.end = ParseVersion (columns [5]);
+                build.entry.flags |= RANGE_END_EXCL;
+            }
+        } else if (!cpe [3].empty () && cpe [3] != "*" && cpe [3] != "-") {
+            build.entry.start = build.entry.end = ParseVersion (cpe [3]);
+        }
+        products [NormaliseProduct (cpe [2])].push_back (build);
+    }
+
+    /* Trie over the product names, flattened breadth first so each node's edges are contiguous */
+    struct BuildNode {
+        std::map <unsigned char, uint32_t> children;
+        const std::vector <BuildEntry> *entries = nullptr;
+    };
+    std::vector <BuildNode> trie (1);
+    for (auto &product : products) {
+        uint32_t node = 0;
+        for (unsigned char character : product.first) {
+            auto find = trie [node].children.find (character);
+            if (find == trie [node].children.end ()) {
+                trie [node].children [character] = static_cast <uint32_t> (trie.size ());
+                node = static_cast <uint32_t> (trie.size ());
+                trie.emplace_back ();
+            } else {
+                node = find->second;
+            }
+        }
+        std::sort (product.second.begin (), product.second.end (), [](const BuildEntry &left, const BuildEntry &right) {
+            return CompareVersions (left.entry.end, right.entry.end) < 0;
+        });
+        trie [node].entries = &product.second;
+    }
+
+    std::vector <uint32_t> order;
+    std::vector <uint32_t> position (trie.size ());
+    std::queue <uint32_t> queue;
+    queue.push (0);
+    while (!queue.empty ()) {
+        uint32_t node = queue.front ();
+        queue.pop ();
+        position [node] = static_cast <uint32_t> (order.size ());
+        order.push_back (node);
+        for (const auto &child : trie [node].children) { queue.push (child.second); }
+    }
+
+    std::vector <TrieNode> nodes;
+    std::vector <TrieEdge> edges;
+    std::vector <CVEEntry> entries;
+    std::string strings (1, '\0');
+    std::map <std::string, uint32_t> interned;
+    for (uint32_t node : order) {
+        TrieNode flat {static_cast <uint32_t> (edges.size ()), static_cast <uint32_t> (trie [node].children.size ()),
+                       static_cast <uint32_t> (entries.size ()), 0};
+        for (const auto &child : trie [node].children) { edges.push_back ({child.first, position [child.second]}); }
+        if (trie [node].entries) {
+            for (const auto &build : *trie [node].entries) {
+                auto find = interned.find (build.vendor);
+                if (find == interned.end ()) {
+                    find = interned.emplace (build.vendor, static_cast <uint32_t> (strings.size ())).first;
+                    strings += build.vendor;
+                    strings += '\0';
+                }
+                entries.push_back (build.entry);
+                entries.back ().vendor = find->second;
+            }
+            flat.entryCount = static_cast <uint32_t> (trie [node].entries->size ());
+        }
+        nodes.push_back (flat);
+    }
+
+    CVEIndexHeader header {};
+    std::memcpy (header.magic, CVE_INDEX_MAGIC, sizeof (header.magic));
+    header.nodeCount = static_cast <uint32_t> (nodes.size ());
+    header.edgeCount = static_cast <uint32_t> (edges.size ());
+    header.entryCount = static_cast <uint32_t> (entries.size ());
+    header.stringBytes = static_cast <uint32_t> (strings.size ());
+    std::string temporary = indexFile + ".tmp";
+    std::ofstream output (temporary, std::ios::binary | std::ios::trunc);
+    output.write (reinterpret_cast <const char *> (&header), sizeof (header));
+    output.write (reinterpret_cast <const char *> (nodes.data ()), nodes.size () * sizeof (TrieNode));
+    output.write (reinterpret_cast <const char *> (edges.data ()), edges.size () * sizeof (TrieEdge));
+    output.write (reinterpret_cast <const char *> (entries.data ()), entries.size () * sizeof (CVEEntry));
+    output.write (strings.data (), strings.size ());
+    output.close ();
+    if (!output || std::rename (temporary.c_str (), indexFile.c_str ()) != 0) {
+        objLog.Log (FAIL, MOD_CVE_INDEX, CVE_INDEX_BUILD_FAIL, true);
+        return CVE_INDEX_BUILD_FAIL;
+    }
+
+    std::stringstream optional;
+    optional << "Indexed " << entries.size () << " CPE match(es) across " << products.size () << " product(s).";
+    objLog.Log (PASS, MOD_CVE_INDEX, CVE_INDEX_BUILD_PASS, true, optional);
+    return CVE_INDEX_BUILD_PASS;
+
+} /* End of BuildCVEIndex () */
+
+
+/*
+ * This function checks that every offset & count held by a mapped index stays within the index, so a truncated or
+ * corrupted file is rejected when opened instead of being read out of bounds when looked up.
+ * :arg: header, const pointer to the header of the index, followed by the rest of the index.
+ * :arg: size, size_t holding the size of the mapped index, in bytes.
+ * :return: bool value indicating whether the index can be used in place.
+ */
+static bool ValidateLayout (const CVEIndexHeader *header, size_t size) {
+
+    uint64_t expected = sizeof (CVEIndexHeader) + uint64_t (header->nodeCount) * sizeof (TrieNode) +
+                        uint64_t (header->edgeCount) * sizeof (TrieEdge) +
+                        uint64_t (header->entryCount) * sizeof (CVEEntry) + header->stringBytes;
+    if (std::memcmp (header->magic, CVE_INDEX_MAGIC, sizeof (CVE_INDEX_MAGIC)) != 0 || expected != size ||
+        header->nodeCount == 0) {
+        return false;
+    }
+    const auto *nodes = reinterpret_cast <const TrieNode *> (header + 1);
+    const auto *edges = reinterpret_cast <const TrieEdge *> (nodes + header->nodeCount);
+    const auto *entries = reinterpret_cast <const CVEEntry *> (edges + header->edgeCount);
+    const auto *strings = reinterpret_cast <const char *> (entries + header->entryCount);
+    for (const TrieNode *node = nodes; node != nodes + header->nodeCount; node++) {
+        if (uint64_t (node->firstEdge) + node->edgeCount > header->edgeCount ||
+            uint64_t (node->firstEntry) + node->entryCount > header->entryCount) {
+            return false;
+        }
+    }
+    for (const TrieEdge *edge = edges; edge != edges + header->edgeCount; edge++) {
+        if (edge->child >= header->nodeCount) { return false; }
+    }
+    /* Vendors are read as C strings, so each must start within the strings and the last one must be terminated */
+    if (header->entryCount && (header->stringBytes == 0 || strings [header->stringBytes - 1] != '\0')) { return false; }
+    for (const CVEEntry *entry = entries; entry != entries + header->entryCount; entry++) {
+        if (entry->vendor >= header->stringBytes) { return false; }
+    }
+    return true;
+
+} /* End of ValidateLayout () */
+
+
+/*
+ * This is a constructor function for CVEIndex class. The index is empty until Open () is called.
+ */
+CVEIndex::CVEIndex () : mapping (nullptr), mappingSize (0), header (nullptr), nodes (nullptr), edges (nullptr),
+                        entries (nullptr), strings (nullptr) {
+
+} /* End of CVEIndex () */
+
+
+/*
+ * This is a destructor function for CVEIndex class, unmaps the index file if it is mapped.
+ */
+CVEIndex::~CVEIndex () {
+
+    if (mapping) { munmap (mapping, mappingSize); }
+
+} /* End of ~CVEIndex () */
+
+
+/*
+ * This function maps the given index file read-only and validates its layout, down to every offset & count in it.
+ * :arg: indexFile, const string holding the path of the index file.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success or failure of the operation.
+ */
+ReturnCodes CVEIndex::Open (const std::string &indexFile, Logger objLog) {
+
+    struct stat status {};
+    int fd = open (indexFile.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat (fd, &status) != 0 || static_cast <size_t> (status.st_size) < sizeof (CVEIndexHeader)) {
+        if (fd >= 0) { close (fd); }
+        objLog.Log (FAIL, MOD_CVE_INDEX, CVE_INDEX_OPEN_FAIL, false);
+        return CVE_INDEX_OPEN_FAIL;
+    }
+    void *mapped = mmap (nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapped == MAP_FAILED) {
+        objLog.Log (FAIL, MOD_CVE_INDEX, CVE_INDEX_OPEN_FAIL, false);
+        return CVE_INDEX_OPEN_FAIL;
+    }
+
+    const auto *mappedHeader = static_cast <const CVEIndexHeader *> (mapped);
+    if (!ValidateLayout (mappedHeader, static_cast <size_t> (status.st_size))) {
+        munmap (mapped, status.st_size);
+        objLog.Log (FAIL, MOD_CVE_INDEX, CVE_INDEX_OPEN_FAIL, true);
+        return CVE_INDEX_OPEN_FAIL;
+    }
+
+    if (mapping) { munmap (mapping, mappingSize); }
+    mapping = mapped;
+    mappingSize = status.st_size;
+    header = mappedHeader;
+    nodes = reinterpret_cast <const TrieNode *> (header + 1);
+    edges = reinterpret_cast <const TrieEdge *> (nodes + header->nodeCount);
+    entries = reinterpret_cast <const CVEEntry *> (edges + header->edgeCount);
+    strings = reinterpret_cast <const char *> (entries + header->entryCount);
+
+    std::stringstream optional;
+    optional << header->entryCount << " CPE match(es) mapped.";
+    objLog.Log (PASS, MOD_CVE_INDEX, CVE_INDEX_OPEN_PASS, false, optional);
+    return CVE_INDEX_OPEN_PASS;
+
+} /* End of Open () */
+
+
+/*
+ * This function returns whether an index file is mapped.
+ * :return: bool value indicating whether the index can be looked up.
+ */
+bool CVEIndex::IsOpen () const {
+
+    return mapping != nullptr;
+
+} /* End of IsOpen () */
+
+
+/*
+ * This function walks the product trie, binary searching each node's sorted edges.
+ * :arg: product, const string holding the normalised product name.
+ * :return: pointer to the node of the product, nullptr if the product is not indexed.
+ */
+const TrieNode *CVEIndex::FindProduct (const std::string &product) const {
+
+    const TrieNode *node = nodes;
+    for (unsigned char character : product) {
+        const TrieEdge *first = edges + node->firstEdge;
+        const TrieEdge *last = first + node->edgeCount;
+        const TrieEdge *find = std::lower_bound (first, last, character, [](const TrieEdge &edge, uint32_t label) {
+            return edge.label < label;
+        });
+        if (find == last || find->label != character) { return nullptr; }
+        node = nodes + find->child;
+    }
+    return node;
+
+} /* End of FindProduct () */
+
+
+/*
+ * This function looks up the known vulnerabilities of the given product & version.
+ * :arg: product, const string holding the product name, normalised before lookup.
+ * :arg: version, const string holding the version.
+ * :arg: vendor, const string holding the CPE vendor, matches any vendor if empty.
+ * :return: vector of CVEMatch holding the matched vulnerabilities.
+ */
+std::vector <CVEMatch> CVEIndex::Lookup (const std::string &product, const std::string &version,
+                                         const std::string &vendor) const {
+
+    std::vector <CVEMatch> matches;
+    const TrieNode *node = mapping ? FindProduct (NormaliseProduct (product)) : nullptr;
+    if (!node || node->entryCount == 0 || version.empty ()) { return matches; }
+
+    VersionKey key = ParseVersion (version);
+    const CVEEntry *first = entries + node->firstEntry;
+    const CVEEntry *last = first + node->entryCount;
+    /* Entries are sorted by the end of their range, so every candidate lies at or after the first one ending here */
+    const CVEEntry *entry = std::lower_bound (first, last, key, [](const CVEEntry &candidate, const VersionKey &value) {
+        return CompareVersions (candidate.end, value) < 0;
+    });
+    for (; entry != last; entry++) {
+        int toEnd = CompareVersions (key, entry->end);
+        int toStart = CompareVersions (key, entry->start);
+        if ((entry->flags & RANGE_END_EXCL) && toEnd == 0) { continue; }
+        if (toStart < 0 || ((entry->flags & RANGE_START_EXCL) && toStart == 0)) { continue; }
+        if (!vendor.empty () && vendor != strings + entry->vendor) { continue; }
+        char cve [24];
+        snprintf (cve, sizeof (cve), "CVE-%u-%04u", entry->cveYear, entry->cveNumber);
+        if (std::none_of (matches.begin (), matches.end (), [&](const CVEMatch &match) { return match.cve == cve; })) {
+            matches.push_back ({cve, entry->score / 10.0f});
+        }
+    }
+    return matches;
+
+} /* End of Lookup () */
+
+
+/*
+ * This function matches a batch of ports, typically every open port across the scanned fleet, against the index.
+ * CPEs reported for a port are looked up first, as they name the vendor & product exactly. Otherwise, its product is
+ * looked up whole, with identical product & version pairs looked up only once. Single words of a product name are
+ * not tried on their own, as "Apache" of "Apache httpd" would match every product of that name, whoever its vendor.
+ * :arg: ports, const vector of pointers to the Port objects to be matched.
+ * :return: number of ports with at least one known vulnerability.
+ */
+size_t CVEIndex::MatchPorts (const std::vector <Port *> &ports) const {
+
+    std::map <std::pair <std::string, std::string>, std::vector <CVEMatch>> cache;
+    size_t matched = 0;
+    for (Port *port : ports) {
+        std::string version = port->version.substr (0, port->version.find (' '));
+        std::vector <CVEMatch> cpeMatches;
+        /* CPEs reported by NMAP name the vendor & product exactly, prefer them over the free-form product name */
+        for (const CPE &cpe : port->cpes) {
+            if (cpe.product == CPE_ANY) { continue; }
+            std::string cpeVersion = (cpe.version != CPE_ANY) ? InternedString (cpe.version) : version;
+            for (auto &match : Lookup (InternedString (cpe.product), cpeVersion, InternedString (cpe.vendor))) {
+                cpeMatches.push_back (match);
+            }
+        }
+        if (!cpeMatches.empty ()) {
+            for (const auto &match : cpeMatches) {
+                if (std::find (port->knownCVEs.begin (), port->knownCVEs.end (), match.cve) == port->knownCVEs.end ()) {
+                    port->knownCVEs.push_back (match.cve);
+                    port->knownScore = std::max (port->knownScore, match.score);
+                }
+            }
+            matched++;
+            continue;
+        }
+        if (port->product.empty () || version.empty ()) { continue; }
+        auto key = std::make_pair (port->product, version);
+        auto find = cache.find (key);
+        if (find == cache.end ()) {
+            find = cache.emplace (key, Lookup (port->product, version)).first;
+        }
+        for (const auto &match : find->second) {
+            if (std::find (port->knownCVEs.begin (), port->knownCVEs.end (), match.cve) == port->knownCVEs.end ()) {
+                port->knownCVEs.push_back (match.cve);
+                port->knownScore = std::max (port->knownScore, match.score);
+            }
+        }
+        if (!find->second.empty ()) { matched++; }
+    }
+    return matched;
+
+} /* End of MatchPorts () */
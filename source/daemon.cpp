@@ -0,0 +1,520 @@
+/*
+ ***********************************************************************************************************************
+ * File: daemon.cpp
+ * Description: This file contains definitions of support functions & member functions associated with the long
+ *              running scan daemon. Its scan engine, holding the signatures, the command templates & the CVE index,
+ *              resolved addresses and finished results stay loaded between jobs, which are run one at a time by a
+ *              runner thread, while a thread per client connection answers requests and streams results.
+ * Functions:
+ *           string JobStateName ()
+ *           string FormatPortResult ()
+ *           bool SendLine ()
+ *           bool ParseRequest ()
+ *           class ScanDaemon
+ *              ScanDaemon ()
+ *              ReturnCodes Run ()
+ *              void RunJobs ()
+ *              void RunJob ()
+ *              void PruneExpired ()
+ *              void ServeClient ()
+ *              bool HandleRequest ()
+ *              string FormatStatus ()
+ *              void PortsDiscovered ()
+ *              void PortScanned ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "daemon.hpp"
+
+
+/*
+ * This function returns the name of a job state, as used by the protocol.
+ * :arg: state, JobState to be named.
+ * :return: string holding the name of the state.
+ */
+static std::string JobStateName (JobState state) {
+
+    switch (state) {
+        case JOB_QUEUED: return "queued";
+        case JOB_DISCOVERY: return "discovery";
+        case JOB_DEEP_SCAN: return "deep-scan";
+        case JOB_DONE: return "done";
+        case JOB_FAILED: return "failed";
+        case JOB_CANCELLED: return "cancelled";
+    }
+    return "unknown";
+
+} /* End of JobStateName () */
+
+
+/*
+ * This function formats the result of a port as a PORT line.
+ * :arg: port, const Port object to be formatted.
+ * :return: string holding the tab separated PORT line, without the line feed.
+ */
+static std::string FormatPortResult (const Port &port) {
+
+    auto join = [](const std::vector <std::string> &values) {
+        std::string joined;
+        for (const auto &value : values) { joined += (joined.empty () ? "" : ",") + value; }
+        return joined.empty () ? "-" : joined;
+    };
+    auto field = [](const std::string &value) { return value.empty () ? std::string ("-") : value; };
+    return "PORT\t" + port.Key () + "\t" + port.state + "\t" + field (port.service) + "\t" + field (port.product) +
+           "\t" + field (port.version) + "\t" + SeverityName (port.severity) + "\t" + join (port.cves) + "\t" +
+           join (port.knownCVEs);
+
+} /* End of FormatPortResult () */
+
+
+/*
+ * This function writes a line to a client, without raising SIGPIPE if the client has gone away.
+ * :arg: fd, integer holding the descriptor of the client connection.
+ * :arg: line, const string holding the line to be sent, without the line feed.
+ * :return: bool value indicating whether the whole line has been sent.
+ */
+static bool SendLine (int fd, const std::string &line) {
+
+    std::string payload = line + "\n";
+    size_t sent = 0;
+    while (sent < payload.size ()) {
+        ssize_t written = send (fd, payload.data () + sent, payload.size () - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written <= 0) { return false; }
+        sent += written;
+    }
+    return true;
+
+} /* End of SendLine () */
+
+
+/*
+ * This function splits a request line into its words and checks them: the verb must be known, SUBMIT needs a target
+ * and a known profile, defaulting to PROFILE_DEFAULT, while STATUS, RESULTS & CANCEL need a numeric job id.
+ * :arg: line, const string holding the request line, without the line feed.
+ * :arg: request, DaemonRequest object to which the request is copied to.
+ * :arg: error, string to which the message of an ERR response is copied to, if the request is invalid.
+ * :return: bool value indicating whether the request is valid.
+ */
+bool ParseRequest (const std::string &line, DaemonRequest &request, std::string &error) {
+
+    std::string argument;
+    std::stringstream words (line);
+    request = DaemonRequest ();
+    words >> request.verb >> argument >> request.profile;
+    if (request.verb == "SUBMIT") {
+        request.target = argument;
+        if (request.profile.empty ()) { request.profile = PROFILE_DEFAULT; }
+        if (request.target.empty ()) { error = "target required"; }
+        else if (request.profile != PROFILE_DEFAULT && request.profile != PROFILE_DISCOVERY) {
+            error = "unknown profile";
+        }
+    } else if (request.verb == "STATUS" || request.verb == "RESULTS" || request.verb == "CANCEL") {
+        char *end = nullptr;
+        unsigned long id = strtoul (argument.c_str (), &end, 10);
+        if (argument.empty () || !std::isdigit (static_cast <unsigned char> (argument [0])) || *end != '\0' ||
+            id > UINT32_MAX) {
+            error = "job id required";
+        }
+        request.id = static_cast <uint32_t> (id);
+    } else if (request.verb != "LIST" && request.verb != "SHUTDOWN") {
+        error = "unknown request";
+    }
+    return error.empty ();
+
+} /* End of ParseRequest () */
+
+
+/*
+ * Instantiates a new object of ScanDaemon class.
+ * :arg: path, const string holding the path of the Unix socket to listen on.
+ */
+ScanDaemon::ScanDaemon (const std::string &path)
+                       : socketPath (path), daemonLog (LOG_DAEMON), current (nullptr), nextId (1), stopping (false) {
+
+} /* End of ScanDaemon () */
+
+
+/*
+ * This function loads the state kept warm between jobs, listens on the Unix socket and serves clients until the
+ * token is cancelled or a SHUTDOWN request is received. The running job is cancelled and reaped before returning.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes ScanDaemon::Run (const CancelToken &token) {
+
+    /* module = MOD_DAEMON */
+    std::stringstream optional;
+    optional << "Socket: " << socketPath;
+    engine = std::make_unique <ScanEngine> (daemonLog);
+    engine->AddResultSink (this);
+
+    struct sockaddr_un local {};
+    local.sun_family = AF_UNIX;
+    int listener = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0 || socketPath.size () >= sizeof (local.sun_path)) {
+        if (listener >= 0) { close (listener); }
+        daemonLog.Log (FAIL, MOD_DAEMON, DAEMON_START_FAIL, true, optional);
+        return DAEMON_START_FAIL;
+    }
+    strncpy (local.sun_path, socketPath.c_str (), sizeof (local.sun_path) - 1);
+    unlink (socketPath.c_str ());
+    /* Only the user running the daemon may submit jobs */
+    mode_t mask = umask (0177);
+    int bound = bind (listener, reinterpret_cast <struct sockaddr *> (&local), sizeof (local));
+    umask (mask);
+    if (bound != 0 || listen (listener, SOMAXCONN) != 0) {
+        close (listener);
+        daemonLog.Log (FAIL, MOD_DAEMON, DAEMON_START_FAIL, true, optional);
+        return DAEMON_START_FAIL;
+    }
+    daemonLog.Log (PASS, MOD_DAEMON, DAEMON_START_PASS, true, optional);
+
+    std::thread runner (&ScanDaemon::RunJobs, this);
+    struct pollfd reader {listener, POLLIN, 0};
+    for (;;) {
+        {
+            std::lock_guard <std::mutex> lock (mtx);
+            if (stopping || token.IsCancelled ()) { break; }
+        }
+        int ready = poll (&reader, 1, CANCEL_POLL_MS);
+        if (ready <= 0) { continue; }
+        int client = accept4 (listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) { continue; }
+        std::lock_guard <std::mutex> lock (mtx);
+        clients.push_back (client);
+        std::thread (&ScanDaemon::ServeClient, this, client).detach ();
+    }
+
+    /* Stop taking work, cancel every outstanding job and unblock the clients still connected */
+    close (listener);
+    unlink (socketPath.c_str ());
+    {
+        std::lock_guard <std::mutex> lock (mtx);
+        stopping = true;
+        for (auto &[id, job] : jobs) {
+            if (job->state < JOB_DONE) { job->token.Cancel (); }
+        }
+        for (int client : clients) { shutdown (client, SHUT_RDWR); }
+    }
+    changed.notify_all ();
+    runner.join ();
+    {
+        std::unique_lock <std::mutex> lock (mtx);
+        changed.wait (lock, [this]() { return clients.empty (); });
+    }
+    daemonLog.Log (INFO, MOD_DAEMON, DAEMON_STOP_INFO, true, optional);
+    return DAEMON_START_PASS;
+
+} /* End of Run () */
+
+
+/*
+ * This function runs queued jobs one at a time, until the daemon is stopping.
+ */
+void ScanDaemon::RunJobs () {
+
+    for (;;) {
+        Job *job = nullptr;
+        {
+            std::unique_lock <std::mutex> lock (mtx);
+            changed.wait (lock, [this]() { return stopping || !queue.empty (); });
+            if (stopping) { break; }
+            auto find = jobs.find (queue.front ());
+            queue.pop_front ();
+            if (find == jobs.end () || find->second->state != JOB_QUEUED) { continue; }
+            job = find->second.get ();
+            job->state = JOB_DISCOVERY;
+            current = job;
+        }
+        changed.notify_all ();
+        RunJob (*job);
+        {
+            std::lock_guard <std::mutex> lock (mtx);
+            current = nullptr;
+            job->finished = time (nullptr);
+            PruneExpired ();
+        }
+        changed.notify_all ();
+    }
+    /* Jobs still queued will never run */
+    std::lock_guard <std::mutex> lock (mtx);
+    for (uint32_t id : queue) {
+        auto find = jobs.find (id);
+        if (find != jobs.end () && find->second->state == JOB_QUEUED) {
+            find->second->state = JOB_CANCELLED;
+            find->second->finished = time (nullptr);
+        }
+    }
+    changed.notify_all ();
+
+} /* End of RunJobs () */
+
+
+/*
+ * This function scans the target of a job with the profile of the job, through the daemon's engine, so the default
+ * profile runs every stage a scan of the tool runs, from banner grabbing to the inspection of TLS ports, and checkpoints
+ * to the journal. Results reach the job through the sink callbacks, as they are produced.
+ * :arg: job, Job object to be run.
+ */
+void ScanDaemon::RunJob (Job &job) {
+
+    /* module = MOD_DAEMON */
+    std::stringstream optional;
+    optional << "Job: " << job.id << ", target: " << job.target << " (" << job.address << "), profile: "
+             << job.profile;
+    daemonLog.Log (INFO, MOD_DAEMON, DAEMON_JOB_INFO, true, optional);
+
+    ScanRequest request;
+    request.target = job.address;
+    request.profile = job.profile;
+    request.banners = true;
+    request.versionProbes = true;
+    request.tls = true;
+    request.http = true;
+    ScanResult result = engine->Scan (request, job.token);
+    JobState state = JOB_DONE;
+    if (result.cancelled) { state = JOB_CANCELLED; }
+    else if (result.status != PORTS_FOUND_PASS && result.status != PORT_FOUND_FAIL) { state = JOB_FAILED; }
+    std::lock_guard <std::mutex> lock (mtx);
+    job.state = state;
+
+} /* End of RunJob () */
+
+
+/*
+ * This function forgets the jobs that finished more than RESULT_TTL_SECONDS ago and the addresses resolved more than
+ * RESOLVED_TTL_SECONDS ago, so neither grows for as long as the daemon runs. A client still streaming the results of
+ * a forgotten job keeps the job alive until it is done. The daemon's lock must be held.
+ */
+void ScanDaemon::PruneExpired () {
+
+    time_t now = time (nullptr);
+    for (auto job = jobs.begin (); job != jobs.end ();) {
+        bool expired = job->second->state >= JOB_DONE && job->second->finished &&
+                       difftime (now, job->second->finished) >= RESULT_TTL_SECONDS;
+        job = expired ? jobs.erase (job) : std::next (job);
+    }
+    for (auto entry = resolved.begin (); entry != resolved.end ();) {
+        bool expired = difftime (now, entry->second.resolved) >= RESOLVED_TTL_SECONDS;
+        entry = expired ? resolved.erase (entry) : std::next (entry);
+    }
+
+} /* End of PruneExpired () */
+
+
+/*
+ * This function serves the requests of a client connection until the client disconnects or the daemon stops.
+ * :arg: fd, integer holding the descriptor of the client connection, closed before returning.
+ */
+void ScanDaemon::ServeClient (int fd) {
+
+    std::string pending;
+    char buffer [1024];
+    for (bool open = true; open;) {
+        ssize_t bytes = read (fd, buffer, sizeof (buffer));
+        if (bytes < 0 && errno == EINTR) { continue; }
+        if (bytes <= 0) { break; }
+        pending.append (buffer, bytes);
+        for (size_t end = pending.find ('\n'); open && end != std::string::npos; end = pending.find ('\n')) {
+            std::string request = pending.substr (0, end);
+            pending.erase (0, end + 1);
+            if (!request.empty () && request.back () == '\r') { request.pop_back (); }
+            open = HandleRequest (fd, request);
+        }
+        if (pending.size () > REQUEST_MAX) {
+            SendLine (fd, "ERR request too long");
+            break;
+        }
+    }
+    close (fd);
+    /* Notified under the lock, as a stopping daemon may be destroyed as soon as the last client is gone */
+    std::lock_guard <std::mutex> lock (mtx);
+    clients.erase (std::remove (clients.begin (), clients.end (), fd), clients.end ());
+    changed.notify_all ();
+
+} /* End of ServeClient () */
+
+
+/*
+ * This function answers a single request of a client.
+ * :arg: fd, integer holding the descriptor of the client connection.
+ * :arg: request, const string holding the request line.
+ * :return: bool value indicating whether the connection is to be kept open.
+ */
+bool ScanDaemon::HandleRequest (int fd, const std::string &request) {
+
+    DaemonRequest parsed;
+    std::string error;
+    if (!ParseRequest (request, parsed, error)) { return SendLine (fd, "ERR " + error); }
+    const std::string &verb = parsed.verb;
+    const std::string &argument = parsed.target;
+    const std::string &profile = parsed.profile;
+    uint32_t id = parsed.id;
+
+    if (verb == "SUBMIT") {
+        std::string address;
+        {
+            std::lock_guard <std::mutex> lock (mtx);
+            PruneExpired ();
+            auto find = resolved.find (argument);
+            if (find != resolved.end ()) { address = find->second.address; }
+        }
+        if (address.empty ()) {
+            if (ConvertToIPAddress (argument, address) != TARGET_ADDR_PASS) { return SendLine (fd, "ERR invalid target"); }
+            std::lock_guard <std::mutex> lock (mtx);
+            resolved [argument] = ResolvedAddress {address, time (nullptr)};
+        }
+        std::unique_lock <std::mutex> lock (mtx);
+        if (stopping) { return SendLine (fd, "ERR shutting down"); }
+        /* Serve a recent result of the same scan from the cache */
+        for (const auto &[jobId, job] : jobs) {
+            if (job->address == address && job->profile == profile && job->state == JOB_DONE &&
+                difftime (time (nullptr), job->finished) < RESULT_TTL_SECONDS) {
+                return SendLine (fd, "OK\t" + std::to_string (jobId) + "\tcached");
+            }
+        }
+        auto job = std::make_shared <Job> ();
+        job->id = nextId++;
+        job->target = argument;
+        job->address = address;
+        job->profile = profile;
+        id = job->id;
+        queue.push_back (id);
+        jobs [id] = std::move (job);
+        lock.unlock ();
+        changed.notify_all ();
+        return SendLine (fd, "OK\t" + std::to_string (id));
+    }
+    if (verb == "STATUS" || verb == "CANCEL") {
+        std::unique_lock <std::mutex> lock (mtx);
+        auto find = jobs.find (id);
+        if (find == jobs.end ()) { return SendLine (fd, "ERR unknown job"); }
+        if (verb == "STATUS") { return SendLine (fd, FormatStatus (*find->second)); }
+        Job &job = *find->second;
+        if (job.state == JOB_QUEUED) {
+            job.state = JOB_CANCELLED;
+            job.finished = time (nullptr);
+        }
+        job.token.Cancel ();
+        lock.unlock ();
+        changed.notify_all ();
+        return SendLine (fd, "OK\t" + std::to_string (id));
+    }
+    if (verb == "LIST") {
+        std::vector <std::string> lines;
+        {
+            std::lock_guard <std::mutex> lock (mtx);
+            for (const auto &[jobId, job] : jobs) { lines.push_back (FormatStatus (*job)); }
+        }
+        for (const auto &line : lines) {
+            if (!SendLine (fd, line)) { return false; }
+        }
+        return SendLine (fd, "END");
+    }
+    if (verb == "RESULTS") {
+        /* Stream results as they are produced, the lock is released while sending */
+        size_t sent = 0;
+        std::unique_lock <std::mutex> lock (mtx);
+        auto find = jobs.find (id);
+        if (find == jobs.end ()) { return SendLine (fd, "ERR unknown job"); }
+        /* Held, as the job may be pruned while its results are being sent */
+        std::shared_ptr <Job> held = find->second;
+        Job &job = *held;
+        for (;;) {
+            changed.wait (lock, [&]() {
+                return stopping || sent < job.results.size () || job.state >= JOB_DONE;
+            });
+            std::vector <std::string> batch (job.results.begin () + sent, job.results.end ());
+            sent = job.results.size ();
+            bool finished = job.state >= JOB_DONE || stopping;
+            std::string state = JobStateName (job.state);
+            lock.unlock ();
+            for (const auto &line : batch) {
+                if (!SendLine (fd, line)) { return false; }
+            }
+            if (finished) { return SendLine (fd, "END\t" + state); }
+            lock.lock ();
+        }
+    }
+    if (verb == "SHUTDOWN") {
+        {
+            std::lock_guard <std::mutex> lock (mtx);
+            stopping = true;
+        }
+        changed.notify_all ();
+        SendLine (fd, "OK");
+        return false;
+    }
+    return SendLine (fd, "ERR unknown request");
+
+} /* End of HandleRequest () */
+
+
+/*
+ * This function formats the STATUS line of a job. The daemon's lock must be held.
+ * :arg: job, const Job object to be formatted.
+ * :return: string holding the STATUS line, without the line feed.
+ */
+std::string ScanDaemon::FormatStatus (const Job &job) const {
+
+    return "OK\t" + std::to_string (job.id) + "\t" + job.target + "\t" + job.profile + "\t" + JobStateName (job.state) +
+           "\t" + std::to_string (job.portsDone) + "/" + std::to_string (job.portsTotal);
+
+} /* End of FormatStatus () */
+
+
+/*
+ * This function is notified once the ports of the current job's target are discovered. With the discovery profile
+ * the discovered ports are the results of the job, with the default profile the job moves on to the deep scan.
+ * :arg: host, const Host object whose ports have been discovered.
+ */
+void ScanDaemon::PortsDiscovered (const Host &host) {
+
+    {
+        std::lock_guard <std::mutex> lock (mtx);
+        if (!current || current->address != host.Address ()) { return; }
+        if (current->profile == PROFILE_DISCOVERY) {
+            for (const auto &port : host.OpenPorts ()) { current->results.push_back (FormatPortResult (port)); }
+            for (const auto &port : host.FilteredPorts ()) { current->results.push_back (FormatPortResult (port)); }
+            current->portsDone = current->portsTotal = host.OpenPorts ().size () + host.FilteredPorts ().size ();
+        }
+        else {
+            current->portsTotal = host.OpenPorts ().size ();
+            current->state = JOB_DEEP_SCAN;
+        }
+    }
+    changed.notify_all ();
+
+} /* End of PortsDiscovered () */
+
+
+/*
+ * This function is notified, on the runner thread, as the scan of a port of the current job finishes, the port
+ * already matched against the offline CVE index by the engine.
+ * :arg: address, const string holding the address of the target.
+ * :arg: port, const Port object holding the result of the scan.
+ */
+void ScanDaemon::PortScanned (const std::string &address, const Port &port) {
+
+    std::string line = FormatPortResult (port);
+    {
+        std::lock_guard <std::mutex> lock (mtx);
+        if (!current || current->address != address) { return; }
+        current->results.push_back (line);
+        current->portsDone++;
+    }
+    changed.notify_all ();
+
+} /* End of PortScanned () */
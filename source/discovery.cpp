@@ -0,0 +1,508 @@
+/*
+ ***********************************************************************************************************************
+ * File: discovery.cpp
+ * Description: This file contains definitions of support functions & member functions associated with the native
+ *              discovery sweep & its congestion controller.
+ * Functions:
+ *           class CongestionController
+ *              CongestionController ()
+ *              void Limit ()
+ *              void OnResponse ()
+ *              bool OnTimeout ()
+ *              size_t Window ()
+ *              int TimeoutMs ()
+ *              double Rate ()
+ *           CongestionController &NetworkController ()
+ *           Task <ProbeVerdict> Probe ()
+ *           Task <> TimingProbe ()
+ *           Task <> ConnectProbe ()
+ *           Task <ReturnCodes> NativeSweep ()
+ *           string ServiceName ()
+ *           vector <uint16_t> RankedPorts ()
+ *           vector <uint16_t> PortSchedule ()
+ *           bool ParseShardCount ()
+ *           size_t ShardCount ()
+ *           vector <vector <string>> ShardPortSpecs ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netdb.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include "discovery.hpp"
+#include "metrics.hpp"
+
+/* Verdict of a single connect probe */
+enum ProbeVerdict : uint8_t {
+    PROBE_OPEN,
+    PROBE_CLOSED,
+    PROBE_UNREACHABLE,
+    PROBE_TIMEOUT,
+    PROBE_RETRY,
+};
+
+/* Most frequently open TCP ports, most frequent first, ranked when no port frequency table is available */
+static const uint16_t COMMON_TCP_PORTS [] = {
+    80, 23, 443, 21, 22, 25, 3389, 110, 445, 139, 143, 53, 135, 3306, 8080, 1723, 111, 995, 993, 5900, 1025, 587, 8888,
+    199, 1720, 465, 548, 113, 81, 6001, 10000, 514, 5060, 179, 1026, 2000, 8443, 8000, 32768, 554, 26, 1433, 49152,
+    2001, 515, 8008, 49154, 1027, 5666, 646, 5000, 5631, 631, 49153, 8081, 2049, 88, 79, 5800, 106, 2121, 1110, 49155,
+    6000, 513, 990, 5357, 427, 49156, 543, 544, 5101, 144, 7, 389, 8009, 3128, 444, 9999, 5009, 7070, 5190, 3000, 5432,
+    1900, 3986, 13, 1029, 9, 5051, 6646, 49157, 1028, 873, 1755, 2717, 4899, 9100, 119, 37,
+};
+
+/* State shared by the dispatcher of a sweep & its probes, which live no longer than the dispatcher */
+struct SweepState {
+    EventLoop &loop;
+    struct sockaddr_in target;
+    CongestionController &controller;
+    SweepResult &result;
+    std::deque <std::pair <uint16_t, int>> queue;
+    size_t inFlight = 0;
+    /* Last port found open or closed, 0 until one is, probed to learn whether unanswered probes were lost */
+    uint16_t responsive = 0;
+    bool timing = false;
+};
+
+
+/*
+ * Instantiates a new object of CongestionController class, in slow start with an initial window of
+ * DISC_WINDOW_INIT probes and a timeout of DISC_RTO_INIT_MS until the first RTT sample.
+ */
+CongestionController::CongestionController ()
+                     : window (DISC_WINDOW_INIT), ssthresh (DISC_WINDOW_MAX), cap (DISC_WINDOW_MAX), srtt (0), rttvar (0),
+                       sampled (false) {
+
+} /* End of CongestionController () */
+
+
+/*
+ * This function caps the window, e.g. to the descriptors available to the sweep.
+ * :arg: maxWindow, size_t holding the largest window allowed, at least one.
+ */
+void CongestionController::Limit (size_t maxWindow) {
+
+    cap = std::clamp <size_t> (maxWindow, 1, DISC_WINDOW_MAX);
+    window = std::min (window, static_cast <double> (cap));
+
+} /* End of Limit () */
+
+
+/*
+ * This function accounts for a probe which has been answered: the RTT estimate is updated and the window grows by a
+ * probe per response in slow start, by a probe per window of responses afterwards.
+ * :arg: rttMicros, uint64_t holding the time the probe took to be answered.
+ */
+void CongestionController::OnResponse (uint64_t rttMicros) {
+
+    double sample = static_cast <double> (rttMicros);
+    if (!sampled) {
+        srtt = sample;
+        rttvar = sample / 2;
+        sampled = true;
+    }
+    else {
+        rttvar = 0.75 * rttvar + 0.25 * std::abs (srtt - sample);
+        srtt = 0.875 * srtt + 0.125 * sample;
+    }
+    window += window < ssthresh ? 1.0 : 1.0 / window;
+    window = std::min (window, static_cast <double> (cap));
+
+} /* End of OnResponse () */
+
+
+/*
+ * This function accounts for a probe which has been lost, i.e. a timing probe to a port which has answered before,
+ * left unanswered along with its retransmission, halving the window. Losses of the probes sent within the same round
+ * trip are one congestion event, so the window is halved once per round trip.
+ * :return: bool value indicating whether the window has been reduced.
+ */
+bool CongestionController::OnTimeout () {
+
+    auto now = std::chrono::steady_clock::now ();
+    if (now < recovery) { return false; }
+    ssthresh = std::max (window / 2, 2.0);
+    window = std::min (ssthresh, static_cast <double> (cap));
+    recovery = now + std::chrono::milliseconds (TimeoutMs ());
+    return true;
+
+} /* End of OnTimeout () */
+
+
+/*
+ * These functions return the current decisions of the controller: the number of probes allowed in flight, the time a
+ * probe is given to be answered & the pace, in probes per second, at which probes may leave.
+ */
+size_t CongestionController::Window () const { return std::max <size_t> (static_cast <size_t> (window), 1); }
+int CongestionController::TimeoutMs () const {
+
+    if (!sampled) { return DISC_RTO_INIT_MS; }
+    int rto = static_cast <int> ((srtt + 4 * rttvar) / 1000);
+    return std::clamp (rto, DISC_RTO_MIN_MS, DISC_RTO_MAX_MS);
+
+}
+double CongestionController::Rate () const {
+
+    /* Until the first sample, the window alone bounds the sweep */
+    if (!sampled) { return 1e9; }
+    return window * 1e6 / std::max (srtt, 1.0);
+
+} /* End of Rate () */
+
+
+/*
+ * This function returns the controller of the network, a /24, holding the given address. Controllers are created on
+ * first use and kept for the lifetime of the process, so later sweeps start from what earlier ones learnt.
+ * :arg: address, const string holding the IPv4 address of the target.
+ * :return: reference to the CongestionController of the network.
+ */
+CongestionController &NetworkController (const std::string &address) {
+
+    static std::mutex mtx;
+    static std::map <std::string, std::unique_ptr <CongestionController>> controllers;
+    std::string network = address.substr (0, address.rfind ('.'));
+    std::lock_guard <std::mutex> lock (mtx);
+    std::unique_ptr <CongestionController> &controller = controllers [network];
+    if (!controller) { controller = std::make_unique <CongestionController> (); }
+    return *controller;
+
+} /* End of NetworkController () */
+
+
+/*
+ * This function probes a port with a non-blocking connect, given the controller's timeout to be answered.
+ * :arg: state, SweepState object of the sweep.
+ * :arg: port, uint16_t holding the port to be probed.
+ * :arg: rttMicros, uint64_t to which the time the probe took is written.
+ * :return: ProbeVerdict denoting the outcome of the probe.
+ */
+static Task <ProbeVerdict> Probe (SweepState &state, uint16_t port, uint64_t &rttMicros) {
+
+    ProbeVerdict verdict = PROBE_TIMEOUT;
+    struct sockaddr_in target = state.target;
+    target.sin_port = htons (port);
+    auto start = std::chrono::steady_clock::now ();
+    int fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int error = fd < 0 ? errno : 0;
+    if (fd >= 0 && connect (fd, reinterpret_cast <struct sockaddr *> (&target), sizeof (target)) != 0) {
+        error = errno;
+        if (error == EINPROGRESS) {
+            error = ETIMEDOUT;
+            if (co_await state.loop.Writable (fd, state.controller.TimeoutMs ())) {
+                socklen_t length = sizeof (error);
+                getsockopt (fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            }
+        }
+    }
+    switch (error) {
+        case 0: verdict = PROBE_OPEN; break;
+        case ECONNREFUSED: verdict = PROBE_CLOSED; break;
+        case EHOSTUNREACH: case ENETUNREACH: case EHOSTDOWN: case EACCES: case EPERM: verdict = PROBE_UNREACHABLE; break;
+        case ETIMEDOUT: verdict = PROBE_TIMEOUT; break;
+        /* Out of descriptors, buffers or local ports, nothing was sent */
+        case EMFILE: case ENFILE: case ENOBUFS: case EAGAIN: case EADDRNOTAVAIL: verdict = PROBE_RETRY; break;
+        default: verdict = PROBE_UNREACHABLE; break;
+    }
+    if (fd >= 0) {
+        /* Reset rather than close open connections, so the sweep does not leave TIME_WAIT sockets behind */
+        struct linger reset {1, 0};
+        setsockopt (fd, SOL_SOCKET, SO_LINGER, &reset, sizeof (reset));
+        close (fd);
+    }
+    auto rtt = std::chrono::duration_cast <std::chrono::microseconds> (std::chrono::steady_clock::now () - start);
+    rttMicros = rtt.count ();
+    runMetrics.GetCounter (MET_NATIVE_PROBES).Add ();
+    co_return verdict;
+
+} /* End of Probe () */
+
+
+/*
+ * This function probes a port which has already answered, to tell congestion from ports dropping probes. The window
+ * is only reduced when the probe and its retransmission are both lost, an answer feeds the controller as any other.
+ * :arg: state, SweepState object of the sweep.
+ */
+static Task <> TimingProbe (SweepState &state) {
+
+    ProbeVerdict verdict = PROBE_TIMEOUT;
+    uint64_t rtt = 0;
+    for (int attempt = 0; attempt < 2 && (verdict == PROBE_TIMEOUT || verdict == PROBE_RETRY); attempt++) {
+        verdict = co_await Probe (state, state.responsive, rtt);
+    }
+    if (verdict == PROBE_TIMEOUT) {
+        if (state.controller.OnTimeout ()) { runMetrics.GetCounter (MET_NATIVE_BACKOFFS).Add (); }
+    }
+    else if (verdict != PROBE_RETRY) { state.controller.OnResponse (rtt); }
+    state.timing = false;
+
+} /* End of TimingProbe () */
+
+
+/*
+ * This function probes a port, feeds the outcome to the controller and records it. Unanswered probes are queued again
+ * until DISC_RETRIES retries have been spent, probes which could not be sent for lack of local resources are queued
+ * again as they are. As a filtered port drops probes just as a congested network does, an unanswered probe does not
+ * reduce the window itself, it sends a timing probe to a port which has answered instead.
+ * :arg: state, SweepState object of the sweep.
+ * :arg: port, uint16_t holding the port to be probed.
+ * :arg: attempt, integer denoting the number of earlier attempts on the port.
+ */
+static Task <> ConnectProbe (SweepState &state, uint16_t port, int attempt) {
+
+    uint64_t rtt = 0;
+    ProbeVerdict verdict = co_await Probe (state, port, rtt);
+    state.inFlight--;
+
+    if (verdict == PROBE_RETRY) {
+        state.queue.emplace_front (port, attempt);
+        co_return;
+    }
+    if (verdict == PROBE_TIMEOUT) {
+        state.result.timeouts++;
+        runMetrics.GetCounter (MET_NATIVE_TIMEOUTS).Add ();
+        if (state.responsive && !state.timing) {
+            state.timing = true;
+            state.loop.Spawn (TimingProbe (state));
+        }
+        if (attempt < DISC_RETRIES) {
+            runMetrics.GetCounter (MET_NATIVE_RETRIES).Add ();
+            state.queue.emplace_back (port, attempt + 1);
+        }
+        else { state.result.filtered.push_back (port); }
+    }
+    else {
+        state.result.responses++;
+        state.controller.OnResponse (rtt);
+        runMetrics.GetHistogram (MET_NATIVE_RTT).Record (rtt);
+        if (verdict == PROBE_OPEN || verdict == PROBE_CLOSED) { state.responsive = port; }
+        if (verdict == PROBE_OPEN) { state.result.open.push_back (port); }
+        else if (verdict == PROBE_CLOSED) { state.result.closed++; }
+        else { state.result.filtered.push_back (port); }
+    }
+    runMetrics.GetGauge (MET_NATIVE_WINDOW).Set (static_cast <int64_t> (state.controller.Window ()));
+
+} /* End of ConnectProbe () */
+
+
+/*
+ * This function sweeps the given ports of the target with connect probes, as a task of the given loop. Probes leave
+ * while the window has room, paced by the controller's rate, and the sweep ends once every port has a verdict or
+ * cancellation is requested, in which case the probes in flight are waited for.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target.
+ * :arg: ports, const vector of the ports to be probed, in order, which must outlive the task.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: controller, CongestionController object of the target's network.
+ * :arg: result, SweepResult object to which open & filtered ports are added.
+ * :return: ReturnCodes object denoting the success, failure or cancellation of the sweep.
+ */
+Task <ReturnCodes> NativeSweep (EventLoop &loop, const std::string &address, const std::vector <uint16_t> &ports,
+                                const CancelToken &token, CongestionController &controller, SweepResult &result) {
+
+    SweepState state {loop, {}, controller, result, {}, 0, 0, false};
+    state.target.sin_family = AF_INET;
+    if (inet_pton (AF_INET, address.c_str (), &state.target.sin_addr) != 1) { co_return NATIVE_DISC_FAIL; }
+    struct rlimit files {};
+    if (getrlimit (RLIMIT_NOFILE, &files) == 0 && files.rlim_cur > DISC_FD_RESERVE) {
+        controller.Limit (files.rlim_cur - DISC_FD_RESERVE);
+    }
+    for (uint16_t port : ports) { state.queue.emplace_back (port, 0); }
+
+    double credit = 1;
+    auto last = std::chrono::steady_clock::now ();
+    while (!token.IsCancelled () && (!state.queue.empty () || state.inFlight > 0)) {
+        auto now = std::chrono::steady_clock::now ();
+        double elapsed = std::chrono::duration <double> (now - last).count ();
+        double window = static_cast <double> (controller.Window ());
+        credit = std::min (credit + elapsed * controller.Rate (), window);
+        last = now;
+        while (!state.queue.empty () && state.inFlight < controller.Window () && credit >= 1) {
+            auto [port, attempt] = state.queue.front ();
+            state.queue.pop_front ();
+            state.inFlight++;
+            credit -= 1;
+            loop.Spawn (ConnectProbe (state, port, attempt));
+        }
+        /* 0 until the first RTT sample, while the sweep is not paced yet */
+        double rate = controller.Rate () < 1e9 ? controller.Rate () : 0;
+        runMetrics.GetGauge (MET_NATIVE_RATE).Set (static_cast <int64_t> (rate));
+        runMetrics.GetGauge (MET_NATIVE_RTO).Set (controller.TimeoutMs ());
+        co_await loop.Sleep (1);
+    }
+    while (state.inFlight > 0 || state.timing) { co_await loop.Sleep (1); }
+    std::sort (result.open.begin (), result.open.end ());
+    std::sort (result.filtered.begin (), result.filtered.end ());
+    co_return token.IsCancelled () ? CMD_EXEC_CANCEL : NATIVE_DISC_PASS;
+
+} /* End of NativeSweep () */
+
+
+/*
+ * This function looks up the conventional service name of a port in the services database, as NMAP would report it.
+ * :arg: port, uint16_t holding the port.
+ * :arg: protocol, const char pointer holding the protocol of the port, default value is "tcp".
+ * :return: string holding the service name, "N/A" if the port has none.
+ */
+std::string ServiceName (uint16_t port, const char *protocol) {
+
+    struct servent entry {};
+    struct servent *found = nullptr;
+    char buffer [1024];
+    if (getservbyport_r (htons (port), protocol, &entry, buffer, sizeof (buffer), &found) != 0 || !found) {
+        return "N/A";
+    }
+    return found->s_name;
+
+} /* End of ServiceName () */
+
+
+/*
+ * This function ranks the TCP ports of a port frequency table in the format of nmap-services, i.e. lines of
+ * "name port/protocol frequency", from the most to the least frequently open. Ports of equal frequency are ranked in
+ * ascending order and ports never seen open are left out.
+ * :arg: servicesFile, const string holding the path of the table.
+ * :return: vector of the ranked ports, the built-in ranking of common ports if the table is missing or holds none.
+ */
+std::vector <uint16_t> RankedPorts (const std::string &servicesFile) {
+
+    std::ifstream input (servicesFile);
+    std::vector <std::pair <double, uint16_t>> frequencies;
+    std::string line;
+    while (std::getline (input, line)) {
+        if (line.empty () || line [0] == '#') { continue; }
+        std::istringstream fields (line);
+        std::string name, entry;
+        double frequency = 0;
+        if (!(fields >> name >> entry >> frequency) || frequency <= 0) { continue; }
+        size_t slash = entry.find ('/');
+        int port = std::atoi (entry.c_str ());
+        if (slash == std::string::npos || entry.substr (slash + 1) != "tcp" || port < 1 || port > UINT16_MAX) {
+            continue;
+        }
+        frequencies.emplace_back (frequency, static_cast <uint16_t> (port));
+    }
+    if (frequencies.empty ()) { return {std::begin (COMMON_TCP_PORTS), std::end (COMMON_TCP_PORTS)}; }
+    std::sort (frequencies.begin (), frequencies.end (), [](const auto &left, const auto &right) {
+        return left.first != right.first ? left.first > right.first : left.second < right.second;
+    });
+    std::vector <uint16_t> ranked;
+    std::vector <bool> seen (UINT16_MAX + 1, false);
+    for (const auto &[frequency, port] : frequencies) {
+        if (!seen [port]) { ranked.push_back (port); }
+        seen [port] = true;
+    }
+    return ranked;
+
+} /* End of RankedPorts () */
+
+
+/*
+ * This function orders every TCP port for a sweep: the ranked ports first, in their order, then the rest ascending.
+ * :arg: ranked, const vector of the ranked ports.
+ * :return: vector of all 65535 ports, in the order they are to be swept.
+ */
+std::vector <uint16_t> PortSchedule (const std::vector <uint16_t> &ranked) {
+
+    std::vector <bool> scheduled (UINT16_MAX + 1, false);
+    std::vector <uint16_t> schedule;
+    schedule.reserve (UINT16_MAX);
+    for (uint16_t port : ranked) {
+        if (port == 0 || scheduled [port]) { continue; }
+        scheduled [port] = true;
+        schedule.push_back (port);
+    }
+    for (uint32_t port = 1; port <= UINT16_MAX; port++) {
+        if (!scheduled [port]) { schedule.push_back (static_cast <uint16_t> (port)); }
+    }
+    return schedule;
+
+} /* End of PortSchedule () */
+
+
+/*
+ * This function parses the number of shards an NMAP sweep is split into, as given on the command line.
+ * :arg: value, const string holding the number of shards, up to DISC_MAX_SHARDS, or "auto".
+ * :arg: shards, size_t set to the number of shards, 0 for "auto".
+ * :return: bool value indicating whether the value is a valid one.
+ */
+bool ParseShardCount (const std::string &value, size_t &shards) {
+
+    if (value == SHARDS_AUTO) {
+        shards = 0;
+        return true;
+    }
+    /* strtoul () would take leading spaces & signs */
+    if (value.empty () || !std::isdigit (static_cast <unsigned char> (value [0]))) { return false; }
+    char *end = nullptr;
+    unsigned long count = std::strtoul (value.c_str (), &end, 10);
+    if (*end != '\0' || count == 0 || count > DISC_MAX_SHARDS) { return false; }
+    shards = count;
+    return true;
+
+} /* End of ParseShardCount () */
+
+
+/*
+ * This function tunes the number of shards a sweep of the given number of ports is split into. Left to itself, it
+ * runs an NMAP child per available core, but no more than DISC_MAX_SHARDS, nor so many that a shard would hold fewer
+ * than DISC_SHARD_MIN_PORTS ports.
+ * :arg: requested, size_t holding the number of shards asked for, 0 to tune it to the available cores.
+ * :arg: ports, size_t holding the number of ports to be swept.
+ * :return: size_t holding the number of shards, 1 if the sweep is not to be split.
+ */
+size_t ShardCount (size_t requested, size_t ports) {
+
+    size_t shards = requested ? requested : std::max (1U, std::thread::hardware_concurrency ());
+    shards = std::min ({shards, DISC_MAX_SHARDS, ports / DISC_SHARD_MIN_PORTS});
+    return std::max (shards, size_t {1});
+
+} /* End of ShardCount () */
+
+
+/*
+ * This function splits the given ports into contiguous runs of near equal size and writes each of them as an NMAP
+ * port specification, with consecutive ports folded into ranges, e.g. "-p" "1-19,21-79".
+ * :arg: ports, const vector of the ports to be swept, in order.
+ * :arg: shards, size_t holding the number of shards.
+ * :return: vector of the NMAP arguments selecting the ports of each shard.
+ */
+std::vector <std::vector <std::string>> ShardPortSpecs (const std::vector <uint16_t> &ports, size_t shards) {
+
+    std::vector <std::vector <std::string>> specs;
+    shards = std::max (size_t {1}, std::min (shards, ports.size ()));
+    for (size_t shard = 0; shard < shards; shard++) {
+        std::vector <uint16_t> run (ports.begin () + ports.size () * shard / shards,
+                                    ports.begin () + ports.size () * (shard + 1) / shards);
+        std::sort (run.begin (), run.end ());
+        std::string spec;
+        for (size_t index = 0; index < run.size ();) {
+            size_t last = index;
+            while (last + 1 < run.size () && run [last + 1] == run [last] + 1) { last++; }
+            if (index) { spec += ','; }
+            spec += std::to_string (run [index]);
+            if (last > index) {
+                spec += '-';
+                spec += std::to_string (run [last]);
+            }
+            index = last + 1;
+        }
+        specs.push_back ({"-p", spec});
+    }
+    return specs;
+
+} /* End of ShardPortSpecs () */
@@ -0,0 +1,337 @@
+/*
+ ***********************************************************************************************************************
+ * File: engine.cpp
+ * Description: This file contains definitions of member functions associated with the embeddable scan engine & the
+ *              result sinks shipped with it.
+ * Functions:
+ *           class SinkFanout
+ *              SinkFanout ()
+ *              void PortsDiscovered ()
+ *              void PortScanned ()
+ *           class ConsoleSink
+ *              ConsoleSink ()
+ *              void HostsSwept ()
+ *              void PortsDiscovered ()
+ *              void ScanFinished ()
+ *           class ScanEngine
+ *              ScanEngine ()
+ *              ReturnCodes PrepareDirectories ()
+ *              void AddResultSink ()
+ *              ScanResult Scan ()
+ *              vector <ScanResult> ScanTargets ()
+ *              future <ScanResult> ScanAsync ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "engine.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+/* Relays the observer callbacks of a host to the sinks attached to the engine */
+class SinkFanout : public ScanObserver {
+    private:
+        const Host &host;
+        const std::vector <ResultSink *> &sinks;
+        const CVEIndex &cveIndex;
+    public:
+        SinkFanout (const Host &scanHost, const std::vector <ResultSink *> &resultSinks, const CVEIndex &index);
+        void PortsDiscovered (const std::string &address, const std::vector <Port> &open,
+                              const std::vector <Port> &filtered) override;
+        void PortScanned (const std::string &address, const Port &port) override;
+
+}; /* End of class SinkFanout */
+
+
+/*
+ * Instantiates a new object of SinkFanout class.
+ * :arg: scanHost, const Host object whose callbacks are relayed.
+ * :arg: resultSinks, const vector of the sinks to be notified, in order.
+ * :arg: index, const CVEIndex object each scanned port is matched against before it is relayed.
+ */
+SinkFanout::SinkFanout (const Host &scanHost, const std::vector <ResultSink *> &resultSinks, const CVEIndex &index)
+                       : host (scanHost), sinks (resultSinks), cveIndex (index) {
+
+} /* End of SinkFanout () */
+
+
+/*
+ * This function relays the end of port discovery, the sinks read the ports from the host itself.
+ */
+void SinkFanout::PortsDiscovered (const std::string &, const std::vector <Port> &, const std::vector <Port> &) {
+
+    for (ResultSink *sink : sinks) { sink->PortsDiscovered (host); }
+
+} /* End of PortsDiscovered () */
+
+
+/*
+ * This function relays the end of the script scan of a port, along with the known CVEs of the port, so results can
+ * be published as they are produced rather than once the host is done.
+ * :arg: address, const string holding the IP address of the host.
+ * :arg: port, const Port object which has been scanned.
+ */
+void SinkFanout::PortScanned (const std::string &address, const Port &port) {
+
+    if (sinks.empty ()) { return; }
+    Port matched = port;
+    if (cveIndex.IsOpen ()) { cveIndex.MatchPorts ({&matched}); }
+    for (ResultSink *sink : sinks) { sink->PortScanned (address, matched); }
+
+} /* End of PortScanned () */
+
+
+/*
+ * Instantiates a new object of ConsoleSink class.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: queries, const vector of the CPE prefixes to be queried once the scan is finished.
+ */
+ConsoleSink::ConsoleSink (Logger objLog, const std::vector <std::string> &queries)
+                         : consoleLog (objLog), cpeQueries (queries), labelHosts (false) {
+
+} /* End of ConsoleSink () */
+
+
+/*
+ * This function prints the outcome of the liveness sweep of the targets, once it is over.
+ * :arg: hosts, const vector of HostLiveness objects of the targets.
+ * :arg: policy, UnknownPolicy applied to the targets of unknown liveness.
+ */
+void ConsoleSink::HostsSwept (const std::vector <HostLiveness> &hosts, UnknownPolicy policy) {
+
+    PrintLivenessSummary (hosts, policy, consoleLog);
+    labelHosts = true;
+
+} /* End of HostsSwept () */
+
+
+/*
+ * This function prints the open & filtered ports of a host, once they are discovered.
+ * :arg: host, const Host object whose ports have been discovered.
+ */
+void ConsoleSink::PortsDiscovered (const Host &host) {
+
+    if (labelHosts) { std::cout << CYN << "[" << host.Address () << "]" << RST << std::endl; }
+    host.PrintOpenScanSummary (consoleLog);
+
+} /* End of PortsDiscovered () */
+
+
+/*
+ * This function prints the script scan summary of a host and answers the CPE queries, once the scan is finished.
+ * :arg: result, const ScanResult object of the finished scan.
+ */
+void ConsoleSink::ScanFinished (const ScanResult &result) {
+
+    if (!result.host) { return; }
+    result.host->PrintDeepScanSummary (consoleLog);
+    CPEIndex cpeIndex;
+    result.host->IndexCPEs (cpeIndex);
+    for (const auto &prefix : cpeQueries) { PrintCPEQuery (cpeIndex, prefix, consoleLog); }
+
+} /* End of ScanFinished () */
+
+
+/*
+ * Instantiates a new object of ScanEngine class, creating the working directories and loading the signatures, the
+ * command templates & the offline CVE index, which stay loaded for every scan run by the engine. Directories which
+ * cannot be created are logged and tried again by each scan, which fails until they exist; the embedding process is
+ * never exited.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ */
+ScanEngine::ScanEngine (Logger objLog) : engineLog (objLog) {
+
+    workDirs = PrepareDirectories ();
+    signatures.Load (SIG_FILE, engineLog);
+    commands.Load (COMMANDS_FILE, engineLog);
+    cveIndex.Open (CVE_INDEX_FILE, engineLog);
+
+} /* End of ScanEngine () */
+
+
+/*
+ * This function creates the working directories, holding the logs, the NMAP output files & the journal.
+ * :return: ReturnCodes denoting whether the directories exist.
+ */
+ReturnCodes ScanEngine::PrepareDirectories () {
+
+    /* module = MOD_INIT */
+    std::string error;
+    ReturnCodes result = InitializeDirectories ({DIR_BASE, DIR_LOGS, DIR_PORTS}, error);
+    if (result != WORK_DIRS_PASS) {
+        std::stringstream optional;
+        optional << error;
+        engineLog.Log (FAIL, MOD_INIT, WORK_DIRS_FAIL, true, optional);
+    }
+    return result;
+
+} /* End of PrepareDirectories () */
+
+
+/*
+ * This function attaches a sink, notified by every scan started after this call.
+ * :arg: sink, pointer to the ResultSink object, which must outlive those scans.
+ */
+void ScanEngine::AddResultSink (ResultSink *sink) {
+
+    std::lock_guard <std::mutex> lock (sinkMtx);
+    sinks.push_back (sink);
+
+} /* End of AddResultSink () */
+
+
+/*
+ * This function scans a target on the calling thread: port discovery, of the UDP services too when asked for, then,
+ * with the default profile, banner grabbing, native version detection & HTTP fingerprinting when asked for, the NMAP
+ * script scan of every open port not identified natively, the inspection of TLS ports when asked for and the lookup of
+ * known CVEs. When discovery is ordered by frequency, the stages run on the most frequently open ports while the rest
+ * are swept, then once more on the ports found by that sweep. Progress is checkpointed to the journal, so an
+ * interrupted scan can be resumed by a later request.
+ * :arg: request, const ScanRequest object describing the scan.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: ScanResult object holding the host and the outcome of the scan.
+ */
+ScanResult ScanEngine::Scan (const ScanRequest &request, const CancelToken &token) {
+
+    ScanResult result;
+    std::vector <ResultSink *> notified;
+    {
+        std::lock_guard <std::mutex> lock (sinkMtx);
+        notified = sinks;
+    }
+    std::string address;
+    if (ConvertToIPAddress (request.target, address) != TARGET_ADDR_PASS) {
+        for (ResultSink *sink : notified) { sink->ScanFinished (result); }
+        return result;
+    }
+
+    std::lock_guard <std::mutex> lock (scanMtx);
+    if (workDirs != WORK_DIRS_PASS && (workDirs = PrepareDirectories ()) != WORK_DIRS_PASS) {
+        result.status = WORK_DIRS_FAIL;
+        for (ResultSink *sink : notified) { sink->ScanFinished (result); }
+        return result;
+    }
+    result.host = std::make_shared <Host> (address);
+    Host &host = *result.host;
+    Journal journal (LOG_JOURNAL);
+    SinkFanout fanout (host, notified, cveIndex);
+    if (journal.Open (request.resume, engineLog) == JOURNAL_OPEN_PASS) { host.AttachJournal (&journal); }
+    host.AttachSignatures (&signatures);
+    host.AttachCommands (&commands);
+    host.AttachObserver (&fanout);
+    result.status = host.GetOpenPorts (engineLog, token, request.discovery, request.udp, request.frequentFirst,
+                                       request.shards);
+    /* Ports swept in the background are collected, then staged, once the ports found ahead of them are done */
+    for (bool staging = result.status == PORTS_FOUND_PASS; staging; staging = host.CollectTail (engineLog) > 0) {
+        if (request.profile != PROFILE_DEFAULT) { continue; }
+        if (request.banners) { host.GrabBanners (engineLog, token); }
+        if (request.versionProbes && !serviceProbes.IsLoaded ()) {
+            /* The database is only loaded by the first scan asking for it, a copy under PH/ overrides NMAP's */
+            serviceProbes.Load (std::filesystem::exists (SERVICE_PROBES_FILE) ? SERVICE_PROBES_FILE :
+                                SERVICE_PROBES_SYSTEM, engineLog);
+        }
+        if (request.versionProbes && serviceProbes.IsLoaded ()) {
+            host.DetectVersions (serviceProbes, engineLog, token);
+        }
+        if (request.http && !token.IsCancelled ()) { host.FingerprintHTTP (request.httpPaths, engineLog, token); }
+        host.MultitreadedNMAPScript (engineLog, token, request.maxThreads);
+        if (request.tls && !token.IsCancelled ()) { host.InspectTLSPorts (engineLog, token); }
+        if (cveIndex.IsOpen ()) { host.MatchKnownCVEs (cveIndex, engineLog); }
+    }
+    /* The journal, the fanout, the signatures & the templates do not outlive this call, the host may */
+    host.AttachJournal (nullptr);
+    host.AttachObserver (nullptr);
+    host.AttachSignatures (nullptr);
+    host.AttachCommands (nullptr);
+    result.cancelled = token.IsCancelled ();
+    for (ResultSink *sink : notified) { sink->ScanFinished (result); }
+    return result;
+
+} /* End of Scan () */
+
+
+/*
+ * This function scans a set of targets one after the other on the calling thread. When there is more than one, or
+ * the request asks for it, the targets are first swept for liveness all at once, and only the hosts found up, plus
+ * those of unknown liveness if the request's policy says so, are scanned. Targets after the first append to the
+ * journal of the earlier ones, so a resumed run skips the work they completed.
+ * :arg: request, const ScanRequest object describing the scan of each target, its target is ignored.
+ * :arg: addresses, const vector of the IPv4 addresses of the targets.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: vector of the ScanResult objects of the targets scanned, in order.
+ */
+std::vector <ScanResult> ScanEngine::ScanTargets (const ScanRequest &request,
+                                                  const std::vector <std::string> &addresses,
+                                                  const CancelToken &token) {
+
+    /* module = MOD_LIVENESS */
+    std::vector <ScanResult> results;
+    std::vector <HostLiveness> hosts;
+    for (const auto &address : addresses) {
+        HostLiveness host;
+        host.address = address;
+        hosts.push_back (host);
+    }
+    if (request.ping || hosts.size () > 1) {
+        ScopedTimer phaseTimer (MET_PHASE_LIVENESS);
+        EventLoop loop;
+        ReturnCodes swept = LIVENESS_SWEEP_FAIL;
+        loop.Spawn (StoreResult (LivenessSweep (loop, hosts, token), swept));
+        loop.Run ();
+        phaseTimer.Stop ();
+        if (swept == LIVENESS_SWEEP_FAIL) {
+            engineLog.Log (FAIL, MOD_LIVENESS, LIVENESS_SWEEP_FAIL, true);
+            return results;
+        }
+        for (const HostLiveness &host : hosts) {
+            runMetrics.GetCounter (host.state == LIVENESS_UP ? MET_LIVE_UP : host.state == LIVENESS_DOWN ?
+                                   MET_LIVE_DOWN : MET_LIVE_UNKNOWN).Add ();
+        }
+        std::vector <ResultSink *> notified;
+        {
+            std::lock_guard <std::mutex> lock (sinkMtx);
+            notified = sinks;
+        }
+        for (ResultSink *sink : notified) { sink->HostsSwept (hosts, request.unknownHosts); }
+    }
+
+    ScanRequest hostRequest = request;
+    for (const HostLiveness &host : hosts) {
+        if (token.IsCancelled ()) { break; }
+        if (!AdmitHost (host, request.unknownHosts)) {
+            std::stringstream optional;
+            optional << "Target: " << host.address;
+            engineLog.Log (INFO, MOD_LIVENESS, HOST_SKIPPED_INFO, false, optional);
+            continue;
+        }
+        hostRequest.target = host.address;
+        if (hosts.size () > 1) { engineLog.Header (host.address); }
+        results.push_back (Scan (hostRequest, token));
+        hostRequest.resume = true;
+    }
+    return results;
+
+} /* End of ScanTargets () */
+
+
+/*
+ * This function starts a scan on a thread of its own. The completion callback, if given, is called on that thread
+ * once the sinks have been notified, before the future becomes ready.
+ * :arg: request, const ScanRequest object describing the scan, copied.
+ * :arg: token, CancelToken object observed for cancellation requests, which must outlive the scan.
+ * :arg: onComplete, function called with the result of the scan, may be empty.
+ * :return: future holding the ScanResult object of the scan.
+ */
+std::future <ScanResult> ScanEngine::ScanAsync (const ScanRequest &request, const CancelToken &token,
+                                                std::function <void (const ScanResult &)> onComplete) {
+
+    return std::async (std::launch::async, [this, request, &token, onComplete]() {
+        traceRecorder.NameThread ("scan");
+        ScanResult result = Scan (request, token);
+        if (onComplete) { onComplete (result); }
+        return result;
+    });
+
+} /* End of ScanAsync () */
@@ -0,0 +1,271 @@
+/*
+ ***********************************************************************************************************************
+ * File: eventloop.cpp
+ * Description: This file contains definitions of member functions associated with the epoll event loop, its
+ *              awaitables & the concurrency limiter.
+ * Functions:
+ *           class LoopAwaiter
+ *              LoopAwaiter ()
+ *              void await_suspend ()
+ *           struct YieldAwaiter
+ *              void await_suspend ()
+ *           class EventLoop
+ *              EventLoop ()
+ *              ~EventLoop ()
+ *              DetachedTask RunDetached ()
+ *              void Spawn ()
+ *              void Schedule ()
+ *              void Suspend ()
+ *              void Wake ()
+ *              void Run ()
+ *              LoopAwaiter Readable ()
+ *              LoopAwaiter Writable ()
+ *              LoopAwaiter Sleep ()
+ *              YieldAwaiter Yield ()
+ *           class Limiter
+ *              Limiter ()
+ *              Awaiter Acquire ()
+ *              void Release ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "eventloop.hpp"
+
+const int LOOP_EVENTS_MAX = 64;
+
+
+/*
+ * Instantiates a new object of LoopAwaiter class.
+ * :arg: eventLoop, EventLoop object on which the coroutine is suspended.
+ * :arg: fd, integer holding the descriptor to be awaited, -1 to await the deadline alone.
+ * :arg: waitEvents, uint32_t holding the epoll events to be awaited.
+ * :arg: waitMs, integer denoting the deadline in milliseconds, -1 for none.
+ */
+LoopAwaiter::LoopAwaiter (EventLoop &eventLoop, int fd, uint32_t waitEvents, int waitMs)
+                         : loop (eventLoop), events (waitEvents), timeoutMs (waitMs) {
+
+    waiter.fd = fd;
+
+} /* End of LoopAwaiter () */
+
+
+/*
+ * This function registers the suspended coroutine with the loop.
+ * :arg: handle, coroutine_handle of the suspended coroutine.
+ */
+void LoopAwaiter::await_suspend (std::coroutine_handle <> handle) {
+
+    waiter.handle = handle;
+    loop.Suspend (waiter, events, timeoutMs);
+
+} /* End of await_suspend () */
+
+
+/*
+ * This function queues the suspended coroutine behind the ones already runnable.
+ * :arg: handle, coroutine_handle of the suspended coroutine.
+ */
+void YieldAwaiter::await_suspend (std::coroutine_handle <> handle) {
+
+    loop.Schedule (handle);
+
+} /* End of await_suspend () */
+
+
+/*
+ * Instantiates a new object of EventLoop class.
+ */
+EventLoop::EventLoop () : epollFd (epoll_create1 (EPOLL_CLOEXEC)), live (0) {
+
+} /* End of EventLoop () */
+
+
+/*
+ * Closes the epoll descriptor of the loop. Tasks still suspended are leaked, Run () is to be called before.
+ */
+EventLoop::~EventLoop () {
+
+    if (epollFd >= 0) { close (epollFd); }
+
+} /* End of ~EventLoop () */
+
+
+/*
+ * This function runs a spawned task from the loop's next turn and accounts for it until it has finished.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: task, Task object to be run.
+ * :return: DetachedTask, which destroys itself once done.
+ */
+DetachedTask EventLoop::RunDetached (EventLoop &loop, Task <> task) {
+
+    co_await loop.Yield ();
+    co_await task;
+    loop.live--;
+
+} /* End of RunDetached () */
+
+
+/*
+ * This function hands a task over to the loop, which runs it detached.
+ * :arg: task, Task object to be run.
+ */
+void EventLoop::Spawn (Task <> task) {
+
+    live++;
+    RunDetached (*this, std::move (task));
+
+} /* End of Spawn () */
+
+
+/*
+ * This function queues a suspended coroutine to be resumed on the loop's next turn.
+ * :arg: handle, coroutine_handle of the suspended coroutine.
+ */
+void EventLoop::Schedule (std::coroutine_handle <> handle) {
+
+    ready.push_back (handle);
+
+} /* End of Schedule () */
+
+
+/*
+ * This function parks a suspended coroutine until its descriptor is ready or its deadline has passed. Descriptors
+ * epoll cannot watch are polled in place, so the coroutine still sees them as ready or timed out.
+ * :arg: waiter, LoopWaiter object of the suspended coroutine, which lives in its frame.
+ * :arg: events, uint32_t holding the epoll events to be awaited.
+ * :arg: timeoutMs, integer denoting the deadline in milliseconds, -1 for none.
+ */
+void EventLoop::Suspend (LoopWaiter &waiter, uint32_t events, int timeoutMs) {
+
+    waiter.timedOut = false;
+    waiter.hasTimer = false;
+    if (waiter.fd >= 0) {
+        struct epoll_event event {};
+        event.events = events | EPOLLONESHOT;
+        event.data.ptr = &waiter;
+        if (epoll_ctl (epollFd, EPOLL_CTL_ADD, waiter.fd, &event) != 0) {
+            struct pollfd single {waiter.fd, static_cast <short> (events), 0};
+            while (poll (&single, 1, timeoutMs) < 0 && errno == EINTR) {}
+            waiter.timedOut = single.revents == 0;
+            waiter.fd = -1;
+            Schedule (waiter.handle);
+            return;
+        }
+    }
+    if (timeoutMs >= 0) {
+        auto deadline = std::chrono::steady_clock::now () + std::chrono::milliseconds (timeoutMs);
+        waiter.timer = timers.emplace (deadline, &waiter);
+        waiter.hasTimer = true;
+    }
+    else if (waiter.fd < 0) {
+        Schedule (waiter.handle);
+    }
+
+} /* End of Suspend () */
+
+
+/*
+ * This function unparks a coroutine, dropping whichever of its descriptor & deadline has not fired, and resumes it.
+ * :arg: waiter, LoopWaiter object of the coroutine.
+ * :arg: timedOut, bool value indicating whether the deadline fired.
+ */
+void EventLoop::Wake (LoopWaiter &waiter, bool timedOut) {
+
+    if (waiter.fd >= 0) { epoll_ctl (epollFd, EPOLL_CTL_DEL, waiter.fd, nullptr); }
+    if (waiter.hasTimer) { timers.erase (waiter.timer); }
+    waiter.hasTimer = false;
+    waiter.timedOut = timedOut;
+    waiter.handle.resume ();
+
+} /* End of Wake () */
+
+
+/*
+ * This function drives the loop on the calling thread until every spawned task has finished.
+ */
+void EventLoop::Run () {
+
+    struct epoll_event events [LOOP_EVENTS_MAX];
+    while (live > 0) {
+        while (!ready.empty ()) {
+            std::coroutine_handle <> handle = ready.front ();
+            ready.pop_front ();
+            handle.resume ();
+        }
+        if (live == 0) { break; }
+        int timeout = -1;
+        if (!timers.empty ()) {
+            auto wait = timers.begin ()->first - std::chrono::steady_clock::now ();
+            auto waitMs = std::chrono::ceil <std::chrono::milliseconds> (wait).count ();
+            timeout = static_cast <int> (std::max <int64_t> (waitMs, 0));
+        }
+        int count = epoll_wait (epollFd, events, LOOP_EVENTS_MAX, timeout);
+        for (int index = 0; index < count; index++) {
+            Wake (*static_cast <LoopWaiter *> (events [index].data.ptr), false);
+        }
+        auto now = std::chrono::steady_clock::now ();
+        while (!timers.empty () && timers.begin ()->first <= now) {
+            LoopWaiter &waiter = *timers.begin ()->second;
+            timers.erase (timers.begin ());
+            waiter.hasTimer = false;
+            Wake (waiter, true);
+        }
+    }
+
+} /* End of Run () */
+
+
+/*
+ * These functions return the awaitables of the loop: Readable & Writable resume once the descriptor is ready, with
+ * false when the deadline passes first, Sleep once the deadline has passed & Yield on the loop's next turn.
+ */
+LoopAwaiter EventLoop::Readable (int fd, int timeoutMs) { return {*this, fd, EPOLLIN, timeoutMs}; }
+LoopAwaiter EventLoop::Writable (int fd, int timeoutMs) { return {*this, fd, EPOLLOUT, timeoutMs}; }
+LoopAwaiter EventLoop::Sleep (int ms) { return {*this, -1, 0, ms}; }
+YieldAwaiter EventLoop::Yield () { return {*this}; } /* End of Yield () */
+
+
+/*
+ * Instantiates a new object of Limiter class.
+ * :arg: eventLoop, EventLoop object running the tasks.
+ * :arg: limit, size_t holding the number of tasks let in at once, at least one.
+ */
+Limiter::Limiter (EventLoop &eventLoop, size_t limit) : loop (eventLoop), available (std::max <size_t> (limit, 1)) {
+
+} /* End of Limiter () */
+
+
+/*
+ * These functions let a task in straight away while there is room, or queue it otherwise.
+ */
+bool Limiter::Awaiter::await_ready () noexcept {
+
+    if (limiter.available == 0) { return false; }
+    limiter.available--;
+    return true;
+
+}
+void Limiter::Awaiter::await_suspend (std::coroutine_handle <> handle) { limiter.waiting.push_back (handle); }
+Limiter::Awaiter Limiter::Acquire () { return {*this}; } /* End of Acquire () */
+
+
+/*
+ * This function lets a task out, handing its place to the longest waiting task.
+ */
+void Limiter::Release () {
+
+    if (waiting.empty ()) {
+        available++;
+        return;
+    }
+    loop.Schedule (waiting.front ());
+    waiting.pop_front ();
+
+} /* End of Release () */
@@ -0,0 +1,238 @@
+/*
+ ***********************************************************************************************************************
+ * File: findings.cpp
+ * Description: This file contains definitions of support functions associated with extracting structured findings
+ *              from the <table>/<elem> trees emitted by NSE scripts, along with their ranking & de-duplication.
+ * Functions:
+ *           uint32_t PackCVE ()
+ *           string UnpackCVE ()
+ *           string FindingStateName ()
+ *           FindingState ParseFindingState ()
+ *           void AddCVE ()
+ *           void BuildFinding ()
+ *           void ExtractFindings ()
+ *           void RankFindings ()
+ *           string FormatFinding ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include "cpe.hpp"
+#include "findings.hpp"
+
+static const std::vector <std::string> FINDING_STATE_NAMES = {"unknown", "not vulnerable", "likely vulnerable",
+                                                              "vulnerable", "exploitable"};
+
+
+/*
+ * This function packs a CVE id into 32 bits, the year offset from CVE_YEAR_BASE in the top 8 bits and the sequence
+ * number in the lower 24 bits. A leading "CVE:" as used in NSE "ids" tables is accepted.
+ * :arg: cve, const string holding the CVE id, e.g. "CVE-2017-0143".
+ * :return: packed CVE id, 0 if the string is not a CVE id.
+ */
+uint32_t PackCVE (const std::string &cve) {
+
+    unsigned year = 0;
+    unsigned number = 0;
+    const char *text = cve.c_str ();
+    if (strncasecmp (text, "CVE:", 4) == 0) { text += 4; }
+    if (strncasecmp (text, "CVE-", 4) != 0 || sscanf (text + 4, "%u-%u", &year, &number) != 2) { return 0; }
+    if (year <= CVE_YEAR_BASE || year - CVE_YEAR_BASE > 0xFF || number > 0xFFFFFF) { return 0; }
+    return ((year - CVE_YEAR_BASE) << 24) | number;
+
+} /* End of PackCVE () */
+
+
+/*
+ * This function reverses PackCVE.
+ * :arg: packed, uint32_t holding the packed CVE id.
+ * :return: string holding the CVE id.
+ */
+std::string UnpackCVE (uint32_t packed) {
+
+    char cve [24];
+    snprintf (cve, sizeof (cve), "CVE-%u-%04u", (packed >> 24) + CVE_YEAR_BASE, packed & 0xFFFFFF);
+    return cve;
+
+} /* End of UnpackCVE () */
+
+
+/*
+ * This function returns the printable name of the given finding state.
+ * :arg: state, FindingState to be named.
+ * :return: string holding the name of the state.
+ */
+const std::string FindingStateName (FindingState state) {
+
+    return (state < FINDING_STATE_NAMES.size ()) ? FINDING_STATE_NAMES [state] : FINDING_STATE_NAMES [0];
+
+} /* End of FindingStateName () */
+
+
+/*
+ * This function converts the state reported by the NSE vulns library (e.g. "LIKELY VULNERABLE",
+ * "VULNERABLE (Exploitable)") or a name given by FindingStateName into a FindingState.
+ * :arg: state, const string holding the state.
+ * :return: FindingState of the state, FINDING_UNKNOWN if it is not recognised.
+ */
+FindingState ParseFindingState (const std::string &state) {
+
+    std::string upper = state;
+    std::transform (upper.begin (), upper.end (), upper.begin (), ::toupper);
+    if (upper.find ("NOT VULNERABLE") != std::string::npos) { return FINDING_NOT_VULNERABLE; }
+    if (upper.find ("EXPLOITABLE") != std::string::npos) { return FINDING_EXPLOITABLE; }
+    if (upper.find ("LIKELY") != std::string::npos) { return FINDING_LIKELY; }
+    if (upper.find ("VULNERABLE") != std::string::npos) { return FINDING_VULNERABLE; }
+    return FINDING_UNKNOWN;
+
+} /* End of ParseFindingState () */
+
+
+/*
+ * This function adds a CVE id to the finding, unless it is already present or the record is full.
+ * :arg: finding, Finding object to which the CVE id is added.
+ * :arg: cve, const string holding the CVE id.
+ */
+static void AddCVE (Finding &finding, const std::string &cve) {
+
+    uint32_t packed = PackCVE (cve);
+    if (packed == 0 || finding.cveCount >= MAX_FINDING_CVES) { return; }
+    if (std::find (finding.cves, finding.cves + finding.cveCount, packed) != finding.cves + finding.cveCount) { return; }
+    finding.cves [finding.cveCount++] = packed;
+
+} /* End of AddCVE () */
+
+
+/*
+ * This function builds a finding from a single NSE table, when the table describes one. Tables from the vulns library
+ * carry "state", "title", "ids", "scores" & "refs", while tables from vulners-style scripts carry "id" & "cvss".
+ * :arg: table, const xml_node of the <table> to be examined.
+ * :arg: script, uint32_t holding the interned script id.
+ * :arg: scope, FindingScope of the script.
+ * :arg: finding, Finding object to which the finding is copied to.
+ * :return: bool value indicating whether the table describes a finding.
+ */
+static bool BuildFinding (const pugi::xml_node &table, uint32_t script, FindingScope scope, Finding &finding) {
+
+    std::map <std::string, std::string> elems;
+    for (pugi::xml_node elem = table.child ("elem"); elem; elem = elem.next_sibling ("elem")) {
+        elems [elem.attribute ("key").value ()] = elem.child_value ();
+    }
+    bool library = elems.count ("state") > 0;
+    bool listing = elems.count ("id") > 0 && elems.count ("cvss") > 0;
+    if (!library && !listing) { return false; }
+
+    finding = Finding {};
+    finding.script = script;
+    finding.scope = scope;
+    if (library) {
+        finding.state = ParseFindingState (elems ["state"]);
+        finding.title = InternString (elems.count ("title") ? elems ["title"] : table.attribute ("key").value ());
+        AddCVE (finding, table.attribute ("key").value ());
+    } else {
+        /* Listings are derived from the detected version, not from probing the flaw */
+        finding.state = FINDING_LIKELY;
+        finding.title = InternString (elems ["id"]);
+        AddCVE (finding, elems ["id"]);
+        finding.score = static_cast <uint16_t> (std::max (0.0, atof (elems ["cvss"].c_str ()) * 10));
+    }
+
+    for (pugi::xml_node child = table.child ("table"); child; child = child.next_sibling ("table")) {
+        std::string key = child.attribute ("key").value ();
+        for (pugi::xml_node elem = child.child ("elem"); elem; elem = elem.next_sibling ("elem")) {
+            std::string value = elem.child_value ();
+            if (key == "ids") {
+                AddCVE (finding, value);
+            } else if (key == "refs" && finding.refCount < MAX_FINDING_REFS) {
+                finding.refs [finding.refCount++] = InternString (value);
+            } else if (key == "scores") {
+                /* Keep the highest of the CVSS versions given */
+                uint16_t score = static_cast <uint16_t> (std::max (0.0, atof (value.c_str ()) * 10));
+                finding.score = std::max (finding.score, score);
+            }
+        }
+    }
+    return true;
+
+} /* End of BuildFinding () */
+
+
+/*
+ * This function extracts every finding from the tables of the given <script> node, descending into tables which do
+ * not themselves describe a finding (e.g. vulners groups its listings by CPE).
+ * :arg: script, const xml_node of the <script>.
+ * :arg: scope, FindingScope of the script, port or host.
+ * :arg: findings, vector of Finding to which the findings are appended.
+ */
+void ExtractFindings (const pugi::xml_node &script, FindingScope scope, std::vector <Finding> &findings) {
+
+    uint32_t scriptID = InternString (script.attribute ("id").value ());
+    std::vector <pugi::xml_node> pending;
+    for (pugi::xml_node table = script.child ("table"); table; table = table.next_sibling ("table")) {
+        pending.push_back (table);
+    }
+    while (!pending.empty ()) {
+        pugi::xml_node table = pending.back ();
+        pending.pop_back ();
+        Finding finding;
+        if (BuildFinding (table, scriptID, scope, finding)) {
+            findings.push_back (finding);
+            continue;
+        }
+        for (pugi::xml_node child = table.child ("table"); child; child = child.next_sibling ("table")) {
+            pending.push_back (child);
+        }
+    }
+
+} /* End of ExtractFindings () */
+
+
+/*
+ * This function orders findings most severe first, by state and then by score, and drops duplicates. Findings are
+ * duplicates when they share the script, the scope and either their first CVE id or, without one, their title; the
+ * most severe of them is kept.
+ * :arg: findings, vector of Finding to be ranked in place.
+ */
+void RankFindings (std::vector <Finding> &findings) {
+
+    auto identity = [](const Finding &finding) {
+        return std::make_tuple (finding.script, finding.scope, finding.cveCount ? finding.cves [0] : 0,
+                                finding.cveCount ? 0 : finding.title);
+    };
+    std::sort (findings.begin (), findings.end (), [&](const Finding &left, const Finding &right) {
+        if (identity (left) != identity (right)) { return identity (left) < identity (right); }
+        return std::tie (left.state, left.score) > std::tie (right.state, right.score);
+    });
+    findings.erase (std::unique (findings.begin (), findings.end (), [&](const Finding &left, const Finding &right) {
+        return identity (left) == identity (right);
+    }), findings.end ());
+    std::stable_sort (findings.begin (), findings.end (), [](const Finding &left, const Finding &right) {
+        return std::tie (left.state, left.score) > std::tie (right.state, right.score);
+    });
+
+} /* End of RankFindings () */
+
+
+/*
+ * This function formats a finding into a single printable line, e.g.
+ * "[vulnerable] CVE-2017-0143 (9.3) smb-vuln-ms17-010: Remote Code Execution vulnerability in Microsoft SMBv1".
+ * :arg: finding, const Finding object to be formatted.
+ * :return: string holding the formatted finding.
+ */
+std::string FormatFinding (const Finding &finding) {
+
+    std::stringstream line;
+    line << "[" << FindingStateName (finding.state) << "]";
+    for (int index = 0; index < finding.cveCount; index++) { line << " " << UnpackCVE (finding.cves [index]); }
+    if (finding.score > 0) { line << " (" << finding.score / 10 << "." << finding.score % 10 << ")"; }
+    line << " " << InternedString (finding.script);
+    std::string title = InternedString (finding.title);
+    if (!title.empty () && (finding.cveCount == 0 || title != UnpackCVE (finding.cves [0]))) { line << ": " << title; }
+    return line.str ();
+
+} /* End of FormatFinding () */
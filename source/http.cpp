@@ -0,0 +1,364 @@
+/*
+ ***********************************************************************************************************************
+ * File: http.cpp
+ * Description: This file contains definitions of functions associated with the native fingerprinting of web
+ *              services.
+ * Functions:
+ *           std::string BuildRequest ()
+ *           size_t ParseResponse ()
+ *           std::string ExtractTitle ()
+ *           std::string EncodeBase64 ()
+ *           bool IsHTTPService ()
+ *           int32_t MurmurHash3 ()
+ *           int32_t FaviconHash ()
+ *           Task <HTTPFingerprint> FetchHTTP ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include "http.hpp"
+#include "tls.hpp"
+#include "utilities.hpp"
+
+/* Bytes read from the stream at once */
+static const size_t HTTP_READ_CHUNK = 16384;
+static const std::string HTTP_USER_AGENT = "Mozilla/5.0 (compatible; PortHawk/1.0)";
+
+
+/*
+ * This function builds a GET request for a path. Every request but the last of a pipeline keeps the connection
+ * alive, the last one asks the server to close it once answered, so the end of the pipeline is not waited for.
+ * :arg: path, const string holding the path requested.
+ * :arg: host, const string holding the value of the Host header.
+ * :arg: last, bool value indicating whether the request ends the pipeline.
+ * :return: string holding the request.
+ */
+static std::string BuildRequest (const std::string &path, const std::string &host, bool last) {
+
+    return "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nUser-Agent: " + HTTP_USER_AGENT +
+           "\r\nAccept: */*\r\nConnection: " + (last ? "close" : "keep-alive") + "\r\n\r\n";
+
+} /* End of BuildRequest () */
+
+
+/*
+ * This function parses the response at the beginning of the bytes received, framed by Content-Length, chunked
+ * transfer coding or the end of the stream.
+ * :arg: received, const string holding the bytes received and not yet parsed.
+ * :arg: closed, bool value indicating whether the stream has ended, so a response framed by its end is complete and
+ *       a truncated one is taken as it is.
+ * :arg: response, HTTPResponse object to which the status & headers are copied.
+ * :arg: body, string to which the decoded body is copied.
+ * :arg: keepAlive, bool value set to whether the server keeps the connection open after this response.
+ * :return: number of bytes making up the response, 0 when it is incomplete, std::string::npos when the bytes are not
+ *          an HTTP response.
+ */
+static size_t ParseResponse (const std::string &received, bool closed, HTTPResponse &response, std::string &body,
+                             bool &keepAlive) {
+
+    size_t headEnd = received.find ("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        bool http = received.size () < 5 ? received == std::string ("HTTP/").substr (0, received.size ()) :
+                    received.compare (0, 5, "HTTP/") == 0;
+        return http ? 0 : std::string::npos;
+    }
+    /* Status line, "HTTP/1.1 200 OK" */
+    if (received.compare (0, 5, "HTTP/") != 0 || headEnd < 12 || !std::isdigit (received [9]) ||
+        !std::isdigit (received [10]) || !std::isdigit (received [11])) {
+        return std::string::npos;
+    }
+    response.status = std::atoi (received.substr (9, 3).c_str ());
+    keepAlive = received.compare (0, 8, "HTTP/1.0") != 0;
+    bool chunked = false;
+    bool sized = false;
+    size_t length = 0;
+    size_t lineStart = received.find ("\r\n") + 2;
+    while (lineStart < headEnd) {
+        size_t lineEnd = received.find ("\r\n", lineStart);
+        size_t colon = received.find (':', lineStart);
+        if (colon < lineEnd) {
+            std::string name = received.substr (lineStart, colon - lineStart);
+            std::transform (name.begin (), name.end (), name.begin (), ::tolower);
+            size_t valueStart = received.find_first_not_of (" \t", colon + 1);
+            std::string value = valueStart < lineEnd ? received.substr (valueStart, lineEnd - valueStart) : "";
+            while (!value.empty () && (value.back () == ' ' || value.back () == '\t')) { value.pop_back (); }
+            std::string lower = value;
+            std::transform (lower.begin (), lower.end (), lower.begin (), ::tolower);
+            if (name == "content-length") {
+                sized = true;
+                length = std::strtoull (value.c_str (), nullptr, 10);
+            }
+            else if (name == "transfer-encoding") { chunked = lower.find ("chunked") != std::string::npos; }
+            else if (name == "connection" && lower.find ("close") != std::string::npos) { keepAlive = false; }
+            else if (name == "connection" && lower.find ("keep-alive") != std::string::npos) { keepAlive = true; }
+            else if (name == "server") { response.server = value; }
+            else if (name == "content-type") { response.contentType = value; }
+            else if (name == "location") { response.location = value; }
+            else if (name == "x-powered-by") { response.poweredBy = value; }
+            else if (name == "www-authenticate") { response.authenticate = value; }
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    size_t position = headEnd + 4;
+    if (response.status < 200 || response.status == 204 || response.status == 304) { return position; }
+    if (chunked) {
+        while (true) {
+            size_t lineEnd = received.find ("\r\n", position);
+            if (lineEnd == std::string::npos) { break; }
+            size_t size = std::strtoull (received.c_str () + position, nullptr, 16);
+            position = lineEnd + 2;
+            if (size == 0) {
+                /* Trailer fields, if any, end with an empty line */
+                if (received.compare (position, 2, "\r\n") == 0) { return position + 2; }
+                size_t trailerEnd = received.find ("\r\n\r\n", position);
+                if (trailerEnd != std::string::npos) { return trailerEnd + 4; }
+                break;
+            }
+            if (received.size () < position + size + 2) {
+                if (closed) { body.append (received, position, size); }
+                break;
+            }
+            body.append (received, position, size);
+            position += size + 2;
+        }
+        return closed ? received.size () : 0;
+    }
+    if (sized) {
+        if (received.size () < position + length && !closed) { return 0; }
+        body = received.substr (position, length);
+        return std::min (received.size (), position + length);
+    }
+    /* Neither length nor chunks, the body runs until the server closes the connection */
+    keepAlive = false;
+    if (!closed) { return 0; }
+    body = received.substr (position);
+    return received.size ();
+
+} /* End of ParseResponse () */
+
+
+/*
+ * This function extracts the title of an HTML page, with runs of whitespace collapsed to a single space.
+ * :arg: body, const string holding the page.
+ * :return: string holding at most HTTP_TITLE_CHARS characters of the title, empty when the page has none.
+ */
+static std::string ExtractTitle (const std::string &body) {
+
+    std::string lower = body.substr (0, 65536);
+    std::transform (lower.begin (), lower.end (), lower.begin (), ::tolower);
+    size_t open = lower.find ("<title");
+    if (open == std::string::npos) { return ""; }
+    size_t start = lower.find ('>', open);
+    size_t end = start == std::string::npos ? std::string::npos : lower.find ("</title", start);
+    if (end == std::string::npos) { return ""; }
+    std::string title;
+    for (size_t index = start + 1; index < end && title.size () < HTTP_TITLE_CHARS; index++) {
+        unsigned char character = body [index];
+        if (std::isspace (character) || character < 0x20) {
+            if (!title.empty () && title.back () != ' ') { title += ' '; }
+        }
+        else { title += static_cast <char> (character); }
+    }
+    while (!title.empty () && title.back () == ' ') { title.pop_back (); }
+    return title;
+
+} /* End of ExtractTitle () */
+
+
+/*
+ * This function encodes bytes in base64 the way Python's base64.encodebytes () does, with a line break after every 76
+ * characters and at the end.
+ * :arg: data, const string holding the bytes.
+ * :return: string holding the encoded bytes.
+ */
+static std::string EncodeBase64 (const std::string &data) {
+
+    static const char alphabet [] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve ((data.size () + 2) / 3 * 4 + data.size () / 57 + 1);
+    for (size_t index = 0; index < data.size (); index += 3) {
+        uint32_t block = static_cast <unsigned char> (data [index]) << 16;
+        if (index + 1 < data.size ()) { block |= static_cast <unsigned char> (data [index + 1]) << 8; }
+        if (index + 2 < data.size ()) { block |= static_cast <unsigned char> (data [index + 2]); }
+        encoded += alphabet [(block >> 18) & 0x3f];
+        encoded += alphabet [(block >> 12) & 0x3f];
+        encoded += index + 1 < data.size () ? alphabet [(block >> 6) & 0x3f] : '=';
+        encoded += index + 2 < data.size () ? alphabet [block & 0x3f] : '=';
+        if ((index + 3) % 57 == 0 || index + 3 >= data.size ()) { encoded += '\n'; }
+    }
+    return encoded;
+
+} /* End of EncodeBase64 () */
+
+
+/*
+ * This function decides whether a port serves HTTP, from its service name or, when the service is unknown, from the
+ * well-known web ports.
+ * :arg: service, const string holding the name of the service.
+ * :arg: portid, const string holding the port.
+ * :return: bool value indicating whether the port is to be fingerprinted.
+ */
+bool IsHTTPService (const std::string &service, const std::string &portid) {
+
+    static const std::vector <std::string> ports = {
+        "80", "81", "443", "591", "3000", "5000", "8000", "8008", "8080", "8081", "8088", "8443", "8888", "9000",
+        "9443",
+    };
+    if (service.find ("http") != std::string::npos) { return true; }
+    return (service.empty () || service == "N/A" || service == "ssl" || service == "unknown") &&
+           std::find (ports.begin (), ports.end (), portid) != ports.end ();
+
+} /* End of IsHTTPService () */
+
+
+/*
+ * This function hashes bytes with the x86 32-bit variant of MurmurHash3.
+ * :arg: data, const string holding the bytes.
+ * :arg: seed, unsigned integer seeding the hash, default value is 0.
+ * :return: integer holding the hash, signed as mmh3.hash () returns it.
+ */
+int32_t MurmurHash3 (const std::string &data, uint32_t seed) {
+
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    const size_t blocks = data.size () / 4;
+    uint32_t hash = seed;
+    for (size_t index = 0; index < blocks; index++) {
+        uint32_t block;
+        std::memcpy (&block, data.data () + index * 4, 4);
+        block *= c1;
+        block = (block << 15) | (block >> 17);
+        block *= c2;
+        hash ^= block;
+        hash = (hash << 13) | (hash >> 19);
+        hash = hash * 5 + 0xe6546b64;
+    }
+    const unsigned char *tail = reinterpret_cast <const unsigned char *> (data.data ()) + blocks * 4;
+    uint32_t last = 0;
+    switch (data.size () & 3) {
+        case 3: last ^= tail [2] << 16; [[fallthrough]];
+        case 2: last ^= tail [1] << 8; [[fallthrough]];
+        case 1:
+            last ^= tail [0];
+            last *= c1;
+            last = (last << 15) | (last >> 17);
+            last *= c2;
+            hash ^= last;
+    }
+    hash ^= static_cast <uint32_t> (data.size ());
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return static_cast <int32_t> (hash);
+
+} /* End of MurmurHash3 () */
+
+
+/*
+ * This function hashes a favicon the way Shodan does for http.favicon.hash: MurmurHash3 of its base64 encoding.
+ * :arg: icon, const string holding the bytes of the favicon.
+ * :return: integer holding the hash.
+ */
+int32_t FaviconHash (const std::string &icon) {
+
+    return MurmurHash3 (EncodeBase64 (icon));
+
+} /* End of FaviconHash () */
+
+
+/*
+ * This function fetches the given paths from a port, as a task of the given loop. The requests are pipelined over a
+ * keep-alive connection, and the paths a server leaves unanswered, as servers which do not pipeline or close early
+ * do, are sent again over a new connection. It gives up once a connection brings no answer or the port turns out not
+ * to speak HTTP.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target, which must outlive the task.
+ * :arg: portid, const string holding the port, which must outlive the task.
+ * :arg: paths, const vector of strings holding the paths to fetch, which must outlive the task.
+ * :arg: encrypted, bool value indicating whether the port speaks HTTPS.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: HTTPFingerprint object holding the responses, in the order of the paths.
+ */
+Task <HTTPFingerprint> FetchHTTP (EventLoop &loop, const std::string &address, const std::string &portid,
+                                  const std::vector <std::string> &paths, bool encrypted, const CancelToken &token) {
+
+    HTTPFingerprint fingerprint;
+    fingerprint.tls = encrypted;
+    std::vector <HTTPResponse> answers (paths.size ());
+    std::vector <size_t> pending;
+    for (size_t index = 0; index < paths.size (); index++) { pending.push_back (index); }
+    bool standard = portid == (encrypted ? "443" : "80");
+    std::string host = standard ? address : address + ":" + portid;
+    std::vector <char> buffer (HTTP_READ_CHUNK);
+
+    /* Every connection but the last answers at least one path, so there are at most as many as paths */
+    while (!pending.empty () && !token.IsCancelled ()) {
+        NetStream stream;
+        if (!co_await stream.Open (loop, address, portid, encrypted, HTTP_TIMEOUT_MS)) { break; }
+        fingerprint.connections++;
+        std::string requests;
+        for (size_t index = 0; index < pending.size (); index++) {
+            requests += BuildRequest (paths [pending [index]], host, index + 1 == pending.size ());
+        }
+        fingerprint.requests += static_cast <int> (pending.size ());
+        /* A failed write may still leave the first requests answered */
+        co_await stream.Send (loop, requests, HTTP_TIMEOUT_MS);
+
+        std::string received;
+        size_t answered = 0;
+        bool closed = false;
+        bool keepAlive = true;
+        bool foreign = false;
+        while (answered < pending.size () && keepAlive) {
+            HTTPResponse response;
+            std::string body;
+            bool persistent = true;
+            size_t used = ParseResponse (received, closed, response, body, persistent);
+            if (used == std::string::npos) {
+                foreign = true;
+                break;
+            }
+            if (used > 0) {
+                keepAlive = persistent;
+                received.erase (0, used);
+                /* Interim responses, such as 100 Continue, precede the final one */
+                if (response.status < 200) { continue; }
+                response.path = paths [pending [answered]];
+                response.title = ExtractTitle (body);
+                response.bodyBytes = body.size ();
+                response.bodyHash = MurmurHash3 (body);
+                bool icon = response.path.size () >= 11 &&
+                            response.path.compare (response.path.size () - 11, 11, "favicon.ico") == 0;
+                if (icon && response.status == 200 && !body.empty () &&
+                    response.contentType.find ("html") == std::string::npos) {
+                    fingerprint.hasFavicon = true;
+                    fingerprint.faviconHash = FaviconHash (body);
+                }
+                answers [pending [answered++]] = response;
+                continue;
+            }
+            if (closed || token.IsCancelled ()) { break; }
+            ssize_t bytes = co_await stream.Receive (loop, buffer.data (), buffer.size (), HTTP_TIMEOUT_MS);
+            if (bytes < 0) { break; }
+            if (bytes == 0 || received.size () + bytes >= HTTP_MAX_BYTES) { closed = true; }
+            received.append (buffer.data (), bytes);
+        }
+        pending.erase (pending.begin (), pending.begin () + answered);
+        if (answered == 0 || foreign) { break; }
+    }
+
+    for (HTTPResponse &response : answers) {
+        if (response.status != 0) { fingerprint.responses.push_back (std::move (response)); }
+    }
+    fingerprint.fetched = !fingerprint.responses.empty ();
+    co_return fingerprint;
+
+} /* End of FetchHTTP () */
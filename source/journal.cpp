@@ -0,0 +1,396 @@
+/*
+ ***********************************************************************************************************************
+ * File: journal.cpp
+ * Description: This file contains definitions of support functions & member functions associated with the write-ahead
+ *              scan journal. Every completed unit of work is appended and synced to disk before it is acknowledged,
+ *              so an interrupted or crashed run can be resumed without repeating it.
+ * Functions:
+ *           uint32_t Checksum ()
+ *           string EscapeField ()
+ *           string UnescapeField ()
+ *           string JoinList ()
+ *           vector SplitList ()
+ *           class Journal
+ *              Journal ()
+ *              ~Journal ()
+ *              void Replay ()
+ *              bool Append ()
+ *              ReturnCodes Open ()
+ *              JournalHost *Find ()
+ *              void RecordDiscoveryStart ()
+ *              void RecordDiscoveredPort ()
+ *              void RecordDiscoveryEnd ()
+ *              void RecordDeepScan ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include "journal.hpp"
+#include "trace.hpp"
+
+
+/*
+ * This function computes the FNV-1a checksum of the given record, used to detect torn or corrupted journal lines.
+ * :arg: data, const string holding the record payload.
+ * :return: 32-bit checksum of the payload.
+ */
+static uint32_t Checksum (const std::string &data) {
+
+    uint32_t hash = 2166136261u;
+    for (unsigned char byte : data) {
+        hash ^= byte;
+        hash *= 16777619u;
+    }
+    return hash;
+
+} /* End of Checksum () */
+
+
+/*
+ * This function escapes the characters used as record and field separators, so arbitrary values can be journaled.
+ * :arg: field, const string holding the raw field value.
+ * :return: string holding the escaped field value.
+ */
+static std::string EscapeField (const std::string &field) {
+
+    std::string result;
+    result.reserve (field.size ());
+    for (char character : field) {
+        switch (character) {
+            case '\\': result += "\\\\"; break;
+            case '\t': result += "\\t"; break;
+            case '\n': result += "\\n"; break;
+            default: result += character;
+        }
+    }
+    return result;
+
+} /* End of EscapeField () */
+
+
+/*
+ * This function reverses EscapeField.
+ * :arg: field, const string holding the escaped field value.
+ * :return: string holding the raw field value.
+ */
+static std::string UnescapeField (const std::string &field) {
+
+    std::string result;
+    result.reserve (field.size ());
+    for (size_t index = 0; index < field.size (); index++) {
+        if (field [index] == '\\' && index + 1 < field.size ()) {
+            char next = field [++index];
+            result += (next == 't') ? '\t' : (next == 'n') ? '\n' : next;
+        } else {
+            result += field [index];
+        }
+    }
+    return result;
+
+} /* End of UnescapeField () */
+
+
+/*
+ * This function joins the given values into a single comma separated field.
+ * :arg: values, const vector of strings, none of which may contain a comma.
+ * :return: string holding the joined values.
+ */
+static std::string JoinList (const std::vector <std::string> &values) {
+
+    std::string result;
+    for (const auto &value : values) {
+        if (!result.empty ()) { result += ','; }
+        result += value;
+    }
+    return result;
+
+} /* End of JoinList () */
+
+
+/*
+ * This function reverses JoinList.
+ * :arg: field, const string holding the comma separated values.
+ * :return: vector of strings holding the values, empty if the field is empty.
+ */
+static std::vector <std::string> SplitList (const std::string &field) {
+
+    std::vector <std::string> values;
+    std::stringstream stream (field);
+    std::string value;
+    while (std::getline (stream, value, ',')) {
+        if (!value.empty ()) { values.push_back (value); }
+    }
+    return values;
+
+} /* End of SplitList () */
+
+
+/*
+ * This is a constructor function for Journal class. The journal file is not touched until Open () is called.
+ * :arg: nameFile, string holding the path of the journal file.
+ */
+Journal::Journal (const std::string &nameFile) : fd (-1), fileName (nameFile) {
+
+} /* End of Journal () */
+
+
+/*
+ * This is a destructor function for Journal class, closes the journal file if it is open.
+ */
+Journal::~Journal () {
+
+    if (fd >= 0) { close (fd); }
+
+} /* End of ~Journal () */
+
+
+/*
+ * This function applies a single verified journal record to the in-memory view of completed work.
+ * :arg: line, const string holding the record payload, sans checksum.
+ */
+void Journal::Replay (const std::string &line) {
+
+    std::vector <std::string> fields;
+    size_t start = 0;
+    size_t position;
+    while ((position = line.find ('\t', start)) != std::string::npos) {
+        fields.push_back (UnescapeField (line.substr (start, position - start)));
+        start = position + 1;
+    }
+    fields.push_back (UnescapeField (line.substr (start)));
+    if (fields.size () < 2 || fields [0].size () != 1) { return; }
+
+    JournalHost &host = hosts [fields [1]];
+    switch (fields [0][0]) {
+        case REC_DISC_START:
+            /* A restarted discovery supersedes any partial one before it */
+            host.discovered = false;
+            host.ports.clear ();
+            break;
+        case REC_DISC_PORT:
+            /* Journals written before UDP discovery hold TCP ports only */
+            if (fields.size () >= 5) {
+                const std::string &protocol = fields.size () >= 6 ? fields [5] : PROTO_TCP;
+                host.ports.emplace_back (fields [2], fields [3], fields [4], protocol);
+            }
+            break;
+        case REC_DISC_END:
+            host.discovered = true;
+            break;
+        case REC_FINDING:
+            /* Findings precede the port record which completes them */
+            if (fields.size () >= 10) {
+                Finding finding {};
+                finding.scope = (fields [3] == "host") ? SCOPE_HOST : SCOPE_PORT;
+                finding.script = InternString (fields [4]);
+                finding.state = ParseFindingState (fields [5]);
+                finding.score = static_cast <uint16_t> (atoi (fields [6].c_str ()));
+                finding.title = InternString (fields [7]);
+                for (const auto &cve : SplitList (fields [8])) {
+                    if (finding.cveCount < MAX_FINDING_CVES) { finding.cves [finding.cveCount++] = PackCVE (cve); }
+                }
+                std::stringstream refs (fields [9]);
+                std::string ref;
+                while (refs >> ref && finding.refCount < MAX_FINDING_REFS) {
+                    finding.refs [finding.refCount++] = InternString (ref);
+                }
+                host.findings [fields [2]].push_back (finding);
+            }
+            break;
+        case REC_PORT_DONE:
+            if (fields.size () >= 11) {
+                Port port (fields [2], fields [3], fields [4]);
+                port.product = fields [5];
+                port.version = fields [6];
+                port.osName = fields [7];
+                port.severity = ParseSeverity (fields [8]);
+                port.vulnerabilities = SplitList (fields [9]);
+                port.cves = SplitList (fields [10]);
+                if (fields.size () >= 14) {
+                    port.extraInfo = fields [11];
+                    port.osType = fields [12];
+                    for (const auto &name : SplitList (fields [13])) {
+                        CPE cpe;
+                        int depth = 0;
+                        if (ParseCPE (name, cpe, depth)) { port.cpes.push_back (cpe); }
+                    }
+                }
+                if (fields.size () >= 15) { port.protocol = fields [14]; }
+                port.scansCompleted.push_back (SCAN_NMAP_VULN);
+                for (const Finding &finding : host.findings [port.Key ()]) {
+                    (finding.scope == SCOPE_HOST ? port.hostFindings : port.findings).push_back (finding);
+                }
+                /* Findings of an earlier, interrupted attempt at the same port are folded in as duplicates */
+                RankFindings (port.findings);
+                RankFindings (port.hostFindings);
+                host.findings.erase (port.Key ());
+                host.completed.insert_or_assign (port.Key (), port);
+            }
+            break;
+    }
+
+} /* End of Replay () */
+
+
+/*
+ * This function appends a single record to the journal and syncs it to disk before returning, so a record that has
+ * been acknowledged survives a crash of the tool or the machine.
+ * :arg: type, char denoting the record type.
+ * :arg: fields, const vector of strings holding the record fields.
+ * :return: bool value indicating whether the record has been made durable.
+ */
+bool Journal::Append (char type, const std::vector <std::string> &fields) {
+
+    std::string payload (1, type);
+    for (const auto &field : fields) {
+        payload += '\t';
+        payload += EscapeField (field);
+    }
+    char prefix [10];
+    snprintf (prefix, sizeof (prefix), "%08x ", Checksum (payload));
+    std::string record = prefix + payload + "\n";
+
+    TraceScope syncScope ("journal.append", TRACE_JOURNAL, std::string (1, type));
+    std::lock_guard <std::mutex> lock (mtx);
+    if (fd < 0) { return false; }
+    /* A single write on an O_APPEND descriptor keeps concurrent records from interleaving */
+    if (write (fd, record.data (), record.size ()) != static_cast <ssize_t> (record.size ())) { return false; }
+    return fdatasync (fd) == 0;
+
+} /* End of Append () */
+
+
+/*
+ * This function opens the journal file. When resuming, the existing journal is replayed first, discarding any torn
+ * or corrupted records at its tail, otherwise the journal is truncated to start a new run.
+ * :arg: resume, bool value indicating whether the previous journal is to be reloaded.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success or failure of the operation.
+ */
+ReturnCodes Journal::Open (bool resume, Logger objLog) {
+
+    int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+    off_t validBytes = 0;
+    if (resume) {
+        std::ifstream input (fileName);
+        std::string line;
+        size_t replayed = 0;
+        if (!input) {
+            objLog.Log (FAIL, MOD_JOURNAL, JOURNAL_LOAD_FAIL, true);
+        } else {
+            while (std::getline (input, line)) {
+                char *end = nullptr;
+                /* A record without its terminating newline was torn mid-write */
+                if (input.eof () || line.size () < 10 || line [8] != ' ') { break; }
+                uint32_t expected = strtoul (line.substr (0, 8).c_str (), &end, 16);
+                std::string payload = line.substr (9);
+                if (expected != Checksum (payload)) { break; }
+                Replay (payload);
+                replayed++;
+                validBytes += line.size () + 1;
+            }
+            std::stringstream optional;
+            optional << "Replayed " << replayed << " record(s).";
+            objLog.Log (PASS, MOD_JOURNAL, JOURNAL_LOAD_PASS, true, optional);
+        }
+    } else {
+        flags |= O_TRUNC;
+    }
+
+    fd = open (fileName.c_str (), flags, 0644);
+    if (fd < 0) {
+        objLog.Log (FAIL, MOD_JOURNAL, JOURNAL_OPEN_FAIL, true);
+        return JOURNAL_OPEN_FAIL;
+    }
+    /* Drop a torn tail left by a crash, so new records are not appended onto a partial line */
+    if (resume && ftruncate (fd, validBytes) != 0) {
+        close (fd);
+        fd = -1;
+        objLog.Log (FAIL, MOD_JOURNAL, JOURNAL_OPEN_FAIL, true);
+        return JOURNAL_OPEN_FAIL;
+    }
+    objLog.Log (PASS, MOD_JOURNAL, JOURNAL_OPEN_PASS, false);
+    return JOURNAL_OPEN_PASS;
+
+} /* End of Open () */
+
+
+/*
+ * This function returns the work restored from the journal for the given host.
+ * :arg: address, const string holding the address of the host.
+ * :return: pointer to the restored JournalHost, nullptr if the journal holds nothing for the host.
+ */
+const JournalHost *Journal::Find (const std::string &address) const {
+
+    auto find = hosts.find (address);
+    return (find != hosts.end ()) ? &find->second : nullptr;
+
+} /* End of Find () */
+
+
+/*
+ * This function records that open ports discovery has started against the given host.
+ * :arg: address, const string holding the address of the host.
+ */
+void Journal::RecordDiscoveryStart (const std::string &address) {
+
+    Append (REC_DISC_START, {address});
+
+} /* End of RecordDiscoveryStart () */
+
+
+/*
+ * This function records a single port identified during open ports discovery.
+ * :arg: address, const string holding the address of the host.
+ * :arg: port, Port object holding the discovered port.
+ */
+void Journal::RecordDiscoveredPort (const std::string &address, const Port &port) {
+
+    Append (REC_DISC_PORT, {address, port.portid, port.state, port.service, port.protocol});
+
+} /* End of RecordDiscoveredPort () */
+
+
+/*
+ * This function records that open ports discovery against the given host has completed, after which the discovered
+ * ports are trusted on resume.
+ * :arg: address, const string holding the address of the host.
+ */
+void Journal::RecordDiscoveryEnd (const std::string &address) {
+
+    Append (REC_DISC_END, {address});
+
+} /* End of RecordDiscoveryEnd () */
+
+
+/*
+ * This function records the results of a completed deep scan of a single port, its findings first and then the port
+ * record which marks them complete.
+ * :arg: address, const string holding the address of the host.
+ * :arg: port, Port object holding the deep scan results.
+ */
+void Journal::RecordDeepScan (const std::string &address, const Port &port) {
+
+    std::vector <std::string> cpes;
+    for (const CPE &cpe : port.cpes) { cpes.push_back (cpe.ToString ()); }
+    for (const auto *list : {&port.findings, &port.hostFindings}) {
+        for (const Finding &finding : *list) {
+            std::vector <std::string> ids;
+            std::string refs;
+            for (int index = 0; index < finding.cveCount; index++) { ids.push_back (UnpackCVE (finding.cves [index])); }
+            for (int index = 0; index < finding.refCount; index++) {
+                refs += (index ? " " : "") + InternedString (finding.refs [index]);
+            }
+            Append (REC_FINDING, {address, port.Key (), finding.scope == SCOPE_HOST ? "host" : "port",
+                                  InternedString (finding.script), FindingStateName (finding.state),
+                                  std::to_string (finding.score), InternedString (finding.title), JoinList (ids), refs});
+        }
+    }
+    Append (REC_PORT_DONE, {address, port.portid, port.state, port.service, port.product, port.version, port.osName,
+                            SeverityName (port.severity), JoinList (port.vulnerabilities), JoinList (port.cves),
+                            port.extraInfo, port.osType, JoinList (cpes), port.protocol});
+
+} /* End of RecordDeepScan () */
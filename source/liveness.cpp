@@ -0,0 +1,366 @@
+/*
+ ***********************************************************************************************************************
+ * File: liveness.cpp
+ * Description: This file contains definitions of functions associated with the native host liveness sweep.
+ * Functions:
+ *           uint16_t Checksum ()
+ *           int OpenEchoSocket ()
+ *           void Decide ()
+ *           Task <> ConnectPing ()
+ *           void ReadARPCache ()
+ *           Task <ReturnCodes> LivenessSweep ()
+ *           bool AdmitHost ()
+ *           bool ParseUnknownPolicy ()
+ *           void PrintLivenessSummary ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "discovery.hpp"
+#include "liveness.hpp"
+#include "metrics.hpp"
+#include "utilities.hpp"
+
+/* Echo requests sent or replies read per tick */
+static const size_t LIVE_BATCH = 64;
+/* ARP cache flag of a resolved entry */
+static const unsigned LIVE_ARP_COMPLETE = 0x2;
+
+/* State shared by the dispatcher of a liveness sweep & its connect pings */
+struct LivenessState {
+    EventLoop &loop;
+    std::vector <HostLiveness> &hosts;
+    std::vector <struct sockaddr_in> targets;
+    std::chrono::steady_clock::time_point start;
+    size_t inFlight = 0;
+};
+
+
+/*
+ * This function computes the Internet checksum (RFC 1071) of an ICMP message.
+ * :arg: data, const pointer to the message, its checksum field zeroed.
+ * :arg: length, size_t holding the length of the message.
+ * :return: uint16_t holding the checksum, in network byte order.
+ */
+static uint16_t Checksum (const void *data, size_t length) {
+
+    const uint8_t *bytes = static_cast <const uint8_t *> (data);
+    uint32_t sum = 0;
+    for (size_t index = 0; index + 1 < length; index += 2) { sum += (bytes [index] << 8) | bytes [index + 1]; }
+    if (length % 2) { sum += bytes [length - 1] << 8; }
+    while (sum >> 16) { sum = (sum & 0xFFFF) + (sum >> 16); }
+    return htons (static_cast <uint16_t> (~sum));
+
+} /* End of Checksum () */
+
+
+/*
+ * This function opens the socket echo requests are sent over: an unprivileged ICMP datagram socket when the kernel
+ * allows it (net.ipv4.ping_group_range), else a raw ICMP socket, which needs CAP_NET_RAW.
+ * :arg: raw, bool set to whether the socket is a raw one, whose replies carry their IP header.
+ * :return: integer holding the descriptor of the socket, -1 if neither can be opened.
+ */
+static int OpenEchoSocket (bool &raw) {
+
+    raw = false;
+    int fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_ICMP);
+    if (fd >= 0) { return fd; }
+    raw = true;
+    return socket (AF_INET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_ICMP);
+
+} /* End of OpenEchoSocket () */
+
+
+/*
+ * This function records the liveness of a target. A host proven up stays up, a host is only marked down while
+ * nothing else is known of it.
+ * :arg: state, LivenessState object of the sweep.
+ * :arg: index, size_t holding the index of the target.
+ * :arg: liveness, Liveness of the target.
+ * :arg: reason, const string naming the probe which decided it.
+ */
+static void Decide (LivenessState &state, size_t index, Liveness liveness, const std::string &reason) {
+
+    HostLiveness &host = state.hosts [index];
+    if (host.state == LIVENESS_UP || (liveness == LIVENESS_DOWN && host.state != LIVENESS_UNKNOWN)) { return; }
+    host.state = liveness;
+    host.reason = reason;
+    auto elapsed = std::chrono::steady_clock::now () - state.start;
+    host.elapsedMicros = std::chrono::duration_cast <std::chrono::microseconds> (elapsed).count ();
+
+} /* End of Decide () */
+
+
+/*
+ * This function pings a port of a target with a non-blocking connect. An accept or a reset proves the target up, an
+ * unreachable host or network marks it down, while a timeout tells nothing. Targets already up are not pinged again.
+ * :arg: state, LivenessState object of the sweep.
+ * :arg: index, size_t holding the index of the target.
+ * :arg: port, uint16_t holding the port to be pinged.
+ */
+static Task <> ConnectPing (LivenessState &state, size_t index, uint16_t port) {
+
+    int error = ETIMEDOUT;
+    int fd = -1;
+    if (state.hosts [index].state != LIVENESS_UP) {
+        fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    if (fd >= 0) {
+        struct sockaddr_in target = state.targets [index];
+        target.sin_port = htons (port);
+        runMetrics.GetCounter (MET_LIVE_PINGS).Add ();
+        error = connect (fd, reinterpret_cast <struct sockaddr *> (&target), sizeof (target)) == 0 ? 0 : errno;
+        if (error == EINPROGRESS) {
+            error = ETIMEDOUT;
+            if (co_await state.loop.Writable (fd, LIVE_TIMEOUT_MS)) {
+                socklen_t length = sizeof (error);
+                getsockopt (fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            }
+        }
+        /* Reset rather than close accepted connections, so the pings do not leave TIME_WAIT sockets behind */
+        struct linger reset {1, 0};
+        setsockopt (fd, SOL_SOCKET, SO_LINGER, &reset, sizeof (reset));
+        close (fd);
+        std::string name = "tcp/" + std::to_string (port);
+        switch (error) {
+            case 0: Decide (state, index, LIVENESS_UP, name + " syn-ack"); break;
+            case ECONNREFUSED: Decide (state, index, LIVENESS_UP, name + " reset"); break;
+            case EHOSTUNREACH: case ENETUNREACH: case EHOSTDOWN:
+                Decide (state, index, LIVENESS_DOWN, name + " unreachable");
+                break;
+            default: break;
+        }
+    }
+    state.inFlight--;
+
+} /* End of ConnectPing () */
+
+
+/*
+ * This function judges the targets on a local segment by the kernel's ARP cache, which the probes sent to them have
+ * filled in: a resolved entry proves a target up even if it dropped every probe, an unresolved one marks it down.
+ * Targets off the local segments have no entry and are left as they are.
+ * :arg: state, LivenessState object of the sweep.
+ * :arg: indices, const map of the targets' addresses to their indices.
+ */
+static void ReadARPCache (LivenessState &state, const std::map <std::string, size_t> &indices) {
+
+    std::ifstream cache (LIVE_ARP_CACHE);
+    std::string line;
+    std::getline (cache, line);
+    while (std::getline (cache, line)) {
+        std::istringstream fields (line);
+        std::string address, type, flags;
+        if (!(fields >> address >> type >> flags) || !indices.count (address)) { continue; }
+        bool complete = std::strtoul (flags.c_str (), nullptr, 16) & LIVE_ARP_COMPLETE;
+        Decide (state, indices.at (address), complete ? LIVENESS_UP : LIVENESS_DOWN,
+                complete ? "arp reply" : "arp unresolved");
+    }
+
+} /* End of ReadARPCache () */
+
+
+/*
+ * This function sweeps the targets for liveness, as a task of the given loop. Echo requests leave at LIVE_RATE_PPS,
+ * LIVE_BATCH per tick, and are sent LIVE_RETRIES more times when unanswered, while connect pings to LIVE_TCP_PORTS
+ * leave at the same rate with up to LIVE_CONCURRENCY in flight, the first port of every target before the second one
+ * of any. The ARP cache is read once every probe has been answered or has timed out. Without an ICMP socket, the
+ * connect pings & the ARP cache decide.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: hosts, vector of HostLiveness objects holding the IPv4 addresses of the targets, to which verdicts are set.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: ReturnCodes object denoting the success, failure or cancellation of the sweep.
+ */
+Task <ReturnCodes> LivenessSweep (EventLoop &loop, std::vector <HostLiveness> &hosts, const CancelToken &token) {
+
+    LivenessState state {loop, hosts, {}, std::chrono::steady_clock::now (), 0};
+    std::map <std::string, size_t> indices;
+    std::map <uint32_t, size_t> byAddress;
+    for (size_t index = 0; index < hosts.size (); index++) {
+        struct sockaddr_in target {};
+        target.sin_family = AF_INET;
+        if (inet_pton (AF_INET, hosts [index].address.c_str (), &target.sin_addr) != 1) {
+            co_return LIVENESS_SWEEP_FAIL;
+        }
+        state.targets.push_back (target);
+        indices [hosts [index].address] = index;
+        byAddress [target.sin_addr.s_addr] = index;
+    }
+    size_t concurrency = LIVE_CONCURRENCY;
+    struct rlimit files {};
+    if (getrlimit (RLIMIT_NOFILE, &files) == 0 && files.rlim_cur > DISC_FD_RESERVE) {
+        concurrency = std::min (concurrency, static_cast <size_t> (files.rlim_cur - DISC_FD_RESERVE));
+    }
+    bool raw = false;
+    int echo = OpenEchoSocket (raw);
+    uint16_t identifier = static_cast <uint16_t> (getpid ());
+    std::deque <std::pair <size_t, int>> echoQueue;
+    for (size_t index = 0; echo >= 0 && index < hosts.size (); index++) { echoQueue.emplace_back (index, 0); }
+    /* Targets awaiting an echo reply, with their attempt & deadline */
+    std::map <size_t, std::pair <int, std::chrono::steady_clock::time_point>> outstanding;
+    std::deque <std::pair <size_t, uint16_t>> pingQueue;
+    for (uint16_t port : LIVE_TCP_PORTS) {
+        for (size_t index = 0; index < hosts.size (); index++) { pingQueue.emplace_back (index, port); }
+    }
+
+    double credit = LIVE_BATCH;
+    double pingCredit = LIVE_BATCH;
+    auto last = std::chrono::steady_clock::now ();
+    while (!token.IsCancelled () && (!echoQueue.empty () || !outstanding.empty () || !pingQueue.empty () ||
+                                     state.inFlight > 0)) {
+        auto now = std::chrono::steady_clock::now ();
+        double earned = std::chrono::duration <double> (now - last).count () * LIVE_RATE_PPS;
+        credit = std::min (credit + earned, static_cast <double> (LIVE_BATCH));
+        pingCredit = std::min (pingCredit + earned, static_cast <double> (LIVE_BATCH));
+        last = now;
+        /* Echo requests, targets proven up while waiting to be retransmitted are dropped */
+        while (!echoQueue.empty () && credit >= 1) {
+            auto [index, attempt] = echoQueue.front ();
+            echoQueue.pop_front ();
+            if (hosts [index].state == LIVENESS_UP) { continue; }
+            struct icmphdr request {};
+            request.type = ICMP_ECHO;
+            request.un.echo.id = htons (identifier);
+            request.un.echo.sequence = htons (static_cast <uint16_t> (index));
+            request.checksum = Checksum (&request, sizeof (request));
+            const struct sockaddr_in &target = state.targets [index];
+            if (sendto (echo, &request, sizeof (request), 0, reinterpret_cast <const struct sockaddr *> (&target),
+                        sizeof (target)) < 0) {
+                /* A full socket buffer leaves the request to the next tick, any other error gives up on the echo */
+                if (errno != EAGAIN && errno != ENOBUFS) { continue; }
+                echoQueue.emplace_front (index, attempt);
+                break;
+            }
+            outstanding [index] = {attempt, now + std::chrono::milliseconds (LIVE_TIMEOUT_MS)};
+            credit -= 1;
+            runMetrics.GetCounter (MET_LIVE_ECHOES).Add ();
+        }
+        /* Echo replies, named by their source. A raw socket sees every ICMP message, its own requests included. */
+        for (size_t round = 0; echo >= 0 && round < LIVE_BATCH; round++) {
+            char buffer [512];
+            struct sockaddr_in source {};
+            socklen_t length = sizeof (source);
+            ssize_t received = recvfrom (echo, buffer, sizeof (buffer), 0,
+                                         reinterpret_cast <struct sockaddr *> (&source), &length);
+            if (received <= 0) { break; }
+            size_t offset = raw ? (reinterpret_cast <const struct iphdr *> (buffer)->ihl * 4u) : 0;
+            if (static_cast <size_t> (received) < offset + sizeof (struct icmphdr)) { continue; }
+            const struct icmphdr *reply = reinterpret_cast <const struct icmphdr *> (buffer + offset);
+            if (reply->type != ICMP_ECHOREPLY || (raw && ntohs (reply->un.echo.id) != identifier)) { continue; }
+            auto found = byAddress.find (source.sin_addr.s_addr);
+            if (found == byAddress.end ()) { continue; }
+            Decide (state, found->second, LIVENESS_UP, "icmp echo-reply");
+            outstanding.erase (found->second);
+        }
+        /* Unanswered echo requests are retransmitted, then given up on */
+        for (auto entry = outstanding.begin (); entry != outstanding.end ();) {
+            auto [index, pending] = *entry;
+            if (pending.second > now && hosts [index].state != LIVENESS_UP) {
+                ++entry;
+                continue;
+            }
+            entry = outstanding.erase (entry);
+            if (hosts [index].state != LIVENESS_UP && pending.first < LIVE_RETRIES) {
+                echoQueue.emplace_back (index, pending.first + 1);
+            }
+        }
+        /* Connect pings, up to the concurrency in flight */
+        while (!pingQueue.empty () && state.inFlight < concurrency && pingCredit >= 1) {
+            auto [index, port] = pingQueue.front ();
+            pingQueue.pop_front ();
+            if (hosts [index].state == LIVENESS_UP) { continue; }
+            state.inFlight++;
+            pingCredit -= 1;
+            loop.Spawn (ConnectPing (state, index, port));
+        }
+        co_await loop.Sleep (1);
+    }
+    while (state.inFlight > 0) { co_await loop.Sleep (1); }
+    if (echo >= 0) { close (echo); }
+    ReadARPCache (state, indices);
+    co_return token.IsCancelled () ? CMD_EXEC_CANCEL : LIVENESS_SWEEP_PASS;
+
+} /* End of LivenessSweep () */
+
+
+/*
+ * This function decides whether a target is admitted into port discovery: hosts up are, hosts down are not and hosts
+ * of unknown liveness are as the policy says.
+ * :arg: host, const HostLiveness object of the target.
+ * :arg: policy, UnknownPolicy applied to a target of unknown liveness.
+ * :return: bool value indicating whether the target is to be scanned.
+ */
+bool AdmitHost (const HostLiveness &host, UnknownPolicy policy) {
+
+    if (host.state == LIVENESS_UNKNOWN) { return policy == UNKNOWN_SCAN; }
+    return host.state == LIVENESS_UP;
+
+} /* End of AdmitHost () */
+
+
+/*
+ * This function parses the name of an unknown liveness policy, as given on the command line.
+ * :arg: name, const string holding the name, "scan" or "skip".
+ * :arg: policy, UnknownPolicy set to the policy named.
+ * :return: bool value indicating whether the name is a valid one.
+ */
+bool ParseUnknownPolicy (const std::string &name, UnknownPolicy &policy) {
+
+    if (name == "scan") { policy = UNKNOWN_SCAN; }
+    else if (name == "skip") { policy = UNKNOWN_SKIP; }
+    else { return false; }
+    return true;
+
+} /* End of ParseUnknownPolicy () */
+
+
+/*
+ * This function prints a summary of the liveness sweep: how many targets are up, down or unknown, along with every
+ * target admitted into port discovery and the probe which proved it up.
+ * :arg: hosts, const vector of HostLiveness objects of the targets.
+ * :arg: policy, UnknownPolicy applied to the targets of unknown liveness.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: out, ostream to which the summary is printed, default value is STDOUT.
+ */
+void PrintLivenessSummary (const std::vector <HostLiveness> &hosts, UnknownPolicy policy, Logger objLog,
+                           std::ostream &out) {
+
+    /* module = MOD_LIVENESS */
+    auto count = [&](Liveness state) {
+        return std::count_if (hosts.begin (), hosts.end (), [&](const HostLiveness &host) {
+            return host.state == state;
+        });
+    };
+    std::stringstream optional;
+    optional << "Up: " << count (LIVENESS_UP) << ", down: " << count (LIVENESS_DOWN) << ", unknown: "
+             << count (LIVENESS_UNKNOWN) << (policy == UNKNOWN_SCAN ? " (scanned)" : " (skipped)");
+    objLog.Log (PASS, MOD_LIVENESS, LIVENESS_SWEEP_PASS, true, optional);
+    out << "\t" << optional.str () << std::endl;
+    for (const HostLiveness &host : hosts) {
+        if (!AdmitHost (host, policy)) { continue; }
+        out << "\t" << BLU << "[+] " << RST << std::setw (15) << std::left << host.address << " : ";
+        if (host.state == LIVENESS_UP) {
+            out << host.reason << " after " << std::fixed << std::setprecision (1) << host.elapsedMicros / 1000.0
+                << " ms";
+        }
+        else { out << "unknown"; }
+        out << std::right << std::endl;
+    }
+
+} /* End of PrintLivenessSummary () */
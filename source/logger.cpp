@@ -6,9 +6,10 @@
  * Functions:
  *           string GetReturnMessage ()
  *           string GetCurrentTime ()
- *           void InitializeDirectories ()
+ *           ReturnCodes InitializeDirectories ()
  *           class Logger
  *              Logger ()
+ *              void AttachSink ()
  *              void Header ()
  *              void Footer ()
  *              void Log ()
@@ -18,7 +19,9 @@
  ***********************************************************************************************************************
  */
 #include "logger.hpp"
+#include "probes.hpp"
 #include "tool.hpp"
+#include "trace.hpp"
 
 
 /*
@@ -52,8 +55,10 @@ const std::string GetCurrentTime () {
  * This function takes a vector of strings as its parameter, uses them as directory names and creates directories.
  * This function also checks whether the directory already exists and also handles error conditions.
  * :arg: dirs, constant vector of strings holding the name(s) of directories to be created.
+ * :arg: error, string to which the directory & the reason it could not be created are copied to, on failure.
+ * :return: ReturnCodes denoting whether every directory exists.
  */
-void InitializeDirectories (const std::vector <std::string>& dirs) {
+ReturnCodes InitializeDirectories (const std::vector <std::string>& dirs, std::string &error) {
 
     for (const auto &dir : dirs) {
         try {
@@ -62,12 +67,12 @@ void InitializeDirectories (const std::vector <std::string>& dirs) {
             } else if (std::filesystem::create_directory (dir)) {
                 // std::cout << "Dir " << dir << " created.\n";
             }
-        } catch (const std::filesystem::filesystem_error &error) {
-            std::cout << "Dir " << dir << " creation failed. Error: " << error.what () 
-                      << "\nEnsure you have permission to create new directories the current path. " << std::endl;
-            exit (-1);
+        } catch (const std::filesystem::filesystem_error &exception) {
+            error = "Dir " + dir + " creation failed. Error: " + exception.what ();
+            return WORK_DIRS_FAIL;
         }
     }
+    return WORK_DIRS_PASS;
 
 } /* End of InitializeDirectories */
 
@@ -77,11 +82,23 @@ void InitializeDirectories (const std::vector <std::string>& dirs) {
  * :arg: nameFile, string holding the name of the log file.
  * :arg: flag, bool value indicating whether to set the verbose flag.
  */
-Logger::Logger (std::string nameFile, bool flag) : fileName (nameFile), verbose (flag) {
+Logger::Logger (std::string nameFile, bool flag) : fileName (nameFile), verbose (flag), sink (nullptr) {
     
 } /* End of Logger () */
 
 
+/*
+ * This function attaches a sink which receives every log message in place of STDOUT. Copies of the Logger made after
+ * this call share the sink.
+ * :arg: logSink, pointer to the LogSink object, nullptr restores printing to STDOUT.
+ */
+void Logger::AttachSink (LogSink *logSink) {
+
+    sink = logSink;
+
+} /* End of AttachSink () */
+
+
 /*
  * This function formats and prints header to both STDOUT and log file, based on user inputs on tool.hpp.
  * :arg: identifier, string holding the user-supplied identifier, to be printed onto log file. If identifier is
@@ -164,7 +181,10 @@ void Logger::Log (const int severity, const std::string module, const ReturnCode
             break;
     }
 
-    if (verbose || uFlag) {
+    if (sink) {
+        sink->Write (severity, module, code, optional ? message + optional.str () : message, verbose || uFlag);
+    }
+    else if (verbose || uFlag) {
         strUser << color << strType << RST << GetCurrentTime () << "[" << module << "] " << message;
         if (optional) { strUser << optional.str (); }
         std::cout << strUser.str () << std::endl;
@@ -173,8 +193,10 @@ void Logger::Log (const int severity, const std::string module, const ReturnCode
     strFile << strType << GetCurrentTime () << "[" << module << "] " << message;
     if (optional) { strFile << optional.str (); }
     strFile << "\n";
+    TraceScope flushScope ("log.flush", TRACE_LOG, module);
     logFile.open (fileName, std::ios::app);
     logFile << strFile.str ();
     logFile.close ();
+    PH_PROBE4 (log__write, severity, module.c_str (), static_cast <int> (code), static_cast <size_t> (strFile.tellp ()));
 
 } /* End of Log () */
\ No newline at end of file
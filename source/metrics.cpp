@@ -0,0 +1,397 @@
+/*
+ ***********************************************************************************************************************
+ * File: metrics.cpp
+ * Description: This file contains definitions of member functions associated with the run metrics registry of
+ *              counters, gauges & latency histograms, the end-of-run timing report and the machine readable dump.
+ * Functions:
+ *           string FormatMillis ()
+ *           class Gauge
+ *              void Set ()
+ *              void Add ()
+ *           class Histogram
+ *              int BucketIndex ()
+ *              uint64_t BucketValue ()
+ *              void Record ()
+ *              uint64_t Min ()
+ *              uint64_t Percentile ()
+ *              vector Buckets ()
+ *           class MetricsRegistry
+ *              Counter &GetCounter ()
+ *              Gauge &GetGauge ()
+ *              Histogram &GetHistogram ()
+ *              void RecordSpan ()
+ *              void RecordChild ()
+ *              void PrintReport ()
+ *              ReturnCodes Dump ()
+ *           class ScopedTimer
+ *              ScopedTimer ()
+ *              ~ScopedTimer ()
+ *              void Stop ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "utilities.hpp"
+
+MetricsRegistry runMetrics;
+
+
+/*
+ * This function formats a duration in microseconds as milliseconds.
+ * :arg: micros, uint64_t holding the duration in microseconds.
+ * :return: string holding the duration in milliseconds, with three decimals.
+ */
+static std::string FormatMillis (uint64_t micros) {
+
+    std::stringstream millis;
+    millis << std::fixed << std::setprecision (3) << micros / 1000.0;
+    return millis.str ();
+
+} /* End of FormatMillis () */
+
+
+/*
+ * This function sets the level of the gauge.
+ * :arg: level, int64_t holding the new level.
+ */
+void Gauge::Set (int64_t level) {
+
+    value.store (level, std::memory_order_relaxed);
+    int64_t highest = peak.load (std::memory_order_relaxed);
+    while (level > highest && !peak.compare_exchange_weak (highest, level, std::memory_order_relaxed)) {}
+
+} /* End of Set () */
+
+
+/*
+ * This function moves the level of the gauge by the given amount.
+ * :arg: amount, int64_t holding the change of level, negative to lower it.
+ */
+void Gauge::Add (int64_t amount) {
+
+    int64_t level = value.fetch_add (amount, std::memory_order_relaxed) + amount;
+    int64_t highest = peak.load (std::memory_order_relaxed);
+    while (level > highest && !peak.compare_exchange_weak (highest, level, std::memory_order_relaxed)) {}
+
+} /* End of Add () */
+
+
+/*
+ * This function maps a value to its bucket. Values below 2 * HIST_SUB_COUNT get a bucket each, larger values share a
+ * bucket with the values agreeing on their HIST_SUB_BITS + 1 leading bits.
+ * :arg: value, uint64_t to be mapped.
+ * :return: integer holding the index of the bucket.
+ */
+int Histogram::BucketIndex (uint64_t value) {
+
+    if (value < static_cast <uint64_t> (HIST_SUB_COUNT)) { return static_cast <int> (value); }
+    int magnitude = 63 - __builtin_clzll (value);
+    uint64_t top = value >> (magnitude - HIST_SUB_BITS);
+    return ((magnitude - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + static_cast <int> (top - HIST_SUB_COUNT);
+
+} /* End of BucketIndex () */
+
+
+/*
+ * This function returns the highest value mapped to a bucket.
+ * :arg: index, integer holding the index of the bucket.
+ * :return: uint64_t holding the highest value of the bucket.
+ */
+uint64_t Histogram::BucketValue (int index) {
+
+    if (index < 2 * HIST_SUB_COUNT) { return static_cast <uint64_t> (index); }
+    int shift = (index >> HIST_SUB_BITS) - 1;
+    uint64_t top = static_cast <uint64_t> ((index & (HIST_SUB_COUNT - 1)) + HIST_SUB_COUNT);
+    return (top << shift) + ((1ULL << shift) - 1);
+
+} /* End of BucketValue () */
+
+
+/*
+ * This function records a value in the histogram.
+ * :arg: value, uint64_t to be recorded.
+ */
+void Histogram::Record (uint64_t value) {
+
+    buckets [BucketIndex (value)].fetch_add (1, std::memory_order_relaxed);
+    count.fetch_add (1, std::memory_order_relaxed);
+    sum.fetch_add (value, std::memory_order_relaxed);
+    uint64_t lowest = min.load (std::memory_order_relaxed);
+    while (value < lowest && !min.compare_exchange_weak (lowest, value, std::memory_order_relaxed)) {}
+    uint64_t highest = max.load (std::memory_order_relaxed);
+    while (value > highest && !max.compare_exchange_weak (highest, value, std::memory_order_relaxed)) {}
+
+} /* End of Record () */
+
+
+/*
+ * This function returns the lowest value recorded.
+ * :return: uint64_t holding the lowest value, 0 if nothing has been recorded.
+ */
+uint64_t Histogram::Min () const {
+
+    return Count () ? min.load (std::memory_order_relaxed) : 0;
+
+} /* End of Min () */
+
+
+/*
+ * This function returns the value below which the given fraction of the recorded values fall.
+ * :arg: percentile, double between 0 and 1.
+ * :return: uint64_t holding the value at the percentile, within the precision of its bucket.
+ */
+uint64_t Histogram::Percentile (double percentile) const {
+
+    uint64_t total = Count ();
+    if (total == 0) { return 0; }
+    uint64_t rank = std::max <uint64_t> (1, static_cast <uint64_t> (std::ceil (percentile * total)));
+    uint64_t seen = 0;
+    for (int index = 0; index < HIST_BUCKETS; index++) {
+        seen += buckets [index].load (std::memory_order_relaxed);
+        if (seen >= rank) { return std::clamp (BucketValue (index), Min (), Max ()); }
+    }
+    return Max ();
+
+} /* End of Percentile () */
+
+
+/*
+ * This function returns the non-empty buckets of the histogram.
+ * :return: vector of pairs holding the highest value and the count of each non-empty bucket.
+ */
+std::vector <std::pair <uint64_t, uint64_t>> Histogram::Buckets () const {
+
+    std::vector <std::pair <uint64_t, uint64_t>> filled;
+    for (int index = 0; index < HIST_BUCKETS; index++) {
+        uint64_t hits = buckets [index].load (std::memory_order_relaxed);
+        if (hits) { filled.emplace_back (BucketValue (index), hits); }
+    }
+    return filled;
+
+} /* End of Buckets () */
+
+
+/*
+ * These functions return the metric registered under the given name, registering it on first use. Metrics are never
+ * removed, so call sites may keep the reference.
+ * :arg: name, const string holding the name of the metric.
+ * :return: reference to the metric.
+ */
+Counter &MetricsRegistry::GetCounter (const std::string &name) {
+
+    std::lock_guard <std::mutex> lock (mtx);
+    std::unique_ptr <Counter> &counter = counters [name];
+    if (!counter) { counter = std::make_unique <Counter> (); }
+    return *counter;
+
+} /* End of GetCounter () */
+
+Gauge &MetricsRegistry::GetGauge (const std::string &name) {
+
+    std::lock_guard <std::mutex> lock (mtx);
+    std::unique_ptr <Gauge> &gauge = gauges [name];
+    if (!gauge) { gauge = std::make_unique <Gauge> (); }
+    return *gauge;
+
+} /* End of GetGauge () */
+
+Histogram &MetricsRegistry::GetHistogram (const std::string &name) {
+
+    std::lock_guard <std::mutex> lock (mtx);
+    std::unique_ptr <Histogram> &histogram = histograms [name];
+    if (!histogram) { histogram = std::make_unique <Histogram> (); }
+    return *histogram;
+
+} /* End of GetHistogram () */
+
+
+/*
+ * This function records the wall time a phase has spent on a single item, both in the histogram of the phase and as a
+ * span, so the report can name the items dominating the run.
+ * :arg: metric, const string holding the name of the phase.
+ * :arg: key, const string identifying the item, e.g. "<address>:<port>".
+ * :arg: micros, uint64_t holding the wall time in microseconds.
+ */
+void MetricsRegistry::RecordSpan (const std::string &metric, const std::string &key, uint64_t micros) {
+
+    GetHistogram (metric).Record (micros);
+    std::lock_guard <std::mutex> lock (mtx);
+    spans.push_back ({metric, key, micros});
+
+} /* End of RecordSpan () */
+
+
+/*
+ * This function records the resources used by a spawned child, CPU times as "<metric>.cpu_user" & "<metric>.cpu_sys"
+ * histograms, its peak memory in the "<metric>.max_rss_kib" gauge and unsuccessful exits in "<metric>.failed_exit".
+ * :arg: metric, const string holding the name of the stage which spawned the child, e.g. MET_DEEP_NMAP.
+ * :arg: usage, const ChildUsage object holding the resources used.
+ */
+void MetricsRegistry::RecordChild (const std::string &metric, const ChildUsage &usage) {
+
+    if (!usage.valid) { return; }
+    GetHistogram (metric + ".cpu_user").Record (usage.userMicros);
+    GetHistogram (metric + ".cpu_sys").Record (usage.sysMicros);
+    GetGauge (metric + ".max_rss_kib").Set (usage.maxRSSKiB);
+    if (usage.exitStatus != 0) { GetCounter (metric + ".failed_exit").Add (); }
+
+} /* End of RecordChild () */
+
+
+/*
+ * This function prints the end-of-run timing report, a row of latency statistics per histogram, the counters and
+ * gauges, and the slowest items.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ */
+void MetricsRegistry::PrintReport (Logger objLog) {
+
+    /* module = MOD_METRICS */
+    std::lock_guard <std::mutex> lock (mtx);
+    objLog.Log (INFO, MOD_METRICS, METRICS_REPORT_INFO, true);
+    std::cout << "\t" << std::left << std::setw (26) << "Timing (ms)" << std::right << std::setw (8) << "count"
+              << std::setw (12) << "total" << std::setw (11) << "mean" << std::setw (11) << "p50" << std::setw (11)
+              << "p90" << std::setw (11) << "p99" << std::setw (11) << "max" << std::endl;
+    for (const auto &[name, histogram] : histograms) {
+        uint64_t count = histogram->Count ();
+        if (count == 0) { continue; }
+        std::cout << "\t" << std::left << std::setw (26) << name << std::right << std::setw (8) << count
+                  << std::setw (12) << FormatMillis (histogram->Sum ()) << std::setw (11)
+                  << FormatMillis (histogram->Sum () / count) << std::setw (11)
+                  << FormatMillis (histogram->Percentile (0.5)) << std::setw (11)
+                  << FormatMillis (histogram->Percentile (0.9)) << std::setw (11)
+                  << FormatMillis (histogram->Percentile (0.99)) << std::setw (11) << FormatMillis (histogram->Max ())
+                  << std::endl;
+    }
+    for (const auto &[name, counter] : counters) {
+        std::cout << "\t" << std::left << std::setw (26) << name << std::right << std::setw (8) << counter->Value ()
+                  << std::endl;
+    }
+    for (const auto &[name, gauge] : gauges) {
+        std::cout << "\t" << std::left << std::setw (26) << name << std::right << std::setw (8) << gauge->Value ()
+                  << "  (peak " << gauge->Peak () << ")" << std::endl;
+    }
+    if (!spans.empty ()) {
+        std::vector <Span> slowest = spans;
+        size_t shown = std::min (METRICS_SLOWEST, slowest.size ());
+        std::partial_sort (slowest.begin (), slowest.begin () + shown, slowest.end (),
+                           [](const Span &left, const Span &right) { return left.micros > right.micros; });
+        std::cout << "\tSlowest\n";
+        for (size_t index = 0; index < shown; index++) {
+            std::cout << "\t   " << std::left << std::setw (23) << slowest [index].metric << std::setw (24)
+                      << slowest [index].key << std::right << std::setw (12) << FormatMillis (slowest [index].micros)
+                      << std::endl;
+        }
+    }
+
+} /* End of PrintReport () */
+
+
+/*
+ * This function dumps every metric, the buckets of every histogram and every span as JSON.
+ * :arg: fileName, const string holding the name of the file to be written.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes MetricsRegistry::Dump (const std::string &fileName, Logger objLog) {
+
+    /* module = MOD_METRICS */
+    std::lock_guard <std::mutex> lock (mtx);
+    std::stringstream optional;
+    std::ofstream output (fileName, std::ios::trunc);
+    optional << "File: " << fileName;
+    output << "{\n  \"counters\": {";
+    const char *separator = "\n";
+    for (const auto &[name, counter] : counters) {
+        output << separator << "    \"" << EscapeJSON (name) << "\": " << counter->Value ();
+        separator = ",\n";
+    }
+    output << "\n  },\n  \"gauges\": {";
+    separator = "\n";
+    for (const auto &[name, gauge] : gauges) {
+        output << separator << "    \"" << EscapeJSON (name) << "\": {\"value\": " << gauge->Value ()
+               << ", \"peak\": " << gauge->Peak () << "}";
+        separator = ",\n";
+    }
+    output << "\n  },\n  \"histograms\": {";
+    separator = "\n";
+    for (const auto &[name, histogram] : histograms) {
+        output << separator << "    \"" << EscapeJSON (name) << "\": {\"unit\": \"us\", \"count\": "
+               << histogram->Count () << ", \"sum\": " << histogram->Sum () << ", \"min\": " << histogram->Min ()
+               << ", \"max\": " << histogram->Max () << ", \"p50\": " << histogram->Percentile (0.5)
+               << ", \"p90\": " << histogram->Percentile (0.9) << ", \"p99\": " << histogram->Percentile (0.99)
+               << ", \"p999\": " << histogram->Percentile (0.999) << ", \"buckets\": [";
+        const char *comma = "";
+        for (const auto &[upper, hits] : histogram->Buckets ()) {
+            output << comma << "[" << upper << ", " << hits << "]";
+            comma = ", ";
+        }
+        output << "]}";
+        separator = ",\n";
+    }
+    output << "\n  },\n  \"spans\": [";
+    separator = "\n";
+    for (const Span &span : spans) {
+        output << separator << "    {\"metric\": \"" << EscapeJSON (span.metric) << "\", \"key\": \""
+               << EscapeJSON (span.key) << "\", \"us\": " << span.micros << "}";
+        separator = ",\n";
+    }
+    output << "\n  ]\n}\n";
+    output.close ();
+    if (!output) {
+        objLog.Log (FAIL, MOD_METRICS, METRICS_DUMP_FAIL, true, optional);
+        return METRICS_DUMP_FAIL;
+    }
+    objLog.Log (PASS, MOD_METRICS, METRICS_DUMP_PASS, false, optional);
+    return METRICS_DUMP_PASS;
+
+} /* End of Dump () */
+
+
+/*
+ * Instantiates a new object of ScopedTimer class, starting the clock.
+ * :arg: name, const string holding the name of the histogram to be fed.
+ * :arg: item, const string identifying the item timed, when it is to be recorded as a span.
+ * :arg: acrossAwait, bool value indicating whether the timer runs across a co_await of a coroutine.
+ */
+ScopedTimer::ScopedTimer (const std::string &name, const std::string &item, bool acrossAwait)
+                         : metric (name), key (item), start (std::chrono::steady_clock::now ()), stopped (false),
+                           suspends (acrossAwait && !item.empty ()) {
+
+} /* End of ScopedTimer () */
+
+
+/*
+ * Records the time elapsed since the construction of the timer, unless it has been stopped already.
+ */
+ScopedTimer::~ScopedTimer () {
+
+    Stop ();
+
+} /* End of ~ScopedTimer () */
+
+
+/*
+ * This function stops the timer and records the time elapsed since its construction, also as a trace span when
+ * tracing is enabled. Later calls do nothing.
+ */
+void ScopedTimer::Stop () {
+
+    if (stopped) { return; }
+    stopped = true;
+    auto elapsed = std::chrono::steady_clock::now () - start;
+    uint64_t micros = std::chrono::duration_cast <std::chrono::microseconds> (elapsed).count ();
+    if (key.empty ()) { runMetrics.GetHistogram (metric).Record (micros); }
+    else { runMetrics.RecordSpan (metric, key, micros); }
+    /* Timed phases double as trace spans, categorised by the prefix of their metric name */
+    if (traceRecorder.IsEnabled ()) {
+        traceRecorder.Record (metric, metric.substr (0, metric.find ('.')), key, traceRecorder.Offset (start), micros,
+                              suspends);
+    }
+
+} /* End of Stop () */
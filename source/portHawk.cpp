@@ -8,8 +8,11 @@
  ***********************************************************************************************************************
  */
 
+#include "daemon.hpp"
+#include "engine.hpp"
 #include "logger.hpp"
-#include "scanner.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 #include "utilities.hpp"
 
 std::string LOG_DIR;
@@ -18,17 +21,51 @@ std::string MASTER_LOG;
 int main (int argCount, char **values) {
     
     std::signal (SIGINT, KeyboardInterrupt);
-    std::string target;
+    std::signal (SIGTERM, KeyboardInterrupt);
+    Options options;
     std::string rawFile = LOG_RAW;
     Logger rawLog (rawFile);
-    if (ValidateArguments (argCount, values, target) == TARGET_ADDR_PASS) {
-        rawLog.Header (target, false);
-        class Host host (target);
-        host.GetOpenPorts (rawLog);
-        host.PrintOpenScanSummary (rawLog);
-        host.MultitreadedNMAPScript (rawLog);
-        host.PrintDeepScanSummary (rawLog);
+    ReturnCodes validation = ValidateArguments (argCount, values, options);
+    if (!options.cveFeed.empty ()) { BuildCVEIndex (options.cveFeed, CVE_INDEX_FILE, rawLog); }
+    if (options.daemon) {
+        ScanDaemon daemon (options.socketPath.empty () ? DAEMON_SOCKET : options.socketPath);
+        return daemon.Run (interruptToken) == DAEMON_START_PASS ? 0 : -1;
     }
+    if (validation == TARGET_ADDR_PASS) {
+        rawLog.Header (options.address, false);
+        if (!options.cgroupRoot.empty ()) { scanCgroups.Setup (options.cgroupRoot, rawLog); }
+        if (!options.traceFile.empty ()) {
+            traceRecorder.Enable ();
+            traceRecorder.NameThread ("main");
+        }
+        ScopedTimer runTimer (MET_RUN, options.address);
+        ScanEngine engine (rawLog);
+        ConsoleSink console (rawLog, options.cpeQueries);
+        ScanRequest request;
+        request.target = options.address;
+        request.resume = options.resume;
+        request.discovery = options.native ? DISCOVERY_NATIVE : DISCOVERY_NMAP;
+        request.udp = options.udp;
+        request.frequentFirst = options.frequentFirst;
+        ParseShardCount (options.shards, request.shards);
+        request.ping = options.ping;
+        ParseUnknownPolicy (options.unknownHosts, request.unknownHosts);
+        request.banners = options.banners;
+        request.versionProbes = options.versionProbes;
+        request.tls = options.tls;
+        request.http = options.http;
+        if (!options.httpPaths.empty ()) { request.httpPaths = options.httpPaths; }
+        engine.AddResultSink (&console);
+        engine.ScanTargets (request, options.addresses, interruptToken);
+        runTimer.Stop ();
+        scanCgroups.Report (rawLog);
+        runMetrics.PrintReport (rawLog);
+        runMetrics.Dump (METRICS_FILE, rawLog);
+        if (traceRecorder.IsEnabled ()) { traceRecorder.Write (options.traceFile, rawLog); }
+    }
+    /* Partial results have been summarised above, so an interrupted run still leaves something useful behind */
+    if (interruptToken.IsCancelled ()) { rawLog.Log (FAIL, MOD_SPL, KEYBOARD_INT, true); }
     rawLog.Footer (false);
-    return 0;
+    std::cout.flush ();
+    return interruptToken.IsCancelled () ? -1 : 0;
 } /* End of main () */
\ No newline at end of file
@@ -6,17 +6,55 @@
  * Functions:
  *           Port
  *              Port ()
- *              DeepServiceProbe ()
+ *              Key ()
+ *              RestoreDeepScan ()
+ *              NMAPScriptScanAsync ()
+ *              NMAPScriptScan ()
+ *              ExtractScriptResults ()
  *           Host
  *              Host ()
+ *              AttachJournal ()
+ *              AttachSignatures ()
+ *              AttachCommands ()
+ *              AttachObserver ()
+ *              Address ()
+ *              OpenPorts ()
+ *              FilteredPorts ()
+ *              HostFindings ()
+ *              DiscoveryUsage ()
  *              AddPortToHost ()
  *              GetOpenPorts ()
+ *              SweepNMAP ()
+ *              SweepNative ()
+ *              SweepUDP ()
+ *              JoinTail ()
+ *              CollectTail ()
+ *              Unstaged ()
  *              PrintOpenScanSummary ()
+ *              BannerTask ()
+ *              GrabBanners ()
+ *              VersionTask ()
+ *              DetectVersions ()
+ *              HTTPTask ()
+ *              FingerprintHTTP ()
+ *              ScanPortTask ()
  *              MultitreadedNMAPScript ()
+ *              TLSTask ()
+ *              InspectTLSPorts ()
+ *              MatchKnownCVEs ()
+ *              IndexCPEs ()
+ *              PrintDeepScanSummary ()
+ *           PrintCPEQuery ()
  * Author: 0x6D76
  * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
  ***********************************************************************************************************************
  */
+#include "cveindex.hpp"
+#include "discovery.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
+#include "probes.hpp"
+#include "trace.hpp"
 #include "scanner.hpp"
 
 
@@ -25,61 +63,191 @@
  * :arg: id, constant string holding the port id.
  * :arg: status, constant string holding the current state of the port.
  * :arg: name, const string holding the name of the service running on the port.
+ * :arg: proto, const string holding the transport protocol of the port, default value is PROTO_TCP.
  */
-Port::Port (const std::string &id, const std::string &status, const std::string &name) 
-            : portid (id), state (status), service (name) {
+Port::Port (const std::string &id, const std::string &status, const std::string &name, const std::string &proto)
+            : portid (id), protocol (proto), state (status), service (name), severity (SEV_NONE), knownScore (0) {
 
 } /* End of Port () */
 
 
+/*
+ * This function returns the key identifying the port among those of its host: the port id of a TCP port, the port id
+ * and protocol of any other, e.g. "53/udp".
+ * :return: string holding the key.
+ */
+std::string Port::Key () const {
+
+    return protocol == PROTO_TCP ? portid : portid + "/" + protocol;
+
+} /* End of Key () */
+
+
+/*
+ * This function restores the results of a deep scan completed by an earlier run, as replayed from the journal. Only
+ * the fields the journal holds are copied, so the banner, TLS report & HTTP fingerprint gathered by this run are kept,
+ * and the service, product & version learnt by this run are not cleared by empty ones.
+ * :arg: journalled, const Port object replayed from the journal.
+ */
+void Port::RestoreDeepScan (const Port &journalled) {
+
+    state = journalled.state;
+    if (!journalled.service.empty () && journalled.service != "N/A") { service = journalled.service; }
+    if (!journalled.product.empty ()) { product = journalled.product; }
+    if (!journalled.version.empty ()) { version = journalled.version; }
+    osName = journalled.osName;
+    extraInfo = journalled.extraInfo;
+    osType = journalled.osType;
+    severity = journalled.severity;
+    vulnerabilities = journalled.vulnerabilities;
+    cves = journalled.cves;
+    cpes = journalled.cpes;
+    findings = journalled.findings;
+    hostFindings = journalled.hostFindings;
+    scansCompleted.push_back (SCAN_NMAP_VULN);
+
+} /* End of RestoreDeepScan () */
+
+
 /*
  * This function runs deep NMAP script scan against the target on the specified port to identify its associated service,
- * product, version and OS information.
- * :arg: target, string holding the target IP address.
+ * product, version and OS information, as a task of the given loop.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: target, string holding the target IP address, which must outlive the task.
  * :arg: masterLog, Logger object holding the master log to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: signatures, SignatureEngine object used to classify the output of each script, which must outlive the task.
+ * :arg: templates, CommandTemplates object the NMAP command is rendered from.
  * :return: ReturnCode object denoting the success or failure of the operation.
  */
-int Port::NMAPScriptScan (const std::string &target, Logger masterLog) {
+Task <int> Port::NMAPScriptScanAsync (EventLoop &loop, const std::string &target, Logger masterLog,
+                                      const CancelToken &token, const SignatureEngine &signatures,
+                                      const CommandTemplates &templates) {
 
-    std::string command {};
+    std::vector <std::string> command {};
     std::stringstream optional {};
     std::stringstream output {};
     pugi::xml_document document {};
-    std::string xmlDeep = DIR_PORTS + portid + ".xml";
-    std::string logFile = DIR_LOGS + portid + ".log";
+    /* Files of a UDP port are kept apart from those of the TCP port of the same number */
+    std::string stem = protocol == PROTO_TCP ? portid : portid + "-" + protocol;
+    std::string xmlDeep = DIR_PORTS + stem + ".xml";
+    std::string logFile = DIR_LOGS + stem + ".log";
     Logger portLog (logFile);
-
-    optional << "Port: " << portid;
-    std::unordered_map <std::string, std::string> placeHolders = {
-        {ID, portid},
-        {XML_FILE, xmlDeep},
-        {TARGET, target},
+    ScopedTimer portTimer (MET_DEEP_PORT, target + ":" + portid, true);
+    /* Every exit reports its return code to the deep__done probe */
+    auto finish = [&](int code) {
+        PH_PROBE3 (deep__done, target.c_str (), portid.c_str (), code);
+        return code;
     };
+
+    optional << "Port: " << Key ();
+    CommandValues values;
+    values [SLOT_ID] = {portid};
+    values [SLOT_XML_FILE] = {xmlDeep};
+    values [SLOT_TARGET] = {target};
     portLog.Header (portid);
+    PH_PROBE2 (deep__start, target.c_str (), portid.c_str ());
     portLog.Log (INFO, MOD_DEEP_SCAN, NMAP_SCRIPT_INFO, false);
-    command = ReplacePlaceHolders (BASE_NMAP_DEEP, placeHolders);
+    /* Versions detected natively are not detected again */
+    bool versioned = std::find (scansCompleted.begin (), scansCompleted.end (), SCAN_VERSION) != scansCompleted.end ();
+    CommandKind kind = protocol == PROTO_UDP ? COMMAND_NMAP_DEEP_UDP :
+                       versioned ? COMMAND_NMAP_SCRIPT : COMMAND_NMAP_DEEP;
+    command = templates.Render (kind, values);
     /* Executing NMAP scan */
-    if (ExecuteSystemCommand (command, output) == CMD_EXEC_FAIL) {
-        portLog.Log (FAIL, MOD_DEEP_SCAN, NMAP_SCRIPT_EXEC_FAIL, false);
+    ScopedTimer execTimer (MET_DEEP_NMAP, target + ":" + portid, true);
+    std::string cgroup = scanCgroups.StageDir (STAGE_DEEP);
+    ReturnCodes result = co_await ExecuteCommandAsync (loop, command, output, token, &usage, cgroup);
+    execTimer.Stop ();
+    runMetrics.RecordChild (MET_DEEP_NMAP, usage);
+    if (result == CMD_EXEC_CANCEL) {
+        /* Whatever NMAP managed to write is incomplete, do not leave it behind to be mistaken for a result */
+        std::error_code error;
+        std::filesystem::remove (xmlDeep, error);
+        portLog.Log (FAIL, MOD_DEEP_SCAN, CMD_EXEC_CANCEL, false);
+        masterLog.Log (FAIL, MOD_DEEP_SCAN, CMD_EXEC_CANCEL, false, optional);
+        runMetrics.GetCounter (MET_DEEP_CANCEL).Add ();
+        scansFailed.push_back (SCAN_NMAP_VULN);
+        co_return finish (NMAP_SCRIPT_FAIL);
+    }
+    if (result == CMD_EXEC_FAIL) {
+        if (usage.valid) { optional << " " << FormatChildUsage (usage); }
+        portLog.Log (FAIL, MOD_DEEP_SCAN, NMAP_SCRIPT_EXEC_FAIL, false, optional);
         masterLog.Log (FAIL, MOD_DEEP_SCAN, NMAP_SCRIPT_EXEC_FAIL, true, optional);
-        scansFailed.push_back ("NMAP vuln");
-        return NMAP_SCRIPT_FAIL;
+        runMetrics.GetCounter (MET_DEEP_FAIL).Add ();
+        scansFailed.push_back (SCAN_NMAP_VULN);
+        co_return finish (NMAP_SCRIPT_FAIL);
     }
     portLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_EXEC_PASS, false);
     /* Parsing the XML file */
+    ScopedTimer parseTimer (MET_DEEP_XML, target + ":" + portid);
     if (!document.load_file (xmlDeep.c_str ())) {
         portLog.Log (FAIL, MOD_DEEP_SCAN, NMAP_SCRIPT_XML_FAIL, false);
         masterLog.Log (FAIL, MOD_DEEP_SCAN, NMAP_SCRIPT_XML_FAIL, true, optional);
-        return NMAP_SCRIPT_FAIL;
+        runMetrics.GetCounter (MET_DEEP_FAIL).Add ();
+        co_return finish (NMAP_SCRIPT_FAIL);
     }
     portLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_XML_PASS, false);
-    pugi::xml_node nodeHost = document.child ("nmaprun").child ("host");
+    ExtractScriptResults (document.child ("nmaprun").child ("host"), portLog, signatures);
+    parseTimer.Stop ();
+    runMetrics.GetCounter (MET_DEEP_PASS).Add ();
+    scansCompleted.push_back (SCAN_NMAP_VULN);
+    portLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, false);
+    masterLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, true, optional);
+
+    co_return finish (NMAP_SCRIPT_PASS);
+
+} /* End of NMAPScriptScanAsync () */
+
+
+/*
+ * This function runs the deep NMAP script scan of the port on a loop of its own, for callers which are not coroutines.
+ * :arg: target, string holding the target IP address.
+ * :arg: masterLog, Logger object holding the master log to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: signatures, SignatureEngine object used to classify the output of each script.
+ * :arg: templates, CommandTemplates object the NMAP command is rendered from.
+ * :return: ReturnCode object denoting the success or failure of the operation.
+ */
+int Port::NMAPScriptScan (const std::string &target, Logger masterLog, const CancelToken &token,
+                          const SignatureEngine &signatures, const CommandTemplates &templates) {
+
+    EventLoop loop;
+    int result = NMAP_SCRIPT_FAIL;
+    loop.Spawn (StoreResult (NMAPScriptScanAsync (loop, target, masterLog, token, signatures, templates), result));
+    loop.Run ();
+    return result;
+
+} /* End of NMAPScriptScan () */
+
+
+/*
+ * This function extracts the service, product, version, CPE, OS, vulnerability & finding information of the port from
+ * the <host> node of a parsed NMAP script scan.
+ * :arg: nodeHost, xml_node of the <host> holding the port.
+ * :arg: portLog, Logger object holding the port log to which the messages are to be logged.
+ * :arg: signatures, SignatureEngine object used to classify the output of each script.
+ */
+void Port::ExtractScriptResults (const pugi::xml_node &nodeHost, Logger portLog, const SignatureEngine &signatures) {
+
     pugi::xml_node nodePort = nodeHost.child ("ports").child ("port");
     pugi::xml_node nodeService = nodePort.child ("service");
-    /* Extracting service information */
-    service = nodeService.attribute ("name").as_string ();
-    product = nodeService.attribute ("product").as_string (); 
-    version = nodeService.attribute ("version").as_string ();
+    /* Extracting service information, which without -sV is a guess from the port number */
+    if (std::find (scansCompleted.begin (), scansCompleted.end (), SCAN_VERSION) == scansCompleted.end ()) {
+        service = nodeService.attribute ("name").as_string ();
+        product = nodeService.attribute ("product").as_string ();
+        version = nodeService.attribute ("version").as_string ();
+        extraInfo = nodeService.attribute ("extrainfo").as_string ();
+        osType = nodeService.attribute ("ostype").as_string ();
+        /* Extracting CPE information */
+        for (pugi::xml_node nodeCPE = nodeService.child ("cpe"); nodeCPE; nodeCPE = nodeCPE.next_sibling ("cpe")) {
+            CPE cpe;
+            int depth = 0;
+            if (ParseCPE (nodeCPE.child_value (), cpe, depth) && std::find (cpes.begin (), cpes.end (), cpe) ==
+                cpes.end ()) {
+                cpes.push_back (cpe);
+            }
+        }
+    }
     /* Extracting OS information */
     pugi::xml_node nodeOS = nodeHost.child ("os").child ("osmatch");
     if (!nodeOS.empty ()) { osName = nodeOS.attribute ("name").value (); }
@@ -87,20 +255,32 @@ int Port::NMAPScriptScan (const std::string &target, Logger masterLog) {
     pugi::xml_node nodeScript;
     for (nodeScript = nodePort.child ("script"); nodeScript; nodeScript = nodeScript.next_sibling ("script")) {
         std::string scriptID = nodeScript.attribute ("id").value ();
-        std::string scriptOP = nodeScript.child_value ();
+        /* NMAP writes the script's text into its output attribute, older versions into the node itself */
+        std::string scriptOP = nodeScript.attribute ("output").value ();
+        if (scriptOP.empty ()) { scriptOP = nodeScript.child_value (); }
+        ExtractFindings (nodeScript, SCOPE_PORT, findings);
+        ScriptVerdict verdict = signatures.Classify (scriptOP);
+        if (verdict.severity == SEV_NONE) { continue; }
         std::stringstream optional {};
-        optional >> scriptID;
-        if (scriptOP.find ("vulerable") != std::string::npos) {
-            vulnerabilities.push_back (scriptID);
-            portLog.Log (PASS, MOD_DEEP_SCAN, VULNS_FOUND, false, optional);
+        optional << "Script: " << scriptID << " Severity: " << SeverityName (verdict.severity);
+        for (const auto &cve : verdict.cves) {
+            optional << " " << cve;
+            if (std::find (cves.begin (), cves.end (), cve) == cves.end ()) { cves.push_back (cve); }
         }
+        severity = std::max (severity, verdict.severity);
+        /* Informational matches, e.g. "State: UNKNOWN", are no vulnerability */
+        if (verdict.severity > SEV_INFO) { vulnerabilities.push_back (scriptID); }
+        portLog.Log (PASS, MOD_DEEP_SCAN, VULNS_FOUND, false, optional);
     }
-    portLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, false);
-    masterLog.Log (PASS, MOD_DEEP_SCAN, NMAP_SCRIPT_PASS, true, optional);
-
-    return NMAP_SCRIPT_PASS;
+    /* Extracting host level findings, reported under <hostscript> by every port's scan */
+    pugi::xml_node nodeHostScript = nodeHost.child ("hostscript");
+    for (nodeScript = nodeHostScript.child ("script"); nodeScript; nodeScript = nodeScript.next_sibling ("script")) {
+        ExtractFindings (nodeScript, SCOPE_HOST, hostFindings);
+    }
+    RankFindings (findings);
+    RankFindings (hostFindings);
 
-} /* End of NMAPScriptScan () */
+} /* End of ExtractScriptResults () */
 
 
 /*
@@ -108,11 +288,70 @@ int Port::NMAPScriptScan (const std::string &target, Logger masterLog) {
  * :arg: addr, constant string holding the validated address of the target.
  */
 Host::Host (const std::string &addr)
-            : address (addr), numOpen (0), numFilter (0) {
+            : address (addr), numOpen (0), numFilter (0), staged (0), journal (nullptr), signatures (nullptr),
+              commandTemplates (nullptr), observer (nullptr) {
 
 } /* End of Host () */
 
 
+/*
+ * This function attaches the scan journal, to which completed work is checkpointed and from which work completed by
+ * an earlier run is restored.
+ * :arg: scanJournal, pointer to the Journal object, nullptr disables checkpointing.
+ */
+void Host::AttachJournal (Journal *scanJournal) {
+
+    journal = scanJournal;
+
+} /* End of AttachJournal () */
+
+
+/*
+ * This function attaches the signature engine used to classify NMAP script output, in place of the built-in
+ * signatures.
+ * :arg: engine, pointer to the loaded SignatureEngine object, nullptr restores the built-in signatures.
+ */
+void Host::AttachSignatures (const SignatureEngine *engine) {
+
+    signatures = engine;
+
+} /* End of AttachSignatures () */
+
+
+/*
+ * This function attaches the command templates the NMAP children are spawned from, in place of the built-in ones.
+ * :arg: templates, pointer to the loaded CommandTemplates object, nullptr restores the built-in templates.
+ */
+void Host::AttachCommands (const CommandTemplates *templates) {
+
+    commandTemplates = templates;
+
+} /* End of AttachCommands () */
+
+
+/*
+ * This function attaches an observer, notified once the ports of the host are discovered and as each port's NMAP
+ * script scan finishes.
+ * :arg: scanObserver, pointer to the ScanObserver object, nullptr detaches it.
+ */
+void Host::AttachObserver (ScanObserver *scanObserver) {
+
+    observer = scanObserver;
+
+} /* End of AttachObserver () */
+
+
+/*
+ * These functions give read access to the results of the scan, for callers which present them on their own. They
+ * must not be called while a scan of the host is running.
+ */
+const std::string &Host::Address () const { return address; } /* End of Address () */
+const std::vector <Port> &Host::OpenPorts () const { return openPorts; } /* End of OpenPorts () */
+const std::vector <Port> &Host::FilteredPorts () const { return filterPorts; } /* End of FilteredPorts () */
+const std::vector <Finding> &Host::HostFindings () const { return hostFindings; } /* End of HostFindings () */
+const ChildUsage &Host::DiscoveryUsage () const { return discoveryUsage; } /* End of DiscoveryUsage () */
+
+
 /*
  * This function adds Ports object to Host object based on the current state of the port, to either Open Ports or
  * Filtered ports.
@@ -123,7 +362,7 @@ void Host::AddPortToHost (const Port &port) {
     if (port.state == STATE_OPEN) {
         openPorts.push_back (port);
         numOpen++;
-    } else if (port.state == STATE_FLTR) {
+    } else if (port.state == STATE_FLTR || port.state == STATE_OPEN_FLTR) {
         filterPorts.push_back (port);
         numFilter++;
     }
@@ -132,73 +371,389 @@ void Host::AddPortToHost (const Port &port) {
 
 
 /*
- * This function executes NMAP scan agains the target and parses the XML file to identify open and filtered ports, 
- * along with their respective states, portids and service names.
+ * This function identifies the open and filtered ports of the target, along with their respective states, portids and
+ * service names, with the given backend, followed by the native UDP sweep when asked for. Discovery completed by an
+ * earlier run is restored from the journal instead. An ordered sweep only waits for the DISC_HEAD_PORTS most frequently
+ * open ports, the rest are swept on a thread of their own and added by CollectTail (), unless the head holds no open
+ * port, in which case they are waited for. An NMAP sweep may be split into shards of its ports, run as concurrent
+ * NMAP children.
  * :arg: ojLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests, which must outlive the background sweep.
+ * :arg: backend, DiscoveryBackend sweeping the target, default value is DISCOVERY_NMAP.
+ * :arg: udp, bool value indicating whether the UDP services are swept too, default value is false.
+ * :arg: ordered, bool value indicating whether the ports are swept by frequency, default value is false.
+ * :arg: shards, size_t holding the number of NMAP children each sweep is split across, 0 to tune it to the available
+ *       cores, default value is 1.
  * :return: ReturnCodes object denoting the success/failure of the operation.
  */
-ReturnCodes Host::GetOpenPorts (Logger objLog) {
+ReturnCodes Host::GetOpenPorts (Logger objLog, const CancelToken &token, DiscoveryBackend backend, bool udp,
+                                bool ordered, size_t shards) {
 
-    std::string command {};
-    std::stringstream output {};
-    std::string xmlOpen = DIR_BASE + "OpenPorts.xml";
-    std::unordered_map <std::string, std::string> placeHolders = {
-        {XML_FILE, xmlOpen},
-        {TARGET, address},
+    ScopedTimer phaseTimer (MET_PHASE_DISC, address);
+    /* Every exit reports its return code to the discovery__done probe */
+    auto finish = [this](ReturnCodes code) {
+        PH_PROBE4 (discovery__done, address.c_str (), static_cast <int> (code), numOpen, numFilter);
+        return code;
     };
-    command = ReplacePlaceHolders (BASE_NMAP_OPEN, placeHolders);
-    /* Execute NMAP scan and return failure code, if it fails */
-    if (ExecuteSystemCommand (command, output) == CMD_EXEC_FAIL) {
-        objLog.Log (FAIL, MOD_NMAP_OPEN, OPEN_NMAP_FAIL, true);
-        return OPEN_NMAP_FAIL;
-    }
-    objLog.Log (PASS, MOD_NMAP_OPEN, OPEN_NMAP_PASS, false);
-    /* Parsing NMAP scan results */
-    pugi::xml_document document;
-    if (!document.load_file (xmlOpen.c_str ())) {
-        objLog.Log (FAIL, MOD_XML_OPEN, OPEN_XML_FAIL, true);
-        return OPEN_XML_FAIL;
+    PH_PROBE1 (discovery__start, address.c_str ());
+    /* Restore discovery completed by an earlier run, instead of sweeping the target again */
+    const JournalHost *restored = journal ? journal->Find (address) : nullptr;
+    if (restored && restored->discovered) {
+        for (const auto &port : restored->ports) { AddPortToHost (port); }
+        runMetrics.GetCounter (MET_DISC_OPEN).Add (numOpen);
+        runMetrics.GetCounter (MET_DISC_FILTER).Add (numFilter);
+        if (observer) { observer->PortsDiscovered (address, openPorts, filterPorts); }
+        objLog.Log (INFO, MOD_JOURNAL, JOURNAL_DISC_INFO, true);
+        if (numOpen == 0 && numFilter == 0) {
+            objLog.Log (FAIL, MOD_XML_OPEN, PORT_FOUND_FAIL, true);
+            return finish (PORT_FOUND_FAIL);
+        }
+        return finish (PORTS_FOUND_PASS);
     }
-    pugi::xml_node port;
-    pugi::xml_node ports = document.child ("nmaprun").child ("host").child ("ports");
-    /* Loop through port nodes to identify ports, their respective portids, states & services. */
-    for (port = ports.first_child (); port; port = port.next_sibling ("port")) {
-        std::string id = port.attribute ("portid").value ();
-        std::string status = port.child ("state").attribute ("state").value ();
-        std::string name = port.child ("service").attribute ("name").value ();
 
-        if (name.empty ()) { name = "N/A"; }
-        /* Add corresponding port object to the target Host if the port's current state is not closed. */
-        if (status != STATE_CLSD) { AddPortToHost (Port (id, status, name)); }
+    if (journal) { journal->RecordDiscoveryStart (address); }
+    std::vector <Port> found;
+    std::vector <uint16_t> ranked = ordered ? RankedPorts (std::filesystem::exists (PORT_FREQUENCY_FILE) ?
+                                                           PORT_FREQUENCY_FILE : PORT_FREQUENCY_SYSTEM)
+                                            : std::vector <uint16_t> {};
+    std::vector <uint16_t> schedule = PortSchedule (ranked);
+    size_t head = ordered ? std::min (ranked.size (), DISC_HEAD_PORTS) : schedule.size ();
+    std::vector <uint16_t> headPorts (schedule.begin (), schedule.begin () + head);
+    std::string headList;
+    for (size_t index = 0; ordered && index < head; index++) {
+        if (index) { headList += ','; }
+        headList += std::to_string (headPorts [index]);
+    }
+    size_t headShards = ShardCount (shards, head);
+    std::vector <std::vector <std::string>> portSpecs = headShards > 1 ? ShardPortSpecs (headPorts, headShards) :
+        std::vector <std::vector <std::string>> {ordered ? std::vector <std::string> {"-p", headList} :
+                                                           std::vector <std::string> {"-p-"}};
+    ScopedTimer headTimer (MET_DISC_HEAD, address);
+    ReturnCodes swept = backend == DISCOVERY_NATIVE ? SweepNative (objLog, token, headPorts, found) :
+                        SweepNMAP (objLog, token, portSpecs, DIR_BASE + "OpenPorts", found, discoveryUsage);
+    headTimer.Stop ();
+    if (swept < 0) { return finish (swept); }
+    for (const Port &port : found) { AddPortToHost (port); }
+    if (ordered) {
+        std::stringstream optional;
+        optional << "Swept " << head << " port(s), open: " << numOpen << ", filtered: " << numFilter;
+        objLog.Log (INFO, MOD_PORT_ORDER, DISC_HEAD_INFO, true, optional);
+        std::vector <uint16_t> tail (schedule.begin () + head, schedule.end ());
+        size_t tailShards = ShardCount (shards, tail.size ());
+        std::vector <std::vector <std::string>> tailSpecs = tailShards > 1 ? ShardPortSpecs (tail, tailShards) :
+            std::vector <std::vector <std::string>> {{"-p-", "--exclude-ports", headList}};
+        tailSweep = std::async (std::launch::async, [this, objLog, &token, backend, tail, tailSpecs]() {
+            traceRecorder.NameThread ("discovery");
+            ScopedTimer tailTimer (MET_DISC_TAIL, address);
+            if (backend == DISCOVERY_NATIVE) { return SweepNative (objLog, token, tail, tailPorts); }
+            return SweepNMAP (objLog, token, tailSpecs, DIR_BASE + "OpenPortsTail", tailPorts, tailUsage);
+        });
+    }
+    /* A failed UDP sweep leaves the TCP results standing, a cancelled one leaves discovery to be resumed */
+    if (udp && SweepUDP (objLog, token) != UDP_SWEEP_PASS && token.IsCancelled ()) {
+        if (tailSweep.valid ()) { JoinTail (); }
+        return finish (UDP_SWEEP_FAIL);
+    }
+    /* With no open port ahead of the rest, there is nothing to start scanning early */
+    if (tailSweep.valid () && numOpen == 0) {
+        swept = JoinTail ();
+        if (swept < 0) { return finish (swept); }
     }
+    if (journal && !tailSweep.valid ()) { journal->RecordDiscoveryEnd (address); }
+    runMetrics.GetCounter (MET_DISC_OPEN).Add (numOpen);
+    runMetrics.GetCounter (MET_DISC_FILTER).Add (numFilter);
+    if (observer) { observer->PortsDiscovered (address, openPorts, filterPorts); }
 
     if (numOpen == 0 && numFilter == 0) {
         objLog.Log (FAIL, MOD_XML_OPEN, PORT_FOUND_FAIL, true);
-        return PORT_FOUND_FAIL;
+        return finish (PORT_FOUND_FAIL);
     }
     objLog.Log (PASS, MOD_XML_OPEN, PORTS_FOUND_PASS, true);
-    return PORTS_FOUND_PASS;
+    return finish (PORTS_FOUND_PASS);
     
 } /* End of GetOpenPorts () */
 
 
+/*
+ * This function executes NMAP scan agains the target and parses the XML file to identify open and filtered ports, 
+ * along with their respective states, portids and service names. A sweep split into shards runs an NMAP child per
+ * shard at once on a loop of its own, each writing an XML file of its own, and the shards are merged in order; any
+ * shard failing fails the sweep, rather than leave its ports silently unswept. The host itself is left untouched, so
+ * the sweep may run on a thread of its own.
+ * :arg: ojLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: portSpecs, const vector of the NMAP arguments selecting the ports of each shard, e.g. "-p-".
+ * :arg: xmlStem, const string holding the path of the XML files written by NMAP, without the extension.
+ * :arg: found, vector to which the open and filtered ports are added.
+ * :arg: usage, ChildUsage object to which the resources used by the NMAP children are copied.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes Host::SweepNMAP (Logger objLog, const CancelToken &token,
+                             const std::vector <std::vector <std::string>> &portSpecs, const std::string &xmlStem,
+                             std::vector <Port> &found, ChildUsage &usage) {
+
+    size_t shards = portSpecs.size ();
+    std::vector <std::vector <std::string>> commands;
+    std::vector <std::string> xmlFiles;
+    std::vector <std::stringstream> outputs (shards);
+    std::vector <ChildUsage> usages (shards);
+    std::vector <ReturnCodes> results (shards, CMD_EXEC_FAIL);
+    const CommandTemplates builtIn {};
+    const CommandTemplates &templates = commandTemplates ? *commandTemplates : builtIn;
+    for (size_t shard = 0; shard < shards; shard++) {
+        xmlFiles.push_back (xmlStem + (shards > 1 ? "." + std::to_string (shard) : "") + ".xml");
+        CommandValues values;
+        values [SLOT_PORTS] = portSpecs [shard];
+        values [SLOT_XML_FILE] = {xmlFiles.back ()};
+        values [SLOT_TARGET] = {address};
+        commands.push_back (templates.Render (COMMAND_NMAP_OPEN, values));
+    }
+    if (shards > 1) {
+        std::stringstream optional;
+        optional << "Shards: " << shards;
+        objLog.Log (INFO, MOD_NMAP_OPEN, DISC_SHARD_INFO, false, optional);
+    }
+    /* Execute NMAP scan and return failure code, if it fails or is cancelled */
+    ScopedTimer execTimer (MET_DISC_NMAP, address);
+    EventLoop loop;
+    std::string cgroup = scanCgroups.StageDir (STAGE_DISCOVERY);
+    for (size_t shard = 0; shard < shards; shard++) {
+        loop.Spawn (StoreResult (ExecuteCommandAsync (loop, commands [shard], outputs [shard], token, &usages [shard],
+                                                      cgroup), results [shard]));
+    }
+    loop.Run ();
+    execTimer.Stop ();
+    for (const ChildUsage &shardUsage : usages) {
+        runMetrics.RecordChild (MET_DISC_NMAP, shardUsage);
+        MergeChildUsage (usage, shardUsage);
+    }
+    if (std::count (results.begin (), results.end (), CMD_EXEC_CANCEL)) {
+        std::error_code error;
+        for (const std::string &xmlOpen : xmlFiles) { std::filesystem::remove (xmlOpen, error); }
+        objLog.Log (FAIL, MOD_NMAP_OPEN, CMD_EXEC_CANCEL, true);
+        return OPEN_NMAP_FAIL;
+    }
+    if (std::count (results.begin (), results.end (), CMD_EXEC_FAIL)) {
+        std::stringstream optional;
+        for (size_t shard = 0; shard < shards; shard++) {
+            if (results [shard] != CMD_EXEC_FAIL || !usages [shard].valid) { continue; }
+            if (optional.tellp () > 0) { optional << "; "; }
+            optional << "Shard " << shard << ": " << FormatChildUsage (usages [shard]);
+        }
+        objLog.Log (FAIL, MOD_NMAP_OPEN, OPEN_NMAP_FAIL, true, optional);
+        return OPEN_NMAP_FAIL;
+    }
+    objLog.Log (PASS, MOD_NMAP_OPEN, OPEN_NMAP_PASS, false);
+    /* Parsing NMAP scan results */
+    ScopedTimer parseTimer (MET_DISC_XML, address);
+    std::vector <Port> merged;
+    for (const std::string &xmlOpen : xmlFiles) {
+        pugi::xml_document document;
+        if (!document.load_file (xmlOpen.c_str ())) {
+            objLog.Log (FAIL, MOD_XML_OPEN, OPEN_XML_FAIL, true);
+            return OPEN_XML_FAIL;
+        }
+        pugi::xml_node port;
+        pugi::xml_node ports = document.child ("nmaprun").child ("host").child ("ports");
+        /* Loop through port nodes to identify ports, their respective portids, states & services. */
+        for (port = ports.first_child (); port; port = port.next_sibling ("port")) {
+            std::string id = port.attribute ("portid").value ();
+            std::string status = port.child ("state").attribute ("state").value ();
+            std::string name = port.child ("service").attribute ("name").value ();
+
+            if (name.empty ()) { name = "N/A"; }
+            /* Add corresponding port object to the target Host if the port's current state is not closed. */
+            if (status != STATE_CLSD) { merged.emplace_back (id, status, name); }
+        }
+    }
+    /* Ports are only recorded once every shard has been parsed, so a failed sweep leaves none of them behind */
+    for (const Port &port : merged) {
+        found.push_back (port);
+        if (journal) { journal->RecordDiscoveredPort (address, port); }
+    }
+    return OPEN_XML_PASS;
+
+} /* End of SweepNMAP () */
+
+
+/*
+ * This function sweeps the given TCP ports of the target with the native connect sweep, paced by the congestion
+ * controller of the target's network, to identify open and filtered ports along with their conventional service names.
+ * The host itself is left untouched, so the sweep may run on a thread of its own.
+ * :arg: ojLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: ports, const vector of the ports to be swept, in order.
+ * :arg: found, vector to which the open and filtered ports are added.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes Host::SweepNative (Logger objLog, const CancelToken &token, const std::vector <uint16_t> &ports,
+                               std::vector <Port> &found) {
+
+    /* module = MOD_NATIVE_DISC */
+    std::stringstream optional;
+    SweepResult result;
+    CongestionController &controller = NetworkController (address);
+    EventLoop loop;
+    ReturnCodes swept = NATIVE_DISC_FAIL;
+    loop.Spawn (StoreResult (NativeSweep (loop, address, ports, token, controller, result), swept));
+    loop.Run ();
+    if (swept == CMD_EXEC_CANCEL) {
+        objLog.Log (FAIL, MOD_NATIVE_DISC, CMD_EXEC_CANCEL, true);
+        return NATIVE_DISC_FAIL;
+    }
+    if (swept == NATIVE_DISC_FAIL) {
+        objLog.Log (FAIL, MOD_NATIVE_DISC, NATIVE_DISC_FAIL, true);
+        return NATIVE_DISC_FAIL;
+    }
+    optional << "Window: " << controller.Window () << ", timeout: " << controller.TimeoutMs () << " ms, responses: "
+             << result.responses << ", timeouts: " << result.timeouts << ", closed: " << result.closed;
+    objLog.Log (INFO, MOD_NATIVE_DISC, NATIVE_DISC_INFO, false, optional);
+    for (uint16_t id : result.open) {
+        found.emplace_back (std::to_string (id), STATE_OPEN, ServiceName (id));
+        if (journal) { journal->RecordDiscoveredPort (address, found.back ()); }
+    }
+    /* A target dropping most probes only reports how many ports are filtered */
+    for (uint16_t id : result.filtered.size () <= DISC_FILTER_LIST_MAX ? result.filtered : std::vector <uint16_t> {}) {
+        found.emplace_back (std::to_string (id), STATE_FLTR, ServiceName (id));
+        if (journal) { journal->RecordDiscoveredPort (address, found.back ()); }
+    }
+    optional.str ("");
+    optional << "Open: " << result.open.size () << ", filtered: " << result.filtered.size ();
+    objLog.Log (PASS, MOD_NATIVE_DISC, NATIVE_DISC_PASS, false, optional);
+    return NATIVE_DISC_PASS;
+
+} /* End of SweepNative () */
+
+
+/*
+ * This function sweeps the UDP ports of the payload table with the native UDP sweep, to identify open, filtered and
+ * open|filtered ports. A port answering its payload is taken to run the service the payload was written for.
+ * :arg: ojLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes Host::SweepUDP (Logger objLog, const CancelToken &token) {
+
+    /* module = MOD_UDP_DISC */
+    std::stringstream optional;
+    std::vector <uint16_t> ports;
+    std::map <uint16_t, std::string> services;
+    SweepResult result;
+    for (const UDPPayload &entry : UDPPayloads ()) {
+        ports.push_back (entry.port);
+        services [entry.port] = entry.service;
+    }
+    EventLoop loop;
+    ReturnCodes swept = UDP_SWEEP_FAIL;
+    loop.Spawn (StoreResult (UDPSweep (loop, address, ports, token, result), swept));
+    loop.Run ();
+    if (swept == CMD_EXEC_CANCEL) {
+        objLog.Log (FAIL, MOD_UDP_DISC, CMD_EXEC_CANCEL, true);
+        return UDP_SWEEP_FAIL;
+    }
+    if (swept == UDP_SWEEP_FAIL) {
+        objLog.Log (FAIL, MOD_UDP_DISC, UDP_SWEEP_FAIL, true);
+        return UDP_SWEEP_FAIL;
+    }
+    auto add = [&](const std::vector <uint16_t> &ids, const std::string &state) {
+        for (uint16_t id : ids) {
+            Port found (std::to_string (id), state, services [id], PROTO_UDP);
+            if (journal) { journal->RecordDiscoveredPort (address, found); }
+            AddPortToHost (found);
+        }
+    };
+    add (result.open, STATE_OPEN);
+    add (result.filtered, STATE_FLTR);
+    add (result.openFiltered, STATE_OPEN_FLTR);
+    optional << "Open: " << result.open.size () << ", closed: " << result.closed << ", filtered: "
+             << result.filtered.size () << ", open|filtered: " << result.openFiltered.size ();
+    objLog.Log (PASS, MOD_UDP_DISC, UDP_SWEEP_PASS, true, optional);
+    return UDP_SWEEP_PASS;
+
+} /* End of SweepUDP () */
+
+
+/*
+ * This function waits for the background sweep of the ports left after the most frequent ones and adds the ports it
+ * found to the host. The resources of its NMAP child are added to those of discovery.
+ * :return: ReturnCodes object denoting the success/failure of the background sweep.
+ */
+ReturnCodes Host::JoinTail () {
+
+    ReturnCodes swept = tailSweep.get ();
+    if (swept >= 0) {
+        for (const Port &port : tailPorts) { AddPortToHost (port); }
+    }
+    tailPorts.clear ();
+    /* Both sweeps ran at once, the wall clock time of discovery is that of the longer one */
+    MergeChildUsage (discoveryUsage, tailUsage);
+    return swept;
+
+} /* End of JoinTail () */
+
+
+/*
+ * This function collects the background sweep of an ordered discovery, once the ports found ahead of it have been
+ * through the scan stages. The ports it found are the only ones the stages run on next, and the observer is notified
+ * of them. Discovery is checkpointed as complete only once the background sweep has succeeded.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: integer denoting the number of open ports found by the background sweep, 0 if there is none pending.
+ */
+int Host::CollectTail (Logger objLog) {
+
+    /* module = MOD_PORT_ORDER */
+    if (!tailSweep.valid ()) { return 0; }
+    int open = numOpen;
+    int filter = numFilter;
+    size_t filteredFrom = filterPorts.size ();
+    staged = openPorts.size ();
+    if (JoinTail () < 0) { return 0; }
+    if (journal) { journal->RecordDiscoveryEnd (address); }
+    runMetrics.GetCounter (MET_DISC_OPEN).Add (numOpen - open);
+    runMetrics.GetCounter (MET_DISC_FILTER).Add (numFilter - filter);
+    if (observer) {
+        observer->PortsDiscovered (address, std::vector <Port> (openPorts.begin () + staged, openPorts.end ()),
+                                   std::vector <Port> (filterPorts.begin () + filteredFrom, filterPorts.end ()));
+    }
+    std::stringstream optional;
+    optional << "Open: " << numOpen - open << ", filtered: " << numFilter - filter;
+    objLog.Log (INFO, MOD_PORT_ORDER, DISC_TAIL_INFO, true, optional);
+    return numOpen - open;
+
+} /* End of CollectTail () */
+
+
+/*
+ * This function returns the open ports which have not been through the scan stages yet.
+ * :return: span of the open ports found since the last collected sweep.
+ */
+std::span <Port> Host::Unstaged () {
+
+    return std::span <Port> (openPorts).subspan (staged);
+
+} /* End of Unstaged () */
+
+
 /*
  * This function prints a summary of open and filtered ports identified on the target, along with their respective
  * service names, if identified.
  * :arg: logObj, Logger object to which the messages are to be logged.
+ * :arg: out, ostream to which the summary is printed, default value is STDOUT.
  */
-void Host::PrintOpenScanSummary (Logger logObj) {
+void Host::PrintOpenScanSummary (Logger logObj, std::ostream &out) const {
 
     /* module = MOD_SUM_PORTS */
+    ScopedTimer summaryTimer (MET_OPEN_SUM);
+    if (discoveryUsage.valid) { out << "\tNMAP discovery: " << FormatChildUsage (discoveryUsage) << std::endl; }
     if (numFilter > 0) {
         std::stringstream optional;
         optional << "Found " << numFilter << " filtered port(s).";
         logObj.Log (INFO, MOD_SUM_PORTS,FILTER_FOUND_PASS, true, optional);
-        std::cout << "\t" << optional.str () << std::endl;
+        out << "\t" << optional.str () << std::endl;
 
         for (const auto &port : filterPorts) {
-            std::cout << "\t" << CYN << "[!] " << RST;
-            std::cout << std::setw (5) << std::right << port.portid << " : " << port.service << std::endl;
+            out << "\t" << CYN << "[!] " << RST;
+            out << std::setw (5) << std::right << port.Key () << " : " << port.service << std::endl;
         }
     } 
     else {
@@ -209,75 +764,598 @@ void Host::PrintOpenScanSummary (Logger logObj) {
         std::stringstream optional;
         optional << "Found " << numOpen << " open port(s).";
         logObj.Log (INFO, MOD_SUM_PORTS,OPEN_FOUND_PASS, true, optional);
-        std::cout << "\t" << optional.str () << std::endl;
+        out << "\t" << optional.str () << std::endl;
 
         for (const auto &port : openPorts) {
-            std::cout << "\t" << BLU << "[+] " << RST;
-            std::cout << std::setw (5) << std::right << port.portid << " : " << port.service << std::endl;
+            out << "\t" << BLU << "[+] " << RST;
+            out << std::setw (5) << std::right << port.Key () << " : " << port.service << std::endl;
         }
     } 
     else {
         logObj.Log (INFO, MOD_SUM_PORTS, OPEN_FOUND_FAIL, true);
     }
+    if (tailSweep.valid ()) { out << "\tThe remaining ports are being swept in the background." << std::endl; }
 } /* End of PrintOpenScanSummary () */
 
 
 /*
- * This function creates necessary threads and make multi-threaded calls to DeepServiceProbe with the target address
- * as its parameter.
+ * This function grabs the banner of a port once the limiter lets it in and identifies its service from it. Ports
+ * still waiting when cancellation is requested are not contacted.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: limiter, Limiter object capping the number of connections open at once.
+ * :arg: port, Port object to be identified.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ */
+Task <> Host::BannerTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token) {
+
+    co_await limiter.Acquire ();
+    if (!token.IsCancelled ()) {
+        ScopedTimer portTimer (MET_BANNER_PORT, address + ":" + port.portid, true);
+        std::string banner = co_await GrabBanner (loop, address, port.portid, BANNER_TIMEOUT_MS);
+        portTimer.Stop ();
+        port.banner = PrintableBanner (banner);
+        /* A generic rule only names the protocol, such a port is still left to NMAP to be identified */
+        if (MatchBanner (banner, port) && !port.product.empty () && !port.version.empty ()) {
+            std::stringstream optional;
+            optional << "Port: " << port.portid << ", " << port.service << " " << port.product << " " << port.version;
+            objLog.Log (INFO, MOD_BANNER, BANNER_GRAB_INFO, false, optional);
+            port.scansCompleted.push_back (SCAN_BANNER);
+            runMetrics.GetCounter (MET_BANNER_HIT).Add ();
+        }
+        else {
+            runMetrics.GetCounter (MET_BANNER_MISS).Add ();
+        }
+    }
+    limiter.Release ();
+
+} /* End of BannerTask () */
+
+
+/*
+ * This function grabs the banner of every open port as tasks of an event loop driven by the calling thread, filling
+ * the service, product & version of the ports whose banners are recognised. The NMAP script scan skips those ports.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: concurrency, integer denoting the number of connections open at once, default value is BANNER_CONCURRENCY.
+ * :return: integer denoting the number of ports identified.
+ */
+int Host::GrabBanners (Logger objLog, const CancelToken &token, int concurrency) {
+
+    /* module = MOD_BANNER */
+    ScopedTimer phaseTimer (MET_PHASE_BANNER, address);
+    EventLoop loop;
+    Limiter limiter (loop, static_cast <size_t> (std::max (concurrency, 1)));
+    size_t attempted = 0;
+    for (Port &port : Unstaged ()) {
+        if (port.protocol != PROTO_TCP) { continue; }
+        loop.Spawn (BannerTask (loop, limiter, port, objLog, token));
+        attempted++;
+    }
+    loop.Run ();
+
+    int identified = static_cast <int> (std::ranges::count_if (Unstaged (), [](const Port &port) {
+        return std::find (port.scansCompleted.begin (), port.scansCompleted.end (), SCAN_BANNER) !=
+               port.scansCompleted.end ();
+    }));
+    std::stringstream optional;
+    optional << identified << " of " << attempted << " open port(s) identified from their banners.";
+    objLog.Log (INFO, MOD_BANNER, BANNER_GRAB_INFO, true, optional);
+    return identified;
+
+} /* End of GrabBanners () */
+
+
+/*
+ * This function detects the version of a port with the native service probes once the limiter lets it in. A match
+ * fills the service, product, version, OS & CPEs of the port, a softmatch only its service.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: limiter, Limiter object capping the number of ports probed at once.
+ * :arg: port, Port object to be identified.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: probes, ServiceProbes object holding the loaded database.
+ */
+Task <> Host::VersionTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token,
+                           const ServiceProbes &probes) {
+
+    co_await limiter.Acquire ();
+    if (!token.IsCancelled ()) {
+        ScopedTimer portTimer (MET_VERSION_PORT, address + ":" + port.portid, true);
+        ServiceVerdict verdict = co_await probes.Detect (loop, address, port.portid, token);
+        portTimer.Stop ();
+        runMetrics.GetCounter (MET_VERSION_PROBES).Add (verdict.probesSent);
+        if (verdict.matched) {
+            std::stringstream optional;
+            optional << "Port: " << port.portid << ", " << verdict.service << " " << verdict.product << " "
+                     << verdict.version << " (probe " << verdict.probe << ")";
+            objLog.Log (INFO, MOD_SERVICE_PROBES, SERVICE_VERSION_INFO, false, optional);
+            port.service = verdict.service;
+            port.product = verdict.product;
+            port.version = verdict.version;
+            port.extraInfo = verdict.info;
+            port.osType = verdict.osType;
+            for (const std::string &text : verdict.cpes) {
+                CPE cpe;
+                int depth = 0;
+                if (ParseCPE (text, cpe, depth) && std::find (port.cpes.begin (), port.cpes.end (), cpe) ==
+                    port.cpes.end ()) {
+                    port.cpes.push_back (cpe);
+                }
+            }
+            port.scansCompleted.push_back (SCAN_VERSION);
+            runMetrics.GetCounter (MET_VERSION_HIT).Add ();
+        }
+        else if (verdict.soft) {
+            port.service = verdict.service;
+            runMetrics.GetCounter (MET_VERSION_SOFT).Add ();
+        }
+        else {
+            runMetrics.GetCounter (MET_VERSION_MISS).Add ();
+        }
+    }
+    limiter.Release ();
+
+} /* End of VersionTask () */
+
+
+/*
+ * This function detects the version of every open port not yet identified, with the native service probes run as
+ * tasks of an event loop driven by the calling thread. The NMAP script scan of the ports whose version is detected
+ * runs without -sV.
+ * :arg: probes, ServiceProbes object holding the loaded database.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: concurrency, integer denoting the number of ports probed at once, default value is SP_CONCURRENCY.
+ * :return: integer denoting the number of ports whose version has been detected.
+ */
+int Host::DetectVersions (const ServiceProbes &probes, Logger objLog, const CancelToken &token, int concurrency) {
+
+    /* module = MOD_SERVICE_PROBES */
+    ScopedTimer phaseTimer (MET_PHASE_VERSION, address);
+    auto completed = [](const Port &port, const std::string &scan) {
+        return std::find (port.scansCompleted.begin (), port.scansCompleted.end (), scan) != port.scansCompleted.end ();
+    };
+    size_t attempted = 0;
+    EventLoop loop;
+    Limiter limiter (loop, static_cast <size_t> (std::max (concurrency, 1)));
+    for (Port &port : Unstaged ()) {
+        if (port.protocol != PROTO_TCP || completed (port, SCAN_BANNER) || completed (port, SCAN_VERSION)) { continue; }
+        loop.Spawn (VersionTask (loop, limiter, port, objLog, token, probes));
+        attempted++;
+    }
+    loop.Run ();
+
+    int identified = static_cast <int> (std::ranges::count_if (Unstaged (), [&](const Port &port) {
+        return completed (port, SCAN_VERSION);
+    }));
+    std::stringstream optional;
+    optional << identified << " of " << attempted << " port(s) identified by the service probes.";
+    objLog.Log (INFO, MOD_SERVICE_PROBES, SERVICE_VERSION_INFO, true, optional);
+    return identified;
+
+} /* End of DetectVersions () */
+
+
+/*
+ * This function fingerprints the web service of a port once the limiter lets it in. A port not yet identified takes
+ * its product & version from the Server header, e.g. "nginx/1.18.0".
+ * :arg: loop, EventLoop object running the task.
+ * :arg: limiter, Limiter object capping the number of ports fingerprinted at once.
+ * :arg: port, Port object to be fingerprinted.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: paths, const vector of strings holding the paths to fetch.
+ */
+Task <> Host::HTTPTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token,
+                        const std::vector <std::string> &paths) {
+
+    co_await limiter.Acquire ();
+    if (!token.IsCancelled ()) {
+        ScopedTimer portTimer (MET_HTTP_PORT, address + ":" + port.portid, true);
+        bool encrypted = IsTLSService (port.service, port.portid);
+        port.http = co_await FetchHTTP (loop, address, port.portid, paths, encrypted, token);
+        portTimer.Stop ();
+        runMetrics.GetCounter (MET_HTTP_REQUESTS).Add (port.http.requests);
+        runMetrics.GetCounter (MET_HTTP_CONNECTIONS).Add (port.http.connections);
+        if (port.http.fetched) {
+            if (!IsHTTPService (port.service, "") || port.service == "ssl") {
+                port.service = encrypted ? "https" : "http";
+            }
+            const std::string &server = port.http.responses.front ().server;
+            if (port.product.empty () && !server.empty ()) {
+                std::string product = server.substr (0, server.find (' '));
+                size_t slash = product.find ('/');
+                port.product = product.substr (0, slash);
+                if (slash != std::string::npos) { port.version = product.substr (slash + 1); }
+            }
+            std::stringstream optional;
+            optional << "Port: " << port.portid << ",";
+            for (const HTTPResponse &response : port.http.responses) {
+                optional << " " << response.path << " (" << response.status << ")";
+            }
+            optional << " over " << port.http.connections << " connection(s)";
+            objLog.Log (INFO, MOD_HTTP, HTTP_PORT_INFO, false, optional);
+            /* A response alone does not identify the service, such a port is still left to NMAP */
+            if (!port.product.empty () && !port.version.empty ()) { port.scansCompleted.push_back (SCAN_HTTP); }
+        }
+    }
+    limiter.Release ();
+
+} /* End of HTTPTask () */
+
+
+/*
+ * This function fingerprints every open port serving HTTP, as tasks of an event loop driven by the calling thread:
+ * the given paths are fetched with pipelined requests over a keep-alive connection per port, TLS wrapped on the ports
+ * speaking it. Ports fingerprinted this way skip the NMAP script scan.
+ * :arg: paths, const vector of strings holding the paths to fetch, which must outlive the call.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: concurrency, integer denoting the number of ports fingerprinted at once, default value is HTTP_CONCURRENCY.
+ * :return: integer denoting the number of ports which answered over HTTP.
+ */
+int Host::FingerprintHTTP (const std::vector <std::string> &paths, Logger objLog, const CancelToken &token,
+                           int concurrency) {
+
+    /* module = MOD_HTTP */
+    ScopedTimer phaseTimer (MET_PHASE_HTTP, address);
+    size_t attempted = 0;
+    EventLoop loop;
+    Limiter limiter (loop, static_cast <size_t> (std::max (concurrency, 1)));
+    for (Port &port : Unstaged ()) {
+        if (port.protocol != PROTO_TCP || !IsHTTPService (port.service, port.portid)) { continue; }
+        loop.Spawn (HTTPTask (loop, limiter, port, objLog, token, paths));
+        attempted++;
+    }
+    loop.Run ();
+
+    int fingerprinted = static_cast <int> (std::ranges::count_if (Unstaged (), [](const Port &port) {
+        return port.http.fetched;
+    }));
+    std::stringstream optional;
+    optional << fingerprinted << " of " << attempted << " web port(s) fingerprinted.";
+    objLog.Log (INFO, MOD_HTTP, HTTP_FINGERPRINT_INFO, true, optional);
+    return fingerprinted;
+
+} /* End of FingerprintHTTP () */
+
+
+/*
+ * This function runs the deep NMAP script scan of a port once the limiter lets it in, then checkpoints the result and
+ * notifies the observer. Ports still waiting when cancellation is requested are not scanned.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: limiter, Limiter object capping the number of scans running at once.
+ * :arg: port, Port object to be scanned.
  * :arg: objFile, Logger object to which the messages are to be logged.
- * :arg: maxThreads, integer denoting the number of threads, default value is MAX_THREADS (20).
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: engine, SignatureEngine object used to classify the output of each script.
+ * :arg: templates, CommandTemplates object the NMAP command is rendered from.
+ */
+Task <> Host::ScanPortTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objFile, const CancelToken &token,
+                            const SignatureEngine &engine, const CommandTemplates &templates) {
+
+    co_await limiter.Acquire ();
+    if (!token.IsCancelled ()) {
+        Gauge &active = runMetrics.GetGauge (MET_DEEP_ACTIVE);
+        active.Add (1);
+        int result = co_await port.NMAPScriptScanAsync (loop, address, objFile, token, engine, templates);
+        active.Add (-1);
+        if (result == NMAP_SCRIPT_PASS && journal) { journal->RecordDeepScan (address, port); }
+        if (observer) { observer->PortScanned (address, port); }
+    }
+    limiter.Release ();
+
+} /* End of ScanPortTask () */
+
+
+/*
+ * This function runs the deep NMAP script scan of every open port as tasks of an event loop driven by the calling
+ * thread, with at most maxThreads NMAP children running at once. Ports still waiting are not scanned once
+ * cancellation is requested, while scans already running reap their NMAP processes and return. Ports identified from
+ * their banners or fingerprinted over HTTP are not scanned.
+ * :arg: objFile, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: maxThreads, integer denoting the number of concurrent scans, default value is MAX_THREADS (20).
  * :return: ReturnCodes object denoting the success/failure of the operation.
  */
-int Host::MultitreadedNMAPScript (Logger objFile, int maxThreads) {
+int Host::MultitreadedNMAPScript (Logger objFile, const CancelToken &token, int maxThreads) {
 
     /* module = MOD_MULTI_SCAN */
-    std::vector <std::thread> threads;
+    ScopedTimer phaseTimer (MET_PHASE_DEEP, address);
+    std::vector <Port *> pending;
+    const SignatureEngine builtIn {};
+    const SignatureEngine &engine = signatures ? *signatures : builtIn;
+    const CommandTemplates builtInTemplates {};
+    const CommandTemplates &templates = commandTemplates ? *commandTemplates : builtInTemplates;
     objFile.Log (INFO, MOD_MULTI_SCAN, MT_NMAP_SCRIPT_INFO, true);
-    threads.reserve (std::min (maxThreads, static_cast <int> (openPorts.size ())));
+    const JournalHost *restored = journal ? journal->Find (address) : nullptr;
     
-    for (Port &port : openPorts) {
-        threads.emplace_back ([&]() {
-            {
-                std::lock_guard <std::mutex> lock (mtx);
-                port.NMAPScriptScan (this->address, objFile);
-            }
-        });
+    for (Port &port : Unstaged ()) {
+        /* Skip ports whose deep scan has already been completed by an earlier run */
+        if (restored && restored->completed.count (port.Key ())) {
+            std::stringstream optional;
+            optional << "Port: " << port.Key ();
+            port.RestoreDeepScan (restored->completed.at (port.Key ()));
+            objFile.Log (INFO, MOD_JOURNAL, JOURNAL_PORT_INFO, false, optional);
+            runMetrics.GetCounter (MET_DEEP_RESTORED).Add ();
+            if (observer) { observer->PortScanned (address, port); }
+            continue;
+        }
+        /* Ports identified from their banners or fingerprinted over HTTP need no NMAP child */
+        if (std::find_if (port.scansCompleted.begin (), port.scansCompleted.end (), [](const std::string &scan) {
+                return scan == SCAN_BANNER || scan == SCAN_HTTP;
+            }) != port.scansCompleted.end ()) {
+            runMetrics.GetCounter (MET_DEEP_SKIPPED).Add ();
+            if (observer) { observer->PortScanned (address, port); }
+            continue;
+        }
+        pending.push_back (&port);
     }
 
-    for (std::thread &thread : threads) {
-        if (thread.joinable ()) {
-            thread.join ();
-        }
+    size_t workers = std::min (static_cast <size_t> (std::max (maxThreads, 1)), pending.size ());
+    runMetrics.GetGauge (MET_DEEP_WORKERS).Set (static_cast <int64_t> (workers));
+    EventLoop loop;
+    Limiter limiter (loop, workers);
+    for (Port *port : pending) { loop.Spawn (ScanPortTask (loop, limiter, *port, objFile, token, engine, templates)); }
+    loop.Run ();
+
+    /* Host level findings are reported by each port's scan, keep a single copy of each */
+    for (const Port &port : Unstaged ()) {
+        hostFindings.insert (hostFindings.end (), port.hostFindings.begin (), port.hostFindings.end ());
+    }
+    RankFindings (hostFindings);
+    if (token.IsCancelled ()) {
+        objFile.Log (INFO, MOD_MULTI_SCAN, SCAN_CANCEL_INFO, true);
+        objFile.Log (FAIL, MOD_MULTI_SCAN, MT_NMAP_SCRIPT_FAIL, true);
+        return MT_NMAP_SCRIPT_FAIL;
     }
     objFile.Log (PASS, MOD_MULTI_SCAN, MT_NMAP_SCRIPT_PASS, true);
     return MT_NMAP_SCRIPT_PASS;
 } /* End of MultitreadedNMAPScript () */
 
 
-void Host::PrintDeepScanSummary (Logger objFile) {
+/*
+ * This function inspects the TLS service of a port once the limiter lets it in.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: limiter, Limiter object capping the number of ports inspected at once.
+ * :arg: port, Port object to be inspected.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ */
+Task <> Host::TLSTask (EventLoop &loop, Limiter &limiter, Port &port, Logger objLog, const CancelToken &token) {
+
+    co_await limiter.Acquire ();
+    if (!token.IsCancelled ()) {
+        ScopedTimer portTimer (MET_TLS_PORT, address + ":" + port.portid, true);
+        port.tls = co_await InspectTLS (loop, address, port.portid, token);
+        portTimer.Stop ();
+        runMetrics.GetCounter (MET_TLS_HANDSHAKES).Add (port.tls.handshakes);
+        if (port.tls.handshake) {
+            std::stringstream optional;
+            optional << "Port: " << port.portid << ",";
+            for (const TLSProtocol &protocol : port.tls.protocols) {
+                optional << " " << protocol.name << " (" << protocol.ciphers.size () << " cipher(s))";
+            }
+            objLog.Log (INFO, MOD_TLS, TLS_PORT_INFO, false, optional);
+            port.scansCompleted.push_back (SCAN_TLS);
+        }
+    }
+    limiter.Release ();
+
+} /* End of TLSTask () */
+
+
+/*
+ * This function inspects every open port speaking TLS, as tasks of an event loop driven by the calling thread: the
+ * protocol versions & cipher suites it accepts and its certificate chain. It runs once the NMAP script scan has named
+ * the services, so ports found to tunnel over SSL by -sV are included.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: concurrency, integer denoting the number of ports inspected at once, default value is TLS_CONCURRENCY.
+ * :return: integer denoting the number of ports which completed a handshake.
+ */
+int Host::InspectTLSPorts (Logger objLog, const CancelToken &token, int concurrency) {
+
+    /* module = MOD_TLS */
+    if (!TLSAvailable ()) {
+        objLog.Log (FAIL, MOD_TLS, TLS_INSPECT_FAIL, true);
+        return 0;
+    }
+    ScopedTimer phaseTimer (MET_PHASE_TLS, address);
+    size_t attempted = 0;
+    EventLoop loop;
+    Limiter limiter (loop, static_cast <size_t> (std::max (concurrency, 1)));
+    for (Port &port : Unstaged ()) {
+        if (port.protocol != PROTO_TCP || !IsTLSService (port.service, port.portid)) { continue; }
+        loop.Spawn (TLSTask (loop, limiter, port, objLog, token));
+        attempted++;
+    }
+    loop.Run ();
+
+    int inspected = static_cast <int> (std::ranges::count_if (Unstaged (), [](const Port &port) {
+        return port.tls.handshake;
+    }));
+    std::stringstream optional;
+    optional << inspected << " of " << attempted << " TLS port(s) completed a handshake.";
+    objLog.Log (PASS, MOD_TLS, TLS_INSPECT_PASS, true, optional);
+    return inspected;
+
+} /* End of InspectTLSPorts () */
+
+
+/*
+ * This function matches the product & version identified on every open port against the offline CVE index.
+ * :arg: index, CVEIndex object holding the mapped index.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ */
+void Host::MatchKnownCVEs (const CVEIndex &index, Logger objLog) {
+
+    /* module = MOD_CVE_INDEX */
+    ScopedTimer matchTimer (MET_CVE_MATCH, address);
+    std::vector <Port *> ports;
+    std::stringstream optional;
+    for (Port &port : Unstaged ()) { ports.push_back (&port); }
+    optional << index.MatchPorts (ports) << " of " << ports.size () << " open port(s) have known CVEs.";
+    objLog.Log (INFO, MOD_CVE_INDEX, CVE_MATCH_INFO, true, optional);
+
+} /* End of MatchKnownCVEs () */
+
+
+/*
+ * This function adds every CPE identified on the open ports of the host to the given fleet-wide index.
+ * :arg: index, CPEIndex object to which the ports are added.
+ */
+void Host::IndexCPEs (CPEIndex &index) const {
+
+    for (const Port &port : openPorts) {
+        for (const CPE &cpe : port.cpes) { index.Add (address, port.Key (), cpe); }
+    }
+
+} /* End of IndexCPEs () */
+
+
+/*
+ * This function prints a summary of the script scan of every open port, along with the findings of the host.
+ * :arg: objFile, Logger object to which the messages are to be logged.
+ * :arg: out, ostream to which the summary is printed, default value is STDOUT.
+ */
+void Host::PrintDeepScanSummary (Logger objFile, std::ostream &out) const {
 
     /* module = MOD_DEEP_SUM; */
+    ScopedTimer summaryTimer (MET_DEEP_SUM);
     if (numOpen > 0) {
         objFile.Log (INFO, MOD_DEEP_SUM, NMAP_SCRIPT_SUM_INFO, false);
-        std::cout << "\tNMAP Script Scan Summary\n";
+        out << "\tNMAP Script Scan Summary\n";
         for (const auto &port : openPorts) {
-            std::cout << "\t\t" << BLU << "[+] " << RST;
-            std::cout << std::setw (5) << std::right << port.portid << " : " << port.service << std::endl;
-            std::cout << "\t\t   ";
-            std::cout << port.product << " " << port.version << std::endl;
+            out << "\t\t" << BLU << "[+] " << RST;
+            out << std::setw (5) << std::right << port.Key () << " : " << port.service << std::endl;
+            out << "\t\t   ";
+            out << port.product << " " << port.version;
+            if (!port.extraInfo.empty ()) { out << " (" << port.extraInfo << ")"; }
+            out << std::endl;
+            for (const CPE &cpe : port.cpes) { out << "\t\t   " << cpe.ToString () << std::endl; }
+            if (port.usage.valid) { out << "\t\t   NMAP child: " << FormatChildUsage (port.usage) << std::endl; }
+            if (!port.banner.empty ()) { out << "\t\t   Banner: " << port.banner << std::endl; }
             /* Vuln Scan Summary */
-            if (port.vulnerabilities.size () < 1) {
-                std::cout << "\t\t   No known vulnerabilities found from NMAP script scan.\n";
+            bool scripted = std::find (port.scansCompleted.begin (), port.scansCompleted.end (), SCAN_NMAP_VULN) !=
+                            port.scansCompleted.end ();
+            if (!scripted && std::find (port.scansCompleted.begin (), port.scansCompleted.end (), SCAN_BANNER) !=
+                             port.scansCompleted.end ()) {
+                out << "\t\t   Identified from its banner, NMAP script scan skipped.\n";
+            }
+            else if (!scripted && port.http.fetched) {
+                out << "\t\t   Fingerprinted over HTTP, NMAP script scan skipped.\n";
+            }
+            else if (!scripted) {
+                out << "\t\t   NMAP script scan did not complete, results are partial.\n";
+            }
+            else if (port.vulnerabilities.size () < 1) {
+                out << "\t\t   No known vulnerabilities found from NMAP script scan.\n";
             }
             else {
-                std::cout << "\t\t   Vulnerabilities identified\n\t\t\t";
+                out << "\t\t   Vulnerabilities identified (" << SeverityName (port.severity) << ")\n\t\t\t";
                 for (size_t index = 0; index < port.vulnerabilities.size (); index++) {
-                    std::cout << port.vulnerabilities [index];
-                    if (index < port.vulnerabilities.size () - 1) { std::cout << ", "; }
+                    out << port.vulnerabilities [index];
+                    if (index < port.vulnerabilities.size () - 1) { out << ", "; }
+                }
+                out << std::endl;
+                if (!port.cves.empty ()) {
+                    out << "\t\t   CVEs\n\t\t\t";
+                    for (size_t index = 0; index < port.cves.size (); index++) {
+                        out << port.cves [index];
+                        if (index < port.cves.size () - 1) { out << ", "; }
+                    }
+                    out << std::endl;
                 }
-                std::cout << std::endl;
+            }
+            /* HTTP Summary */
+            for (const HTTPResponse &response : port.http.responses) {
+                out << "\t\t   GET " << response.path << " : " << response.status << ", " << response.bodyBytes
+                    << " bytes";
+                if (!response.contentType.empty ()) { out << " of " << response.contentType; }
+                if (!response.title.empty ()) { out << ", \"" << response.title << "\""; }
+                out << std::endl;
+                if (!response.server.empty ()) { out << "\t\t\tServer: " << response.server << std::endl; }
+                if (!response.poweredBy.empty ()) { out << "\t\t\tPowered by: " << response.poweredBy << std::endl; }
+                if (!response.location.empty ()) { out << "\t\t\tRedirects to: " << response.location << std::endl; }
+                if (!response.authenticate.empty ()) {
+                    out << "\t\t\tAuthentication: " << response.authenticate << std::endl;
+                }
+                out << "\t\t\tBody hash: " << response.bodyHash << std::endl;
+            }
+            if (port.http.hasFavicon) { out << "\t\t   Favicon hash: " << port.http.faviconHash << std::endl; }
+            /* TLS Summary */
+            for (const TLSProtocol &protocol : port.tls.protocols) {
+                out << "\t\t   " << protocol.name << " (" << protocol.ciphers.size () << " cipher(s))\n\t\t\t";
+                for (size_t index = 0; index < protocol.ciphers.size (); index++) {
+                    out << protocol.ciphers [index];
+                    if (index < protocol.ciphers.size () - 1) { out << ", "; }
+                }
+                out << std::endl;
+            }
+            for (size_t index = 0; index < port.tls.chain.size (); index++) {
+                const TLSCertificate &certificate = port.tls.chain [index];
+                out << "\t\t   Certificate " << index << ": " << certificate.subject << std::endl;
+                out << "\t\t\tIssuer: " << certificate.issuer << std::endl;
+                out << "\t\t\tValid: " << certificate.notBefore << " to " << certificate.notAfter
+                    << (certificate.expired ? " (expired)" : "") << std::endl;
+                out << "\t\t\tKey: " << certificate.keyType << " " << certificate.keyBits << " bits, signed with "
+                    << certificate.signature << std::endl;
+                if (!certificate.altNames.empty ()) {
+                    out << "\t\t\tNames: ";
+                    for (size_t name = 0; name < certificate.altNames.size (); name++) {
+                        out << certificate.altNames [name];
+                        if (name < certificate.altNames.size () - 1) { out << ", "; }
+                    }
+                    out << std::endl;
+                }
+                out << "\t\t\tSHA-256: " << certificate.sha256 << std::endl;
+            }
+            /* Structured Findings Summary */
+            for (const Finding &finding : port.findings) {
+                if (finding.state == FINDING_NOT_VULNERABLE) { continue; }
+                out << "\t\t   " << FormatFinding (finding) << std::endl;
+            }
+            /* Known CVE Summary */
+            if (!port.knownCVEs.empty ()) {
+                std::stringstream score;
+                score << std::fixed << std::setprecision (1) << port.knownScore;
+                out << "\t\t   Known CVEs for " << port.product << " " << port.version << " (max CVSS "
+                          << score.str () << ")\n\t\t\t";
+                for (size_t index = 0; index < port.knownCVEs.size (); index++) {
+                    out << port.knownCVEs [index];
+                    if (index < port.knownCVEs.size () - 1) { out << ", "; }
+                }
+                out << std::endl;
             }
         }
+        if (!hostFindings.empty ()) {
+            out << "\t\tHost Findings\n";
+            for (const Finding &finding : hostFindings) {
+                if (finding.state == FINDING_NOT_VULNERABLE) { continue; }
+                out << "\t\t   " << FormatFinding (finding) << std::endl;
+            }
+        }
+    }
+} /* End of PrintDeepScanSummary () */
+
+
+/*
+ * This function looks up the given CPE prefix across every scanned host and prints the ports exposing it.
+ * :arg: index, CPEIndex object holding the CPEs of every scanned host.
+ * :arg: prefix, const string holding the CPE prefix to be looked up.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ */
+void PrintCPEQuery (const CPEIndex &index, const std::string &prefix, Logger objLog) {
+
+    /* module = MOD_CPE_INDEX */
+    std::vector <PortRef> refs = index.Find (prefix);
+    std::stringstream optional;
+    optional << prefix << " is exposed on " << refs.size () << " port(s).";
+    objLog.Log (INFO, MOD_CPE_INDEX, CPE_QUERY_INFO, true, optional);
+    for (const auto &ref : refs) {
+        std::cout << "\t" << BLU << "[+] " << RST << ref.address << ":" << ref.portid << std::endl;
     }
-} /* End of PrintDeepScanSummary () */
\ No newline at end of file
+
+} /* End of PrintCPEQuery () */
@@ -0,0 +1,598 @@
+/*
+ ***********************************************************************************************************************
+ * File: serviceprobes.cpp
+ * Description: This file contains definitions of member functions & support functions of the native service-probe
+ *              engine: parsing of the nmap-service-probes database, compilation of its match patterns and the
+ *              probe/match protocol run against each port.
+ * Functions:
+ *           string DecodeEscapes ()
+ *           bool ParsePortList ()
+ *           bool ParseDelimited ()
+ *           string FillVersionField ()
+ *           void FillVerdict ()
+ *           class ServiceProbes
+ *              ServiceProbes ()
+ *              ReturnCodes Load ()
+ *              size_t LoadFromString ()
+ *              bool IsLoaded ()
+ *              size_t NumProbes ()
+ *              size_t NumMatches ()
+ *              size_t NumRejected ()
+ *              bool IsExcluded ()
+ *              bool MatchProbe ()
+ *              bool Match ()
+ *              Task <ServiceVerdict> Detect ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "banner.hpp"
+#include "serviceprobes.hpp"
+#include "utilities.hpp"
+#ifdef PORTHAWK_HAVE_RE2
+#include <re2/re2.h>
+#include <re2/set.h>
+#endif
+
+/* Cancellation is checked at least this often while a probe waits for its response */
+const int SP_CANCEL_SLICE_MS = 250;
+
+#ifdef PORTHAWK_HAVE_RE2
+/* Compiled patterns, per probe & per match. A rejected pattern, one RE2 cannot compile, has no regex. Each set maps
+ * its indices to those of the matches it holds. */
+struct ServiceProbes::Compiled {
+    std::vector <std::vector <std::unique_ptr <RE2>>> regexes;
+    std::vector <std::vector <std::pair <RE2::Set, std::vector <size_t>>>> sets;
+};
+#else
+struct ServiceProbes::Compiled {};
+#endif
+
+
+/*
+ * This function decodes the C style escapes of a probe payload: \\, \0, \a, \b, \f, \n, \r, \t, \v & \xHH.
+ * :arg: text, const string holding the payload as written in the database.
+ * :return: string holding the payload bytes.
+ */
+static std::string DecodeEscapes (const std::string &text) {
+
+    std::string bytes;
+    for (size_t index = 0; index < text.size (); index++) {
+        if (text [index] != '\\' || index + 1 == text.size ()) {
+            bytes.push_back (text [index]);
+            continue;
+        }
+        char escape = text [++index];
+        switch (escape) {
+            case '0': bytes.push_back ('\0'); break;
+            case 'a': bytes.push_back ('\a'); break;
+            case 'b': bytes.push_back ('\b'); break;
+            case 'f': bytes.push_back ('\f'); break;
+            case 'n': bytes.push_back ('\n'); break;
+            case 'r': bytes.push_back ('\r'); break;
+            case 't': bytes.push_back ('\t'); break;
+            case 'v': bytes.push_back ('\v'); break;
+            case 'x':
+                if (index + 2 < text.size () && std::isxdigit (text [index + 1]) && std::isxdigit (text [index + 2])) {
+                    bytes.push_back (static_cast <char> (std::stoi (text.substr (index + 1, 2), nullptr, 16)));
+                    index += 2;
+                }
+                break;
+            default: bytes.push_back (escape);
+        }
+    }
+    return bytes;
+
+} /* End of DecodeEscapes () */
+
+
+/*
+ * This function parses a comma separated list of ports & port ranges, e.g. "21,23,1000-1010". Entries prefixed with
+ * a protocol are kept only for TCP ("T:9100-9107"), the "U:" ones are skipped.
+ * :arg: text, const string holding the list.
+ * :arg: ranges, vector to which the ranges of the list are appended.
+ * :return: bool value indicating whether the list is well formed.
+ */
+static bool ParsePortList (const std::string &text, std::vector <std::pair <uint16_t, uint16_t>> &ranges) {
+
+    std::stringstream list (text);
+    std::string entry;
+    bool tcp = true;
+    while (std::getline (list, entry, ',')) {
+        entry.erase (0, entry.find_first_not_of (" \t"));
+        if (entry.size () > 2 && entry [1] == ':') {
+            tcp = entry [0] == 'T';
+            entry.erase (0, 2);
+        }
+        if (!tcp || entry.empty ()) { continue; }
+        size_t dash = entry.find ('-');
+        try {
+            int low = std::stoi (entry.substr (0, dash));
+            int high = (dash == std::string::npos) ? low : std::stoi (entry.substr (dash + 1));
+            if (low < 0 || high > 65535 || low > high) { return false; }
+            ranges.emplace_back (static_cast <uint16_t> (low), static_cast <uint16_t> (high));
+        }
+        catch (const std::exception &) { return false; }
+    }
+    return true;
+
+} /* End of ParsePortList () */
+
+
+/*
+ * This function reads a field written as <letter><delimiter><value><delimiter>, the way NMAP writes q|...|, m|...| &
+ * p/.../. The delimiter is any character and cannot appear in the value.
+ * :arg: text, const string holding the line.
+ * :arg: position, reference to the index of the delimiter, moved past the closing delimiter.
+ * :arg: value, string to which the value is copied.
+ * :return: bool value indicating whether the closing delimiter has been found.
+ */
+static bool ParseDelimited (const std::string &text, size_t &position, std::string &value) {
+
+    if (position >= text.size ()) { return false; }
+    char delimiter = text [position];
+    size_t end = text.find (delimiter, position + 1);
+    if (end == std::string::npos) { return false; }
+    value = text.substr (position + 1, end - position - 1);
+    position = end + 1;
+    return true;
+
+} /* End of ParseDelimited () */
+
+
+/*
+ * This function fills a field of a version template with the groups matched by its pattern. $1-$9 are replaced by
+ * the group, $P(n) by its printable characters, $SUBST(n,"from","to") by the group with "from" replaced by "to" and
+ * $I(n,">") by the group read as a big (">") or little ("<") endian unsigned integer.
+ * :arg: field, const string holding the field as written in the database.
+ * :arg: groups, const vector of the groups, groups [0] being the whole match.
+ * :return: string holding the filled field.
+ */
+std::string FillVersionField (const std::string &field, const std::vector <std::string> &groups) {
+
+    auto group = [&groups](size_t number) { return number < groups.size () ? groups [number] : std::string (); };
+    std::string filled;
+    for (size_t index = 0; index < field.size (); index++) {
+        if (field [index] != '$' || index + 1 == field.size ()) {
+            filled.push_back (field [index]);
+            continue;
+        }
+        if (std::isdigit (field [index + 1])) {
+            filled += group (field [++index] - '0');
+            continue;
+        }
+        size_t open = field.find ('(', index);
+        size_t close = field.find (')', index);
+        if (open == std::string::npos || close == std::string::npos || close < open || open + 1 >= field.size () ||
+            !std::isdigit (field [open + 1])) {
+            filled.push_back (field [index]);
+            continue;
+        }
+        std::string function = field.substr (index + 1, open - index - 1);
+        std::string value = group (field [open + 1] - '0');
+        std::vector <std::string> arguments;
+        for (size_t quote = field.find ('"', open); quote != std::string::npos && quote < close;) {
+            size_t end = field.find ('"', quote + 1);
+            if (end == std::string::npos) { break; }
+            arguments.push_back (field.substr (quote + 1, end - quote - 1));
+            quote = field.find ('"', end + 1);
+            /* A quoted ")" moves the end of the call */
+            if (end > close) { close = field.find (')', end); }
+        }
+        if (function == "P") {
+            for (char character : value) {
+                if (character >= 0x20 && character <= 0x7e) { filled.push_back (character); }
+            }
+        }
+        else if (function == "SUBST" && arguments.size () == 2 && !arguments [0].empty ()) {
+            for (size_t at = value.find (arguments [0]); at != std::string::npos;
+                 at = value.find (arguments [0], at + arguments [1].size ())) {
+                value.replace (at, arguments [0].size (), arguments [1]);
+            }
+            filled += value;
+        }
+        else if (function == "I" && arguments.size () == 1 && value.size () <= 8) {
+            uint64_t number = 0;
+            for (size_t byte = 0; byte < value.size (); byte++) {
+                size_t at = (arguments [0] == ">") ? byte : value.size () - 1 - byte;
+                number = (number << 8) | static_cast <uint8_t> (value [at]);
+            }
+            filled += std::to_string (number);
+        }
+        index = close;
+    }
+    return filled;
+
+} /* End of FillVersionField () */
+
+
+/*
+ * This function fills a verdict from the version template of the match which has been hit.
+ * :arg: verdict, ServiceVerdict object to be filled.
+ * :arg: match, const ServiceMatch object which has been hit.
+ * :arg: groups, const vector of the groups matched by its pattern.
+ */
+static void FillVerdict (ServiceVerdict &verdict, const ServiceMatch &match, const std::vector <std::string> &groups) {
+
+    const std::string &info = match.versionInfo;
+    verdict.service = match.service;
+    for (size_t position = 0; position < info.size ();) {
+        if (std::isspace (static_cast <unsigned char> (info [position]))) {
+            position++;
+            continue;
+        }
+        bool cpe = info.compare (position, 4, "cpe:") == 0;
+        char field = info [position];
+        position += cpe ? 4 : 1;
+        std::string value;
+        if (!ParseDelimited (info, position, value)) { break; }
+        /* Skip the flags following a field, e.g. the "a" of cpe:/a:vendor:product/a */
+        while (position < info.size () && std::isalpha (static_cast <unsigned char> (info [position]))) { position++; }
+        value = FillVersionField (value, groups);
+        if (cpe) { verdict.cpes.push_back ("cpe:/" + value); }
+        else if (field == 'p') { verdict.product = value; }
+        else if (field == 'v') { verdict.version = value; }
+        else if (field == 'i') { verdict.info = value; }
+        else if (field == 'h') { verdict.hostname = value; }
+        else if (field == 'o') { verdict.osType = value; }
+        else if (field == 'd') { verdict.deviceType = value; }
+    }
+
+} /* End of FillVerdict () */
+
+
+/*
+ * Instantiates a new object of ServiceProbes class, holding no probes until a database is loaded.
+ */
+ServiceProbes::ServiceProbes () : numMatches (0), numRejected (0) {
+
+} /* End of ServiceProbes () */
+
+
+/*
+ * This function loads & compiles a service probe database, replacing the probes loaded before.
+ * :arg: fileName, const string holding the path of the database, in the nmap-service-probes format.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes ServiceProbes::Load (const std::string &fileName, Logger objLog) {
+
+    /* module = MOD_SERVICE_PROBES */
+    std::stringstream optional;
+#ifndef PORTHAWK_HAVE_RE2
+    optional << "PortHawk has been built without RE2.";
+    objLog.Log (FAIL, MOD_SERVICE_PROBES, SERVICE_PROBES_FAIL, true, optional);
+    return SERVICE_PROBES_FAIL;
+#endif
+    std::ifstream file (fileName, std::ios::binary);
+    std::stringstream database;
+    database << file.rdbuf ();
+    if (!file || LoadFromString (database.str ()) == 0) {
+        optional << "File: " << fileName;
+        objLog.Log (FAIL, MOD_SERVICE_PROBES, SERVICE_PROBES_FAIL, true, optional);
+        return SERVICE_PROBES_FAIL;
+    }
+    optional << probes.size () << " TCP probe(s), " << numMatches << " match(es), " << numRejected
+             << " pattern(s) not supported by RE2, from " << fileName;
+    objLog.Log (PASS, MOD_SERVICE_PROBES, SERVICE_PROBES_PASS, true, optional);
+    return SERVICE_PROBES_PASS;
+
+} /* End of Load () */
+
+
+/*
+ * This function parses & compiles a service probe database held in memory. Only the TCP probes are kept, and the
+ * sslports & tcpwrappedms directives are ignored.
+ * :arg: database, const string holding the database, in the nmap-service-probes format.
+ * :return: number of TCP probes loaded, 0 if the database holds none or RE2 is not available.
+ */
+size_t ServiceProbes::LoadFromString (const std::string &database) {
+
+    std::vector <ServiceProbe> parsed;
+    std::vector <std::pair <uint16_t, uint16_t>> exclusions;
+    std::stringstream lines (database);
+    std::string line;
+    bool tcp = false;
+    while (std::getline (lines, line)) {
+        if (!line.empty () && line.back () == '\r') { line.pop_back (); }
+        if (line.empty () || line [0] == '#') { continue; }
+        size_t space = line.find (' ');
+        std::string directive = line.substr (0, space);
+        std::string rest = (space == std::string::npos) ? "" : line.substr (space + 1);
+        if (directive == "Exclude") {
+            ParsePortList (rest, exclusions);
+        }
+        else if (directive == "Probe") {
+            /* Probe <protocol> <name> q|<payload>| */
+            std::stringstream fields (rest);
+            std::string protocol;
+            ServiceProbe probe;
+            fields >> protocol >> probe.name;
+            size_t position = rest.find (" q", protocol.size () + probe.name.size ());
+            std::string payload;
+            tcp = protocol == "TCP" && position != std::string::npos;
+            if (!tcp) { continue; }
+            position += 2;
+            tcp = ParseDelimited (rest, position, payload);
+            if (!tcp) { continue; }
+            probe.payload = DecodeEscapes (payload);
+            if (probe.name == SP_NULL_PROBE) { probe.rarity = 1; }
+            parsed.push_back (probe);
+        }
+        else if (!tcp || parsed.empty ()) {
+            continue;
+        }
+        else if (directive == "match" || directive == "softmatch") {
+            /* [soft]match <service> m|<pattern>|[flags] [<version info>] */
+            ServiceMatch match;
+            size_t position = rest.find (' ');
+            if (position == std::string::npos || rest.compare (position + 1, 1, "m") != 0) { continue; }
+            match.service = rest.substr (0, position);
+            match.soft = directive == "softmatch";
+            position += 2;
+            std::string pattern;
+            if (!ParseDelimited (rest, position, pattern)) { continue; }
+            std::string flags;
+            while (position < rest.size () && (rest [position] == 'i' || rest [position] == 's')) {
+                flags.push_back (rest [position++]);
+            }
+            /* RE2 takes the flags inline, so every pattern of a probe can share a set */
+            if (!flags.empty ()) { pattern = "(?" + flags + ")" + pattern; }
+            match.pattern = pattern;
+            if (position < rest.size ()) { match.versionInfo = rest.substr (position + 1); }
+            parsed.back ().matches.push_back (match);
+        }
+        else if (directive == "ports") {
+            ParsePortList (rest, parsed.back ().ports);
+        }
+        else if (directive == "rarity") {
+            parsed.back ().rarity = std::atoi (rest.c_str ());
+        }
+        else if (directive == "totalwaitms") {
+            parsed.back ().waitMs = std::max (std::atoi (rest.c_str ()), 1);
+        }
+        else if (directive == "fallback") {
+            std::stringstream names (rest);
+            std::string name;
+            while (std::getline (names, name, ',')) { parsed.back ().fallbackNames.push_back (name); }
+        }
+    }
+    for (ServiceProbe &probe : parsed) {
+        for (const std::string &name : probe.fallbackNames) {
+            for (size_t index = 0; index < parsed.size (); index++) {
+                if (parsed [index].name == name) { probe.fallbacks.push_back (index); }
+            }
+        }
+    }
+
+#ifdef PORTHAWK_HAVE_RE2
+    auto built = std::make_shared <Compiled> ();
+    RE2::Options options;
+    options.set_encoding (RE2::Options::EncodingLatin1);
+    options.set_log_errors (false);
+    size_t matches = 0;
+    size_t rejected = 0;
+    for (const ServiceProbe &probe : parsed) {
+        auto &regexes = built->regexes.emplace_back ();
+        auto &sets = built->sets.emplace_back ();
+        for (size_t index = 0; index < probe.matches.size (); index++) {
+            auto regex = std::make_unique <RE2> (probe.matches [index].pattern, options);
+            matches++;
+            if (sets.empty () || sets.back ().second.size () == SP_SET_CHUNK) {
+                sets.emplace_back (RE2::Set (options, RE2::UNANCHORED), std::vector <size_t> {});
+            }
+            /* Backreferences & lookarounds are beyond RE2, such patterns are left out */
+            if (!regex->ok () || sets.back ().first.Add (probe.matches [index].pattern, nullptr) < 0) {
+                regexes.emplace_back ();
+                rejected++;
+                continue;
+            }
+            sets.back ().second.push_back (index);
+            regexes.push_back (std::move (regex));
+        }
+        for (auto &set : sets) { set.first.Compile (); }
+    }
+    if (parsed.empty ()) { return 0; }
+    probes = std::move (parsed);
+    excluded = std::move (exclusions);
+    compiled = built;
+    numMatches = matches;
+    numRejected = rejected;
+    return probes.size ();
+#else
+    return 0;
+#endif
+
+} /* End of LoadFromString () */
+
+
+/*
+ * Trivial accessors of the loaded database.
+ */
+bool ServiceProbes::IsLoaded () const { return compiled != nullptr; } /* End of IsLoaded () */
+size_t ServiceProbes::NumProbes () const { return probes.size (); } /* End of NumProbes () */
+size_t ServiceProbes::NumMatches () const { return numMatches; } /* End of NumMatches () */
+size_t ServiceProbes::NumRejected () const { return numRejected; } /* End of NumRejected () */
+
+
+/*
+ * This function checks whether a port is excluded from version detection by the Exclude directive.
+ * :arg: port, unsigned 16 bit integer holding the port.
+ * :return: bool value indicating whether the port is excluded.
+ */
+bool ServiceProbes::IsExcluded (uint16_t port) const {
+
+    for (const auto &range : excluded) {
+        if (port >= range.first && port <= range.second) { return true; }
+    }
+    return false;
+
+} /* End of IsExcluded () */
+
+
+/*
+ * This function matches a response against the matches of a single probe, in the order of the database. The sets
+ * select the candidate patterns in one pass, which are then run on their own to extract their groups. A softmatch is
+ * recorded, unless one has already been, while looking on for a match.
+ * :arg: index, size_t holding the index of the probe.
+ * :arg: response, const string holding the bytes received.
+ * :arg: verdict, ServiceVerdict object to which the outcome is copied.
+ * :return: bool value indicating whether a match, not a softmatch, has been hit.
+ */
+bool ServiceProbes::MatchProbe (size_t index, const std::string &response, ServiceVerdict &verdict) const {
+
+#ifdef PORTHAWK_HAVE_RE2
+    const auto &regexes = compiled->regexes [index];
+    std::vector <size_t> candidates;
+    for (const auto &[set, members] : compiled->sets [index]) {
+        std::vector <int> hits;
+        RE2::Set::ErrorInfo error {RE2::Set::kNoError};
+        if (set.Match (response, &hits, &error)) {
+            for (int hit : hits) { candidates.push_back (members [hit]); }
+        }
+        /* The DFA of a set may run out of memory on a long response, every member is a candidate then */
+        else if (error.kind != RE2::Set::kNoError) {
+            candidates.insert (candidates.end (), members.begin (), members.end ());
+        }
+    }
+    std::sort (candidates.begin (), candidates.end ());
+    for (size_t candidate : candidates) {
+        const RE2 &regex = *regexes [candidate];
+        const ServiceMatch &match = probes [index].matches [candidate];
+        int numGroups = regex.NumberOfCapturingGroups () + 1;
+        std::vector <re2::StringPiece> pieces (numGroups);
+        if (!regex.Match (response, 0, response.size (), RE2::UNANCHORED, pieces.data (), numGroups)) { continue; }
+        if (match.soft) {
+            if (!verdict.soft) {
+                verdict.soft = true;
+                verdict.service = match.service;
+                verdict.probe = probes [index].name;
+            }
+            continue;
+        }
+        std::vector <std::string> groups;
+        for (const auto &piece : pieces) { groups.emplace_back (piece.data () ? std::string (piece) : std::string ()); }
+        FillVerdict (verdict, match, groups);
+        verdict.matched = true;
+        verdict.soft = false;
+        verdict.probe = probes [index].name;
+        return true;
+    }
+#else
+    (void) index;
+    (void) response;
+    (void) verdict;
+#endif
+    return false;
+
+} /* End of MatchProbe () */
+
+
+/*
+ * This function matches the response to a probe against the matches of the probe, then those of its fallbacks and
+ * finally those of the NULL probe, as NMAP does for TCP.
+ * :arg: index, size_t holding the index of the probe which has been sent.
+ * :arg: response, const string holding the bytes received.
+ * :arg: verdict, ServiceVerdict object to which the outcome is copied.
+ * :return: bool value indicating whether a match, not a softmatch, has been hit.
+ */
+bool ServiceProbes::Match (size_t index, const std::string &response, ServiceVerdict &verdict) const {
+
+    if (!compiled || index >= probes.size () || response.empty ()) { return false; }
+    if (MatchProbe (index, response, verdict)) { return true; }
+    for (size_t fallback : probes [index].fallbacks) {
+        if (fallback != index && MatchProbe (fallback, response, verdict)) { return true; }
+    }
+    for (size_t null = 0; null < probes.size (); null++) {
+        if (probes [null].name == SP_NULL_PROBE && null != index) { return MatchProbe (null, response, verdict); }
+    }
+    return false;
+
+} /* End of Match () */
+
+
+/*
+ * This function identifies the service of a port with the probe/match protocol of NMAP, as a task of the given loop.
+ * Each probe is sent over a connection of its own: first the NULL probe, then the probes listing the port and then
+ * those whose rarity is within the intensity. Once a softmatch names the service, only probes able to identify the
+ * product of that service are sent. Detection ends at the first match, when the port stops accepting connections
+ * or when cancellation is requested.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target, which must outlive the task.
+ * :arg: portid, const string holding the port, which must outlive the task.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: intensity, integer denoting the highest rarity of the probes sent to every port, default value is 7.
+ * :return: ServiceVerdict object holding the outcome.
+ */
+Task <ServiceVerdict> ServiceProbes::Detect (EventLoop &loop, const std::string &address, const std::string &portid,
+                                             const CancelToken &token, int intensity) const {
+
+    ServiceVerdict verdict;
+    uint16_t port = static_cast <uint16_t> (std::stoi (portid));
+    if (!compiled || IsExcluded (port)) { co_return verdict; }
+    auto listed = [port](const ServiceProbe &probe) {
+        return std::any_of (probe.ports.begin (), probe.ports.end (), [port](const auto &range) {
+            return port >= range.first && port <= range.second;
+        });
+    };
+    std::vector <size_t> order;
+    for (size_t index = 0; index < probes.size (); index++) {
+        if (probes [index].name == SP_NULL_PROBE) { order.insert (order.begin (), index); }
+        else if (listed (probes [index])) { order.push_back (index); }
+    }
+    for (size_t index = 0; index < probes.size (); index++) {
+        if (probes [index].name != SP_NULL_PROBE && !listed (probes [index]) && probes [index].rarity <= intensity) {
+            order.push_back (index);
+        }
+    }
+
+    char buffer [4096];
+    for (size_t index : order) {
+        const ServiceProbe &probe = probes [index];
+        if (token.IsCancelled ()) { break; }
+        if (verdict.soft && std::none_of (probe.matches.begin (), probe.matches.end (), [&verdict](const auto &match) {
+                return !match.soft && match.service == verdict.service;
+            })) {
+            continue;
+        }
+        int fd = co_await ConnectTCP (loop, address, portid, SP_CONNECT_MS);
+        if (fd < 0) { break; }
+        verdict.probesSent++;
+        bool matched = false;
+        bool open = true;
+        for (size_t sent = 0; sent < probe.payload.size () && open;) {
+            ssize_t bytes = send (fd, probe.payload.data () + sent, probe.payload.size () - sent, MSG_NOSIGNAL);
+            if (bytes >= 0) { sent += bytes; }
+            else if (errno == EAGAIN) { open = co_await loop.Writable (fd, SP_CONNECT_MS); }
+            else if (errno != EINTR) { open = false; }
+        }
+        std::string response;
+        auto deadline = std::chrono::steady_clock::now () + std::chrono::milliseconds (probe.waitMs);
+        while (open && !matched && response.size () < SP_MAX_RESPONSE && !token.IsCancelled ()) {
+            auto remaining = std::chrono::duration_cast <std::chrono::milliseconds> (
+                deadline - std::chrono::steady_clock::now ()).count ();
+            if (remaining <= 0) { break; }
+            if (!co_await loop.Readable (fd, static_cast <int> (std::min <int64_t> (remaining, SP_CANCEL_SLICE_MS)))) {
+                continue;
+            }
+            ssize_t bytes = recv (fd, buffer, std::min (sizeof (buffer), SP_MAX_RESPONSE - response.size ()), 0);
+            if (bytes < 0 && (errno == EINTR || errno == EAGAIN)) { continue; }
+            if (bytes <= 0) { break; }
+            response.append (buffer, bytes);
+            /* Responses are matched as they arrive, so a service answering at once is not waited upon */
+            matched = Match (index, response, verdict);
+        }
+        close (fd);
+        if (matched) { break; }
+    }
+    co_return verdict;
+
+} /* End of Detect () */
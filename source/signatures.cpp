@@ -0,0 +1,232 @@
+/*
+ ***********************************************************************************************************************
+ * File: signatures.cpp
+ * Description: This file contains definitions of support functions & member functions associated with the
+ *              multi-pattern vulnerability signature engine.
+ * Functions:
+ *           string SeverityName ()
+ *           Severity ParseSeverity ()
+ *           class SignatureEngine
+ *              SignatureEngine ()
+ *              void Compile ()
+ *              ReturnCodes Load ()
+ *              size_t LoadFromString ()
+ *              ScriptVerdict Classify ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cctype>
+#include <queue>
+#include "signatures.hpp"
+
+static const std::vector <std::string> SEVERITY_NAMES = {"none", "info", "low", "medium", "high", "critical"};
+
+
+/*
+ * This function returns the printable name of the given severity.
+ * :arg: severity, Severity value to be named.
+ * :return: string holding the name of the severity.
+ */
+const std::string SeverityName (Severity severity) {
+
+    return (severity < SEVERITY_NAMES.size ()) ? SEVERITY_NAMES [severity] : UNKNOWN;
+
+} /* End of SeverityName () */
+
+
+/*
+ * This function converts the given name into its severity.
+ * :arg: name, const string holding the case-insensitive name of the severity.
+ * :return: Severity value, SEV_NONE if the name is not recognised.
+ */
+Severity ParseSeverity (const std::string &name) {
+
+    std::string lower = name;
+    std::transform (lower.begin (), lower.end (), lower.begin (), ::tolower);
+    auto find = std::find (SEVERITY_NAMES.begin (), SEVERITY_NAMES.end (), lower);
+    return (find != SEVERITY_NAMES.end ()) ? static_cast <Severity> (find - SEVERITY_NAMES.begin ()) : SEV_NONE;
+
+} /* End of ParseSeverity () */
+
+
+/*
+ * This is a constructor function for SignatureEngine class. The engine starts out with the default signatures.
+ */
+SignatureEngine::SignatureEngine () : byteClass {}, numClasses (1) {
+
+    LoadFromString (DEFAULT_SIGNATURES);
+
+} /* End of SignatureEngine () */
+
+
+/*
+ * This function compiles the given patterns into a case-insensitive Aho-Corasick automaton. Bytes which appear in no
+ * pattern share a single class, and every transition is resolved ahead of time, so matching costs one table lookup
+ * per byte of input. The node ending a pattern of severity SEV_NONE does not inherit the severity of the patterns it
+ * ends with, which excludes them.
+ * :arg: patterns, const vector of pattern and severity pairs to be compiled.
+ */
+void SignatureEngine::Compile (const std::vector <std::pair <std::string, Severity>> &patterns) {
+
+    /* Byte classes, folding case so matching needs no per-byte conversion */
+    std::fill (std::begin (byteClass), std::end (byteClass), 0);
+    numClasses = 1;
+    for (const auto &pattern : patterns) {
+        for (unsigned char byte : pattern.first) {
+            unsigned char lower = std::tolower (byte);
+            if (byteClass [lower] == 0) {
+                byteClass [lower] = numClasses;
+                byteClass [std::toupper (lower)] = numClasses;
+                numClasses++;
+            }
+        }
+    }
+
+    /* Goto function, as a trie over byte classes */
+    transitions.assign (numClasses, -1);
+    nodeSeverity.assign (1, SEV_NONE);
+    nodeCVE.assign (1, false);
+    std::vector <bool> excluding (1, false);
+    for (const auto &pattern : patterns) {
+        int32_t node = 0;
+        for (unsigned char byte : pattern.first) {
+            int32_t &next = transitions [node * numClasses + byteClass [byte]];
+            if (next < 0) {
+                next = static_cast <int32_t> (nodeSeverity.size ());
+                transitions.resize (transitions.size () + numClasses, -1);
+                nodeSeverity.push_back (SEV_NONE);
+                nodeCVE.push_back (false);
+                excluding.push_back (false);
+            }
+            node = transitions [node * numClasses + byteClass [byte]];
+        }
+        if (pattern.first == SIG_CVE_MARKER) { nodeCVE [node] = true; }
+        else if (pattern.second == SEV_NONE) { excluding [node] = true; }
+        else { nodeSeverity [node] = std::max (nodeSeverity [node], pattern.second); }
+    }
+
+    /* Failure links, folded into the transition table breadth first */
+    std::vector <int32_t> failure (nodeSeverity.size (), 0);
+    std::queue <int32_t> queue;
+    for (int cls = 0; cls < numClasses; cls++) {
+        int32_t &next = transitions [cls];
+        if (next < 0) { next = 0; }
+        else { queue.push (next); }
+    }
+    while (!queue.empty ()) {
+        int32_t node = queue.front ();
+        queue.pop ();
+        if (!excluding [node]) { nodeSeverity [node] = std::max (nodeSeverity [node], nodeSeverity [failure [node]]); }
+        nodeCVE [node] = nodeCVE [node] || nodeCVE [failure [node]];
+        for (int cls = 0; cls < numClasses; cls++) {
+            int32_t &next = transitions [node * numClasses + cls];
+            int32_t fallback = transitions [failure [node] * numClasses + cls];
+            if (next < 0) {
+                next = fallback;
+            } else {
+                failure [next] = fallback;
+                queue.push (next);
+            }
+        }
+    }
+
+} /* End of Compile () */
+
+
+/*
+ * This function loads signatures from the given file, replacing the current ones. The current signatures are kept,
+ * if the file is absent or holds no valid signature.
+ * :arg: fileName, const string holding the path of the signature file.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success or failure of the operation.
+ */
+ReturnCodes SignatureEngine::Load (const std::string &fileName, Logger objLog) {
+
+    std::ifstream input (fileName);
+    std::stringstream content;
+    std::stringstream optional;
+    if (!input) {
+        objLog.Log (INFO, MOD_SIGNATURES, SIG_DEFAULT_INFO, false);
+        return SIG_DEFAULT_INFO;
+    }
+    content << input.rdbuf ();
+    SignatureEngine candidate;
+    size_t count = candidate.LoadFromString (content.str ());
+    if (count == 0) {
+        objLog.Log (FAIL, MOD_SIGNATURES, SIG_LOAD_FAIL, true);
+        return SIG_LOAD_FAIL;
+    }
+    *this = candidate;
+    optional << "Loaded " << count << " signature(s).";
+    objLog.Log (PASS, MOD_SIGNATURES, SIG_LOAD_PASS, false, optional);
+    return SIG_LOAD_PASS;
+
+} /* End of Load () */
+
+
+/*
+ * This function parses the given signatures and compiles them, replacing the current ones. Lines with an unknown
+ * severity or an empty pattern are skipped, those of severity "none" are compiled as exclusions.
+ * :arg: signatures, const string holding the signatures, one "<severity><TAB><pattern>" per line.
+ * :return: number of signatures compiled.
+ */
+size_t SignatureEngine::LoadFromString (const std::string &signatures) {
+
+    std::vector <std::pair <std::string, Severity>> patterns;
+    std::stringstream lines (signatures);
+    std::string line;
+    while (std::getline (lines, line)) {
+        size_t tab = line.find ('\t');
+        if (line.empty () || line [0] == '#' || tab == std::string::npos || tab + 1 >= line.size ()) { continue; }
+        std::string name = line.substr (0, tab);
+        std::transform (name.begin (), name.end (), name.begin (), ::tolower);
+        Severity severity = ParseSeverity (name);
+        if (severity == SEV_NONE && name != SEVERITY_NAMES [SEV_NONE]) { continue; }
+        patterns.emplace_back (line.substr (tab + 1), severity);
+    }
+    if (patterns.empty ()) { return 0; }
+    size_t count = patterns.size ();
+    patterns.emplace_back (SIG_CVE_MARKER, SEV_NONE);
+    Compile (patterns);
+    return count;
+
+} /* End of LoadFromString () */
+
+
+/*
+ * This function classifies the given script output in a single pass, returning the highest severity matched along
+ * with the CVE ids mentioned in it.
+ * :arg: text, const string holding the script output.
+ * :return: ScriptVerdict holding the severity and the de-duplicated, normalised CVE ids.
+ */
+ScriptVerdict SignatureEngine::Classify (const std::string &text) const {
+
+    ScriptVerdict verdict;
+    int32_t node = 0;
+    for (size_t index = 0; index < text.size (); index++) {
+        node = transitions [node * numClasses + byteClass [static_cast <unsigned char> (text [index])]];
+        verdict.severity = std::max (verdict.severity, nodeSeverity [node]);
+        if (!nodeCVE [node]) { continue; }
+        /* "CVE-" has been seen, expect "YYYY-NNNN" with 4 to 7 digits in the sequence number */
+        size_t year = index + 1;
+        size_t number = year + 5;
+        size_t end = number;
+        if (number >= text.size () || text [year + 4] != '-') { continue; }
+        if (!std::all_of (text.begin () + year, text.begin () + year + 4,
+                          [](unsigned char digit) { return std::isdigit (digit); })) { continue; }
+        while (end < text.size () && end - number < 8 && std::isdigit (static_cast <unsigned char> (text [end]))) {
+            end++;
+        }
+        if (end - number < 4 || end - number > 7) { continue; }
+        std::string cve = "CVE-" + text.substr (year, end - year);
+        if (std::find (verdict.cves.begin (), verdict.cves.end (), cve) == verdict.cves.end ()) {
+            verdict.cves.push_back (cve);
+        }
+    }
+    if (!verdict.cves.empty ()) { verdict.severity = std::max (verdict.severity, SEV_CVE_ONLY); }
+    return verdict;
+
+} /* End of Classify () */
@@ -0,0 +1,458 @@
+/*
+ ***********************************************************************************************************************
+ * File: tls.cpp
+ * Description: This file contains definitions of support functions associated with the native TLS inspection of a
+ *              port.
+ * Functions:
+ *           SSL_CTX *ClientContext ()
+ *           string BIOString ()
+ *           void ExtractChain ()
+ *           Task <bool> ConnectSSL ()
+ *           Task <bool> Handshake ()
+ *           bool TLSAvailable ()
+ *           bool IsTLSService ()
+ *           Task <TLSReport> InspectTLS ()
+ *           class NetStream
+ *              NetStream ()
+ *              ~NetStream ()
+ *              Task <bool> Open ()
+ *              Task <bool> Send ()
+ *              Task <ssize_t> Receive ()
+ *              void Close ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "banner.hpp"
+#include "tls.hpp"
+#include "utilities.hpp"
+#ifdef PORTHAWK_HAVE_OPENSSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+/* Protocol versions tried, oldest first */
+static const std::vector <std::pair <int, std::string>> TLS_VERSIONS = {
+    {TLS1_VERSION, "TLSv1.0"},
+    {TLS1_1_VERSION, "TLSv1.1"},
+    {TLS1_2_VERSION, "TLSv1.2"},
+    {TLS1_3_VERSION, "TLSv1.3"},
+};
+/* Every cipher suite OpenSSL knows of, including those disabled by default */
+static const std::string TLS_CIPHERS_ALL = "ALL:COMPLEMENTOFALL:@SECLEVEL=0";
+static const std::vector <std::string> TLS13_SUITES = {
+    "TLS_AES_256_GCM_SHA384", "TLS_CHACHA20_POLY1305_SHA256", "TLS_AES_128_GCM_SHA256", "TLS_AES_128_CCM_SHA256",
+    "TLS_AES_128_CCM_8_SHA256",
+};
+
+
+/*
+ * This function returns the client context shared by every handshake, created on first use. Certificates are not
+ * verified and the security level is lowered, so that legacy protocols & ciphers can be negotiated and reported.
+ * :return: pointer to the SSL_CTX, nullptr if it could not be created.
+ */
+static SSL_CTX *ClientContext () {
+
+    static SSL_CTX *context = []() {
+        SSL_CTX *created = SSL_CTX_new (TLS_client_method ());
+        if (!created) { return created; }
+        SSL_CTX_set_verify (created, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_security_level (created, 0);
+        SSL_CTX_set_options (created, SSL_OP_LEGACY_SERVER_CONNECT | SSL_OP_NO_TICKET);
+        return created;
+    }();
+    return context;
+
+} /* End of ClientContext () */
+
+
+/*
+ * This function drains a memory BIO into a string and frees it.
+ * :arg: bio, pointer to the memory BIO.
+ * :return: string holding the contents of the BIO.
+ */
+static std::string BIOString (BIO *bio) {
+
+    char *data = nullptr;
+    long length = BIO_get_mem_data (bio, &data);
+    std::string text (data ? data : "", length > 0 ? length : 0);
+    BIO_free (bio);
+    return text;
+
+} /* End of BIOString () */
+
+
+/*
+ * This function copies the fields of every certificate of the chain presented by the server, leaf first.
+ * :arg: ssl, pointer to the SSL object of a completed handshake.
+ * :arg: chain, vector to which the certificates are appended.
+ */
+static void ExtractChain (SSL *ssl, std::vector <TLSCertificate> &chain) {
+
+    STACK_OF (X509) *certificates = SSL_get_peer_cert_chain (ssl);
+    for (int index = 0; certificates && index < sk_X509_num (certificates); index++) {
+        X509 *x509 = sk_X509_value (certificates, index);
+        TLSCertificate certificate;
+        BIO *bio = BIO_new (BIO_s_mem ());
+        X509_NAME_print_ex (bio, X509_get_subject_name (x509), 0, XN_FLAG_RFC2253);
+        certificate.subject = BIOString (bio);
+        bio = BIO_new (BIO_s_mem ());
+        X509_NAME_print_ex (bio, X509_get_issuer_name (x509), 0, XN_FLAG_RFC2253);
+        certificate.issuer = BIOString (bio);
+        BIGNUM *serial = ASN1_INTEGER_to_BN (X509_get0_serialNumber (x509), nullptr);
+        if (serial) {
+            char *hex = BN_bn2hex (serial);
+            certificate.serial = hex ? hex : "";
+            OPENSSL_free (hex);
+            BN_free (serial);
+        }
+        bio = BIO_new (BIO_s_mem ());
+        ASN1_TIME_print (bio, X509_get0_notBefore (x509));
+        certificate.notBefore = BIOString (bio);
+        bio = BIO_new (BIO_s_mem ());
+        ASN1_TIME_print (bio, X509_get0_notAfter (x509));
+        certificate.notAfter = BIOString (bio);
+        certificate.expired = X509_cmp_current_time (X509_get0_notAfter (x509)) < 0;
+        /* Algorithms OpenSSL has no name for, e.g. those of a provider not loaded, are reported as unknown */
+        const char *signature = OBJ_nid2ln (X509_get_signature_nid (x509));
+        certificate.signature = signature ? signature : TLS_UNKNOWN_NAME;
+        if (EVP_PKEY *key = X509_get0_pubkey (x509)) {
+            const char *keyType = EVP_PKEY_get0_type_name (key);
+            certificate.keyType = keyType ? keyType : TLS_UNKNOWN_NAME;
+            certificate.keyBits = EVP_PKEY_get_bits (key);
+        }
+        auto *names = static_cast <GENERAL_NAMES *> (X509_get_ext_d2i (x509, NID_subject_alt_name, nullptr, nullptr));
+        for (int name = 0; names && name < sk_GENERAL_NAME_num (names); name++) {
+            const GENERAL_NAME *entry = sk_GENERAL_NAME_value (names, name);
+            if (entry->type == GEN_DNS) {
+                const ASN1_IA5STRING *dns = entry->d.dNSName;
+                certificate.altNames.emplace_back ("DNS:" + std::string (reinterpret_cast <const char *> (
+                    ASN1_STRING_get0_data (dns)), ASN1_STRING_length (dns)));
+            }
+            else if (entry->type == GEN_IPADD && ASN1_STRING_length (entry->d.iPAddress) == 4) {
+                const unsigned char *ip = ASN1_STRING_get0_data (entry->d.iPAddress);
+                certificate.altNames.emplace_back ("IP:" + std::to_string (ip [0]) + "." + std::to_string (ip [1]) +
+                                                   "." + std::to_string (ip [2]) + "." + std::to_string (ip [3]));
+            }
+        }
+        GENERAL_NAMES_free (names);
+        unsigned char digest [EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        if (X509_digest (x509, EVP_sha256 (), digest, &length)) {
+            static const char *HEX = "0123456789ABCDEF";
+            for (unsigned int byte = 0; byte < length; byte++) {
+                if (byte) { certificate.sha256.push_back (':'); }
+                certificate.sha256.push_back (HEX [digest [byte] >> 4]);
+                certificate.sha256.push_back (HEX [digest [byte] & 0xF]);
+            }
+        }
+        chain.push_back (certificate);
+    }
+
+} /* End of ExtractChain () */
+
+
+/*
+ * This function drives the client side of a TLS handshake over a connected non-blocking socket, as a task of the given
+ * loop.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: ssl, pointer to the SSL object, already bound to the socket.
+ * :arg: fd, integer holding the socket.
+ * :arg: timeoutMs, integer denoting the milliseconds given to each round trip of the handshake.
+ * :return: bool value indicating whether the handshake has completed.
+ */
+static Task <bool> ConnectSSL (EventLoop &loop, SSL *ssl, int fd, int timeoutMs) {
+
+    while (true) {
+        int result = SSL_connect (ssl);
+        if (result == 1) { co_return true; }
+        int error = SSL_get_error (ssl, result);
+        bool ready = false;
+        if (error == SSL_ERROR_WANT_READ) { ready = co_await loop.Readable (fd, timeoutMs); }
+        else if (error == SSL_ERROR_WANT_WRITE) { ready = co_await loop.Writable (fd, timeoutMs); }
+        if (!ready) { co_return false; }
+    }
+
+} /* End of ConnectSSL () */
+
+
+/*
+ * This function runs a TLS handshake limited to one protocol version & the given cipher suites, over a connection of
+ * its own, as a task of the given loop.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target.
+ * :arg: portid, const string holding the port.
+ * :arg: version, integer holding the OpenSSL protocol version.
+ * :arg: ciphers, const string holding the cipher list (TLSv1.2 and older) or the cipher suites (TLSv1.3) offered.
+ * :arg: report, TLSReport object counting the handshake, to which the chain is copied if it has none yet.
+ * :arg: cipher, string to which the negotiated cipher suite is copied.
+ * :return: bool value indicating whether the handshake has completed.
+ */
+static Task <bool> Handshake (EventLoop &loop, const std::string &address, const std::string &portid, int version,
+                              const std::string &ciphers, TLSReport &report, std::string &cipher) {
+
+    SSL_CTX *context = ClientContext ();
+    if (!context) { co_return false; }
+    int fd = co_await ConnectTCP (loop, address, portid, TLS_TIMEOUT_MS);
+    if (fd < 0) { co_return false; }
+    report.handshakes++;
+    SSL *ssl = SSL_new (context);
+    bool done = ssl && SSL_set_min_proto_version (ssl, version) && SSL_set_max_proto_version (ssl, version) &&
+                SSL_set_fd (ssl, fd);
+    if (done) {
+        done = (version == TLS1_3_VERSION) ? SSL_set_ciphersuites (ssl, ciphers.c_str ()) :
+                                             SSL_set_cipher_list (ssl, ciphers.c_str ());
+    }
+    if (done) { done = co_await ConnectSSL (loop, ssl, fd, TLS_TIMEOUT_MS); }
+    if (done) {
+        cipher = SSL_get_cipher_name (ssl);
+        if (report.chain.empty ()) { ExtractChain (ssl, report.chain); }
+    }
+    SSL_free (ssl);
+    close (fd);
+    /* Failed handshakes leave their errors on the queue of this thread */
+    ERR_clear_error ();
+    co_return done;
+
+} /* End of Handshake () */
+#endif
+
+
+/*
+ * This function reports whether PortHawk has been built with OpenSSL, without which TLS inspection does nothing.
+ * :return: bool value indicating whether TLS inspection is available.
+ */
+bool TLSAvailable () {
+
+#ifdef PORTHAWK_HAVE_OPENSSL
+    return true;
+#else
+    return false;
+#endif
+
+} /* End of TLSAvailable () */
+
+
+/*
+ * This function decides whether a port speaks TLS from its service name, e.g. "https", "imaps" or "ssl/http", or,
+ * when the service is unknown, from its well-known port.
+ * :arg: service, const string holding the service name of the port.
+ * :arg: portid, const string holding the port.
+ * :return: bool value indicating whether the port is to be inspected.
+ */
+bool IsTLSService (const std::string &service, const std::string &portid) {
+
+    static const std::vector <std::string> services = {
+        "https", "imaps", "pop3s", "smtps", "ldaps", "ftps", "submissions", "ircs", "nntps", "telnets", "ftps-data",
+    };
+    static const std::vector <std::string> ports = {"443", "465", "636", "853", "989", "990", "993", "995", "8443"};
+    if (service.rfind ("ssl", 0) == 0 || service.find ("https") != std::string::npos || service.find ("tls") == 0) {
+        return true;
+    }
+    if (std::find (services.begin (), services.end (), service) != services.end ()) { return true; }
+    return (service.empty () || service == "N/A") && std::find (ports.begin (), ports.end (), portid) != ports.end ();
+
+} /* End of IsTLSService () */
+
+
+/*
+ * This function inspects the TLS service of a port, as a task of the given loop. For every protocol version, the
+ * cipher suites accepted are enumerated the way ssl-enum-ciphers does: the suite chosen by the server is taken out
+ * of the offer and the handshake is run again, until the server refuses. The chain is taken from the first handshake
+ * to complete.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target, which must outlive the task.
+ * :arg: portid, const string holding the port, which must outlive the task.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :return: TLSReport object holding the outcome.
+ */
+Task <TLSReport> InspectTLS (EventLoop &loop, const std::string &address, const std::string &portid,
+                             const CancelToken &token) {
+
+    TLSReport report;
+#ifdef PORTHAWK_HAVE_OPENSSL
+    /* Newest first, so the chain reported is the one a current client gets */
+    for (auto version = TLS_VERSIONS.rbegin (); version != TLS_VERSIONS.rend (); version++) {
+        TLSProtocol protocol {version->second, {}};
+        bool tls13 = version->first == TLS1_3_VERSION;
+        std::vector <std::string> offered = tls13 ? TLS13_SUITES : std::vector <std::string> {};
+        while (protocol.ciphers.size () < TLS_MAX_CIPHERS && !token.IsCancelled ()) {
+            std::string ciphers = TLS_CIPHERS_ALL;
+            if (tls13) {
+                ciphers.clear ();
+                for (const std::string &suite : offered) { ciphers += (ciphers.empty () ? "" : ":") + suite; }
+                if (ciphers.empty ()) { break; }
+            }
+            for (const std::string &accepted : protocol.ciphers) { if (!tls13) { ciphers += ":!" + accepted; } }
+            std::string cipher;
+            if (!co_await Handshake (loop, address, portid, version->first, ciphers, report, cipher)) { break; }
+            /* A server insisting on a suite taken out of the offer would loop forever */
+            if (std::find (protocol.ciphers.begin (), protocol.ciphers.end (), cipher) != protocol.ciphers.end ()) {
+                break;
+            }
+            protocol.ciphers.push_back (cipher);
+            offered.erase (std::remove (offered.begin (), offered.end (), cipher), offered.end ());
+        }
+        if (!protocol.ciphers.empty ()) { report.protocols.insert (report.protocols.begin (), protocol); }
+        /* A port which accepts no connection at all is not worth three more attempts */
+        if (report.handshakes == 0 || token.IsCancelled ()) { break; }
+    }
+    report.handshake = !report.protocols.empty ();
+#else
+    (void) loop;
+    (void) address;
+    (void) portid;
+    (void) token;
+#endif
+    co_return report;
+
+} /* End of InspectTLS () */
+
+
+/*
+ * Instantiates a new object of NetStream class, not connected.
+ */
+NetStream::NetStream () : fd (-1), ssl (nullptr) {
+
+} /* End of NetStream () */
+
+
+/*
+ * Closes the connection, if still open.
+ */
+NetStream::~NetStream () {
+
+    Close ();
+
+} /* End of ~NetStream () */
+
+
+/*
+ * This function connects the stream, running a TLS handshake over the connection when asked to. The certificate of
+ * the server is not verified.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target, which must outlive the task.
+ * :arg: portid, const string holding the port, which must outlive the task.
+ * :arg: encrypted, bool value indicating whether the connection is wrapped in TLS.
+ * :arg: timeoutMs, integer denoting the milliseconds given to connect and to each round trip of the handshake.
+ * :return: bool value indicating whether the stream is connected.
+ */
+Task <bool> NetStream::Open (EventLoop &loop, const std::string &address, const std::string &portid, bool encrypted,
+                             int timeoutMs) {
+
+    Close ();
+    fd = co_await ConnectTCP (loop, address, portid, timeoutMs);
+    if (fd < 0 || !encrypted) { co_return fd >= 0; }
+#ifdef PORTHAWK_HAVE_OPENSSL
+    SSL_CTX *context = ClientContext ();
+    ssl = context ? SSL_new (context) : nullptr;
+    if (ssl && SSL_set_fd (ssl, fd) && co_await ConnectSSL (loop, ssl, fd, timeoutMs)) { co_return true; }
+    ERR_clear_error ();
+#endif
+    Close ();
+    co_return false;
+
+} /* End of Open () */
+
+
+/*
+ * This function writes the whole of the given data to the stream.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: data, const string holding the bytes to be written, which must outlive the task.
+ * :arg: timeoutMs, integer denoting the milliseconds given to each wait for the stream to become writable.
+ * :return: bool value indicating whether every byte has been written.
+ */
+Task <bool> NetStream::Send (EventLoop &loop, const std::string &data, int timeoutMs) {
+
+    for (size_t sent = 0; sent < data.size ();) {
+        bool writable = false;
+        bool readable = false;
+#ifdef PORTHAWK_HAVE_OPENSSL
+        if (ssl) {
+            size_t written = 0;
+            if (SSL_write_ex (ssl, data.data () + sent, data.size () - sent, &written)) {
+                sent += written;
+                continue;
+            }
+            int error = SSL_get_error (ssl, 0);
+            writable = error == SSL_ERROR_WANT_WRITE;
+            readable = error == SSL_ERROR_WANT_READ;
+        }
+#endif
+        if (!ssl) {
+            ssize_t bytes = send (fd, data.data () + sent, data.size () - sent, MSG_NOSIGNAL);
+            if (bytes >= 0) {
+                sent += bytes;
+                continue;
+            }
+            writable = errno == EAGAIN || errno == EINTR;
+        }
+        if (writable && co_await loop.Writable (fd, timeoutMs)) { continue; }
+        if (readable && co_await loop.Readable (fd, timeoutMs)) { continue; }
+        co_return false;
+    }
+    co_return true;
+
+} /* End of Send () */
+
+
+/*
+ * This function reads the bytes available on the stream, waiting for some if there are none.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: buffer, pointer to the buffer to which the bytes are copied, which must outlive the task.
+ * :arg: length, size_t holding the size of the buffer.
+ * :arg: timeoutMs, integer denoting the milliseconds given to the wait.
+ * :return: number of bytes read, 0 once the peer has closed the stream, -1 on error or timeout.
+ */
+Task <ssize_t> NetStream::Receive (EventLoop &loop, char *buffer, size_t length, int timeoutMs) {
+
+    while (fd >= 0) {
+        bool readable = false;
+        bool writable = false;
+#ifdef PORTHAWK_HAVE_OPENSSL
+        if (ssl) {
+            size_t read = 0;
+            /* Records already decrypted are returned without touching the socket */
+            if (SSL_read_ex (ssl, buffer, length, &read)) { co_return static_cast <ssize_t> (read); }
+            int error = SSL_get_error (ssl, 0);
+            if (error == SSL_ERROR_ZERO_RETURN) { co_return 0; }
+            readable = error == SSL_ERROR_WANT_READ;
+            writable = error == SSL_ERROR_WANT_WRITE;
+            /* A peer closing without close_notify, as many web servers do, ends the stream too */
+            if (error == SSL_ERROR_SYSCALL || error == SSL_ERROR_SSL) {
+                ERR_clear_error ();
+                co_return 0;
+            }
+        }
+#endif
+        if (!ssl) {
+            ssize_t bytes = recv (fd, buffer, length, 0);
+            if (bytes >= 0) { co_return bytes; }
+            readable = errno == EAGAIN || errno == EINTR;
+        }
+        if (readable && co_await loop.Readable (fd, timeoutMs)) { continue; }
+        if (writable && co_await loop.Writable (fd, timeoutMs)) { continue; }
+        break;
+    }
+    co_return -1;
+
+} /* End of Receive () */
+
+
+/*
+ * This function closes the stream, without a TLS close_notify.
+ */
+void NetStream::Close () {
+
+#ifdef PORTHAWK_HAVE_OPENSSL
+    if (ssl) { SSL_free (ssl); }
+#endif
+    ssl = nullptr;
+    if (fd >= 0) { close (fd); }
+    fd = -1;
+
+} /* End of Close () */
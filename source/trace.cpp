@@ -0,0 +1,195 @@
+/*
+ ***********************************************************************************************************************
+ * File: trace.cpp
+ * Description: This file contains definitions of member functions associated with the optional trace recorder, which
+ *              writes a timeline of the scan as Chrome/Perfetto trace-event JSON, viewable in chrome://tracing or
+ *              ui.perfetto.dev.
+ * Functions:
+ *           class TraceRecorder
+ *              TraceRecorder ()
+ *              TraceBuffer &LocalBuffer ()
+ *              void Enable ()
+ *              uint64_t Offset ()
+ *              void NameThread ()
+ *              void Record ()
+ *              ReturnCodes Write ()
+ *           class TraceScope
+ *              TraceScope ()
+ *              ~TraceScope ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <unistd.h>
+#include "trace.hpp"
+#include "utilities.hpp"
+
+TraceRecorder traceRecorder;
+
+
+/*
+ * This is a constructor function for TraceRecorder class. Recording stays off until Enable () is called.
+ */
+TraceRecorder::TraceRecorder () : enabled (false), epoch (std::chrono::steady_clock::now ()) {
+
+} /* End of TraceRecorder () */
+
+
+/*
+ * This function returns the buffer of the calling thread, registering one on the thread's first event. Buffers live
+ * as long as the recorder, so events of threads which have already exited are still written.
+ * :return: reference to the TraceBuffer of the calling thread.
+ */
+TraceBuffer &TraceRecorder::LocalBuffer () {
+
+    thread_local TraceBuffer *local = nullptr;
+    if (!local) {
+        std::lock_guard <std::mutex> lock (mtx);
+        local = &buffers.emplace_back ();
+        local->tid = static_cast <uint32_t> (buffers.size ());
+        local->threadName = "thread-" + std::to_string (local->tid);
+    }
+    return *local;
+
+} /* End of LocalBuffer () */
+
+
+/*
+ * This function starts recording, timestamps of the trace are relative to this call.
+ */
+void TraceRecorder::Enable () {
+
+    epoch = std::chrono::steady_clock::now ();
+    enabled.store (true, std::memory_order_relaxed);
+
+} /* End of Enable () */
+
+
+/*
+ * This function converts a point in time to a trace timestamp.
+ * :arg: point, steady_clock time_point to be converted.
+ * :return: uint64_t holding the microseconds elapsed since recording started, 0 for earlier points.
+ */
+uint64_t TraceRecorder::Offset (std::chrono::steady_clock::time_point point) const {
+
+    if (point < epoch) { return 0; }
+    return std::chrono::duration_cast <std::chrono::microseconds> (point - epoch).count ();
+
+} /* End of Offset () */
+
+
+/*
+ * This function names the calling thread in the trace.
+ * :arg: name, const string holding the name of the thread.
+ */
+void TraceRecorder::NameThread (const std::string &name) {
+
+    if (!IsEnabled ()) { return; }
+    TraceBuffer &buffer = LocalBuffer ();
+    std::lock_guard <std::mutex> lock (buffer.mtx);
+    buffer.threadName = name;
+
+} /* End of NameThread () */
+
+
+/*
+ * This function records a completed span in the buffer of the calling thread.
+ * :arg: name, const string holding the name of the span.
+ * :arg: category, const string holding the category of the span.
+ * :arg: item, const string identifying the host or port the span worked on, may be empty.
+ * :arg: start, uint64_t holding the trace timestamp at which the span started.
+ * :arg: duration, uint64_t holding the duration of the span in microseconds.
+ * :arg: async, bool value indicating whether the span overlaps others of the thread, keyed by its item then.
+ */
+void TraceRecorder::Record (const std::string &name, const std::string &category, const std::string &item,
+                            uint64_t start, uint64_t duration, bool async) {
+
+    if (!IsEnabled ()) { return; }
+    TraceBuffer &buffer = LocalBuffer ();
+    std::lock_guard <std::mutex> lock (buffer.mtx);
+    buffer.events.push_back ({name, category, item, start, duration, async});
+
+} /* End of Record () */
+
+
+/*
+ * This function writes the events of every thread as a trace-event JSON file, with a thread_name metadata event per
+ * thread and a complete ("X") event per span. Async spans are written as a begin ("b") & end ("e") pair whose id is
+ * their item, so the spans of a port nest on a track of their own however many ports the thread was scanning.
+ * :arg: fileName, const string holding the name of the file to be written.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes TraceRecorder::Write (const std::string &fileName, Logger objLog) {
+
+    /* module = MOD_TRACE */
+    std::stringstream optional;
+    std::ofstream output (fileName, std::ios::trunc);
+    const char *separator = "\n";
+    pid_t pid = getpid ();
+    optional << "File: " << fileName;
+    output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    std::lock_guard <std::mutex> lock (mtx);
+    for (TraceBuffer &buffer : buffers) {
+        std::lock_guard <std::mutex> bufferLock (buffer.mtx);
+        output << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": "
+               << buffer.tid << ", \"args\": {\"name\": \"" << EscapeJSON (buffer.threadName) << "\"}}";
+        separator = ",\n";
+        for (const TraceEvent &event : buffer.events) {
+            std::string common = "{\"name\": \"" + EscapeJSON (event.name) + "\", \"cat\": \"" +
+                                 EscapeJSON (event.category) + "\", \"pid\": " + std::to_string (pid) +
+                                 ", \"tid\": " + std::to_string (buffer.tid);
+            std::string args = event.item.empty () ? "" : ", \"args\": {\"item\": \"" + EscapeJSON (event.item) + "\"}";
+            if (event.async) {
+                std::string id = ", \"id\": \"" + EscapeJSON (event.item) + "\"";
+                output << separator << common << ", \"ph\": \"b\", \"ts\": " << event.start << id << args << "}";
+                output << separator << common << ", \"ph\": \"e\", \"ts\": " << event.start + event.duration << id
+                       << "}";
+                continue;
+            }
+            output << separator << common << ", \"ph\": \"X\", \"ts\": " << event.start << ", \"dur\": "
+                   << event.duration << args << "}";
+        }
+    }
+    output << "\n]}\n";
+    output.close ();
+    if (!output) {
+        objLog.Log (FAIL, MOD_TRACE, TRACE_WRITE_FAIL, true, optional);
+        return TRACE_WRITE_FAIL;
+    }
+    objLog.Log (PASS, MOD_TRACE, TRACE_WRITE_PASS, true, optional);
+    return TRACE_WRITE_PASS;
+
+} /* End of Write () */
+
+
+/*
+ * Instantiates a new object of TraceScope class, starting the span if tracing is enabled.
+ * :arg: spanName, const string holding the name of the span.
+ * :arg: spanCategory, const string holding the category of the span.
+ * :arg: spanItem, const string identifying the host or port the span works on.
+ */
+TraceScope::TraceScope (const std::string &spanName, const std::string &spanCategory, const std::string &spanItem)
+                       : active (traceRecorder.IsEnabled ()) {
+
+    if (!active) { return; }
+    name = spanName;
+    category = spanCategory;
+    item = spanItem;
+    start = std::chrono::steady_clock::now ();
+
+} /* End of TraceScope () */
+
+
+/*
+ * Records the span, if it has been started.
+ */
+TraceScope::~TraceScope () {
+
+    if (!active) { return; }
+    auto end = std::chrono::steady_clock::now ();
+    traceRecorder.Record (name, category, item, traceRecorder.Offset (start),
+                          std::chrono::duration_cast <std::chrono::microseconds> (end - start).count ());
+
+} /* End of ~TraceScope () */
@@ -0,0 +1,272 @@
+/*
+ ***********************************************************************************************************************
+ * File: udp.cpp
+ * Description: This file contains definitions of functions associated with the native UDP discovery sweep.
+ * Functions:
+ *           std::string Bytes ()
+ *           const std::vector <UDPPayload> &UDPPayloads ()
+ *           Task <ReturnCodes> UDPSweep ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <linux/errqueue.h>
+#include <map>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "metrics.hpp"
+#include "udp.hpp"
+
+/* Verdict of a port, as the sweep learns it */
+enum UDPVerdict : uint8_t {
+    UDP_PENDING,
+    UDP_OPEN,
+    UDP_CLOSED,
+    UDP_FILTERED,
+    UDP_SILENT,
+};
+
+/* ICMP destination unreachable, and its port unreachable code */
+static const uint8_t ICMP_UNREACH = 3;
+static const uint8_t ICMP_UNREACH_PORT = 3;
+/* Rounds of recvmmsg () per tick, so a flood of replies cannot starve the sending */
+static const int UDP_DRAIN_ROUNDS = 16;
+
+
+/*
+ * This function makes a string of the bytes of a literal, embedded NULs included.
+ * :arg: data, char array holding the literal.
+ * :return: string holding every byte of the literal but its terminating NUL.
+ */
+template <size_t N>
+static std::string Bytes (const char (&data) [N]) {
+
+    return std::string (data, N - 1);
+
+} /* End of Bytes () */
+
+
+/*
+ * This function returns the payload table: what NMAP's nmap-payloads sends to the well-known UDP services, reduced to
+ * a request each service answers without prior state.
+ * :return: const reference to the vector of UDPPayload objects.
+ */
+const std::vector <UDPPayload> &UDPPayloads () {
+
+    static const std::vector <UDPPayload> payloads = {
+        /* DNS, query of the root's NS records */
+        {53, "domain", Bytes ("\x12\x34\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01")},
+        /* TFTP, read request of a file which does not exist, answered with an error packet */
+        {69, "tftp", Bytes ("\x00\x01" "r7tp" "\x00" "netascii" "\x00")},
+        /* ONC RPC, NULL call to the portmapper, version 2 */
+        {111, "rpcbind", Bytes ("\x72\xfe\x1d\x13\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01\x86\xa0\x00\x00\x00\x02\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00")},
+        /* NTP, version 4 client request */
+        {123, "ntp", Bytes ("\xe3\x00\x04\xfa\x00\x01\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                            "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                            "\x00\x00\x00\x00")},
+        /* NetBIOS, node status request for the wildcard name */
+        {137, "netbios-ns", Bytes ("\x80\xf0\x00\x10\x00\x01\x00\x00\x00\x00\x00\x00\x20"
+                                   "CKAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA" "\x00\x00\x21\x00\x01")},
+        /* SNMP, version 1 get-request of sysDescr.0 with the "public" community */
+        {161, "snmp", Bytes ("\x30\x29\x02\x01\x00\x04\x06" "public" "\xa0\x1c\x02\x04\x71\x68\x2f\x2b\x02\x01\x00\x02"
+                             "\x01\x00\x30\x0e\x30\x0c\x06\x08\x2b\x06\x01\x02\x01\x01\x01\x00\x05\x00")},
+        /* IPMI over RMCP, Get Channel Authentication Capabilities */
+        {623, "asf-rmcp", Bytes ("\x06\x00\xff\x07\x00\x00\x00\x00\x00\x00\x00\x00\x00\x09\x20\x18\xc8\x81\x00\x38\x8e"
+                                 "\x04\xb5")},
+        /* SQL Server Browser, enumeration of the instances */
+        {1434, "ms-sql-m", Bytes ("\x02")},
+        /* SSDP, search for every device */
+        {1900, "upnp", "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\n"
+                       "ST: ssdp:all\r\n\r\n"},
+        /* ONC RPC, NULL call to NFS, version 3 */
+        {2049, "nfs", Bytes ("\x72\xfe\x1d\x14\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01\x86\xa3\x00\x00\x00\x03\x00\x00"
+                             "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00")},
+        /* STUN, binding request */
+        {3478, "stun", Bytes ("\x00\x01\x00\x00\x21\x12\xa4\x42" "PortHawkSTUN")},
+        /* SIP, OPTIONS request */
+        {5060, "sip", "OPTIONS sip:nm SIP/2.0\r\nVia: SIP/2.0/UDP nm;branch=z9hG4bK-ph;rport\r\n"
+                      "From: <sip:nm@nm>;tag=ph\r\nTo: <sip:nm2@nm2>\r\nCall-ID: 50000\r\nCSeq: 42 OPTIONS\r\n"
+                      "Max-Forwards: 70\r\nContent-Length: 0\r\nContact: <sip:nm@nm>\r\n"
+                      "Accept: application/sdp\r\n\r\n"},
+        /* NAT-PMP, external address request */
+        {5351, "nat-pmp", Bytes ("\x00\x00")},
+        /* mDNS, unicast query of the advertised service types */
+        {5353, "zeroconf", Bytes ("\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x09" "_services" "\x07" "_dns-sd"
+                                  "\x04" "_udp" "\x05" "local" "\x00\x00\x0c\x00\x01")},
+        /* memcached, stats command behind the UDP frame header */
+        {11211, "memcache", Bytes ("\x00\x01\x00\x00\x00\x01\x00\x00" "stats\r\n")},
+    };
+    return payloads;
+
+} /* End of UDPPayloads () */
+
+
+/*
+ * This function sweeps the given UDP ports of the target, as a task of the given loop. Ports are sent their payload
+ * from the table, an empty datagram when there is none, UDP_BATCH datagrams per sendmmsg () at UDP_RATE_PPS. Replies
+ * and the ICMP errors queued on the socket (IP_RECVERR) are read with recvmmsg () every millisecond: a reply makes a
+ * port open, a port unreachable closed & any other unreachable filtered. Ports left unanswered are retransmitted
+ * after UDP_TIMEOUT_MS, UDP_RETRIES times, before being reported as open|filtered. The sweep ends once every port has
+ * a verdict or cancellation is requested.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: address, const string holding the IPv4 address of the target.
+ * :arg: ports, const vector of the ports to be probed, in order, which must outlive the task.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: result, SweepResult object to which open, filtered & open|filtered ports are added.
+ * :return: ReturnCodes object denoting the success, failure or cancellation of the sweep.
+ */
+Task <ReturnCodes> UDPSweep (EventLoop &loop, const std::string &address, const std::vector <uint16_t> &ports,
+                             const CancelToken &token, SweepResult &result) {
+
+    struct sockaddr_in target {};
+    target.sin_family = AF_INET;
+    if (inet_pton (AF_INET, address.c_str (), &target.sin_addr) != 1) { co_return UDP_SWEEP_FAIL; }
+    int fd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { co_return UDP_SWEEP_FAIL; }
+    /* ICMP errors are queued on the socket, along with the destination of the datagram which caused them */
+    int enable = 1;
+    setsockopt (fd, SOL_IP, IP_RECVERR, &enable, sizeof (enable));
+
+    std::map <uint16_t, const std::string *> payloads;
+    for (const UDPPayload &entry : UDPPayloads ()) { payloads [entry.port] = &entry.payload; }
+    const std::string empty;
+    std::vector <UDPVerdict> verdicts (UINT16_MAX + 1, UDP_PENDING);
+    std::deque <std::pair <uint16_t, int>> queue;
+    for (uint16_t port : ports) { queue.emplace_back (port, 0); }
+    /* Ports awaiting an answer, with their attempt & deadline */
+    std::map <uint16_t, std::pair <int, std::chrono::steady_clock::time_point>> outstanding;
+    std::vector <struct mmsghdr> messages (UDP_BATCH);
+    std::vector <struct iovec> vectors (UDP_BATCH);
+    std::vector <struct sockaddr_in> names (UDP_BATCH);
+    std::vector <char> buffers (UDP_BATCH * UDP_MAX_REPLY);
+    std::vector <char> controls (UDP_BATCH * CMSG_SPACE (sizeof (struct sock_extended_err) + sizeof (sockaddr_in)));
+    size_t controlSize = controls.size () / UDP_BATCH;
+    auto decide = [&](uint16_t port, UDPVerdict verdict) {
+        if (verdicts [port] != UDP_PENDING) { return; }
+        verdicts [port] = verdict;
+        outstanding.erase (port);
+        if (verdict == UDP_OPEN) { result.open.push_back (port); }
+        else if (verdict == UDP_CLOSED) { result.closed++; }
+        else if (verdict == UDP_FILTERED) { result.filtered.push_back (port); }
+        else { result.openFiltered.push_back (port); }
+        if (verdict != UDP_SILENT) { result.responses++; }
+    };
+    /* recvmmsg () into the batch buffers, the control buffers are only used for the error queue */
+    auto receive = [&](int flags) {
+        for (size_t index = 0; index < UDP_BATCH; index++) {
+            vectors [index] = {buffers.data () + index * UDP_MAX_REPLY, UDP_MAX_REPLY};
+            messages [index].msg_hdr = {};
+            messages [index].msg_hdr.msg_name = &names [index];
+            messages [index].msg_hdr.msg_namelen = sizeof (names [index]);
+            messages [index].msg_hdr.msg_iov = &vectors [index];
+            messages [index].msg_hdr.msg_iovlen = 1;
+            if (flags & MSG_ERRQUEUE) {
+                messages [index].msg_hdr.msg_control = controls.data () + index * controlSize;
+                messages [index].msg_hdr.msg_controllen = controlSize;
+            }
+        }
+        return recvmmsg (fd, messages.data (), UDP_BATCH, flags | MSG_DONTWAIT, nullptr);
+    };
+
+    double credit = UDP_BATCH;
+    auto last = std::chrono::steady_clock::now ();
+    while (!token.IsCancelled () && (!queue.empty () || !outstanding.empty ())) {
+        auto now = std::chrono::steady_clock::now ();
+        credit = std::min (credit + std::chrono::duration <double> (now - last).count () * UDP_RATE_PPS,
+                           static_cast <double> (UDP_BATCH));
+        last = now;
+        /* Send the next batch, ports decided while waiting to be retransmitted are dropped */
+        std::vector <std::pair <uint16_t, int>> batch;
+        while (!queue.empty () && batch.size () < static_cast <size_t> (credit)) {
+            if (verdicts [queue.front ().first] == UDP_PENDING) { batch.push_back (queue.front ()); }
+            queue.pop_front ();
+        }
+        for (size_t index = 0; index < batch.size (); index++) {
+            auto found = payloads.find (batch [index].first);
+            const std::string &payload = found != payloads.end () ? *found->second : empty;
+            names [index] = target;
+            names [index].sin_port = htons (batch [index].first);
+            vectors [index] = {const_cast <char *> (payload.data ()), payload.size ()};
+            messages [index].msg_hdr = {};
+            messages [index].msg_hdr.msg_name = &names [index];
+            messages [index].msg_hdr.msg_namelen = sizeof (names [index]);
+            messages [index].msg_hdr.msg_iov = &vectors [index];
+            messages [index].msg_hdr.msg_iovlen = 1;
+        }
+        /* A failed call, e.g. an earlier ICMP error reported once more, leaves the batch to the next tick */
+        int sent = batch.empty () ? 0 : sendmmsg (fd, messages.data (), batch.size (), 0);
+        sent = std::max (sent, 0);
+        auto deadline = now + std::chrono::milliseconds (UDP_TIMEOUT_MS);
+        for (int index = 0; index < sent; index++) {
+            outstanding [batch [index].first] = {batch [index].second, deadline};
+        }
+        for (size_t index = batch.size (); index > static_cast <size_t> (sent); index--) {
+            queue.push_front (batch [index - 1]);
+        }
+        credit -= sent;
+        runMetrics.GetCounter (MET_UDP_PROBES).Add (sent);
+
+        /* Replies from the target, any payload makes the port open */
+        for (int round = 0; round < UDP_DRAIN_ROUNDS; round++) {
+            int received = receive (0);
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK) { continue; }
+            for (int index = 0; index < received; index++) {
+                if (names [index].sin_addr.s_addr != target.sin_addr.s_addr) { continue; }
+                decide (ntohs (names [index].sin_port), UDP_OPEN);
+                runMetrics.GetCounter (MET_UDP_REPLIES).Add ();
+            }
+            if (received < static_cast <int> (UDP_BATCH)) { break; }
+        }
+        /* ICMP errors, named by the destination of the probe which caused them */
+        for (int round = 0; round < UDP_DRAIN_ROUNDS; round++) {
+            int received = receive (MSG_ERRQUEUE);
+            for (int index = 0; index < received; index++) {
+                if (names [index].sin_addr.s_addr != target.sin_addr.s_addr) { continue; }
+                struct msghdr &header = messages [index].msg_hdr;
+                for (struct cmsghdr *control = CMSG_FIRSTHDR (&header); control;
+                     control = CMSG_NXTHDR (&header, control)) {
+                    if (control->cmsg_level != SOL_IP || control->cmsg_type != IP_RECVERR) { continue; }
+                    const struct sock_extended_err *error =
+                        reinterpret_cast <const struct sock_extended_err *> (CMSG_DATA (control));
+                    if (error->ee_origin != SO_EE_ORIGIN_ICMP || error->ee_type != ICMP_UNREACH) { continue; }
+                    decide (ntohs (names [index].sin_port), error->ee_code == ICMP_UNREACH_PORT ? UDP_CLOSED :
+                            UDP_FILTERED);
+                    runMetrics.GetCounter (MET_UDP_UNREACHABLE).Add ();
+                }
+            }
+            if (received < static_cast <int> (UDP_BATCH)) { break; }
+        }
+
+        /* Unanswered probes are retransmitted, then given up on */
+        for (auto entry = outstanding.begin (); entry != outstanding.end ();) {
+            auto [port, state] = *entry;
+            if (state.second > now) {
+                ++entry;
+                continue;
+            }
+            entry = outstanding.erase (entry);
+            if (state.first < UDP_RETRIES) {
+                queue.emplace_back (port, state.first + 1);
+                runMetrics.GetCounter (MET_UDP_RETRIES).Add ();
+                continue;
+            }
+            result.timeouts++;
+            decide (port, UDP_SILENT);
+        }
+        co_await loop.Sleep (1);
+    }
+    close (fd);
+    std::sort (result.open.begin (), result.open.end ());
+    std::sort (result.filtered.begin (), result.filtered.end ());
+    std::sort (result.openFiltered.begin (), result.openFiltered.end ());
+    co_return token.IsCancelled () ? CMD_EXEC_CANCEL : UDP_SWEEP_PASS;
+
+} /* End of UDPSweep () */
@@ -5,21 +5,160 @@
  *              otherwise unclassifiable.
  * 
  * Functions:
+ *           class CancelToken
+ *              CancelToken ()
+ *              void Cancel ()
+ *              bool IsCancelled ()
  *           UsageExit ()
  *           KeyboardInterrupt ()
+ *           class CgroupStages
+ *              ReturnCodes Setup ()
+ *              string StageDir ()
+ *              void Report ()
+ *           ReapProcessGroup ()
+ *           FillChildUsage ()
+ *           ExecuteCommandAsync ()
  *           ExecuteSystemCommand ()
  *           ValidateArguments ()
  *           ConvertToIPAddress ()
+ *           ExpandTarget ()
+ *           EscapeJSON ()
+ *           FormatChildUsage ()
+ *           MergeChildUsage ()
  * Author: 0x6D76
  * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
  ***********************************************************************************************************************
  */
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
 #include <netdb.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_set>
+#include "discovery.hpp"
+#include "liveness.hpp"
 #include "logger.hpp"
+#include "probes.hpp"
 #include "utilities.hpp"
 
+CancelToken interruptToken;
+CgroupStages scanCgroups;
+/* Formatted ahead of time, as the signal handler must not allocate */
+static const std::string INTERRUPT_MESSAGE = "\n" + GetReturnMessage (KEYBOARD_INT) + "\n";
+
+
+/*
+ * This is a constructor function for CancelToken class.
+ */
+CancelToken::CancelToken () : cancelled (false) {
+
+} /* End of CancelToken () */
+
+
+/*
+ * This function requests cancellation of every operation observing the token.
+ */
+void CancelToken::Cancel () {
+
+    cancelled.store (true);
+
+} /* End of Cancel () */
+
+
+/*
+ * This function returns whether cancellation has been requested.
+ * :return: bool value indicating whether the token has been cancelled.
+ */
+bool CancelToken::IsCancelled () const {
+
+    return cancelled.load ();
+
+} /* End of IsCancelled () */
+
+
+/*
+ * This function prepares cgroup v2 accounting, creating a sub-group per scan stage under the given directory. The
+ * directory must be delegated to the user running the scan and must not hold processes itself.
+ * :arg: rootDir, const string holding the cgroup v2 directory.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ * :return: ReturnCodes object denoting the success/failure of the operation.
+ */
+ReturnCodes CgroupStages::Setup (const std::string &rootDir, Logger objLog) {
+
+    /* module = MOD_CGROUP */
+    std::error_code error;
+    std::stringstream optional;
+    optional << "Directory: " << rootDir;
+    if (!std::filesystem::exists (rootDir + "/cgroup.procs", error)) {
+        objLog.Log (FAIL, MOD_CGROUP, CGROUP_SETUP_FAIL, true, optional);
+        return CGROUP_SETUP_FAIL;
+    }
+    /* Without the memory controller the stages still report CPU time, so a refusal here is not fatal */
+    std::ofstream controllers (rootDir + "/cgroup.subtree_control");
+    controllers << "+cpu +memory" << std::flush;
+    for (const auto &stage : {STAGE_DISCOVERY, STAGE_DEEP}) {
+        std::filesystem::create_directory (rootDir + "/" + stage, error);
+        if (!std::filesystem::exists (rootDir + "/" + stage + "/cgroup.procs")) {
+            objLog.Log (FAIL, MOD_CGROUP, CGROUP_SETUP_FAIL, true, optional);
+            return CGROUP_SETUP_FAIL;
+        }
+    }
+    root = rootDir;
+    objLog.Log (PASS, MOD_CGROUP, CGROUP_SETUP_PASS, false, optional);
+    return CGROUP_SETUP_PASS;
+
+} /* End of Setup () */
+
+
+/*
+ * This function returns the cgroup directory of a scan stage.
+ * :arg: stage, const string holding the name of the stage.
+ * :return: string holding the directory, empty if cgroup accounting is not enabled.
+ */
+std::string CgroupStages::StageDir (const std::string &stage) const {
+
+    return root.empty () ? "" : root + "/" + stage;
+
+} /* End of StageDir () */
+
+
+/*
+ * This function logs the CPU time and peak memory each scan stage has used, as accounted by its cgroup.
+ * :arg: objLog, Logger object to which the messages are to be logged.
+ */
+void CgroupStages::Report (Logger objLog) const {
+
+    /* module = MOD_CGROUP */
+    if (root.empty ()) { return; }
+    for (const auto &stage : {STAGE_DISCOVERY, STAGE_DEEP}) {
+        std::string key;
+        uint64_t value = 0;
+        uint64_t peak = 0;
+        std::map <std::string, uint64_t> stats;
+        std::ifstream cpuStat (StageDir (stage) + "/cpu.stat");
+        while (cpuStat >> key >> value) { stats [key] = value; }
+        std::ifstream memoryPeak (StageDir (stage) + "/memory.peak");
+        memoryPeak >> peak;
+
+        std::stringstream optional;
+        optional << std::fixed << std::setprecision (3) << "Stage: " << stage << ", CPU "
+                 << stats ["usage_usec"] / 1e6 << "s (user " << stats ["user_usec"] / 1e6 << "s, sys "
+                 << stats ["system_usec"] / 1e6 << "s)";
+        if (peak) { optional << ", memory peak " << std::setprecision (1) << peak / 1048576.0 << " MiB"; }
+        objLog.Log (INFO, MOD_CGROUP, CGROUP_STAT_INFO, true, optional);
+    }
+
+} /* End of Report () */
+
 
 /*
  * This function prints error condition based on the return code given, then prints usage instructions and exits the
@@ -29,48 +168,250 @@
 void UsageExit (ReturnCodes code) {
 
     std::cout << RED << GetReturnMessage (code) << RST << std::endl;
-    std::cout << "Usage: portHawk <target address>" << std::endl;
-    std::cout << "Example: 'portHawk target@domain.com' or 'portHawk 127.0.0.1'" << std::endl;
+    std::cout << "Usage: portHawk [" << FLAG_RESUME << "] [" << FLAG_NATIVE << "] [" << FLAG_UDP << "] ["
+              << FLAG_FREQUENT_FIRST << "] [" << FLAG_BANNERS << "] [" << FLAG_VERSION_PROBES << "] [" << FLAG_TLS
+              << "] [" << FLAG_HTTP << "] [" << FLAG_HTTP_PATH << " <path>]... [" << FLAG_CPE << " <prefix>]... ["
+              << FLAG_TRACE << " <json file>] [" << FLAG_CGROUP << " <dir>] [" << FLAG_PING << "] ["
+              << FLAG_UNKNOWN_HOSTS << " <scan|skip>] [" << FLAG_SHARDS << " <count|auto>] <target address>..."
+              << std::endl;
+    std::cout << "Example: 'portHawk target@domain.com' or 'portHawk 127.0.0.1' or 'portHawk 10.0.0.0/24'" << std::endl;
+    std::cout << "         '" << FLAG_RESUME << "' reloads the scan journal and runs only the outstanding work."
+              << std::endl;
+    std::cout << "         '" << FLAG_NATIVE << "' discovers ports with an in-process connect sweep paced by "
+              << "congestion control, instead of NMAP." << std::endl;
+    std::cout << "         '" << FLAG_UDP << "' also sweeps the well-known UDP services (DNS, SNMP, NTP, IPMI, ...) "
+              << "with their own payloads." << std::endl;
+    std::cout << "         '" << FLAG_FREQUENT_FIRST << "' scans the 1000 most frequently open ports as soon as they "
+              << "are swept, while the rest are swept in the background." << std::endl;
+    std::cout << "         '" << FLAG_SHARDS << " <count|auto>' splits the NMAP sweep of the ports across concurrent "
+              << "NMAP processes, auto uses one per core." << std::endl;
+    std::cout << "         '" << FLAG_BANNERS << "' identifies services from their banners first, NMAP script scans "
+              << "only the rest." << std::endl;
+    std::cout << "         '" << FLAG_VERSION_PROBES << "' detects versions in-process with NMAP's service probes, "
+              << "NMAP then runs its scripts without -sV." << std::endl;
+    std::cout << "         '" << FLAG_TLS << "' inventories the protocol versions, cipher suites & certificate chain "
+              << "of every TLS port." << std::endl;
+    std::cout << "         '" << FLAG_HTTP << "' fingerprints web services in-process, NMAP script scans only the rest."
+              << std::endl;
+    std::cout << "         '" << FLAG_HTTP_PATH << " <path>' fetches the path instead of '/', '/favicon.ico' & "
+              << "'/robots.txt', implies " << FLAG_HTTP << "." << std::endl;
+    std::cout << "         '" << FLAG_CPE << " <prefix>' lists the scanned ports exposing the CPE, e.g. "
+              << "'cpe:/a:apache:http_server:2.4.49'." << std::endl;
+    std::cout << "         '" << FLAG_CGROUP << " <dir>' accounts each scan stage in a sub-group of the given, "
+              << "delegated cgroup v2 directory." << std::endl;
+    std::cout << "         '" << FLAG_TRACE << " <json file>' writes a trace-event timeline of the scan, viewable in "
+              << "ui.perfetto.dev." << std::endl;
+    std::cout << "         '" << FLAG_PING << "' sweeps the targets for live hosts before port discovery, as is done "
+              << "whenever there is more than one target." << std::endl;
+    std::cout << "         '" << FLAG_UNKNOWN_HOSTS << " <scan|skip>' decides whether targets answering no liveness "
+              << "probe are scanned, default is scan." << std::endl;
+    std::cout << "       portHawk " << FLAG_BUILD_CVE << " <feed file> [<target address>]" << std::endl;
+    std::cout << "         builds the offline CVE index from a flattened NVD CPE-match feed." << std::endl;
+    std::cout << "       portHawk " << FLAG_DAEMON << " [" << FLAG_SOCKET << " <path>]" << std::endl;
+    std::cout << "         runs as a daemon taking scan jobs over a Unix socket, PH/portHawk.sock by default." << std::endl;
     exit (-1);
 
 } /* End of UsageExit () */
 
 
 /*
- * This function handles keyboard interrupt (Ctrl-C) signal sent by the user by printing the appropriate messages and 
- * quits the tool operation.
+ * This function handles keyboard interrupt (Ctrl-C) and termination signals. The first signal cancels the interrupt
+ * token, so running scans reap their child processes and partial results are written before the tool quits. A second
+ * signal quits the tool immediately. Only async-signal-safe calls are made here.
  * :arg: signal, integer denoting the received signal.
  */
 void KeyboardInterrupt (int signal) {
 
-    if (signal == SIGINT) {
-        std::cout << GetReturnMessage (KEYBOARD_INT);
-        // keepRunning = 0;
-        exit (-1);
+    if (signal == SIGINT || signal == SIGTERM) {
+        if (interruptToken.IsCancelled ()) { _exit (-1); }
+        interruptToken.Cancel ();
+        ssize_t written = write (STDOUT_FILENO, INTERRUPT_MESSAGE.data (), INTERRUPT_MESSAGE.size ());
+        (void) written;
     }
 
 } /* End of KeyboardInterrupt () */
 
 
 /*
- * This function executes the given string as a system command, captures its output, copies it to the given 
- * stringstream object and finally returns the success or failure of the execution.
- * :arg: command, const string holding the command to be executed.
+ * This function terminates the process group led by the given child, first with SIGTERM and, once the leader has
+ * exited or the grace period has lapsed, with SIGKILL. The child is reaped before returning so no zombie or orphan is
+ * left behind, other tasks of the loop keep running meanwhile.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: pid, pid_t of the child process leading the process group.
+ * :arg: pidfd, integer holding the pidfd of the child, -1 to poll its state instead.
+ * :arg: graceMs, integer denoting the milliseconds the group is given to exit after SIGTERM.
+ * :arg: status, integer to which the wait status of the child is copied.
+ * :arg: resources, rusage structure to which the resources used by the child are copied.
+ */
+static Task <> ReapProcessGroup (EventLoop &loop, pid_t pid, int pidfd, int graceMs, int &status,
+                                 struct rusage &resources) {
+
+    kill (-pid, SIGTERM);
+    if (pidfd >= 0) { co_await loop.Readable (pidfd, graceMs); }
+    for (int waited = 0; pidfd < 0 && waited < graceMs; waited += CANCEL_POLL_MS) {
+        siginfo_t info {};
+        if (waitid (P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid) { break; }
+        co_await loop.Sleep (CANCEL_POLL_MS);
+    }
+    /* Leader is gone or out of time, make sure nothing it spawned outlives it */
+    kill (-pid, SIGKILL);
+    while (wait4 (pid, &status, 0, &resources) < 0 && errno == EINTR) {}
+
+} /* End of ReapProcessGroup () */
+
+
+/*
+ * This function fills the resource accounting of a reaped child.
+ * :arg: usage, ChildUsage pointer to be filled, nothing is done if null.
+ * :arg: status, integer holding the wait status of the child.
+ * :arg: resources, rusage structure returned by wait4 for the child.
+ * :arg: start, steady_clock time_point at which the child was spawned.
+ */
+static void FillChildUsage (ChildUsage *usage, int status, const struct rusage &resources,
+                            std::chrono::steady_clock::time_point start) {
+
+    if (!usage) { return; }
+    auto elapsed = std::chrono::steady_clock::now () - start;
+    usage->valid = true;
+    usage->exitStatus = WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+    usage->termSignal = WIFSIGNALED (status) ? WTERMSIG (status) : 0;
+    usage->wallMicros = std::chrono::duration_cast <std::chrono::microseconds> (elapsed).count ();
+    usage->userMicros = resources.ru_utime.tv_sec * 1000000ULL + resources.ru_utime.tv_usec;
+    usage->sysMicros = resources.ru_stime.tv_sec * 1000000ULL + resources.ru_stime.tv_usec;
+    usage->maxRSSKiB = resources.ru_maxrss;
+
+} /* End of FillChildUsage () */
+
+
+/*
+ * This function executes the given argument vector as a system command in its own process group, as a task of the
+ * given loop, copying its output to the given stringstream object as it arrives. The program is looked up on PATH and
+ * run directly, no shell parses the arguments. The pipe & the child's exit are awaited on the loop, so a single thread
+ * can run any number of commands at once. The token is polled while the command runs, and on cancellation the
+ * command's process group is reaped.
+ * :arg: loop, EventLoop object running the task.
+ * :arg: command, const vector of the arguments, the program first, which must outlive the task.
  * :arg: output, stringstream object to which the output of the system command is copied to.
- * :return: ReturnCodes object denoting the success or failure of the execution.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: usage, ChildUsage pointer to which the resources used by the command are copied to, may be null.
+ * :arg: cgroup, const string holding the cgroup v2 directory the command is to be run in, empty to stay in ours.
+ * :return: ReturnCodes object denoting the success, failure or cancellation of the execution. The execution fails
+ *          when the program could not be run (exit status EXIT_NOT_RUN) or was killed by a signal, the status of the
+ *          child being copied to usage.
  */
-ReturnCodes ExecuteSystemCommand (const std::string &command, std::stringstream &output) {
+Task <ReturnCodes> ExecuteCommandAsync (EventLoop &loop, const std::vector <std::string> &command,
+                                        std::stringstream &output, const CancelToken &token, ChildUsage *usage,
+                                        const std::string &cgroup) {
+
+    int fds [2];
+    int status = 0;
+    size_t total = 0;
+    struct rusage resources {};
+    /* Built before forking, as the child of a multi-threaded process must not allocate */
+    std::string cgroupProcs = cgroup.empty () ? "" : cgroup + "/cgroup.procs";
+    std::vector <char *> arguments;
+    std::string commandLine;
+    for (const auto &argument : command) {
+        arguments.push_back (const_cast <char *> (argument.c_str ()));
+        commandLine += (commandLine.empty () ? "" : " ") + argument;
+    }
+    arguments.push_back (nullptr);
+    char buffer [4096];
+    PH_PROBE1 (exec__start, commandLine.c_str ());
+    if (token.IsCancelled ()) {
+        PH_PROBE4 (exec__done, -1, static_cast <int> (CMD_EXEC_CANCEL), total, status);
+        co_return CMD_EXEC_CANCEL;
+    }
+    /* Open a pipe to capture the output of the system command */
+    if (command.empty () || pipe2 (fds, O_CLOEXEC) != 0) {
+        PH_PROBE4 (exec__done, -1, static_cast <int> (CMD_EXEC_FAIL), total, status);
+        co_return CMD_EXEC_FAIL;
+    }
+    auto start = std::chrono::steady_clock::now ();
+    pid_t pid = fork ();
+    if (pid < 0) {
+        close (fds [0]);
+        close (fds [1]);
+        PH_PROBE4 (exec__done, -1, static_cast <int> (CMD_EXEC_FAIL), total, status);
+        co_return CMD_EXEC_FAIL;
+    }
+    if (pid == 0) {
+        /* Own process group, so the terminal's Ctrl-C does not reach it and it can be signalled as a whole */
+        setpgid (0, 0);
+        if (!cgroupProcs.empty ()) {
+            /* Writing "0" moves the writer itself, the command and everything it spawns are then accounted there */
+            int group = open (cgroupProcs.c_str (), O_WRONLY | O_CLOEXEC);
+            if (group >= 0) {
+                ssize_t written = write (group, "0", 1);
+                (void) written;
+                close (group);
+            }
+        }
+        dup2 (fds [1], STDOUT_FILENO);
+        execvp (arguments [0], arguments.data ());
+        _exit (EXIT_NOT_RUN);
+    }
+    setpgid (pid, pid);
+    close (fds [1]);
+    fcntl (fds [0], F_SETFL, fcntl (fds [0], F_GETFL) | O_NONBLOCK);
+    /* Readable once the child has exited, kernels without pidfd fall back to a blocking reap */
+    int pidfd = static_cast <int> (syscall (SYS_pidfd_open, pid, 0));
+    PH_PROBE2 (exec__spawn, commandLine.c_str (), static_cast <int> (pid));
 
-    char buffer [128] = "";
-    /* Open a pipe to execute system command and capture its output */
-    FILE *pipe = popen (command.c_str (), "r");
-    /* Return failure code, upon execution failure */
-    if (!pipe) { return CMD_EXEC_FAIL; }
-    while (fgets (buffer, sizeof (buffer), pipe) != nullptr) {
-        output << buffer;
+    bool cancelled = false;
+    for (bool open = true; open;) {
+        if ((cancelled = token.IsCancelled ())) { break; }
+        if (!co_await loop.Readable (fds [0], CANCEL_POLL_MS)) { continue; }
+        for (;;) {
+            ssize_t bytes = read (fds [0], buffer, sizeof (buffer));
+            if (bytes < 0 && errno == EINTR) { continue; }
+            if (bytes < 0 && errno == EAGAIN) { break; }
+            if (bytes <= 0) {
+                open = false;
+                break;
+            }
+            output.write (buffer, bytes);
+            total += bytes;
+        }
+    }
+    /* The child may outlive its end of the pipe */
+    while (!cancelled && pidfd >= 0 && !co_await loop.Readable (pidfd, CANCEL_POLL_MS)) {
+        cancelled = token.IsCancelled ();
+    }
+    close (fds [0]);
+    if (cancelled) { co_await ReapProcessGroup (loop, pid, pidfd, CHILD_GRACE_MS, status, resources); }
+    else {
+        while (wait4 (pid, &status, 0, &resources) < 0 && errno == EINTR) {}
     }
-    pclose (pipe);
-    return CMD_EXEC_PASS;
+    if (pidfd >= 0) { close (pidfd); }
+    FillChildUsage (usage, status, resources, start);
+    /* A program which could not be run, or which was killed by a signal we did not send, wrote no result */
+    bool failed = (WIFEXITED (status) && WEXITSTATUS (status) == EXIT_NOT_RUN) || WIFSIGNALED (status);
+    ReturnCodes result = cancelled ? CMD_EXEC_CANCEL : failed ? CMD_EXEC_FAIL : CMD_EXEC_PASS;
+    PH_PROBE4 (exec__done, static_cast <int> (pid), static_cast <int> (result), total, status);
+    co_return result;
+
+} /* End of ExecuteCommandAsync () */
+
+
+/*
+ * This function executes the given argument vector as a system command on a loop of its own, for callers which are
+ * not coroutines, and returns once the command has finished.
+ * :arg: command, const vector of the arguments, the program first.
+ * :arg: output, stringstream object to which the output of the system command is copied to.
+ * :arg: token, CancelToken object observed for cancellation requests.
+ * :arg: usage, ChildUsage pointer to which the resources used by the command are copied to, may be null.
+ * :arg: cgroup, const string holding the cgroup v2 directory the command is to be run in, empty to stay in ours.
+ * :return: ReturnCodes object denoting the success, failure or cancellation of the execution.
+ */
+ReturnCodes ExecuteSystemCommand (const std::vector <std::string> &command, std::stringstream &output,
+                                  const CancelToken &token, ChildUsage *usage, const std::string &cgroup) {
+
+    EventLoop loop;
+    ReturnCodes result = CMD_EXEC_FAIL;
+    loop.Spawn (StoreResult (ExecuteCommandAsync (loop, command, output, token, usage, cgroup), result));
+    loop.Run ();
+    return result;
 
 } /* End of ExecuteSystemCommand () */
 
@@ -79,25 +420,78 @@ ReturnCodes ExecuteSystemCommand (const std::string &command, std::stringstream
  * This functions validates the user supplied arguments and returns the result.
  * :arg: argCount, integer denoting the number of user supplied arguments.
  * :arg: values, char pointer to the user supplied arguments.
- * :arg: target, string object holding the converted or validated target IP address.
+ * :arg: options, Options object holding the converted or validated target IP address and the parsed flags.
  * :return: ReturnCodes denoting the success or failure of the operation.
  */
-ReturnCodes ValidateArguments (int argCount, char **values, std::string &address) {
+ReturnCodes ValidateArguments (int argCount, char **values, Options &options) {
 
     std::vector <std::string> dirs;
-    
-    if (argCount != 2) { 
-        UsageExit (ARG_COUNT_FAIL);
-        return ARG_COUNT_FAIL; 
-    } else if (ConvertToIPAddress (values [1], address) == TARGET_ADDR_FAIL) {
-        UsageExit (TARGET_ADDR_FAIL);
-        return TARGET_ADDR_FAIL;
+    std::vector <std::string> positional;
+
+    for (int index = 1; index < argCount; index++) {
+        if (values [index] == FLAG_RESUME) { options.resume = true; }
+        else if (values [index] == FLAG_NATIVE) { options.native = true; }
+        else if (values [index] == FLAG_UDP) { options.udp = true; }
+        else if (values [index] == FLAG_FREQUENT_FIRST) { options.frequentFirst = true; }
+        else if (values [index] == FLAG_SHARDS && index + 1 < argCount) { options.shards = values [++index]; }
+        else if (values [index] == FLAG_PING) { options.ping = true; }
+        else if (values [index] == FLAG_UNKNOWN_HOSTS && index + 1 < argCount) {
+            options.unknownHosts = values [++index];
+        }
+        else if (values [index] == FLAG_BANNERS) { options.banners = true; }
+        else if (values [index] == FLAG_VERSION_PROBES) { options.versionProbes = true; }
+        else if (values [index] == FLAG_TLS) { options.tls = true; }
+        else if (values [index] == FLAG_HTTP) { options.http = true; }
+        else if (values [index] == FLAG_HTTP_PATH && index + 1 < argCount) {
+            options.http = true;
+            options.httpPaths.emplace_back (values [++index]);
+        }
+        else if (values [index] == FLAG_BUILD_CVE && index + 1 < argCount) { options.cveFeed = values [++index]; }
+        else if (values [index] == FLAG_CPE && index + 1 < argCount) { options.cpeQueries.emplace_back (values [++index]); }
+        else if (values [index] == FLAG_TRACE && index + 1 < argCount) { options.traceFile = values [++index]; }
+        else if (values [index] == FLAG_CGROUP && index + 1 < argCount) { options.cgroupRoot = values [++index]; }
+        else if (values [index] == FLAG_DAEMON) { options.daemon = true; }
+        else if (values [index] == FLAG_SOCKET && index + 1 < argCount) { options.socketPath = values [++index]; }
+        else { positional.emplace_back (values [index]); }
     }
     /* Creating required directories */
     dirs.emplace_back (DIR_BASE);
     dirs.emplace_back (DIR_LOGS);
     dirs.emplace_back (DIR_PORTS);
-    InitializeDirectories (dirs);
+    /* Nothing can be logged or scanned without them, the tool exits */
+    auto initialize = [&dirs]() {
+        std::string error;
+        if (InitializeDirectories (dirs, error) == WORK_DIRS_PASS) { return; }
+        std::cout << RED << GetReturnMessage (WORK_DIRS_FAIL) << error << RST << std::endl;
+        exit (-1);
+    };
+    if (positional.empty () && (!options.cveFeed.empty () || options.daemon)) {
+        initialize ();
+        return ARG_COUNT_PASS;
+    }
+    UnknownPolicy policy;
+    size_t shards;
+    if (positional.empty () || !ParseUnknownPolicy (options.unknownHosts, policy) ||
+        !ParseShardCount (options.shards, shards)) { 
+        UsageExit (ARG_COUNT_FAIL);
+        return ARG_COUNT_FAIL; 
+    }
+    for (const auto &target : positional) {
+        if (ExpandTarget (target, options.addresses) == TARGET_ADDR_FAIL || options.addresses.size () > MAX_TARGETS) {
+            UsageExit (TARGET_ADDR_FAIL);
+            return TARGET_ADDR_FAIL;
+        }
+    }
+    /* Targets given more than once, e.g. by overlapping networks, are scanned once */
+    std::vector <std::string> unique;
+    std::unordered_set <std::string> seen;
+    seen.reserve (options.addresses.size ());
+    for (const auto &address : options.addresses) {
+        if (seen.insert (address).second) { unique.push_back (address); }
+    }
+    options.addresses = unique;
+    options.address = options.addresses.front ();
+    initialize ();
     return TARGET_ADDR_PASS;
 
 } /* End of ValidateArguments () */
@@ -122,33 +516,114 @@ ReturnCodes ConvertToIPAddress (const std::string &target, std::string &address)
         return TARGET_ADDR_FAIL;
     }
 
+    /* inet_ntop writes to a buffer of our own, unlike inet_ntoa, so threads resolving at once never share one */
     auto *addr = (struct sockaddr_in*) result->ai_addr;
-    address = inet_ntoa (addr->sin_addr);
+    char text [INET_ADDRSTRLEN];
+    bool converted = inet_ntop (AF_INET, &addr->sin_addr, text, sizeof (text)) != nullptr;
     freeaddrinfo (result);
+    if (!converted) { return TARGET_ADDR_FAIL; }
+    address = text;
     return TARGET_ADDR_PASS;
 
 } /* End of ConvertToIPAddress () */
 
 
 /*
- * This function gets a string and replaces the placeholders with the values supplied as an unordered map.
- * :arg: command, string on which the placeholders are to be replaced.
- * :arg: placeHolders, unordered_map object containing the placeholders and the respective string values to replace
- *       them with.
- * :return: string holding the placeholder replaced string.
+ * This function expands a target into the IPv4 addresses it names: a network in CIDR notation, e.g. 10.0.0.0/24, to
+ * its host addresses, leaving out the network & broadcast addresses of networks larger than a /31, or a domain or
+ * address to its IP address.
+ * :arg: target, const string holding the target to be expanded.
+ * :arg: addresses, vector to which the addresses are added.
+ * :return: ReturnCodes denoting whether the target is a valid one, holding at most MAX_TARGETS addresses.
+ */
+ReturnCodes ExpandTarget (const std::string &target, std::vector <std::string> &addresses) {
+
+    size_t slash = target.find ('/');
+    if (slash == std::string::npos) {
+        std::string address;
+        if (ConvertToIPAddress (target, address) != TARGET_ADDR_PASS) { return TARGET_ADDR_FAIL; }
+        addresses.push_back (address);
+        return TARGET_ADDR_PASS;
+    }
+    struct in_addr network {};
+    char *end = nullptr;
+    long prefix = std::strtol (target.c_str () + slash + 1, &end, 10);
+    if (inet_pton (AF_INET, target.substr (0, slash).c_str (), &network) != 1 || *end != '\0' ||
+        end == target.c_str () + slash + 1 || prefix < 0 || prefix > 32 || (1ull << (32 - prefix)) > MAX_TARGETS) {
+        return TARGET_ADDR_FAIL;
+    }
+    uint64_t size = 1ull << (32 - prefix);
+    uint32_t first = ntohl (network.s_addr) & static_cast <uint32_t> (~(size - 1));
+    char text [INET_ADDRSTRLEN];
+    for (uint64_t offset = size > 2 ? 1 : 0; offset < (size > 2 ? size - 1 : size); offset++) {
+        struct in_addr host {htonl (first + static_cast <uint32_t> (offset))};
+        addresses.emplace_back (inet_ntop (AF_INET, &host, text, sizeof (text)));
+    }
+    return TARGET_ADDR_PASS;
+
+} /* End of ExpandTarget () */
+
+
+/*
+ * This function escapes a string to be written as a JSON string literal.
+ * :arg: value, const string to be escaped.
+ * :return: string holding the escaped value, without the enclosing quotes.
  */
-std::string ReplacePlaceHolders (const std::string &command, 
-                                 const std::unordered_map <std::string, std::string> &placeHolders) {
-    
-    std::string result = command;
-    for (const auto &placeHolder : placeHolders) {
-        std::string key = "$" + placeHolder.first;
-        size_t position = result.find (key);
+std::string EscapeJSON (const std::string &value) {
 
-        while (position != std::string::npos) {
-            result.replace (position, key.length (), placeHolder.second);
-            position = result.find (key, position + placeHolder.second.length ());
+    std::stringstream escaped;
+    for (unsigned char character : value) {
+        if (character == '"' || character == '\\') { escaped << '\\' << character; }
+        else if (character < 0x20) {
+            escaped << "\\u" << std::hex << std::setw (4) << std::setfill ('0') << static_cast <int> (character)
+                    << std::dec << std::setfill (' ');
         }
+        else { escaped << character; }
     }
-    return result;
-} /* End of ReplacePlaceHolders () */
\ No newline at end of file
+    return escaped.str ();
+
+} /* End of EscapeJSON () */
+
+
+/*
+ * This function formats the resources used by a spawned child for the scan summaries.
+ * :arg: usage, const ChildUsage object to be formatted.
+ * :return: string holding wall time, CPU times, peak memory and exit status of the child.
+ */
+std::string FormatChildUsage (const ChildUsage &usage) {
+
+    std::stringstream formatted;
+    formatted << std::fixed << std::setprecision (3) << usage.wallMicros / 1e6 << "s wall, " << usage.userMicros / 1e6
+              << "s user, " << usage.sysMicros / 1e6 << "s sys, " << std::setprecision (1) << usage.maxRSSKiB / 1024.0
+              << " MiB max RSS, ";
+    if (usage.termSignal) { formatted << "killed by signal " << usage.termSignal; }
+    else { formatted << "exit " << usage.exitStatus; }
+    return formatted.str ();
+
+} /* End of FormatChildUsage () */
+
+
+/*
+ * This function adds the resources used by a child to those of another one run at the same time, so both are
+ * reported as a single stage. As the children ran at once, the wall clock time is that of the longer one.
+ * :arg: total, ChildUsage object to which the resources are added.
+ * :arg: usage, const ChildUsage object holding the resources of the other child.
+ */
+void MergeChildUsage (ChildUsage &total, const ChildUsage &usage) {
+
+    if (!usage.valid) { return; }
+    if (!total.valid) {
+        total = usage;
+        return;
+    }
+    total.wallMicros = std::max (total.wallMicros, usage.wallMicros);
+    total.userMicros += usage.userMicros;
+    total.sysMicros += usage.sysMicros;
+    total.maxRSSKiB = std::max (total.maxRSSKiB, usage.maxRSSKiB);
+    /* A child which failed is reported rather than the one which did not */
+    if (usage.termSignal || usage.exitStatus != 0) {
+        total.exitStatus = usage.exitStatus;
+        total.termSignal = usage.termSignal;
+    }
+
+} /* End of MergeChildUsage () */
@@ -0,0 +1,122 @@
+/*
+ ***********************************************************************************************************************
+ * File: testCPE.cpp
+ * Description: This file contains the behaviour tests of CPE names: parsing & normalising both bindings, extracting
+ *              them from the service node of a port and looking ports up by CPE prefix across hosts.
+ * Functions:
+ *           void TestParseCPE ()
+ *           void TestServiceCPEs ()
+ *           void TestIndex ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "cpe.hpp"
+#include "scanner.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function checks parsing of CPE names, in both their 2.2 URI & 2.3 formatted string bindings.
+ */
+static void TestParseCPE () {
+
+    CPE cpe;
+    int depth = 0;
+    Check (ParseCPE ("cpe:/a:openbsd:openssh:8.9p1", cpe, depth), "CPE 2.2 URI");
+    CheckEqual (cpe.part, 'a', "part");
+    CheckEqual (InternedString (cpe.vendor), "openbsd", "vendor");
+    CheckEqual (InternedString (cpe.product), "openssh", "product");
+    CheckEqual (InternedString (cpe.version), "8.9p1", "version");
+    CheckEqual (depth, 4, "depth of a CPE up to its version");
+    CheckEqual (cpe.ToString (), "cpe:/a:openbsd:openssh:8.9p1", "CPE written back");
+
+    CPE formatted;
+    Check (ParseCPE ("cpe:2.3:a:OpenBSD:OpenSSH:8.9p1:*:*:*:*:*:*:*", formatted, depth), "CPE 2.3 string");
+    Check (formatted == cpe, "both bindings compare equal");
+    CheckEqual (depth, 4, "unspecified components are not counted");
+
+    Check (ParseCPE ("cpe:/a:microsoft:internet_explorer:8.%30", cpe, depth), "CPE 2.2 URI with a percent escape");
+    CheckEqual (InternedString (cpe.version), "8.0", "percent escape decoded");
+    Check (ParseCPE ("cpe:2.3:a:vendor:prod\\:uct:1.0:-", cpe, depth), "CPE 2.3 string with a quoted colon");
+    CheckEqual (InternedString (cpe.product), "prod:uct", "quoted colon kept in its component");
+    CheckEqual (cpe.update, CPE_ANY, "\"-\" is unspecified");
+    Check (ParseCPE ("cpe:/o:linux", cpe, depth), "prefix of a CPE");
+    CheckEqual (depth, 2, "depth of a prefix");
+    CheckEqual (cpe.product, CPE_ANY, "missing components are unspecified");
+
+    Check (!ParseCPE ("openssh 8.9p1", cpe, depth), "rejects a name which is no CPE");
+    Check (!ParseCPE ("cpe:/x:vendor", cpe, depth), "rejects an unknown part");
+    Check (!ParseCPE ("cpe:/a:never-seen-vendor", cpe, depth, false), "rejects an unseen component unless interned");
+
+} /* End of TestParseCPE () */
+
+
+/*
+ * This function checks the CPEs extracted from the service node of a port, duplicates and malformed names dropped.
+ */
+static void TestServiceCPEs () {
+
+    const SignatureEngine engine;
+    pugi::xml_document document;
+    document.load_string (
+        "<host><ports><port protocol=\"tcp\" portid=\"80\"><state state=\"open\"/>"
+        "<service name=\"http\" product=\"Apache httpd\" version=\"2.4.49\">"
+        "<cpe>cpe:/a:apache:http_server:2.4.49</cpe><cpe>cpe:2.3:a:apache:http_server:2.4.49:*:*:*:*:*:*:*</cpe>"
+        "<cpe>not a cpe</cpe><cpe>cpe:/o:linux:linux_kernel</cpe></service>"
+        "</port></ports></host>");
+    Logger portLog ("testCPE.log");
+    Port port ("80", STATE_OPEN);
+    port.ExtractScriptResults (document.child ("host"), portLog, engine);
+    CheckEqual (port.cpes.size (), 2U, "CPEs of the service");
+    if (port.cpes.size () == 2) {
+        CheckEqual (port.cpes [0].ToString (), "cpe:/a:apache:http_server:2.4.49", "application CPE");
+        CheckEqual (port.cpes [1].ToString (), "cpe:/o:linux:linux_kernel", "operating system CPE");
+    }
+
+} /* End of TestServiceCPEs () */
+
+
+/*
+ * This function checks looking ports up by every prefix of the CPEs indexed for them.
+ */
+static void TestIndex () {
+
+    CPEIndex index;
+    CPE cpe;
+    int depth = 0;
+    ParseCPE ("cpe:/a:apache:http_server:2.4.49", cpe, depth);
+    index.Add ("192.0.2.1", "80", cpe);
+    index.Add ("192.0.2.1", "80", cpe);
+    ParseCPE ("cpe:/a:apache:http_server:2.4.57", cpe, depth);
+    index.Add ("192.0.2.2", "443", cpe);
+    ParseCPE ("cpe:/a:apache:tomcat", cpe, depth);
+    index.Add ("192.0.2.2", "8080", cpe);
+
+    CheckEqual (index.Find ("cpe:/a").size (), 3U, "ports of a part");
+    CheckEqual (index.Find ("cpe:/a:apache").size (), 3U, "ports of a vendor");
+    CheckEqual (index.Find ("cpe:2.3:a:apache:http_server").size (), 2U, "ports of a product, 2.3 binding");
+    std::vector <PortRef> exact = index.Find ("cpe:/a:apache:http_server:2.4.49");
+    CheckEqual (exact.size (), 1U, "port of a version, added once");
+    if (!exact.empty ()) {
+        CheckEqual (exact [0].address, "192.0.2.1", "address of the port");
+        CheckEqual (exact [0].portid, "80", "id of the port");
+    }
+    CheckEqual (index.Find ("cpe:/a:apache:tomcat:9.0").size (), 0U, "version below an unspecified component");
+    CheckEqual (index.Find ("cpe:/o").size (), 0U, "part without ports");
+    CheckEqual (index.Find ("cpe:/a:not-indexed-vendor").size (), 0U, "component never seen");
+    CheckEqual (index.Find ("apache").size (), 0U, "malformed prefix");
+
+} /* End of TestIndex () */
+
+
+int main () {
+
+    TestParseCPE ();
+    TestServiceCPEs ();
+    TestIndex ();
+    return FinishChecks ("testCPE");
+
+} /* End of main () */
@@ -0,0 +1,152 @@
+/*
+ ***********************************************************************************************************************
+ * File: testCVEIndex.cpp
+ * Description: This file contains the behaviour tests of the offline CVE index: version ordering, building an index
+ *              from a feed, looking up version ranges, matching ports and rejecting a corrupted index file.
+ * Functions:
+ *           void TestVersions ()
+ *           void TestLookup ()
+ *           void TestMatchPorts ()
+ *           void TestCorruptedIndex ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include "cveindex.hpp"
+#include "testCheck.hpp"
+
+const std::string TEST_FEED = "testCVEIndex.feed";
+const std::string TEST_INDEX = "testCVEIndex.idx";
+
+
+/*
+ * This function checks that version keys order the way versions do.
+ */
+static void TestVersions () {
+
+    CheckEqual (CompareVersions (ParseVersion ("8.9p1"), ParseVersion ("8.9p1 Ubuntu 3ubuntu0.1")), 0,
+                "only the first word is keyed");
+    CheckEqual (CompareVersions (ParseVersion ("2.4.9"), ParseVersion ("2.4.49")), -1, "parts compare as numbers");
+    CheckEqual (CompareVersions (ParseVersion ("8.9p1"), ParseVersion ("8.9")), 1, "letters sort after the number");
+    CheckEqual (CompareVersions (ParseVersion ("9.3p2"), ParseVersion ("9.3p1")), 1, "parts after letters compare");
+    CheckEqual (NormaliseProduct ("Apache HTTP Server"), "apache_http_server", "normalised product");
+
+} /* End of TestVersions () */
+
+
+/*
+ * This function checks lookups of products & versions against ranges built from the feed.
+ * :arg: index, const reference to the CVEIndex object built from the feed.
+ */
+static void TestLookup (const CVEIndex &index) {
+
+    auto cves = [&](const std::string &product, const std::string &version, const std::string &vendor = "") {
+        std::string joined;
+        for (const auto &match : index.Lookup (product, version, vendor)) {
+            joined += (joined.empty () ? "" : ",") + match.cve;
+        }
+        return joined;
+    };
+    CheckEqual (cves ("OpenSSH", "8.9p1"), "CVE-2023-38408", "version below an exclusive end");
+    CheckEqual (cves ("openssh", "9.3p2"), "", "version at an exclusive end");
+    CheckEqual (cves ("http_server", "2.4.49"), "CVE-2021-41773", "exact version of the CPE");
+    CheckEqual (cves ("http_server", "2.4.50"), "CVE-2021-42013", "inclusive range");
+    CheckEqual (cves ("http_server", "2.4.50", "apache"), "CVE-2021-42013", "vendor given");
+    CheckEqual (cves ("http_server", "2.4.50", "nginx"), "", "vendor not matching");
+    CheckEqual (cves ("http_server", "2.4.48"), "", "version outside every range");
+    CheckEqual (cves ("unknown", "1.0"), "", "unknown product");
+    if (!index.Lookup ("openssh", "8.9p1").empty ()) {
+        CheckEqual (index.Lookup ("openssh", "8.9p1") [0].score, 6.5f, "CVSS score");
+    }
+
+} /* End of TestLookup () */
+
+
+/*
+ * This function checks matching ports, by their CPEs first and by their whole product name otherwise.
+ * :arg: index, const reference to the CVEIndex object built from the feed.
+ */
+static void TestMatchPorts (const CVEIndex &index) {
+
+    Port ssh ("22", STATE_OPEN, "ssh");
+    ssh.product = "OpenSSH";
+    ssh.version = "8.9p1 Ubuntu 3ubuntu0.1";
+    Port web ("80", STATE_OPEN, "http");
+    web.product = "Apache httpd";
+    web.version = "2.4.50";
+    Port cpeWeb ("8080", STATE_OPEN, "http");
+    CPE cpe;
+    int depth = 0;
+    ParseCPE ("cpe:/a:apache:http_server:2.4.50", cpe, depth);
+    cpeWeb.cpes.push_back (cpe);
+    CheckEqual (index.MatchPorts ({&ssh, &web, &cpeWeb}), 2U, "ports with known CVEs");
+    CheckEqual (ssh.knownCVEs.size (), 1U, "known CVEs of the product");
+    CheckEqual (web.knownCVEs.size (), 0U, "no match on a single word of the product");
+    CheckEqual (cpeWeb.knownCVEs.size (), 1U, "known CVEs of the CPE");
+    CheckEqual (index.MatchPorts ({&cpeWeb}), 1U, "matching again");
+    CheckEqual (cpeWeb.knownCVEs.size (), 1U, "CVEs are not duplicated");
+
+} /* End of TestMatchPorts () */
+
+
+/*
+ * This function checks that an index whose offsets point outside of it is rejected when opened.
+ */
+static void TestCorruptedIndex () {
+
+    Logger indexLog ("testCVEIndex.log");
+    std::string bytes;
+    {
+        std::ifstream input (TEST_INDEX, std::ios::binary);
+        bytes.assign (std::istreambuf_iterator <char> (input), std::istreambuf_iterator <char> ());
+    }
+    const std::vector <std::pair <size_t, std::string>> corruptions = {
+        {sizeof (CVEIndexHeader) + offsetof (TrieNode, firstEdge), "edge offset"},
+        {sizeof (CVEIndexHeader) + offsetof (TrieNode, entryCount), "entry count"},
+        {offsetof (CVEIndexHeader, nodeCount), "node count"},
+    };
+    for (const auto &[offset, field] : corruptions) {
+        std::string corrupted = bytes;
+        uint32_t value = 0x7FFFFFF0;
+        corrupted.replace (offset, sizeof (value), reinterpret_cast <const char *> (&value), sizeof (value));
+        std::ofstream output (TEST_INDEX + ".bad", std::ios::binary | std::ios::trunc);
+        output << corrupted;
+        output.close ();
+        CVEIndex index;
+        CheckEqual (index.Open (TEST_INDEX + ".bad", indexLog), CVE_INDEX_OPEN_FAIL, "rejects a corrupted " + field);
+        Check (!index.IsOpen (), "corrupted index left closed");
+    }
+    std::ofstream output (TEST_INDEX + ".bad", std::ios::binary | std::ios::trunc);
+    output << bytes.substr (0, bytes.size () - 1);
+    output.close ();
+    CVEIndex truncated;
+    CheckEqual (truncated.Open (TEST_INDEX + ".bad", indexLog), CVE_INDEX_OPEN_FAIL, "rejects a truncated index");
+
+} /* End of TestCorruptedIndex () */
+
+
+int main () {
+
+    Logger indexLog ("testCVEIndex.log");
+    std::ofstream feed (TEST_FEED);
+    feed << "# CVE\tCPE\tstart incl\tstart excl\tend incl\tend excl\tscore\n"
+         << "CVE-2023-38408\tcpe:2.3:a:openbsd:openssh:*:*:*:*:*:*:*:*\t\t\t\t9.3p2\t6.5\n"
+         << "CVE-2021-41773\tcpe:2.3:a:apache:http_server:2.4.49:*:*:*:*:*:*:*\n"
+         << "CVE-2021-42013\tcpe:2.3:a:apache:http_server:*:*:*:*:*:*:*:*\t2.4.50\t\t2.4.50\t\t9.8\n"
+         << "CVE-2099-1\tnot a cpe\n";
+    feed.close ();
+    TestVersions ();
+    CheckEqual (BuildCVEIndex (TEST_FEED, TEST_INDEX, indexLog), CVE_INDEX_BUILD_PASS, "index built");
+    CVEIndex index;
+    CheckEqual (index.Open (TEST_INDEX, indexLog), CVE_INDEX_OPEN_PASS, "index opened");
+    TestLookup (index);
+    TestMatchPorts (index);
+    TestCorruptedIndex ();
+    return FinishChecks ("testCVEIndex");
+
+} /* End of main () */
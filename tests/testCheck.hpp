@@ -0,0 +1,64 @@
+/*
+ ***********************************************************************************************************************
+ * File: testCheck.hpp
+ * Description: This file contains the checks shared by the behaviour tests. Each test is a program of its own, which
+ *              reports every failed check and exits with a non-zero status if any check has failed, as ctest expects.
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#ifndef PORTHAWK_TESTCHECK_HPP
+#define PORTHAWK_TESTCHECK_HPP
+
+#include <iostream>
+#include <string>
+
+/* Number of checks failed so far by the test program */
+inline int failedChecks = 0;
+
+
+/*
+ * This function records the outcome of a check, printing the description of the check if it has failed.
+ * :arg: condition, bool value holding the outcome of the check.
+ * :arg: description, const string describing what has been checked.
+ */
+inline void Check (bool condition, const std::string &description) {
+
+    if (condition) { return; }
+    std::cerr << "[FAIL] " << description << std::endl;
+    failedChecks++;
+
+} /* End of Check () */
+
+
+/*
+ * This function records a check of equality, printing both values if they differ.
+ * :arg: actual, value produced by the code under test.
+ * :arg: expected, value expected of it.
+ * :arg: description, const string describing what has been checked.
+ */
+template <typename Actual, typename Expected>
+inline void CheckEqual (const Actual &actual, const Expected &expected, const std::string &description) {
+
+    if (actual == expected) { return; }
+    std::cerr << "[FAIL] " << description << ": got \"" << actual << "\", expected \"" << expected << "\"" << std::endl;
+    failedChecks++;
+
+} /* End of CheckEqual () */
+
+
+/*
+ * This function ends the test program, summarising its checks.
+ * :arg: name, const string holding the name of the test.
+ * :return: integer holding the exit status of the test program.
+ */
+inline int FinishChecks (const std::string &name) {
+
+    std::cout << name << ": " << (failedChecks ? "failed " + std::to_string (failedChecks) + " check(s)" : "passed")
+              << std::endl;
+    return failedChecks ? 1 : 0;
+
+} /* End of FinishChecks () */
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ ***********************************************************************************************************************
+ * File: testCommands.cpp
+ * Description: This file contains the behaviour tests of the command templates: compiling a template into the words
+ *              of an argument vector, rendering it, rejecting invalid templates and loading user-defined ones.
+ * Functions:
+ *           string Joined ()
+ *           void TestBuiltInTemplates ()
+ *           void TestQuotesAndSlots ()
+ *           void TestInvalidTemplates ()
+ *           void TestLoad ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <fstream>
+#include "commands.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function joins an argument vector with '|', so it is compared & printed as a single string.
+ * :arg: arguments, const vector of the arguments.
+ * :return: string holding the joined arguments.
+ */
+static std::string Joined (const std::vector <std::string> &arguments) {
+
+    std::string joined;
+    for (size_t index = 0; index < arguments.size (); index++) { joined += (index ? "|" : "") + arguments [index]; }
+    return joined;
+
+} /* End of Joined () */
+
+
+/*
+ * This function checks the rendering of the built-in templates, a slot making up a whole word expanding to an
+ * argument per value.
+ */
+static void TestBuiltInTemplates () {
+
+    const CommandTemplates templates;
+    CommandValues values;
+    values [SLOT_TARGET] = {"192.0.2.1"};
+    values [SLOT_XML_FILE] = {"PH/Ports/open.xml"};
+    values [SLOT_PORTS] = {"-p", "1-1024"};
+    CheckEqual (Joined (templates.Render (COMMAND_NMAP_OPEN, values)),
+                "nmap|-Pn|-T4|-sT|--min-rate=2000|-p|1-1024|-oX|PH/Ports/open.xml|192.0.2.1", "nmap-open");
+    values [SLOT_PORTS] = {};
+    CheckEqual (Joined (templates.Render (COMMAND_NMAP_OPEN, values)),
+                "nmap|-Pn|-T4|-sT|--min-rate=2000|-oX|PH/Ports/open.xml|192.0.2.1", "slot without a value");
+    values [SLOT_ID] = {"22"};
+    CheckEqual (Joined (templates.Render (COMMAND_NMAP_DEEP_UDP, values)),
+                "nmap|-sU|-sV|-sC|--script=vuln|-p|22|-oX|PH/Ports/open.xml|192.0.2.1", "nmap-deep-udp");
+
+} /* End of TestBuiltInTemplates () */
+
+
+/*
+ * This function checks quoting, braced slots, literal dollars and slots within a word.
+ */
+static void TestQuotesAndSlots () {
+
+    const uint32_t slots = 1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_ID;
+    CommandTemplate command;
+    std::string error;
+    Check (command.Compile ("nmap --script=\"vuln and safe\" -p ${id}0 '$target' -oX $xmlFile $$HOME $target", slots,
+                            error), "valid template: " + error);
+    CommandValues values;
+    values [SLOT_TARGET] = {"192.0.2.1"};
+    values [SLOT_XML_FILE] = {"a b.xml"};
+    values [SLOT_ID] = {"22", "23"};
+    CheckEqual (Joined (command.Render (values)),
+                "nmap|--script=vuln and safe|-p|22,230|$target|-oX|a b.xml|$HOME|192.0.2.1",
+                "quotes, braces & dollars");
+
+} /* End of TestQuotesAndSlots () */
+
+
+/*
+ * This function checks that invalid templates are rejected, leaving the template compiled before in place.
+ */
+static void TestInvalidTemplates () {
+
+    const uint32_t slots = 1U << SLOT_TARGET | 1U << SLOT_XML_FILE | 1U << SLOT_ID;
+    CommandTemplate command;
+    std::string error;
+    Check (command.Compile ("nmap -p $id -oX $xmlFile $target", slots, error), "valid template");
+    const std::vector <std::pair <std::string, std::string>> invalid = {
+        {"nmap -p $id -oX $xmlFile $targets", "unknown slot"},
+        {"nmap -p $id -oX $xmlFile", "missing slot"},
+        {"nmap $ports -p $id -oX $xmlFile $target", "slot not given to the command"},
+        {"nmap -p $id -oX ${xmlFile $target", "unterminated brace"},
+        {"nmap -p $id -oX $xmlFile '$target", "unterminated quote"},
+        {"$target -p $id -oX $xmlFile", "program named by a slot"},
+    };
+    for (const auto &[source, reason] : invalid) {
+        error.clear ();
+        Check (!command.Compile (source, slots, error) && !error.empty (), "rejects " + reason);
+    }
+    CheckEqual (command.Text (), "nmap -p $id -oX $xmlFile $target", "template kept after rejections");
+
+} /* End of TestInvalidTemplates () */
+
+
+/*
+ * This function checks loading user-defined templates, invalid lines keeping the built-in template.
+ */
+static void TestLoad () {
+
+    const std::string fileName = "testCommands.conf";
+    std::ofstream file (fileName);
+    file << "# comment\n" << "nmap-open = nmap -sS $ports -oX $xmlFile $target\n"
+         << "nmap-deep = nmap -p $id $target\n" << "nmap-bogus = nmap $target\n";
+    file.close ();
+    Logger loadLog ("testCommands.log");
+    CommandTemplates templates;
+    CheckEqual (templates.Load (fileName, loadLog), COMMAND_TEMPLATE_FAIL, "load with invalid lines");
+    CommandValues values;
+    values [SLOT_TARGET] = {"192.0.2.1"};
+    values [SLOT_XML_FILE] = {"open.xml"};
+    values [SLOT_PORTS] = {"-p", "22"};
+    CheckEqual (Joined (templates.Render (COMMAND_NMAP_OPEN, values)), "nmap|-sS|-p|22|-oX|open.xml|192.0.2.1",
+                "user-defined template overrides the built-in");
+    CheckEqual (templates.Get (COMMAND_NMAP_DEEP).Text (), BASE_NMAP_DEEP, "invalid line keeps the built-in");
+    CheckEqual (templates.Load ("testCommands.absent", loadLog), COMMANDS_DEFAULT_INFO, "absent file");
+    CheckEqual (templates.Get (COMMAND_NMAP_OPEN).Text (), BASE_NMAP_OPEN, "absent file restores the built-in");
+
+} /* End of TestLoad () */
+
+
+int main () {
+
+    TestBuiltInTemplates ();
+    TestQuotesAndSlots ();
+    TestInvalidTemplates ();
+    TestLoad ();
+    return FinishChecks ("testCommands");
+
+} /* End of main () */
@@ -0,0 +1,112 @@
+/*
+ ***********************************************************************************************************************
+ * File: testCongestion.cpp
+ * Description: This file contains the behaviour tests of the congestion controller of the native sweep: the window
+ *              growing in slow start & additively afterwards, halving once per round trip on loss, the RTO estimated
+ *              from RTT samples as in RFC 6298 and the controllers shared per /24 network.
+ * Functions:
+ *           void TestInitial ()
+ *           void TestWindow ()
+ *           void TestTimeout ()
+ *           void TestNetworks ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "discovery.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function checks the decisions of a controller which has not been answered yet.
+ */
+static void TestInitial () {
+
+    CongestionController controller;
+    CheckEqual (controller.Window (), DISC_WINDOW_INIT, "initial window");
+    CheckEqual (controller.TimeoutMs (), DISC_RTO_INIT_MS, "initial timeout");
+    Check (controller.Rate () >= 1e9, "pace unbounded until the first sample");
+
+} /* End of TestInitial () */
+
+
+/*
+ * This function checks the window: additive increase per response, multiplicative decrease per loss, within its cap.
+ */
+static void TestWindow () {
+
+    CongestionController controller;
+    controller.OnResponse (200000);
+    CheckEqual (controller.Window (), DISC_WINDOW_INIT + 1, "slow start grows a probe per response");
+    controller.OnResponse (200000);
+    CheckEqual (controller.Window (), DISC_WINDOW_INIT + 2, "slow start again");
+    Check (controller.Rate () > 89.9 && controller.Rate () < 90.1, "pace of window / RTT");
+
+    Check (controller.OnTimeout (), "loss reduces the window");
+    CheckEqual (controller.Window (), (DISC_WINDOW_INIT + 2) / 2, "window halved");
+    Check (!controller.OnTimeout (), "losses within the round trip are one congestion event");
+    CheckEqual (controller.Window (), (DISC_WINDOW_INIT + 2) / 2, "window halved once");
+
+    controller.OnResponse (200000);
+    CheckEqual (controller.Window (), (DISC_WINDOW_INIT + 2) / 2, "congestion avoidance grows less than a probe");
+    for (int response = 0; response < 9; response++) { controller.OnResponse (200000); }
+    CheckEqual (controller.Window (), (DISC_WINDOW_INIT + 2) / 2 + 1, "a probe per window of responses");
+
+    CongestionController capped;
+    capped.Limit (4);
+    CheckEqual (capped.Window (), 4U, "window limited");
+    for (int response = 0; response < 10; response++) { capped.OnResponse (1000); }
+    CheckEqual (capped.Window (), 4U, "growth stops at the limit");
+    capped.Limit (0);
+    CheckEqual (capped.Window (), 1U, "limited to a probe at least");
+    capped.OnTimeout ();
+    CheckEqual (capped.Window (), 1U, "loss does not raise the window over its limit");
+
+} /* End of TestWindow () */
+
+
+/*
+ * This function checks the timeout estimated from RTT samples, and its bounds.
+ */
+static void TestTimeout () {
+
+    CongestionController controller;
+    controller.OnResponse (200000);
+    CheckEqual (controller.TimeoutMs (), 600, "first sample: SRTT + 4 * SRTT / 2");
+    controller.OnResponse (200000);
+    CheckEqual (controller.TimeoutMs (), 500, "variance decays with a steady RTT");
+    controller.OnResponse (400000);
+    CheckEqual (controller.TimeoutMs (), 650, "variance grows with a changing RTT");
+
+    CongestionController fast;
+    fast.OnResponse (1000);
+    CheckEqual (fast.TimeoutMs (), DISC_RTO_MIN_MS, "timeout at least its minimum");
+    CongestionController slow;
+    slow.OnResponse (2000000);
+    CheckEqual (slow.TimeoutMs (), DISC_RTO_MAX_MS, "timeout at most its maximum");
+
+} /* End of TestTimeout () */
+
+
+/*
+ * This function checks that the addresses of a /24 network share a controller.
+ */
+static void TestNetworks () {
+
+    Check (&NetworkController ("192.0.2.1") == &NetworkController ("192.0.2.200"), "controller shared by a /24");
+    Check (&NetworkController ("192.0.2.1") != &NetworkController ("198.51.100.1"), "controller per network");
+
+} /* End of TestNetworks () */
+
+
+int main () {
+
+    TestInitial ();
+    TestWindow ();
+    TestTimeout ();
+    TestNetworks ();
+    return FinishChecks ("testCongestion");
+
+} /* End of main () */
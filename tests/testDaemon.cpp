@@ -0,0 +1,76 @@
+/*
+ ***********************************************************************************************************************
+ * File: testDaemon.cpp
+ * Description: This file contains the behaviour tests of the requests taken by the scan daemon: splitting a request
+ *              line into its words, defaulting the profile and rejecting invalid requests with the ERR message sent.
+ * Functions:
+ *           string Parsed ()
+ *           void TestValidRequests ()
+ *           void TestInvalidRequests ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "daemon.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function parses a request line and joins its fields with '|', or returns the error of an invalid request.
+ * :arg: line, const string holding the request line.
+ * :return: string holding the verb, target, profile & job id of the request, or "ERR <message>".
+ */
+static std::string Parsed (const std::string &line) {
+
+    DaemonRequest request;
+    std::string error;
+    if (!ParseRequest (line, request, error)) { return "ERR " + error; }
+    return request.verb + "|" + request.target + "|" + request.profile + "|" + std::to_string (request.id);
+
+} /* End of Parsed () */
+
+
+/*
+ * This function checks the fields of valid requests.
+ */
+static void TestValidRequests () {
+
+    CheckEqual (Parsed ("SUBMIT scanme.example"), "SUBMIT|scanme.example|" + PROFILE_DEFAULT + "|0", "default profile");
+    CheckEqual (Parsed ("SUBMIT 192.0.2.1 " + PROFILE_DISCOVERY), "SUBMIT|192.0.2.1|" + PROFILE_DISCOVERY + "|0",
+                "profile given");
+    CheckEqual (Parsed ("  STATUS   42 "), "STATUS|||42", "words split on any spacing");
+    CheckEqual (Parsed ("RESULTS 7"), "RESULTS|||7", "results");
+    CheckEqual (Parsed ("CANCEL 4294967295"), "CANCEL|||4294967295", "largest job id");
+    CheckEqual (Parsed ("LIST"), "LIST|||0", "list");
+    CheckEqual (Parsed ("SHUTDOWN"), "SHUTDOWN|||0", "shutdown");
+
+} /* End of TestValidRequests () */
+
+
+/*
+ * This function checks the ERR message of invalid requests.
+ */
+static void TestInvalidRequests () {
+
+    CheckEqual (Parsed (""), "ERR unknown request", "empty line");
+    CheckEqual (Parsed ("submit 192.0.2.1"), "ERR unknown request", "verbs are upper case");
+    CheckEqual (Parsed ("SUBMIT"), "ERR target required", "target missing");
+    CheckEqual (Parsed ("SUBMIT 192.0.2.1 aggressive"), "ERR unknown profile", "unknown profile");
+    CheckEqual (Parsed ("STATUS"), "ERR job id required", "job id missing");
+    CheckEqual (Parsed ("CANCEL abc"), "ERR job id required", "job id not a number");
+    CheckEqual (Parsed ("RESULTS 12x"), "ERR job id required", "job id with trailing characters");
+    CheckEqual (Parsed ("STATUS -1"), "ERR job id required", "negative job id");
+    CheckEqual (Parsed ("STATUS 4294967296"), "ERR job id required", "job id over 32 bits");
+
+} /* End of TestInvalidRequests () */
+
+
+int main () {
+
+    TestValidRequests ();
+    TestInvalidRequests ();
+    return FinishChecks ("testDaemon");
+
+} /* End of main () */
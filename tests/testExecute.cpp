@@ -0,0 +1,75 @@
+/*
+ ***********************************************************************************************************************
+ * File: testExecute.cpp
+ * Description: This file contains the behaviour tests of running scan children: their output, resource accounting and
+ *              the return code of a child which ran, could not be run, was killed or was cancelled.
+ * Functions:
+ *           ReturnCodes Run ()
+ *           void TestExecute ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "testCheck.hpp"
+#include "utilities.hpp"
+
+
+/*
+ * This function runs a command to its end.
+ * :arg: command, const vector of the arguments, the program first.
+ * :arg: output, string to which the output of the command is copied to.
+ * :arg: usage, ChildUsage object to which the resources used by the command are copied to.
+ * :arg: cancel, bool value indicating whether the command is cancelled before it is run.
+ * :return: ReturnCodes object returned for the command.
+ */
+static ReturnCodes Run (const std::vector <std::string> &command, std::string &output, ChildUsage &usage,
+                        bool cancel = false) {
+
+    CancelToken token;
+    if (cancel) { token.Cancel (); }
+    std::stringstream stream;
+    ReturnCodes result = ExecuteSystemCommand (command, stream, token, &usage);
+    output = stream.str ();
+    return result;
+
+} /* End of Run () */
+
+
+/*
+ * This function checks the return code, output & exit status of children ending each way.
+ */
+static void TestExecute () {
+
+    std::string output;
+    ChildUsage usage;
+    CheckEqual (Run ({"sh", "-c", "echo 'a b'"}, output, usage), CMD_EXEC_PASS, "command run");
+    CheckEqual (output, "a b\n", "output captured, arguments not split by a shell");
+    Check (usage.valid && usage.exitStatus == 0 && usage.termSignal == 0, "exit status of the command");
+
+    usage = ChildUsage ();
+    CheckEqual (Run ({"sh", "-c", "exit 3"}, output, usage), CMD_EXEC_PASS, "command exiting with an error");
+    CheckEqual (usage.exitStatus, 3, "its exit status");
+
+    usage = ChildUsage ();
+    CheckEqual (Run ({"porthawk-no-such-program"}, output, usage), CMD_EXEC_FAIL, "program which could not be run");
+    CheckEqual (usage.exitStatus, EXIT_NOT_RUN, "its exit status");
+
+    usage = ChildUsage ();
+    CheckEqual (Run ({"sh", "-c", "kill -KILL $$"}, output, usage), CMD_EXEC_FAIL, "command killed by a signal");
+    CheckEqual (usage.termSignal, 9, "its signal");
+
+    usage = ChildUsage ();
+    CheckEqual (Run ({"true"}, output, usage, true), CMD_EXEC_CANCEL, "command cancelled");
+    Check (!usage.valid, "cancelled before it was spawned");
+
+} /* End of TestExecute () */
+
+
+int main () {
+
+    TestExecute ();
+    return FinishChecks ("testExecute");
+
+} /* End of main () */
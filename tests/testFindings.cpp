@@ -0,0 +1,148 @@
+/*
+ ***********************************************************************************************************************
+ * File: testFindings.cpp
+ * Description: This file contains the behaviour tests of structured findings: packing CVE ids, parsing finding states,
+ *              extracting findings from the NSE tables of the vulns library & of vulners-style listings, and ranking
+ *              them most severe first without duplicates.
+ * Functions:
+ *           void TestPackCVE ()
+ *           void TestStates ()
+ *           vector <Finding> Extract ()
+ *           void TestExtractFindings ()
+ *           void TestRankFindings ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "cpe.hpp"
+#include "findings.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function checks packing CVE ids into 32 bits & back.
+ */
+static void TestPackCVE () {
+
+    CheckEqual (PackCVE ("CVE-2017-0143"), (27U << 24) | 143U, "packed CVE id");
+    CheckEqual (PackCVE ("CVE:cve-2017-0143"), PackCVE ("CVE-2017-0143"), "NSE id prefix & case ignored");
+    CheckEqual (UnpackCVE (PackCVE ("CVE-2017-0143")), "CVE-2017-0143", "unpacked with a padded sequence number");
+    CheckEqual (UnpackCVE (PackCVE ("CVE-2021-44228")), "CVE-2021-44228", "five digit sequence number");
+    CheckEqual (PackCVE ("CVE-1990-0001"), 0U, "year not after the base");
+    CheckEqual (PackCVE ("CVE-2017-16777216"), 0U, "sequence number over 24 bits");
+    CheckEqual (PackCVE ("MS17-010"), 0U, "id which is no CVE");
+
+} /* End of TestPackCVE () */
+
+
+/*
+ * This function checks the states reported by the NSE vulns library, and their names.
+ */
+static void TestStates () {
+
+    CheckEqual (ParseFindingState ("NOT VULNERABLE"), FINDING_NOT_VULNERABLE, "not vulnerable");
+    CheckEqual (ParseFindingState ("LIKELY VULNERABLE"), FINDING_LIKELY, "likely vulnerable");
+    CheckEqual (ParseFindingState ("VULNERABLE (Exploitable)"), FINDING_EXPLOITABLE, "exploitable");
+    CheckEqual (ParseFindingState ("vulnerable"), FINDING_VULNERABLE, "vulnerable, any case");
+    CheckEqual (ParseFindingState ("UNKNOWN (unable to test)"), FINDING_UNKNOWN, "unknown");
+    CheckEqual (ParseFindingState (FindingStateName (FINDING_LIKELY)), FINDING_LIKELY, "name parsed back");
+
+} /* End of TestStates () */
+
+
+/*
+ * This function extracts the findings of a <script> node.
+ * :arg: xml, const string holding the <script> node.
+ * :return: vector of the findings extracted.
+ */
+static std::vector <Finding> Extract (const std::string &xml) {
+
+    pugi::xml_document document;
+    document.load_string (xml.c_str ());
+    std::vector <Finding> findings;
+    ExtractFindings (document.child ("script"), SCOPE_PORT, findings);
+    return findings;
+
+} /* End of Extract () */
+
+
+/*
+ * This function checks findings extracted from a vulns library table & from a vulners listing grouped by CPE.
+ */
+static void TestExtractFindings () {
+
+    std::vector <Finding> library = Extract (
+        "<script id=\"smb-vuln-ms17-010\"><table key=\"CVE-2017-0143\">"
+        "<elem key=\"title\">Remote Code Execution vulnerability in Microsoft SMBv1</elem>"
+        "<elem key=\"state\">VULNERABLE</elem>"
+        "<table key=\"ids\"><elem>CVE:CVE-2017-0143</elem><elem>CVE:CVE-2017-0144</elem></table>"
+        "<table key=\"scores\"><elem>7.5</elem><elem>9.3</elem></table>"
+        "<table key=\"refs\"><elem>https://example.test/a</elem></table>"
+        "</table></script>");
+    CheckEqual (library.size (), 1U, "findings of a vulns library table");
+    if (library.size () == 1) {
+        const Finding &finding = library [0];
+        CheckEqual (finding.state, FINDING_VULNERABLE, "state");
+        CheckEqual (finding.cveCount, 2U, "CVE ids, the key not repeated");
+        CheckEqual (finding.score, 93U, "highest score kept");
+        CheckEqual (finding.refCount, 1U, "references");
+        CheckEqual (InternedString (finding.script), "smb-vuln-ms17-010", "script");
+        CheckEqual (FormatFinding (finding), "[vulnerable] CVE-2017-0143 CVE-2017-0144 (9.3) smb-vuln-ms17-010: "
+                    "Remote Code Execution vulnerability in Microsoft SMBv1", "formatted finding");
+    }
+
+    std::vector <Finding> listing = Extract (
+        "<script id=\"vulners\"><table key=\"cpe:/a:openbsd:openssh:8.9p1\">"
+        "<table><elem key=\"id\">CVE-2023-38408</elem><elem key=\"cvss\">9.8</elem></table>"
+        "<table><elem key=\"id\">PACKETSTORM:1</elem><elem key=\"cvss\">5.0</elem></table>"
+        "</table><table key=\"other\"><elem key=\"note\">no finding</elem></table></script>");
+    CheckEqual (listing.size (), 2U, "findings of a listing nested by CPE");
+    for (const Finding &finding : listing) {
+        CheckEqual (finding.state, FINDING_LIKELY, "listing derived from the version");
+        if (finding.cveCount) { CheckEqual (finding.score, 98U, "CVSS score of the listing"); }
+    }
+
+} /* End of TestExtractFindings () */
+
+
+/*
+ * This function checks that findings rank most severe first, duplicates keeping their most severe copy.
+ */
+static void TestRankFindings () {
+
+    auto make = [](const std::string &cve, FindingState state, uint16_t score) {
+        Finding finding {};
+        finding.script = InternString ("script");
+        finding.title = InternString (cve);
+        finding.cves [0] = PackCVE (cve);
+        finding.cveCount = 1;
+        finding.state = state;
+        finding.score = score;
+        return finding;
+    };
+    std::vector <Finding> findings = {make ("CVE-2020-0001", FINDING_LIKELY, 98),
+                                      make ("CVE-2020-0002", FINDING_VULNERABLE, 50),
+                                      make ("CVE-2020-0001", FINDING_EXPLOITABLE, 70),
+                                      make ("CVE-2020-0003", FINDING_VULNERABLE, 75)};
+    RankFindings (findings);
+    CheckEqual (findings.size (), 3U, "duplicate dropped");
+    if (findings.size () != 3) { return; }
+    CheckEqual (UnpackCVE (findings [0].cves [0]), "CVE-2020-0001", "most severe state first");
+    CheckEqual (findings [0].state, FINDING_EXPLOITABLE, "most severe duplicate kept");
+    CheckEqual (UnpackCVE (findings [1].cves [0]), "CVE-2020-0003", "higher score before lower within a state");
+    CheckEqual (UnpackCVE (findings [2].cves [0]), "CVE-2020-0002", "lowest last");
+
+} /* End of TestRankFindings () */
+
+
+int main () {
+
+    TestPackCVE ();
+    TestStates ();
+    TestExtractFindings ();
+    TestRankFindings ();
+    return FinishChecks ("testFindings");
+
+} /* End of main () */
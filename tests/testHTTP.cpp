@@ -0,0 +1,181 @@
+/*
+ ***********************************************************************************************************************
+ * File: testHTTP.cpp
+ * Description: This file contains the behaviour tests of HTTP fingerprinting: the MurmurHash3 & favicon hashes, and
+ *              fetching paths from a local server which either answers pipelined requests over one connection or
+ *              answers a single request per connection, with responses framed by length, by chunks & by the end of
+ *              the stream.
+ * Functions:
+ *           void TestHashes ()
+ *           string Respond ()
+ *           void Serve ()
+ *           HTTPFingerprint Fetch ()
+ *           void TestFetch ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include "http.hpp"
+#include "testCheck.hpp"
+#include "utilities.hpp"
+
+/* Favicon served by the test server, its hash computed by mmh3.hash (base64.encodebytes (icon)) */
+const int32_t TEST_FAVICON_HASH = -1874651529;
+
+
+/*
+ * This function checks the hashes against published MurmurHash3 test vectors and a favicon hashed the Shodan way.
+ */
+static void TestHashes () {
+
+    CheckEqual (MurmurHash3 (""), 0, "empty input");
+    CheckEqual (static_cast <uint32_t> (MurmurHash3 ("", 1)), 0x514E28B7U, "empty input, seeded");
+    CheckEqual (static_cast <uint32_t> (MurmurHash3 ("Hello, world!", 0x9747B28C)), 0x24884CBAU, "13 bytes");
+    CheckEqual (static_cast <uint32_t> (MurmurHash3 ("The quick brown fox jumps over the lazy dog", 0x9747B28C)),
+                0x2FA826CDU, "43 bytes");
+    std::string icon;
+    for (int byte = 0; byte < 200; byte++) { icon += static_cast <char> (byte); }
+    CheckEqual (FaviconHash (icon), TEST_FAVICON_HASH, "favicon of several base64 lines");
+    Check (IsHTTPService ("http", "8080") && IsHTTPService ("unknown", "80") && !IsHTTPService ("ssh", "22"),
+           "HTTP services");
+
+} /* End of TestHashes () */
+
+
+/*
+ * This function builds the response of the test server to a path.
+ * :arg: path, const string holding the path requested.
+ * :arg: close, bool value indicating whether the connection is closed after the response.
+ * :return: string holding the response.
+ */
+static std::string Respond (const std::string &path, bool close) {
+
+    std::string connection = close ? "Connection: close\r\n" : "";
+    if (path == "/") {
+        return "HTTP/1.1 200 OK\r\nServer: TestServer/1.0\r\nContent-Type: text/html\r\nX-Powered-By: PHP/8.1\r\n" +
+               connection + "Transfer-Encoding: chunked\r\n\r\n" + "d\r\n<html><title>\r\n" +
+               "15\r\n  Test \n Page</title>\r\n" + "0\r\n\r\n";
+    }
+    if (path == "/favicon.ico") {
+        std::string icon;
+        for (int byte = 0; byte < 200; byte++) { icon += static_cast <char> (byte); }
+        return "HTTP/1.1 200 OK\r\nContent-Type: image/x-icon\r\n" + connection + "Content-Length: " +
+               std::to_string (icon.size ()) + "\r\n\r\n" + icon;
+    }
+    /* The last response of a connection runs until the connection is closed */
+    if (close) { return "HTTP/1.1 404 Not Found\r\n" + connection + "\r\nNot here"; }
+    return "HTTP/1.1 404 Not Found\r\nContent-Length: 8\r\n\r\nNot here";
+
+} /* End of Respond () */
+
+
+/*
+ * This function runs the test server until the listener is shut down. A pipelining server answers every request of
+ * a connection, the other answers the first request only and closes the connection.
+ * :arg: listener, integer holding the descriptor of the listening socket.
+ * :arg: pipelining, bool value indicating whether requests are pipelined.
+ */
+static void Serve (int listener, bool pipelining) {
+
+    for (;;) {
+        int client = accept (listener, nullptr, nullptr);
+        if (client < 0) { return; }
+        std::string received;
+        char buffer [4096];
+        bool open = true;
+        while (open) {
+            size_t end = received.find ("\r\n\r\n");
+            if (end == std::string::npos) {
+                ssize_t bytes = read (client, buffer, sizeof (buffer));
+                if (bytes <= 0) { break; }
+                received.append (buffer, bytes);
+                continue;
+            }
+            std::string request = received.substr (0, end);
+            received.erase (0, end + 4);
+            std::string path = request.substr (4, request.find (' ', 4) - 4);
+            open = pipelining && request.find ("Connection: close") == std::string::npos;
+            std::string response = Respond (path, !open);
+            if (write (client, response.data (), response.size ()) < 0) { break; }
+        }
+        close (client);
+    }
+
+} /* End of Serve () */
+
+
+/*
+ * This function fetches the default paths from a test server on a loopback port.
+ * :arg: pipelining, bool value indicating whether the server pipelines requests.
+ * :return: HTTPFingerprint object of the server.
+ */
+static HTTPFingerprint Fetch (bool pipelining) {
+
+    HTTPFingerprint fingerprint;
+    int listener = socket (AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in local {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    socklen_t length = sizeof (local);
+    if (listener < 0 || bind (listener, reinterpret_cast <struct sockaddr *> (&local), sizeof (local)) != 0 ||
+        listen (listener, 8) != 0 || getsockname (listener, reinterpret_cast <struct sockaddr *> (&local), &length)) {
+        Check (false, "test server listening");
+        if (listener >= 0) { close (listener); }
+        return fingerprint;
+    }
+    std::thread server (Serve, listener, pipelining);
+    CancelToken token;
+    EventLoop loop;
+    loop.Spawn (StoreResult (FetchHTTP (loop, "127.0.0.1", std::to_string (ntohs (local.sin_port)), HTTP_PATHS, false,
+                                        token), fingerprint));
+    loop.Run ();
+    shutdown (listener, SHUT_RDWR);
+    server.join ();
+    close (listener);
+    return fingerprint;
+
+} /* End of Fetch () */
+
+
+/*
+ * This function checks the fingerprint of the test server, fetched both ways.
+ */
+static void TestFetch () {
+
+    for (bool pipelining : {true, false}) {
+        std::string mode = pipelining ? "pipelined: " : "one request per connection: ";
+        HTTPFingerprint fingerprint = Fetch (pipelining);
+        Check (fingerprint.fetched, mode + "fetched");
+        CheckEqual (fingerprint.connections, pipelining ? 1 : 3, mode + "connections");
+        CheckEqual (fingerprint.responses.size (), 3U, mode + "responses");
+        if (fingerprint.responses.size () != 3) { continue; }
+        const HTTPResponse &page = fingerprint.responses [0];
+        CheckEqual (page.path, "/", mode + "path");
+        CheckEqual (page.status, 200, mode + "status");
+        CheckEqual (page.server, "TestServer/1.0", mode + "server");
+        CheckEqual (page.poweredBy, "PHP/8.1", mode + "powered by");
+        CheckEqual (page.title, "Test Page", mode + "title from a chunked body");
+        CheckEqual (page.bodyBytes, 34U, mode + "decoded body");
+        CheckEqual (fingerprint.responses [2].status, 404, mode + "missing path");
+        CheckEqual (fingerprint.responses [2].bodyBytes, 8U, mode + "body framed by the end of the stream");
+        Check (fingerprint.hasFavicon, mode + "favicon");
+        CheckEqual (fingerprint.faviconHash, TEST_FAVICON_HASH, mode + "favicon hash");
+    }
+
+} /* End of TestFetch () */
+
+
+int main () {
+
+    TestHashes ();
+    TestFetch ();
+    return FinishChecks ("testHTTP");
+
+} /* End of main () */
@@ -0,0 +1,135 @@
+/*
+ ***********************************************************************************************************************
+ * File: testJournal.cpp
+ * Description: This file contains the behaviour tests of the scan journal: work checkpointed by a run is restored by
+ *              a resumed one, a record torn by a crash is dropped, and a run which does not resume starts afresh.
+ * Functions:
+ *           void RecordScan ()
+ *           void TestResume ()
+ *           void TestTornRecord ()
+ *           void TestFreshRun ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <fstream>
+#include "journal.hpp"
+#include "testCheck.hpp"
+
+const std::string TEST_JOURNAL = "testJournal.wal";
+const std::string TEST_ADDRESS = "192.0.2.10";
+
+
+/*
+ * This function checkpoints the discovery of two ports of a host and the deep scan of one of them.
+ */
+static void RecordScan () {
+
+    Logger journalLog ("testJournal.log");
+    Journal journal (TEST_JOURNAL);
+    CheckEqual (journal.Open (false, journalLog), JOURNAL_OPEN_PASS, "journal opened");
+    Port ssh ("22", STATE_OPEN, "ssh");
+    Port dns ("53", STATE_OPEN_FLTR, "domain", PROTO_UDP);
+    journal.RecordDiscoveryStart (TEST_ADDRESS);
+    journal.RecordDiscoveredPort (TEST_ADDRESS, ssh);
+    journal.RecordDiscoveredPort (TEST_ADDRESS, dns);
+    journal.RecordDiscoveryEnd (TEST_ADDRESS);
+    ssh.product = "OpenSSH";
+    ssh.version = "8.9p1 Ubuntu 3ubuntu0.1";
+    ssh.severity = SEV_HIGH;
+    ssh.vulnerabilities = {"ssh-vuln"};
+    ssh.cves = {"CVE-2023-38408"};
+    CPE cpe;
+    int depth = 0;
+    ParseCPE ("cpe:/a:openbsd:openssh:8.9p1", cpe, depth);
+    ssh.cpes.push_back (cpe);
+    journal.RecordDeepScan (TEST_ADDRESS, ssh);
+
+} /* End of RecordScan () */
+
+
+/*
+ * This function checks that a resumed run restores the discovered ports & the completed deep scan.
+ */
+static void TestResume () {
+
+    Logger journalLog ("testJournal.log");
+    Journal journal (TEST_JOURNAL);
+    CheckEqual (journal.Open (true, journalLog), JOURNAL_OPEN_PASS, "journal resumed");
+    const JournalHost *host = journal.Find (TEST_ADDRESS);
+    Check (host != nullptr, "host restored");
+    Check (journal.Find ("192.0.2.11") == nullptr, "no other host restored");
+    if (!host) { return; }
+    Check (host->discovered, "discovery completed");
+    CheckEqual (host->ports.size (), 2U, "discovered ports");
+    if (host->ports.size () == 2) { CheckEqual (host->ports [1].protocol, PROTO_UDP, "protocol of a UDP port"); }
+    CheckEqual (host->completed.size (), 1U, "completed deep scans");
+    auto find = host->completed.find (Port ("22", STATE_OPEN).Key ());
+    Check (find != host->completed.end (), "deep scan keyed by port");
+    if (find == host->completed.end ()) { return; }
+    const Port &port = find->second;
+    CheckEqual (port.product, "OpenSSH", "product");
+    CheckEqual (port.version, "8.9p1 Ubuntu 3ubuntu0.1", "version with spaces");
+    CheckEqual (SeverityName (port.severity), "high", "severity");
+    CheckEqual (port.cves.size (), 1U, "CVE ids");
+    CheckEqual (port.cpes.size (), 1U, "CPEs");
+
+    /* Restoring into a port already identified natively keeps what the restored scan did not find */
+    Port current ("22", STATE_OPEN, "ssh");
+    current.extraInfo = "protocol 2.0";
+    current.RestoreDeepScan (port);
+    CheckEqual (current.product, "OpenSSH", "restored product");
+    CheckEqual (current.vulnerabilities.size (), 1U, "restored vulnerabilities");
+
+} /* End of TestResume () */
+
+
+/*
+ * This function checks that a record torn mid-write is dropped on resume, keeping every record before it.
+ */
+static void TestTornRecord () {
+
+    {
+        std::ofstream torn (TEST_JOURNAL, std::ios::app);
+        torn << "0badf00d P\t" << TEST_ADDRESS << "\t53";
+    }
+    Logger journalLog ("testJournal.log");
+    Journal journal (TEST_JOURNAL);
+    CheckEqual (journal.Open (true, journalLog), JOURNAL_OPEN_PASS, "journal with a torn record resumed");
+    const JournalHost *host = journal.Find (TEST_ADDRESS);
+    Check (host && host->completed.size () == 1, "torn record dropped, earlier records kept");
+    std::ifstream input (TEST_JOURNAL);
+    std::string content ((std::istreambuf_iterator <char> (input)), std::istreambuf_iterator <char> ());
+    Check (!content.empty () && content.back () == '\n', "torn tail truncated from the file");
+
+} /* End of TestTornRecord () */
+
+
+/*
+ * This function checks that a run which does not resume discards the journal of the earlier run.
+ */
+static void TestFreshRun () {
+
+    Logger journalLog ("testJournal.log");
+    {
+        Journal journal (TEST_JOURNAL);
+        CheckEqual (journal.Open (false, journalLog), JOURNAL_OPEN_PASS, "journal opened afresh");
+    }
+    Journal journal (TEST_JOURNAL);
+    journal.Open (true, journalLog);
+    Check (journal.Find (TEST_ADDRESS) == nullptr, "nothing restored after a fresh run");
+
+} /* End of TestFreshRun () */
+
+
+int main () {
+
+    RecordScan ();
+    TestResume ();
+    TestTornRecord ();
+    TestFreshRun ();
+    return FinishChecks ("testJournal");
+
+} /* End of main () */
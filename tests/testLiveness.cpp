@@ -0,0 +1,103 @@
+/*
+ ***********************************************************************************************************************
+ * File: testLiveness.cpp
+ * Description: This file contains the behaviour tests of the liveness sweep: the policy applied to targets of unknown
+ *              liveness, which targets are admitted into port discovery, the summary printed and a sweep of the
+ *              loopback address.
+ * Functions:
+ *           void TestPolicy ()
+ *           void TestSummary ()
+ *           void TestSweep ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <sstream>
+#include "liveness.hpp"
+#include "testCheck.hpp"
+#include "utilities.hpp"
+
+
+/*
+ * This function checks the policy names and the targets each policy admits.
+ */
+static void TestPolicy () {
+
+    UnknownPolicy policy = UNKNOWN_SKIP;
+    Check (ParseUnknownPolicy ("scan", policy) && policy == UNKNOWN_SCAN, "scan policy");
+    Check (ParseUnknownPolicy ("skip", policy) && policy == UNKNOWN_SKIP, "skip policy");
+    Check (!ParseUnknownPolicy ("SCAN", policy) && policy == UNKNOWN_SKIP, "names are lower case, policy kept");
+    Check (!ParseUnknownPolicy ("", policy), "empty name");
+
+    HostLiveness up {"192.0.2.1", LIVENESS_UP, "icmp echo-reply", 1500};
+    HostLiveness down {"192.0.2.2", LIVENESS_DOWN, "tcp/80 unreachable", 2000};
+    HostLiveness unknown {"192.0.2.3", LIVENESS_UNKNOWN, "", 0};
+    for (UnknownPolicy applied : {UNKNOWN_SCAN, UNKNOWN_SKIP}) {
+        std::string name = applied == UNKNOWN_SCAN ? "scan: " : "skip: ";
+        Check (AdmitHost (up, applied), name + "host up admitted");
+        Check (!AdmitHost (down, applied), name + "host down left out");
+    }
+    Check (AdmitHost (unknown, UNKNOWN_SCAN), "unknown host admitted when scanned");
+    Check (!AdmitHost (unknown, UNKNOWN_SKIP), "unknown host left out when skipped");
+
+} /* End of TestPolicy () */
+
+
+/*
+ * This function checks the summary of a sweep lists the counts and only the targets admitted.
+ */
+static void TestSummary () {
+
+    std::vector <HostLiveness> hosts = {{"192.0.2.1", LIVENESS_UP, "icmp echo-reply", 1500},
+                                        {"192.0.2.2", LIVENESS_DOWN, "tcp/80 unreachable", 2000},
+                                        {"192.0.2.3", LIVENESS_UNKNOWN, "", 0}};
+    Logger summaryLog ("testLiveness.log");
+    for (UnknownPolicy policy : {UNKNOWN_SCAN, UNKNOWN_SKIP}) {
+        std::stringstream out;
+        PrintLivenessSummary (hosts, policy, summaryLog, out);
+        std::string summary = out.str ();
+        std::string name = policy == UNKNOWN_SCAN ? "scan: " : "skip: ";
+        Check (summary.find ("Up: 1, down: 1, unknown: 1") != std::string::npos, name + "counts");
+        Check (summary.find ("icmp echo-reply after 1.5 ms") != std::string::npos, name + "probe proving a host up");
+        Check (summary.find ("192.0.2.2") == std::string::npos, name + "host down not listed");
+        CheckEqual (summary.find ("192.0.2.3") != std::string::npos, policy == UNKNOWN_SCAN,
+                    name + "unknown host listed when scanned");
+    }
+
+} /* End of TestSummary () */
+
+
+/*
+ * This function sweeps the loopback address, which answers connect pings with a reset if not an echo reply.
+ */
+static void TestSweep () {
+
+    std::vector <HostLiveness> hosts = {{"127.0.0.1", LIVENESS_UNKNOWN, "", 0}};
+    CancelToken token;
+    ReturnCodes swept = LIVENESS_SWEEP_FAIL;
+    EventLoop loop;
+    loop.Spawn (StoreResult (LivenessSweep (loop, hosts, token), swept));
+    loop.Run ();
+    CheckEqual (swept, LIVENESS_SWEEP_PASS, "sweep completed");
+    CheckEqual (hosts [0].state, LIVENESS_UP, "loopback up");
+    Check (!hosts [0].reason.empty (), "probe which proved it up");
+
+    std::vector <HostLiveness> invalid = {{"127.0.0.1", LIVENESS_UNKNOWN, "", 0},
+                                           {"not an address", LIVENESS_UNKNOWN, "", 0}};
+    loop.Spawn (StoreResult (LivenessSweep (loop, invalid, token), swept));
+    loop.Run ();
+    CheckEqual (swept, LIVENESS_SWEEP_FAIL, "target which is no IPv4 address");
+
+} /* End of TestSweep () */
+
+
+int main () {
+
+    TestPolicy ();
+    TestSummary ();
+    TestSweep ();
+    return FinishChecks ("testLiveness");
+
+} /* End of main () */
@@ -0,0 +1,92 @@
+/*
+ ***********************************************************************************************************************
+ * File: testPortOrder.cpp
+ * Description: This file contains the behaviour tests of sweeping ports in the order of their frequency: ranking the
+ *              TCP ports of a port frequency table, falling back to the built-in ranking without one, and scheduling
+ *              every port with the ranked ones first.
+ * Functions:
+ *           void TestRankedPorts ()
+ *           void TestPortSchedule ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include "discovery.hpp"
+#include "testCheck.hpp"
+
+/* Port frequency table written by the test, in the nmap-services format */
+const std::string TEST_SERVICES_FILE = "testPortOrder-services";
+
+
+/*
+ * This function checks the ports ranked from a port frequency table, and without one.
+ */
+static void TestRankedPorts () {
+
+    std::ofstream table (TEST_SERVICES_FILE);
+    table << "# Fields: service name, portnum/protocol, open-frequency, optional comments\n"
+          << "ssh\t22/tcp\t0.182286\t# Secure Shell Login\n"
+          << "http\t80/tcp\t0.484143\t# World Wide Web HTTP\n"
+          << "domain\t53/udp\t0.213496\t# Domain Name Server\n"
+          << "https\t443/tcp\t0.208669\t# secure http (SSL)\n"
+          << "unused\t9/tcp\t0.000000\n"
+          << "smtp\t25/tcp\t0.131314\t# Simple Mail Transfer\n"
+          << "mail\t25/tcp\t0.010000\t# same port, less frequent name\n"
+          << "imap\t143/tcp\t0.131314\n"
+          << "broken\t70000/tcp\t0.5\n"
+          << "malformed line\n";
+    table.close ();
+    std::vector <uint16_t> ranked = RankedPorts (TEST_SERVICES_FILE);
+    CheckEqual (ranked.size (), 5U, "TCP ports with a frequency, each listed once");
+    std::vector <uint16_t> expected = {80, 443, 22, 25, 143};
+    Check (ranked == expected, "most frequent first, ties in port order");
+
+    std::vector <uint16_t> builtIn = RankedPorts ("testPortOrder-missing");
+    Check (!builtIn.empty (), "built-in ranking without a table");
+    if (builtIn.size () >= 3) {
+        Check (builtIn [0] == 80 && builtIn [1] == 23 && builtIn [2] == 443, "built-in ranking, most frequent first");
+    }
+    std::ofstream empty (TEST_SERVICES_FILE);
+    empty << "# no TCP port\ndomain\t53/udp\t0.213496\n";
+    empty.close ();
+    CheckEqual (RankedPorts (TEST_SERVICES_FILE).size (), builtIn.size (), "built-in ranking for a table of no use");
+    std::remove (TEST_SERVICES_FILE.c_str ());
+
+} /* End of TestRankedPorts () */
+
+
+/*
+ * This function checks that a schedule holds every port once, the ranked ones first.
+ */
+static void TestPortSchedule () {
+
+    std::vector <uint16_t> schedule = PortSchedule ({443, 80, 0, 443, 22});
+    CheckEqual (schedule.size (), static_cast <size_t> (UINT16_MAX), "every port scheduled once");
+    if (schedule.size () != UINT16_MAX) { return; }
+    Check (schedule [0] == 443 && schedule [1] == 80 && schedule [2] == 22, "ranked ports first, in their order");
+    CheckEqual (schedule [3], 1, "then the rest ascending");
+    CheckEqual (schedule [24], 23, "ranked ports skipped among the rest");
+    CheckEqual (schedule.back (), UINT16_MAX, "highest port last");
+    std::vector <bool> seen (UINT16_MAX + 1, false);
+    for (uint16_t port : schedule) { seen [port] = true; }
+    Check (!seen [0] && std::count (seen.begin (), seen.end (), true) == UINT16_MAX,
+           "no port missing, port 0 left out");
+
+    std::vector <uint16_t> ascending = PortSchedule ({});
+    Check (ascending.front () == 1 && ascending.back () == UINT16_MAX, "unranked schedule ascending");
+
+} /* End of TestPortSchedule () */
+
+
+int main () {
+
+    TestRankedPorts ();
+    TestPortSchedule ();
+    return FinishChecks ("testPortOrder");
+
+} /* End of main () */
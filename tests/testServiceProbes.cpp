@@ -0,0 +1,141 @@
+/*
+ ***********************************************************************************************************************
+ * File: testServiceProbes.cpp
+ * Description: This file contains the behaviour tests of the native service-probe engine: filling the version fields
+ *              of a match from its groups, loading a database in the nmap-service-probes format and matching responses
+ *              against a probe, its fallbacks & the NULL probe. Matching is only checked when built with RE2.
+ * Functions:
+ *           void TestFillVersionField ()
+ *           void TestLoad ()
+ *           void TestMatch ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "serviceprobes.hpp"
+#include "testCheck.hpp"
+
+/* A database of a NULL probe, a probe for HTTP falling back to a probe for an RPC service and a UDP probe */
+static const std::string DATABASE =
+    "# Test database\n"
+    "Exclude T:9100-9107,U:53\n"
+    "Probe TCP NULL q||\n"
+    "totalwaitms 6000\n"
+    "match ssh m|^SSH-([\\d.]+)-OpenSSH_([\\w._-]+)\\r?\\n| p/OpenSSH/ v/$2/ i/protocol $1/ "
+    "cpe:/a:openbsd:openssh:$2/\n"
+    "match ftp m|^220 (.*) FTP|s p/$SUBST(1,\"_\",\".\")/\n"
+    "match echo m|^(\\w)\\1| p/backreference/\n"
+    "Probe TCP GetRequest q|GET / HTTP/1.0\\r\\n\\r\\n|\n"
+    "rarity 1\n"
+    "ports 80,8000-8010\n"
+    "fallback RPCCheck\n"
+    "softmatch http m|^HTTP/1\\.[01] \\d\\d\\d|\n"
+    "match http m|^HTTP/1\\.[01] \\d\\d\\d .*\\r\\nServer: Apache/([\\d.]+)|s p/Apache httpd/ v/$1/ "
+    "cpe:/a:apache:http_server:$1/\n"
+    "Probe UDP DNSStatusRequest q|\\0\\0\\x10\\0\\0\\0\\0\\0\\0\\0\\0\\0|\n"
+    "match dns m|^\\0\\0\\x90| p/UDP only/\n"
+    "Probe TCP RPCCheck q|\\x80\\0\\0\\x28|\n"
+    "rarity 5\n"
+    "match rpcbind m|^\\x80\\0\\0\\x1c(....)| p/rpcbind/ v/$I(1,\">\")/\n";
+
+
+/*
+ * This function checks the fields of a version template filled with the groups of a match.
+ */
+static void TestFillVersionField () {
+
+    std::vector <std::string> groups = {"whole", "2.4.57", "a\x01" "b\x7f", std::string ("\x01\x02", 2), "1_2_3"};
+    CheckEqual (FillVersionField ("Apache $1", groups), "Apache 2.4.57", "group substituted");
+    CheckEqual (FillVersionField ("$P(2)", groups), "ab", "unprintable characters dropped");
+    CheckEqual (FillVersionField ("$I(3,\">\")", groups), "258", "big endian integer");
+    CheckEqual (FillVersionField ("$I(3,\"<\")", groups), "513", "little endian integer");
+    CheckEqual (FillVersionField ("v$SUBST(4,\"_\",\".\")", groups), "v1.2.3", "substitution");
+    CheckEqual (FillVersionField ("$9 left", groups), " left", "missing group empty");
+    CheckEqual (FillVersionField ("cost $", groups), "cost $", "trailing $ kept");
+
+} /* End of TestFillVersionField () */
+
+
+/*
+ * This function checks the probes, ports & exclusions loaded from a database.
+ */
+static void TestLoad () {
+
+    ServiceProbes probes;
+    ServiceVerdict verdict;
+    Check (!probes.IsLoaded (), "nothing loaded");
+    Check (!probes.Match (0, "SSH-2.0-OpenSSH_8.9p1\r\n", verdict), "no match unloaded");
+    size_t loaded = probes.LoadFromString (DATABASE);
+    if (!loaded) {
+        Check (!probes.IsLoaded (), "database not loaded without RE2");
+        return;
+    }
+    CheckEqual (loaded, 3U, "TCP probes only");
+    CheckEqual (probes.NumProbes (), 3U, "probes kept");
+    CheckEqual (probes.NumMatches (), 6U, "matches & softmatches of the TCP probes");
+    CheckEqual (probes.NumRejected (), 1U, "backreference not supported by RE2");
+    Check (probes.IsExcluded (9100) && probes.IsExcluded (9107), "excluded TCP range");
+    Check (!probes.IsExcluded (53), "UDP exclusions ignored");
+    CheckEqual (probes.LoadFromString ("# no probes\n"), 0U, "empty database rejected");
+    CheckEqual (probes.NumProbes (), 3U, "loaded database kept");
+
+} /* End of TestLoad () */
+
+
+/*
+ * This function checks responses matched against a probe, its fallbacks & the NULL probe.
+ */
+static void TestMatch () {
+
+    ServiceProbes probes;
+    if (!probes.LoadFromString (DATABASE)) { return; }
+
+    ServiceVerdict ssh;
+    Check (probes.Match (0, "SSH-2.0-OpenSSH_8.9p1\r\n", ssh), "NULL probe match");
+    CheckEqual (ssh.service, "ssh", "service");
+    CheckEqual (ssh.product, "OpenSSH", "product");
+    CheckEqual (ssh.version, "8.9p1", "version from a group");
+    CheckEqual (ssh.info, "protocol 2.0", "info from a group");
+    CheckEqual (ssh.cpes.size (), 1U, "CPE");
+    if (!ssh.cpes.empty ()) { CheckEqual (ssh.cpes [0], "cpe:/a:openbsd:openssh:8.9p1", "CPE filled"); }
+
+    ServiceVerdict ftp;
+    Check (probes.Match (0, "220 Pure_FTPd FTP\r\n", ftp), "match with a substitution");
+    CheckEqual (ftp.product, "Pure.FTPd", "substituted product");
+
+    ServiceVerdict apache;
+    Check (probes.Match (1, "HTTP/1.1 200 OK\r\nServer: Apache/2.4.57\r\n\r\n", apache), "match of the probe sent");
+    CheckEqual (apache.probe, "GetRequest", "probe which matched");
+    Check (!apache.soft, "match over the softmatch before it");
+    CheckEqual (apache.version, "2.4.57", "version");
+
+    ServiceVerdict soft;
+    Check (!probes.Match (1, "HTTP/1.1 200 OK\r\nServer: nginx\r\n\r\n", soft), "only a softmatch");
+    Check (soft.soft && soft.service == "http", "service named by the softmatch");
+
+    ServiceVerdict rpc;
+    Check (probes.Match (1, std::string ("\x80\0\0\x1c\0\x01\x86\xa0", 8), rpc), "match of a fallback");
+    CheckEqual (rpc.probe, "RPCCheck", "fallback which matched");
+    CheckEqual (rpc.version, "100000", "big endian integer version");
+
+    ServiceVerdict banner;
+    Check (probes.Match (1, "SSH-2.0-OpenSSH_9.6\n", banner), "NULL probe matches after the fallbacks");
+    CheckEqual (banner.probe, SP_NULL_PROBE, "NULL probe which matched");
+
+    ServiceVerdict none;
+    Check (!probes.Match (2, "nothing known", none) && !none.soft, "no match");
+    Check (!probes.Match (7, "SSH-2.0-OpenSSH_9.6\n", none), "unknown probe");
+
+} /* End of TestMatch () */
+
+
+int main () {
+
+    TestFillVersionField ();
+    TestLoad ();
+    TestMatch ();
+    return FinishChecks ("testServiceProbes");
+
+} /* End of main () */
@@ -0,0 +1,96 @@
+/*
+ ***********************************************************************************************************************
+ * File: testSharding.cpp
+ * Description: This file contains the behaviour tests of splitting an NMAP sweep into shards: parsing the number of
+ *              shards asked for, tuning it to the cores & the ports, and writing the ports of each shard as an NMAP
+ *              port specification.
+ * Functions:
+ *           void TestShardCount ()
+ *           void TestShardPortSpecs ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <thread>
+#include "discovery.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function checks the number of shards parsed from the command line, and tuned to the sweep.
+ */
+static void TestShardCount () {
+
+    size_t shards = 99;
+    Check (ParseShardCount (SHARDS_AUTO, shards) && shards == 0, "auto");
+    Check (ParseShardCount ("4", shards) && shards == 4, "count");
+    Check (ParseShardCount (std::to_string (DISC_MAX_SHARDS), shards) && shards == DISC_MAX_SHARDS, "most shards");
+    for (const std::string value : {"0", "17", "-1", "+4", "4x", " 4", ""}) {
+        Check (!ParseShardCount (value, shards), "rejects \"" + value + "\"");
+    }
+    CheckEqual (shards, DISC_MAX_SHARDS, "count kept on a rejected value");
+
+    CheckEqual (ShardCount (4, UINT16_MAX), 4U, "count asked for");
+    CheckEqual (ShardCount (4, 3 * DISC_SHARD_MIN_PORTS - 1), 2U, "fewer shards than asked for a few ports");
+    CheckEqual (ShardCount (4, DISC_SHARD_MIN_PORTS - 1), 1U, "no split below the ports of a shard");
+    CheckEqual (ShardCount (4, 0), 1U, "no split without ports");
+    CheckEqual (ShardCount (DISC_MAX_SHARDS * 2, UINT16_MAX), DISC_MAX_SHARDS, "at most DISC_MAX_SHARDS");
+    size_t cores = std::max (1U, std::thread::hardware_concurrency ());
+    CheckEqual (ShardCount (0, UINT16_MAX), std::min (cores, DISC_MAX_SHARDS), "a shard per core");
+
+} /* End of TestShardCount () */
+
+
+/*
+ * This function checks the ports of each shard, contiguous runs of near equal size written with ranges folded.
+ */
+static void TestShardPortSpecs () {
+
+    std::vector <uint16_t> ports;
+    for (uint16_t port = 1; port <= 30; port++) {
+        if (port != 20 && port != 25) { ports.push_back (port); }
+    }
+    ports.push_back (443);
+    std::vector <std::vector <std::string>> specs = ShardPortSpecs (ports, 2);
+    CheckEqual (specs.size (), 2U, "two shards");
+    if (specs.size () == 2) {
+        Check (specs [0] == std::vector <std::string> {"-p", "1-14"}, "first half folded into a range");
+        CheckEqual (specs [1].back (), "15-19,21-24,26-30,443", "second half, gaps splitting the ranges");
+    }
+
+    specs = ShardPortSpecs ({443, 80, 22, 81, 21}, 2);
+    CheckEqual (specs.size (), 2U, "shards of ranked ports");
+    if (specs.size () == 2) {
+        CheckEqual (specs [0].back (), "80,443", "ports of a shard ascending");
+        CheckEqual (specs [1].back (), "21-22,81", "ranges folded once sorted");
+    }
+
+    specs = ShardPortSpecs ({22, 80}, 8);
+    CheckEqual (specs.size (), 2U, "no more shards than ports");
+    specs = ShardPortSpecs ({22, 80}, 0);
+    CheckEqual (specs.size (), 1U, "a single shard at least");
+    if (specs.size () == 1) { CheckEqual (specs [0].back (), "22,80", "every port in it"); }
+
+    std::vector <uint16_t> every;
+    for (uint32_t port = 1; port <= UINT16_MAX; port++) { every.push_back (static_cast <uint16_t> (port)); }
+    specs = ShardPortSpecs (every, 3);
+    CheckEqual (specs.size (), 3U, "shards of every port");
+    if (specs.size () == 3) {
+        CheckEqual (specs [0].back (), "1-21845", "first third");
+        CheckEqual (specs [1].back (), "21846-43690", "second third");
+        CheckEqual (specs [2].back (), "43691-65535", "last third");
+    }
+
+} /* End of TestShardPortSpecs () */
+
+
+int main () {
+
+    TestShardCount ();
+    TestShardPortSpecs ();
+    return FinishChecks ("testSharding");
+
+} /* End of main () */
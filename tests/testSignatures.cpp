@@ -0,0 +1,115 @@
+/*
+ ***********************************************************************************************************************
+ * File: testSignatures.cpp
+ * Description: This file contains the behaviour tests of the signature engine, which classifies NMAP script output
+ *              by severity and gathers the CVE ids it mentions, and of the extraction of script results from the XML
+ *              of a deep scan.
+ * Functions:
+ *           void TestDefaultSignatures ()
+ *           void TestCVEIds ()
+ *           void TestLoadedSignatures ()
+ *           void TestScriptResults ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include "scanner.hpp"
+#include "testCheck.hpp"
+
+
+/*
+ * This function checks the severities the default signatures give to typical output of the NMAP vulns library.
+ */
+static void TestDefaultSignatures () {
+
+    const SignatureEngine engine;
+    CheckEqual (SeverityName (engine.Classify ("\n  VULNERABLE:\n  Title\n    State: VULNERABLE\n").severity), "high",
+                "vulnerable output");
+    CheckEqual (SeverityName (engine.Classify ("State: VULNERABLE (Exploitable)").severity), "critical",
+                "exploitable output");
+    CheckEqual (SeverityName (engine.Classify ("state: likely vulnerable").severity), "medium",
+                "matching ignores case");
+    CheckEqual (SeverityName (engine.Classify ("\n  NOT VULNERABLE:\n  Title\n    State: NOT VULNERABLE\n").severity),
+                "none", "NOT VULNERABLE is not taken for VULNERABLE");
+    CheckEqual (SeverityName (engine.Classify ("NOT VULNERABLE:\n  VULNERABLE:\n").severity), "high",
+                "an exclusion does not hide a later match");
+    CheckEqual (SeverityName (engine.Classify ("State: UNKNOWN").severity), "info", "unknown state");
+    CheckEqual (SeverityName (engine.Classify ("Nothing to see here").severity), "none", "unrelated output");
+
+} /* End of TestDefaultSignatures () */
+
+
+/*
+ * This function checks that CVE ids are gathered once each, normalised, and only when well formed.
+ */
+static void TestCVEIds () {
+
+    const SignatureEngine engine;
+    ScriptVerdict verdict = engine.Classify ("IDs: CVE:CVE-2023-38408 cve-2021-1234567 CVE-2023-38408 CVE-20x1-1234");
+    CheckEqual (verdict.cves.size (), 2U, "distinct well formed CVE ids");
+    if (verdict.cves.size () == 2) {
+        CheckEqual (verdict.cves [0], "CVE-2023-38408", "first CVE id");
+        CheckEqual (verdict.cves [1], "CVE-2021-1234567", "CVE id normalised to upper case");
+    }
+    CheckEqual (SeverityName (verdict.severity), SeverityName (SEV_CVE_ONLY), "severity of output with CVE ids only");
+    CheckEqual (engine.Classify ("CVE-2023-123 CVE-2023-12345678").cves.size (), 0U, "sequence numbers out of range");
+
+} /* End of TestCVEIds () */
+
+
+/*
+ * This function checks signatures given as text, replacing the default ones.
+ */
+static void TestLoadedSignatures () {
+
+    SignatureEngine engine;
+    CheckEqual (engine.LoadFromString ("# comment\nbogus\tignored\nmedium\tweak cipher\nnone\tno weak cipher\n"), 2U,
+                "signatures compiled, exclusion included");
+    CheckEqual (SeverityName (engine.Classify ("uses a Weak Cipher").severity), "medium", "loaded signature");
+    CheckEqual (SeverityName (engine.Classify ("offers no weak cipher").severity), "none", "loaded exclusion");
+    CheckEqual (SeverityName (engine.Classify ("State: VULNERABLE").severity), "none", "default signatures replaced");
+    CheckEqual (engine.LoadFromString ("bogus\tpattern\n"), 0U, "no valid signature");
+
+} /* End of TestLoadedSignatures () */
+
+
+/*
+ * This function checks the results extracted from the XML of a deep scan: informational matches are not listed as
+ * vulnerabilities, while they still raise the severity of the port.
+ */
+static void TestScriptResults () {
+
+    const SignatureEngine engine;
+    pugi::xml_document document;
+    document.load_string (
+        "<host><ports><port protocol=\"tcp\" portid=\"22\"><state state=\"open\"/>"
+        "<service name=\"ssh\" product=\"OpenSSH\" version=\"8.9p1\"><cpe>cpe:/a:openbsd:openssh:8.9p1</cpe></service>"
+        "<script id=\"vuln-a\" output=\"  VULNERABLE:&#xa;  IDs: CVE:CVE-2023-38408\"/>"
+        "<script id=\"vuln-b\" output=\"  NOT VULNERABLE:&#xa;  State: NOT VULNERABLE\"/>"
+        "<script id=\"probe-c\" output=\"  State: UNKNOWN\"/>"
+        "</port></ports></host>");
+    Logger portLog ("testSignatures.log");
+    Port port ("22", STATE_OPEN);
+    port.ExtractScriptResults (document.child ("host"), portLog, engine);
+    CheckEqual (port.product, "OpenSSH", "product");
+    CheckEqual (port.version, "8.9p1", "version");
+    CheckEqual (port.cpes.size (), 1U, "CPEs");
+    CheckEqual (port.vulnerabilities.size (), 1U, "scripts listed as vulnerabilities");
+    if (!port.vulnerabilities.empty ()) { CheckEqual (port.vulnerabilities [0], "vuln-a", "vulnerable script"); }
+    CheckEqual (port.cves.size (), 1U, "CVE ids of the port");
+    CheckEqual (SeverityName (port.severity), "high", "severity of the port");
+
+} /* End of TestScriptResults () */
+
+
+int main () {
+
+    TestDefaultSignatures ();
+    TestCVEIds ();
+    TestLoadedSignatures ();
+    TestScriptResults ();
+    return FinishChecks ("testSignatures");
+
+} /* End of main () */
@@ -0,0 +1,169 @@
+/*
+ ***********************************************************************************************************************
+ * File: testTLS.cpp
+ * Description: This file contains the behaviour tests of the native TLS inspection, run against "openssl s_server"
+ *              serving a self-signed certificate generated for the test on a loopback port.
+ * Functions:
+ *           string FreePort ()
+ *           bool WaitForPort ()
+ *           pid_t StartServer ()
+ *           void TestInspection ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "testCheck.hpp"
+#include "tls.hpp"
+#include "utilities.hpp"
+
+const std::string TEST_KEY = "testTLS.key";
+const std::string TEST_CERT = "testTLS.crt";
+const std::string TEST_NAME = "porthawk.test";
+
+
+/*
+ * This function picks a loopback port no socket is bound to.
+ * :return: string holding the port, empty if none could be picked.
+ */
+static std::string FreePort () {
+
+    int probe = socket (AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in local {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    socklen_t length = sizeof (local);
+    bool bound = probe >= 0 && bind (probe, reinterpret_cast <struct sockaddr *> (&local), sizeof (local)) == 0 &&
+                 getsockname (probe, reinterpret_cast <struct sockaddr *> (&local), &length) == 0;
+    if (probe >= 0) { close (probe); }
+    return bound ? std::to_string (ntohs (local.sin_port)) : "";
+
+} /* End of FreePort () */
+
+
+/*
+ * This function waits for a loopback port to accept connections.
+ * :arg: port, const string holding the port.
+ * :return: bool value indicating whether the port accepted a connection within 10 seconds.
+ */
+static bool WaitForPort (const std::string &port) {
+
+    struct sockaddr_in remote {};
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    remote.sin_port = htons (static_cast <uint16_t> (std::stoi (port)));
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int probe = socket (AF_INET, SOCK_STREAM, 0);
+        bool connected = connect (probe, reinterpret_cast <struct sockaddr *> (&remote), sizeof (remote)) == 0;
+        close (probe);
+        if (connected) { return true; }
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+    }
+    return false;
+
+} /* End of WaitForPort () */
+
+
+/*
+ * This function starts "openssl s_server" on a loopback port, serving the certificate of the test.
+ * :arg: port, const string holding the port.
+ * :return: process id of the server, -1 if it could not be started.
+ */
+static pid_t StartServer (const std::string &port) {
+
+    pid_t server = fork ();
+    if (server == 0) {
+        execl (OPENSSL_PROGRAM, OPENSSL_PROGRAM, "s_server", "-quiet", "-accept", ("127.0.0.1:" + port).c_str (),
+               "-cert", TEST_CERT.c_str (), "-key", TEST_KEY.c_str (), static_cast <char *> (nullptr));
+        _exit (127);
+    }
+    return server;
+
+} /* End of StartServer () */
+
+
+/*
+ * This function checks the protocols, cipher suites & certificate reported for the server.
+ */
+static void TestInspection () {
+
+    std::string generate = std::string (OPENSSL_PROGRAM) + " req -x509 -newkey rsa:2048 -nodes -days 2 -keyout " +
+                           TEST_KEY + " -out " + TEST_CERT + " -subj /CN=" + TEST_NAME +
+                           " -addext subjectAltName=DNS:" + TEST_NAME + ",IP:127.0.0.1 > /dev/null 2>&1";
+    if (std::system (generate.c_str ()) != 0) {
+        Check (false, "certificate generated");
+        return;
+    }
+    std::string port = FreePort ();
+    pid_t server = port.empty () ? -1 : StartServer (port);
+    if (server < 0 || !WaitForPort (port)) {
+        Check (false, "openssl s_server started");
+        if (server > 0) { kill (server, SIGTERM); }
+        return;
+    }
+
+    CancelToken token;
+    EventLoop loop;
+    TLSReport report;
+    loop.Spawn (StoreResult (InspectTLS (loop, "127.0.0.1", port, token), report));
+    loop.Run ();
+    kill (server, SIGTERM);
+    waitpid (server, nullptr, 0);
+
+    Check (report.handshake, "handshake completed");
+    auto protocol = [&](const std::string &name) {
+        return std::find_if (report.protocols.begin (), report.protocols.end (), [&](const TLSProtocol &accepted) {
+            return accepted.name == name;
+        });
+    };
+    Check (protocol ("TLSv1.3") != report.protocols.end (), "TLSv1.3 accepted");
+    Check (protocol ("TLSv1.2") != report.protocols.end (), "TLSv1.2 accepted");
+    if (protocol ("TLSv1.3") != report.protocols.end ()) {
+        Check (protocol ("TLSv1.3")->ciphers.size () >= 2, "TLSv1.3 cipher suites enumerated");
+    }
+    if (protocol ("TLSv1.2") != report.protocols.end ()) {
+        const auto &ciphers = protocol ("TLSv1.2")->ciphers;
+        Check (ciphers.size () >= 2, "TLSv1.2 cipher suites enumerated");
+        Check (std::find (ciphers.begin () + 1, ciphers.end (), ciphers [0]) == ciphers.end (),
+               "TLSv1.2 cipher suites listed once each");
+    }
+    CheckEqual (report.chain.size (), 1U, "certificates in the chain");
+    if (report.chain.empty ()) { return; }
+    const TLSCertificate &leaf = report.chain [0];
+    CheckEqual (leaf.subject, "CN=" + TEST_NAME, "subject");
+    CheckEqual (leaf.issuer, leaf.subject, "self-signed issuer");
+    CheckEqual (leaf.keyType, "RSA", "key type");
+    CheckEqual (leaf.keyBits, 2048, "key size");
+    CheckEqual (leaf.signature, "sha256WithRSAEncryption", "signature algorithm");
+    Check (!leaf.expired, "not expired");
+    CheckEqual (leaf.sha256.size (), 95U, "SHA-256 fingerprint, colon separated");
+    CheckEqual (leaf.altNames.size (), 2U, "subject alternative names");
+    if (leaf.altNames.size () == 2) {
+        CheckEqual (leaf.altNames [0], "DNS:" + TEST_NAME, "DNS name");
+        CheckEqual (leaf.altNames [1], "IP:127.0.0.1", "IP address");
+    }
+
+} /* End of TestInspection () */
+
+
+int main () {
+
+    if (!TLSAvailable ()) {
+        std::cout << "testTLS: TLS inspection is not compiled in" << std::endl;
+        return 0;
+    }
+    TestInspection ();
+    return FinishChecks ("testTLS");
+
+} /* End of main () */
@@ -0,0 +1,181 @@
+/*
+ ***********************************************************************************************************************
+ * File: testUDP.cpp
+ * Description: This file contains the behaviour tests of the native UDP sweep: the payload table, each entry being a
+ *              well-formed request of its service, and a sweep of loopback ports which answer, are closed or stay
+ *              silent.
+ * Functions:
+ *           const UDPPayload *Find ()
+ *           void TestPayloadTable ()
+ *           int Bind ()
+ *           void TestSweep ()
+ *           int main ()
+ *
+ * Author: 0x6D76
+ * Copyright (c) 2024 0x6D76 (0x6D76@proton.me)
+ ***********************************************************************************************************************
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include "testCheck.hpp"
+#include "udp.hpp"
+#include "utilities.hpp"
+
+
+/*
+ * This function looks up the payload of a port in the table.
+ * :arg: port, unsigned 16 bit integer holding the port.
+ * :return: pointer to the UDPPayload object of the port, nullptr if there is none.
+ */
+static const UDPPayload *Find (uint16_t port) {
+
+    for (const UDPPayload &entry : UDPPayloads ()) {
+        if (entry.port == port) { return &entry; }
+    }
+    return nullptr;
+
+} /* End of Find () */
+
+
+/*
+ * This function checks the payload table: a payload per port, and the framing of the payloads of a few services.
+ */
+static void TestPayloadTable () {
+
+    const std::vector <UDPPayload> &payloads = UDPPayloads ();
+    Check (!payloads.empty (), "payloads in the table");
+    for (size_t index = 0; index < payloads.size (); index++) {
+        Check (!payloads [index].payload.empty (), "payload of port " + std::to_string (payloads [index].port));
+        Check (!payloads [index].service.empty (), "service of port " + std::to_string (payloads [index].port));
+        Check (!index || payloads [index - 1].port < payloads [index].port, "ports in order, each listed once");
+    }
+
+    const UDPPayload *dns = Find (53);
+    Check (dns && dns->service == "domain", "DNS payload");
+    if (dns) {
+        CheckEqual (dns->payload.size (), 17U, "DNS header & a question of the root");
+        CheckEqual (dns->payload.substr (4, 2), std::string ("\x00\x01", 2), "one question");
+    }
+    const UDPPayload *ntp = Find (123);
+    Check (ntp && ntp->payload.size () == 48 && ntp->payload [0] == '\xe3', "NTP version 4 client request");
+    const UDPPayload *snmp = Find (161);
+    Check (snmp && static_cast <size_t> (snmp->payload [1]) + 2 == snmp->payload.size (), "SNMP message length");
+    Check (snmp && snmp->payload.find ("public") != std::string::npos, "SNMP community");
+    for (uint16_t port : {111, 2049}) {
+        const UDPPayload *rpc = Find (port);
+        Check (rpc && rpc->payload.size () == 40 && rpc->payload.substr (4, 4) == std::string (4, '\0'),
+               "ONC RPC call of port " + std::to_string (port));
+    }
+    const UDPPayload *stun = Find (3478);
+    Check (stun && stun->payload.size () == 20 && stun->payload.substr (4, 4) == "\x21\x12\xa4\x42",
+           "STUN header with its magic cookie");
+    for (uint16_t port : {1900, 5060}) {
+        const UDPPayload *text = Find (port);
+        Check (text && text->payload.size () > 4 && text->payload.substr (text->payload.size () - 4) == "\r\n\r\n",
+               "request of port " + std::to_string (port) + " ended by an empty line");
+    }
+    const UDPPayload *memcache = Find (11211);
+    Check (memcache && memcache->payload.substr (8) == "stats\r\n", "memcached command behind its frame header");
+    Check (!Find (1), "no payload for an unlisted port");
+
+} /* End of TestPayloadTable () */
+
+
+/*
+ * This function binds a UDP socket to a loopback port chosen by the kernel.
+ * :arg: port, unsigned 16 bit integer to which the port is copied.
+ * :return: integer holding the descriptor of the socket, -1 on failure.
+ */
+static int Bind (uint16_t &port) {
+
+    int fd = socket (AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in local {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    socklen_t length = sizeof (local);
+    if (fd < 0 || bind (fd, reinterpret_cast <struct sockaddr *> (&local), sizeof (local)) != 0 ||
+        getsockname (fd, reinterpret_cast <struct sockaddr *> (&local), &length) != 0) {
+        if (fd >= 0) { close (fd); }
+        return -1;
+    }
+    port = ntohs (local.sin_port);
+    return fd;
+
+} /* End of Bind () */
+
+
+/*
+ * This function sweeps three loopback ports: one echoing its datagrams, one closed & one never answering.
+ */
+static void TestSweep () {
+
+    uint16_t answering = 0;
+    uint16_t closed = 0;
+    uint16_t silent = 0;
+    int echo = Bind (answering);
+    int unused = Bind (closed);
+    int quiet = Bind (silent);
+    if (unused >= 0) { close (unused); }
+    if (echo < 0 || unused < 0 || quiet < 0) {
+        Check (false, "loopback ports bound");
+        if (echo >= 0) { close (echo); }
+        if (quiet >= 0) { close (quiet); }
+        return;
+    }
+    /* Answers the first datagram, later retransmissions go unanswered */
+    std::thread server ([echo]() {
+        struct timeval wait {5, 0};
+        setsockopt (echo, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof (wait));
+        char buffer [64];
+        struct sockaddr_in peer {};
+        socklen_t length = sizeof (peer);
+        ssize_t received = recvfrom (echo, buffer, sizeof (buffer), 0, reinterpret_cast <struct sockaddr *> (&peer),
+                                     &length);
+        if (received >= 0) {
+            sendto (echo, "pong", 4, 0, reinterpret_cast <struct sockaddr *> (&peer), length);
+        }
+    });
+
+    std::vector <uint16_t> ports = {answering, closed, silent};
+    CancelToken token;
+    SweepResult result;
+    ReturnCodes swept = UDP_SWEEP_FAIL;
+    EventLoop loop;
+    loop.Spawn (StoreResult (UDPSweep (loop, "127.0.0.1", ports, token, result), swept));
+    loop.Run ();
+    server.join ();
+    close (echo);
+    close (quiet);
+
+    CheckEqual (swept, UDP_SWEEP_PASS, "sweep completed");
+    CheckEqual (result.open.size (), 1U, "answering port open");
+    if (!result.open.empty ()) { CheckEqual (result.open [0], answering, "port which answered"); }
+    CheckEqual (result.closed, 1U, "port unreachable makes a port closed");
+    CheckEqual (result.openFiltered.size (), 1U, "silent port open|filtered");
+    if (!result.openFiltered.empty ()) { CheckEqual (result.openFiltered [0], silent, "port which stayed silent"); }
+    CheckEqual (result.responses, 2U, "responses");
+
+    CancelToken cancelled;
+    cancelled.Cancel ();
+    SweepResult none;
+    EventLoop stopped;
+    stopped.Spawn (StoreResult (UDPSweep (stopped, "127.0.0.1", ports, cancelled, none), swept));
+    stopped.Run ();
+    CheckEqual (swept, CMD_EXEC_CANCEL, "cancelled sweep");
+    loop.Spawn (StoreResult (UDPSweep (loop, "not an address", ports, token, none), swept));
+    loop.Run ();
+    CheckEqual (swept, UDP_SWEEP_FAIL, "target which is no IPv4 address");
+
+} /* End of TestSweep () */
+
+
+int main () {
+
+    TestPayloadTable ();
+    TestSweep ();
+    return FinishChecks ("testUDP");
+
+} /* End of main () */